@@ -1,9 +1,38 @@
 #include <benchmark/benchmark.h>
 
+#include <EASTL/unordered_map.h>
+#include <EASTL/unordered_set.h>
+#include <EASTL/vector.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <climits>
+#include <condition_variable>
+#include <cstdio>
 #include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <mutex>
+#include <string>
+#include <thread>
 #include <vector>
 
+#include "../src/blend.h"
+#include "../src/frame_times.h"
+#include "../src/jobs.h"
+#include "../src/paint_backend.h"
+#include "../src/stroke_bins.h"
+#include "../src/tile_codec.h"
+#include "../src/tile_atlas.h"
+#include "../src/tile_index.h"
+#include "../src/tile_instances.h"
+#include "../src/tile_io.h"
+#include "../src/tile_pack.h"
+#include "../src/tiles.h"
+
+#include "../deps/qoi/qoi.h"
+
 static std::vector<int> MidoriDummy(size_t num) {
   std::vector<int> vec;
   for (size_t i = 0; i < num; i++) {
@@ -18,4 +47,690 @@ static void BM_MidoriDummy(benchmark::State& state) {
     MidoriDummy(num);
   }
 }
-BENCHMARK(BM_MidoriDummy);
\ No newline at end of file
+BENCHMARK(BM_MidoriDummy);
+
+// Tile loading
+
+static eastl::vector<uint8_t> MidoriSyntheticTile(uint32_t seed) {
+  // Soft strokes over a transparent background, closer to real tiles than noise
+  eastl::vector<uint8_t> pixels(Midori::TILE_WIDTH * Midori::TILE_HEIGHT * 4, 0);
+  srand(seed);
+  for (int stroke = 0; stroke < 8; stroke++) {
+    const int cx = rand() % Midori::TILE_WIDTH;
+    const int cy = rand() % Midori::TILE_HEIGHT;
+    const int radius = 8 + rand() % 48;
+    const uint8_t r = rand() % 256, g = rand() % 256, b = rand() % 256;
+    for (int y = std::max(cy - radius, 0); y < std::min(cy + radius, (int)Midori::TILE_HEIGHT); y++) {
+      for (int x = std::max(cx - radius, 0); x < std::min(cx + radius, (int)Midori::TILE_WIDTH); x++) {
+        const int d2 = (x - cx) * (x - cx) + (y - cy) * (y - cy);
+        if (d2 > radius * radius) {
+          continue;
+        }
+        uint8_t* pixel = &pixels[(y * Midori::TILE_WIDTH + x) * 4];
+        pixel[0] = r;
+        pixel[1] = g;
+        pixel[2] = b;
+        pixel[3] = static_cast<uint8_t>(255 - (d2 * 255) / (radius * radius));
+      }
+    }
+  }
+  return pixels;
+}
+
+static void BM_MidoriTileDecode(benchmark::State& state) {
+  const auto threads = static_cast<size_t>(state.range(0));
+  constexpr size_t tiles_per_iteration = 256;
+
+  eastl::vector<eastl::vector<uint8_t>> encoded_tiles(16);
+  for (size_t i = 0; i < encoded_tiles.size(); i++) {
+    Midori::EncodeTile(MidoriSyntheticTile(static_cast<uint32_t>(i)), encoded_tiles[i]);
+  }
+
+  Midori::JobSystem jobs(threads);
+  for (auto _ : state) {
+    for (size_t i = 0; i < tiles_per_iteration; i++) {
+      jobs.Submit([&encoded_tiles, i] {
+        eastl::vector<uint8_t> pixels;
+        Midori::DecodeTile(encoded_tiles[i % encoded_tiles.size()], pixels);
+        benchmark::DoNotOptimize(pixels.data());
+      });
+    }
+    jobs.Wait();
+  }
+
+  // items_per_second is the number of tiles decoded per second
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * tiles_per_iteration));
+}
+BENCHMARK(BM_MidoriTileDecode)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime();
+
+// Tile read path, one file and intermediate buffers per tile against a view of the mapped pack decoded in place
+
+static constexpr size_t MIDORI_READ_PATH_TILES = 64;
+
+static std::string MidoriReadPathFolder() {
+  const auto folder = std::filesystem::temp_directory_path() / "midori_benchmark_read_path";
+  std::filesystem::create_directories(folder);
+  return folder.string();
+}
+
+static void BM_MidoriTileReadFiles(benchmark::State& state) {
+  const auto folder = MidoriReadPathFolder();
+  for (size_t i = 0; i < MIDORI_READ_PATH_TILES; i++) {
+    eastl::vector<uint8_t> encoded;
+    Midori::EncodeTile(MidoriSyntheticTile(static_cast<uint32_t>(i)), encoded);
+    std::FILE* file = std::fopen(std::format("{}/{}_0.qoi", folder, i).c_str(), "wb");
+    std::fwrite(encoded.data(), 1, encoded.size(), file);
+    std::fclose(file);
+  }
+
+  // Stands in for the mapped GPU upload buffer
+  eastl::vector<uint8_t> upload(Midori::TILE_PIXELS_SIZE);
+  size_t bytes_copied = 0;
+  for (auto _ : state) {
+    for (size_t i = 0; i < MIDORI_READ_PATH_TILES; i++) {
+      eastl::vector<uint8_t> encoded;
+      eastl::vector<uint8_t> pixels;
+      Midori::ReadTileFile(std::format("{}/{}_0.qoi", folder, i), encoded);
+      // Decoded like DecodeTile did before DecodeTileQoi, qoi_decode allocates the pixels and they are copied out
+      qoi_desc desc;
+      void* decoded = qoi_decode(encoded.data(), static_cast<int>(encoded.size()), &desc, 4);
+      pixels.resize(Midori::TILE_PIXELS_SIZE);
+      std::memcpy(pixels.data(), decoded, pixels.size());
+      free(decoded);
+      std::memcpy(upload.data(), pixels.data(), pixels.size());
+      benchmark::DoNotOptimize(upload.data());
+      bytes_copied += encoded.size() + 2 * pixels.size();
+    }
+  }
+
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * MIDORI_READ_PATH_TILES));
+  state.counters["bytes_copied_per_tile"] =
+      static_cast<double>(bytes_copied) / static_cast<double>(state.iterations() * MIDORI_READ_PATH_TILES);
+  std::filesystem::remove_all(folder);
+}
+BENCHMARK(BM_MidoriTileReadFiles);
+
+static void BM_MidoriTileReadMapped(benchmark::State& state) {
+  const auto folder = MidoriReadPathFolder();
+  const auto path = folder + "/tiles.pack";
+  std::filesystem::remove(path);
+
+  Midori::TilePack pack;
+  pack.Open(path);
+  // Budget of the blob cache in MB, 0 reads and verifies the mapped blob every time
+  pack.Cache().SetBudget(static_cast<size_t>(state.range(0)));
+  for (size_t i = 0; i < MIDORI_READ_PATH_TILES; i++) {
+    eastl::vector<uint8_t> encoded;
+    Midori::EncodeTile(MidoriSyntheticTile(static_cast<uint32_t>(i)), encoded);
+    pack.Write({.layer = 1, .pos = {static_cast<int>(i), 0}}, encoded.data(), encoded.size());
+  }
+  pack.Flush();
+
+  eastl::vector<uint8_t> upload(Midori::TILE_PIXELS_SIZE);
+  size_t bytes_copied = 0;
+  for (auto _ : state) {
+    for (size_t i = 0; i < MIDORI_READ_PATH_TILES; i++) {
+      // The pixels are decoded in place, the blob is only copied when a miss fills the cache
+      const auto misses = pack.Cache().GetStats().misses;
+      Midori::TilePack::BlobView view;
+      pack.View({.layer = 1, .pos = {static_cast<int>(i), 0}}, view);
+      Midori::DecodeTileQoi(view.data, view.size, upload.data());
+      benchmark::DoNotOptimize(upload.data());
+      if (pack.Cache().GetStats().misses != misses) {
+        bytes_copied += view.size;
+      }
+    }
+  }
+
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * MIDORI_READ_PATH_TILES));
+  state.counters["bytes_copied_per_tile"] =
+      static_cast<double>(bytes_copied) / static_cast<double>(state.iterations() * MIDORI_READ_PATH_TILES);
+  pack.Close();
+  std::filesystem::remove_all(folder);
+}
+BENCHMARK(BM_MidoriTileReadMapped)->Arg(0)->Arg(Midori::TileBlobCache::DEFAULT_BUDGET_MB);
+
+// Tile codec against the reference one, on the tiles of a canvas when MIDORI_TILE_CORPUS points to its tiles.pack
+
+static const eastl::vector<eastl::vector<uint8_t>>& MidoriTileCorpus() {
+  static const auto corpus = [] {
+    eastl::vector<eastl::vector<uint8_t>> tiles;
+    if (const char* path = std::getenv("MIDORI_TILE_CORPUS")) {
+      Midori::TilePack pack;
+      if (pack.Open(path)) {
+        for (const auto& coord : pack.Tiles()) {
+          eastl::vector<uint8_t> encoded;
+          eastl::vector<uint8_t> pixels;
+          if (pack.Read(coord, encoded) && Midori::DecodeTile(encoded, pixels)) {
+            tiles.push_back(std::move(pixels));
+          }
+        }
+      }
+    }
+    if (tiles.empty()) {
+      for (uint32_t i = 0; i < 16; i++) {
+        tiles.push_back(MidoriSyntheticTile(i));
+      }
+    }
+    return tiles;
+  }();
+  return corpus;
+}
+
+static void BM_MidoriTileEncodeReference(benchmark::State& state) {
+  const auto& corpus = MidoriTileCorpus();
+  const qoi_desc desc = {
+      .width = Midori::TILE_WIDTH,
+      .height = Midori::TILE_HEIGHT,
+      .channels = 4,
+      .colorspace = QOI_LINEAR,
+  };
+  size_t i = 0;
+  for (auto _ : state) {
+    int size = 0;
+    void* encoded = qoi_encode(corpus[i++ % corpus.size()].data(), &desc, &size);
+    benchmark::DoNotOptimize(encoded);
+    free(encoded);
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * Midori::TILE_PIXELS_SIZE));
+}
+BENCHMARK(BM_MidoriTileEncodeReference);
+
+static void BM_MidoriTileEncodeQoi(benchmark::State& state) {
+  const auto& corpus = MidoriTileCorpus();
+  eastl::vector<uint8_t> encoded(Midori::TILE_QOI_MAX_SIZE);
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(Midori::EncodeTileQoi(corpus[i++ % corpus.size()].data(), encoded.data()));
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * Midori::TILE_PIXELS_SIZE));
+}
+BENCHMARK(BM_MidoriTileEncodeQoi);
+
+static void BM_MidoriTileDecodeReference(benchmark::State& state) {
+  eastl::vector<eastl::vector<uint8_t>> encoded_tiles;
+  for (const auto& pixels : MidoriTileCorpus()) {
+    Midori::EncodeTile(pixels, encoded_tiles.emplace_back());
+  }
+  size_t i = 0;
+  for (auto _ : state) {
+    const auto& encoded = encoded_tiles[i++ % encoded_tiles.size()];
+    qoi_desc desc;
+    void* pixels = qoi_decode(encoded.data(), static_cast<int>(encoded.size()), &desc, 4);
+    benchmark::DoNotOptimize(pixels);
+    free(pixels);
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * Midori::TILE_PIXELS_SIZE));
+}
+BENCHMARK(BM_MidoriTileDecodeReference);
+
+static void BM_MidoriTileDecodeQoi(benchmark::State& state) {
+  eastl::vector<eastl::vector<uint8_t>> encoded_tiles;
+  for (const auto& pixels : MidoriTileCorpus()) {
+    Midori::EncodeTile(pixels, encoded_tiles.emplace_back());
+  }
+  eastl::vector<uint8_t> pixels(Midori::TILE_PIXELS_SIZE);
+  size_t i = 0;
+  for (auto _ : state) {
+    const auto& encoded = encoded_tiles[i++ % encoded_tiles.size()];
+    benchmark::DoNotOptimize(Midori::DecodeTileQoi(encoded.data(), encoded.size(), pixels.data()));
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * Midori::TILE_PIXELS_SIZE));
+}
+BENCHMARK(BM_MidoriTileDecodeQoi);
+
+// Culling of a frame, the per layer hash maps the canvas used against the TileIndex. Every layer has 32x32 saved tiles
+// and the 8x6 visible ones loaded, the view then moves by one tile so a column is loaded and another one unloaded.
+
+static constexpr int MIDORI_CULL_SAVED = 32;
+static constexpr glm::ivec2 MIDORI_CULL_VIEW = glm::ivec2(8, 6);
+
+static bool MidoriCullVisible(const glm::ivec2 pos, const glm::ivec2 view) {
+  return pos.x >= view.x && pos.y >= view.y && pos.x < view.x + MIDORI_CULL_VIEW.x &&
+         pos.y < view.y + MIDORI_CULL_VIEW.y;
+}
+
+static std::vector<glm::ivec2> MidoriCullVisibleTiles(const glm::ivec2 view) {
+  std::vector<glm::ivec2> tiles;
+  for (int y = view.y; y < view.y + MIDORI_CULL_VIEW.y; y++) {
+    for (int x = view.x; x < view.x + MIDORI_CULL_VIEW.x; x++) {
+      tiles.emplace_back(x, y);
+    }
+  }
+  return tiles;
+}
+
+static void BM_MidoriCullHashMaps(benchmark::State& state) {
+  const auto layers = static_cast<Midori::Layer>(state.range(0));
+  eastl::unordered_map<Midori::Layer, eastl::unordered_set<Midori::Tile>> layer_tiles;
+  eastl::unordered_map<Midori::Layer, eastl::unordered_map<glm::ivec2, Midori::Tile>> layer_tile_pos;
+  eastl::unordered_map<Midori::Layer, eastl::unordered_set<glm::ivec2>> layer_tiles_saved;
+  eastl::unordered_map<Midori::Tile, Midori::TileCoord> tile_infos;
+  eastl::vector<Midori::Tile> tiles_unassigned;
+  Midori::Tile tile_last = 0;
+
+  const auto load = [&](const Midori::Layer layer, const glm::ivec2 pos) {
+    Midori::Tile tile = 0;
+    if (tiles_unassigned.empty()) {
+      tile = ++tile_last;
+    } else {
+      tile = tiles_unassigned.back();
+      tiles_unassigned.pop_back();
+    }
+    layer_tiles[layer].insert(tile);
+    layer_tile_pos[layer][pos] = tile;
+    tile_infos[tile] = Midori::TileCoord{.layer = layer, .pos = pos};
+  };
+
+  glm::ivec2 view = glm::ivec2(4, 4);
+  for (Midori::Layer layer = 1; layer <= layers; layer++) {
+    for (int y = 0; y < MIDORI_CULL_SAVED; y++) {
+      for (int x = 0; x < MIDORI_CULL_SAVED; x++) {
+        layer_tiles_saved[layer].insert(glm::ivec2(x, y));
+      }
+    }
+    for (const auto& pos : MidoriCullVisibleTiles(view)) {
+      load(layer, pos);
+    }
+  }
+
+  int step = 1;
+  for (auto _ : state) {
+    view.x += step;
+    step = view.x == 20 || view.x == 4 ? -step : step;
+    const auto visible = MidoriCullVisibleTiles(view);
+
+    for (Midori::Layer layer = 1; layer <= layers; layer++) {
+      eastl::vector<Midori::Tile> unload;
+      for (const auto& tile : layer_tiles[layer]) {
+        if (!MidoriCullVisible(tile_infos[tile].pos, view)) {
+          unload.push_back(tile);
+        }
+      }
+      for (const auto& tile : unload) {
+        layer_tiles[layer].erase(tile);
+        layer_tile_pos[layer].erase(tile_infos[tile].pos);
+        tile_infos.erase(tile);
+        tiles_unassigned.push_back(tile);
+      }
+      for (const auto& pos : visible) {
+        if (layer_tiles_saved[layer].contains(pos) && !layer_tile_pos[layer].contains(pos)) {
+          load(layer, pos);
+        }
+      }
+    }
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * layers);
+}
+BENCHMARK(BM_MidoriCullHashMaps)->Arg(10)->Arg(100)->Arg(1000);
+
+static void BM_MidoriCullTileIndex(benchmark::State& state) {
+  const auto layers = static_cast<Midori::Layer>(state.range(0));
+  Midori::TileIndex index;
+  eastl::vector<Midori::Tile> tiles_unassigned;
+  Midori::Tile tile_last = 0;
+
+  const auto load = [&](const Midori::Layer layer, const glm::ivec2 pos) {
+    Midori::Tile tile = 0;
+    if (tiles_unassigned.empty()) {
+      tile = ++tile_last;
+    } else {
+      tile = tiles_unassigned.back();
+      tiles_unassigned.pop_back();
+    }
+    index.Insert(tile, Midori::TileCoord{.layer = layer, .pos = pos});
+  };
+
+  glm::ivec2 view = glm::ivec2(4, 4);
+  for (Midori::Layer layer = 1; layer <= layers; layer++) {
+    index.AddLayer(layer);
+    for (int y = 0; y < MIDORI_CULL_SAVED; y++) {
+      for (int x = 0; x < MIDORI_CULL_SAVED; x++) {
+        index.SetSaved(layer, glm::ivec2(x, y), true);
+      }
+    }
+    for (const auto& pos : MidoriCullVisibleTiles(view)) {
+      load(layer, pos);
+    }
+  }
+
+  int step = 1;
+  eastl::vector<Midori::Tile> unload;
+  eastl::vector<glm::ivec2> to_load;
+  for (auto _ : state) {
+    view.x += step;
+    step = view.x == 20 || view.x == 4 ? -step : step;
+    const auto visible = MidoriCullVisibleTiles(view);
+    glm::ivec2 visible_min = visible.front();
+    glm::ivec2 visible_max = visible.front();
+    for (const auto& pos : visible) {
+      visible_min = glm::min(visible_min, pos);
+      visible_max = glm::max(visible_max, pos);
+    }
+
+    for (Midori::Layer layer = 1; layer <= layers; layer++) {
+      unload.clear();
+      for (const auto& tile : index.LayerTiles(layer)) {
+        if (!MidoriCullVisible(index.Coord(tile).pos, view)) {
+          unload.push_back(tile);
+        }
+      }
+      for (const auto& tile : unload) {
+        index.Erase(tile);
+        tiles_unassigned.push_back(tile);
+      }
+      to_load.clear();
+      index.ForEachSlot(layer, visible_min, visible_max + 1,
+                        [&](const glm::ivec2 pos, const Midori::TileIndex::Slot& slot) {
+                          if (slot.saved && slot.tile == Midori::TILE_INVALID && MidoriCullVisible(pos, view)) {
+                            to_load.push_back(pos);
+                          }
+                        });
+      for (const auto& pos : to_load) {
+        load(layer, pos);
+      }
+    }
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * layers);
+}
+BENCHMARK(BM_MidoriCullTileIndex)->Arg(10)->Arg(100)->Arg(1000);
+
+// End of a stroke: the stroke layer is merged into the selected layer. The GPU can't run here, the merge is done with
+// the CPU reference of merge.comp. The command buffers the renderer submits for it show as "merge submits" in the
+// debug window.
+
+static void BM_MidoriMergeStrokeEnd(benchmark::State& state) {
+  const auto tiles = static_cast<size_t>(state.range(0));
+  eastl::vector<eastl::vector<uint8_t>> over;
+  eastl::vector<eastl::vector<uint8_t>> below;
+  for (size_t i = 0; i < tiles; i++) {
+    over.push_back(MidoriSyntheticTile(static_cast<uint32_t>(i)));
+    below.push_back(MidoriSyntheticTile(static_cast<uint32_t>(i + tiles)));
+  }
+
+  for (auto _ : state) {
+    for (size_t i = 0; i < tiles; i++) {
+      Midori::MergePixels(over[i].data(), 0.8f, below[i].data(), Midori::TILE_WIDTH * Midori::TILE_HEIGHT);
+    }
+    benchmark::DoNotOptimize(below.data());
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * tiles));
+}
+BENCHMARK(BM_MidoriMergeStrokeEnd)->Arg(16)->Arg(64)->Arg(256);
+
+// Gathering the tile instances of a frame, `layers` layers with a 20x12 view of loaded tiles each. Counts the draw calls
+// the frame records, it used to be one per tile.
+
+static void BM_MidoriTileInstances(benchmark::State& state) {
+  constexpr glm::ivec2 view = {20, 12};
+  const auto layers = static_cast<Midori::Layer>(state.range(0));
+
+  Midori::TileIndex index;
+  Midori::TileAtlas atlas;
+  Midori::Tile tile = 0;
+  for (Midori::Layer layer = 1; layer <= layers; layer++) {
+    index.AddLayer(layer);
+  }
+  // Loaded in view order, like the canvas does when scrolling, so the layers share pages
+  for (int y = 0; y < view.y; y++) {
+    for (int x = 0; x < view.x; x++) {
+      for (Midori::Layer layer = 1; layer <= layers; layer++) {
+        index.Insert(tile, {.layer = layer, .pos = {x, y}});
+        atlas.Allocate(tile, layer);
+        tile++;
+      }
+    }
+  }
+
+  Midori::TileInstanceBatch batch;
+  for (auto _ : state) {
+    batch.Begin(atlas.PageCount());
+    for (Midori::Layer layer = 1; layer <= layers; layer++) {
+      batch.BeginLayer(layer);
+      for (const auto loaded : index.LayerTiles(layer)) {
+        const auto slot = atlas.At(loaded);
+        batch.Add(slot.page, slot.slice, index.Coord(loaded).pos);
+      }
+      batch.EndLayer();
+    }
+    benchmark::DoNotOptimize(batch.Instances().data());
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * tile));
+  state.counters["draws_per_frame"] = static_cast<double>(batch.Draws().size());
+  state.counters["tiles_per_frame"] = static_cast<double>(tile);
+}
+BENCHMARK(BM_MidoriTileInstances)->Arg(1)->Arg(10)->Arg(40);
+
+// A frame of a painting scene, without a GPU: the CPU records for ~400us and the "GPU" thread runs each submitted frame
+// for ~500us, both with a spike every 16 frames (a batch of tile uploads, a full composite). The CPU only waits for the
+// frame `frames_in_flight` submits ago, like Renderer::BeginFrameInFlight, 1 is the old wait after every submit.
+
+static void MidoriSpin(std::chrono::microseconds duration) {
+  const auto end = std::chrono::steady_clock::now() + duration;
+  while (std::chrono::steady_clock::now() < end) {
+  }
+}
+
+static void BM_MidoriFramesInFlight(benchmark::State& state) {
+  const auto frames_in_flight = static_cast<uint64_t>(state.range(0));
+
+  std::mutex mutex;
+  std::condition_variable submitted_cv;
+  std::condition_variable completed_cv;
+  uint64_t submitted = 0;
+  uint64_t completed = 0;
+  bool quit = false;
+
+  std::thread gpu([&] {
+    for (uint64_t frame = 0;; frame++) {
+      {
+        std::unique_lock lock(mutex);
+        submitted_cv.wait(lock, [&] { return quit || submitted > frame; });
+        if (submitted <= frame) {
+          return;
+        }
+      }
+      // Sleeps, the GPU doesn't take CPU time
+      std::this_thread::sleep_for(std::chrono::microseconds(frame % 16 == 8 ? 1500 : 500));
+      {
+        std::lock_guard lock(mutex);
+        completed = frame + 1;
+      }
+      completed_cv.notify_one();
+    }
+  });
+
+  Midori::FrameTimes times;
+  uint64_t frame = 0;
+  auto last = std::chrono::steady_clock::now();
+  for (auto _ : state) {
+    { // Fence of the slot about to be reused
+      std::unique_lock lock(mutex);
+      completed_cv.wait(lock, [&] { return frame < frames_in_flight || completed >= frame + 1 - frames_in_flight; });
+    }
+    MidoriSpin(std::chrono::microseconds(frame % 16 == 0 ? 1500 : 400));
+    {
+      std::lock_guard lock(mutex);
+      submitted = ++frame;
+    }
+    submitted_cv.notify_one();
+
+    const auto now = std::chrono::steady_clock::now();
+    times.Add(std::chrono::duration<float, std::milli>(now - last).count());
+    last = now;
+  }
+
+  {
+    std::lock_guard lock(mutex);
+    quit = true;
+  }
+  submitted_cv.notify_one();
+  gpu.join();
+
+  state.counters["p50_ms"] = times.Percentile(0.5f);
+  state.counters["p95_ms"] = times.Percentile(0.95f);
+  state.counters["p99_ms"] = times.Percentile(0.99f);
+}
+BENCHMARK(BM_MidoriFramesInFlight)->Arg(1)->Arg(2)->Arg(3)->Iterations(480)->UseRealTime();
+
+// Headless painting with the CPU backend: a stroke of `dabs` dabs going through a 4x4 block of tiles, painted with
+// `threads` job threads. Reports dabs and tiles per second, the GPU kernels can't run here.
+
+static Midori::BrushTip MidoriRoundTip(bool detect_round = true) {
+  constexpr int size = 128;
+  eastl::vector<uint8_t> rgba(size * size * 4);
+  for (int y = 0; y < size; y++) {
+    for (int x = 0; x < size; x++) {
+      const float dx = (static_cast<float>(x) + 0.5f) / size - 0.5f;
+      const float dy = (static_cast<float>(y) + 0.5f) / size - 0.5f;
+      const float alpha = std::max(0.0f, 1.0f - 2.0f * std::sqrt(dx * dx + dy * dy));
+      std::fill_n(rgba.begin() + (y * size + x) * 4, 4, static_cast<uint8_t>(alpha * 255.0f));
+    }
+  }
+  return {rgba.data(), size, size, detect_round};
+}
+
+static eastl::vector<Midori::StrokePoint> MidoriStroke(size_t dabs, float radius) {
+  eastl::vector<Midori::StrokePoint> points;
+  for (size_t i = 0; i < dabs; i++) {
+    const float t = static_cast<float>(i) / static_cast<float>(dabs);
+    Midori::StrokePoint point;
+    point.color = {0.1f, 0.5f, 0.9f, 1.0f};
+    // A wave across the block
+    point.position = {t * 4.0f * Midori::TILE_WIDTH, (2.0f + std::sin(t * 12.0f) * 1.5f) * Midori::TILE_HEIGHT};
+    point.radius = radius;
+    point.flow = 0.2f;
+    point.hardness = 0.6f;
+    points.push_back(point);
+  }
+  return points;
+}
+
+static void BM_MidoriCpuPaint(benchmark::State& state) {
+  const auto threads = static_cast<size_t>(state.range(0));
+  const auto dabs = static_cast<size_t>(state.range(1));
+  Midori::JobSystem jobs(threads);
+  Midori::CpuPaintBackend backend(jobs, MidoriRoundTip());
+
+  eastl::vector<Midori::Tile> tiles;
+  for (int y = 0; y < 4; y++) {
+    for (int x = 0; x < 4; x++) {
+      const auto tile = static_cast<Midori::Tile>(tiles.size() + 1);
+      backend.CreateTile(tile, {.layer = 1, .pos = {x, y}});
+      tiles.push_back(tile);
+    }
+  }
+  const auto points = MidoriStroke(dabs, 32.0f);
+
+  for (auto _ : state) {
+    backend.PaintTiles(tiles, points, Midori::PaintMode::Paint);
+    // A new stroke layer, painting stops on opaque pixels and the wet tiles go with the old one
+    state.PauseTiming();
+    for (size_t i = 0; i < tiles.size(); i++) {
+      backend.ReleaseTile(tiles[i]);
+      backend.CreateTile(tiles[i], {.layer = 1, .pos = {static_cast<int>(i % 4), static_cast<int>(i / 4)}});
+    }
+    state.ResumeTiming();
+  }
+  state.counters["dabs_per_second"] =
+      benchmark::Counter(static_cast<double>(state.iterations() * dabs), benchmark::Counter::kIsRate);
+  state.counters["tiles_per_second"] =
+      benchmark::Counter(static_cast<double>(state.iterations() * tiles.size()), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_MidoriCpuPaint)->ArgsProduct({{1, 2, 4}, {256, 2048}})->UseRealTime();
+
+// One thread painting a tile, 0: texture path, 1: falloffs of the round tip
+static void BM_MidoriPaintDabs(benchmark::State& state) {
+  const bool round = state.range(0) != 0;
+  const auto tip = MidoriRoundTip(round);
+  const auto points = MidoriStroke(512, 32.0f);
+  eastl::vector<uint8_t> pixels(Midori::TILE_WIDTH * Midori::TILE_HEIGHT * 4);
+
+  for (auto _ : state) {
+    std::fill(pixels.begin(), pixels.end(), 0);
+    Midori::PaintPixels(Midori::PaintMode::Paint, points.data(), points.size(), tip, {1, 2}, pixels.data());
+    benchmark::DoNotOptimize(pixels.data());
+  }
+  state.SetLabel(tip.Round() ? "falloffs" : "texture");
+  state.counters["dabs_per_second"] =
+      benchmark::Counter(static_cast<double>(state.iterations() * points.size()), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_MidoriPaintDabs)->Arg(0)->Arg(1);
+
+// A stroke painted on a tile a few dabs per frame. 0: RGBA8 rounded after every dab, the load and store per dab of the
+// shaders before they kept the pixels in registers. n: a wet tile painted n dabs at a time.
+static void BM_MidoriPaintWet(benchmark::State& state) {
+  const auto frame_dabs = static_cast<size_t>(state.range(0));
+  const auto tip = MidoriRoundTip();
+  const auto points = MidoriStroke(512, 32.0f);
+  eastl::vector<uint8_t> pixels(Midori::TILE_WIDTH * Midori::TILE_HEIGHT * 4);
+  eastl::vector<float> wet(Midori::WET_TILE_SIZE);
+
+  for (auto _ : state) {
+    std::fill(pixels.begin(), pixels.end(), 0);
+    if (frame_dabs == 0) {
+      for (const auto& point : points) {
+        Midori::PaintPixels(Midori::PaintMode::Paint, &point, 1, tip, {1, 2}, pixels.data());
+      }
+    } else {
+      std::fill(wet.begin(), wet.end(), 0.0f);
+      for (size_t first = 0; first < points.size(); first += frame_dabs) {
+        const size_t count = std::min(frame_dabs, points.size() - first);
+        Midori::PaintPixels(Midori::PaintMode::Paint, points.data() + first, count, tip, {1, 2}, wet.data(),
+                            pixels.data());
+      }
+    }
+    benchmark::DoNotOptimize(pixels.data());
+  }
+  state.SetLabel(frame_dabs == 0 ? "rgba8 per dab" : "wet");
+  state.counters["dabs_per_second"] =
+      benchmark::Counter(static_cast<double>(state.iterations() * points.size()), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_MidoriPaintWet)->Arg(0)->Arg(8)->Arg(64);
+
+static void BM_MidoriStrokeBins(benchmark::State& state) {
+  const auto dabs = static_cast<size_t>(state.range(0));
+  eastl::vector<glm::ivec2> positions;
+  for (int y = 0; y < 4; y++) {
+    for (int x = 0; x < 4; x++) {
+      positions.emplace_back(x, y);
+    }
+  }
+  const auto points = MidoriStroke(dabs, 32.0f);
+
+  Midori::StrokeBins bins;
+  for (auto _ : state) {
+    bins.Build(positions.data(), positions.size(), points.data(), points.size());
+    benchmark::DoNotOptimize(bins.Indices().data());
+  }
+
+  // Distance tests of the paint shader for the stroke: every pixel against every dab before, now every pixel against
+  // the dabs of its 32x32 block plus a test per dab of the tile for each block
+  constexpr int block = Midori::StrokeBins::BLOCK_SIZE;
+  constexpr double block_pixels = block * block;
+  double binned_tests = 0.0;
+  for (size_t tile = 0; tile < positions.size(); tile++) {
+    const auto origin = positions[tile] * glm::ivec2(Midori::TILE_WIDTH, Midori::TILE_HEIGHT);
+    for (int y = 0; y < static_cast<int>(Midori::TILE_HEIGHT); y += block) {
+      for (int x = 0; x < static_cast<int>(Midori::TILE_WIDTH); x += block) {
+        const glm::vec2 min(origin + glm::ivec2(x, y));
+        const glm::vec2 max(min.x + block - 1, min.y + block - 1);
+        for (std::uint32_t i = 0; i < bins.Count(tile); i++) {
+          const auto dab = bins.Indices()[bins.Offset(tile) + i];
+          binned_tests += Midori::StrokeBins::DabTouches(points[dab], min, max) ? block_pixels + 1.0 : 1.0;
+        }
+      }
+    }
+  }
+  const double all_tests = static_cast<double>(positions.size() * Midori::TILE_WIDTH * Midori::TILE_HEIGHT * dabs);
+  state.counters["dabs_per_second"] =
+      benchmark::Counter(static_cast<double>(state.iterations() * dabs), benchmark::Counter::kIsRate);
+  state.counters["dabs_per_tile"] =
+      static_cast<double>(bins.Indices().size()) / static_cast<double>(positions.size());
+  state.counters["shader_tests_saved"] = 1.0 - (binned_tests / all_tests);
+}
+BENCHMARK(BM_MidoriStrokeBins)->Arg(256)->Arg(2048)->Arg(16384);
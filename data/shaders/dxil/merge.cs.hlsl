@@ -1,4 +1,5 @@
-Texture2D<float4> src_tex : register(t0, space0);
+// Tiles are slices of a page, layer textures have a single slice
+Texture2DArray<float4> src_tex : register(t0, space0);
 SamplerState pointSampler : register(s0, space0);
 
 RWTexture2D<float4> dst_tex : register(u0, space1);
@@ -12,16 +13,22 @@ cbuffer MergeCB : register(b0, space2) {
     uint   dst_blend_mode;
     int2   dst_pos;
     int2   dst_size;
+    uint   src_layer;
 };
 
 [numthreads(32, 32, 1)]
 void main(uint3 dispatchThreadID : SV_DispatchThreadID) {
-    int2 coord = (int2)dispatchThreadID.xy;
+    // Only the region is dispatched
+    int2 id = (int2)dispatchThreadID.xy;
+    if (any(id >= dst_size)) {
+        return;
+    }
+    int2 coord = dst_pos + id;
 
     float4 dstColor = dst_tex[coord];
     // dstColor *= dst_opacity;
 
-    float4 srcColor = src_tex.Load(int3(coord, 0));
+    float4 srcColor = src_tex.Load(int4(src_start + id, src_layer, 0));
     // srcColor *= src_opacity;
 
     dstColor.rgb = srcColor.rgb + dstColor.rgb * (1.0 - srcColor.a);
@@ -13,11 +13,17 @@ struct StrokePointData {
     float pad2;
 };
 StructuredBuffer<StrokePointData> stroke_points : register(t1, space0);
+StructuredBuffer<uint> dab_indices : register(t2, space0);
+StructuredBuffer<float> falloffs : register(t3, space0);
 
 RWTexture2D<float4> tile_tex : register(u0, space1);
+// The stroke in float until it ends, see WET_TILE_SIZE in src/blend.h. tile_tex is its RGBA8 copy for display.
+RWTexture2D<float4> wet_tex : register(u1, space1);
 
 cbuffer StrokeCB : register(b0, space2) {
-    uint stroke_points_num;
+    uint dab_offset; // First dab of the tile in dab_indices, see src/stroke_bins.h
+    uint dab_count;
+    uint round_tip; // BrushTip::Round()
 };
 
 cbuffer TileCB : register(b1, space2) {
@@ -25,44 +31,129 @@ cbuffer TileCB : register(b1, space2) {
     float2 tile_size;
 };
 
+// The dabs of the tile are binned again for the 32x32 block of the group, a chunk at a time. A slot holds its dab or
+// NO_DAB so the pixels still go through the dabs in stroke order. Same test as StrokeBins::DabTouches.
+static const uint GROUP_SIZE = 32 * 32;
+static const uint NO_DAB = 0xFFFFFFFF;
+groupshared uint group_dabs[GROUP_SIZE];
+groupshared uint group_dabs_num;
+
+bool DabTouches(uint i, float2 block_min, float2 block_max) {
+    float2 d = stroke_points[i].position - clamp(stroke_points[i].position, block_min, block_max);
+    float reach = stroke_points[i].radius + 1.0;
+    return dot(d, d) <= reach * reach;
+}
+
+// Round tips read their mask from the falloffs of the tip instead of tex_alpha, see BrushTip in src/blend.h. The row of
+// a dab is worked out once per group.
+static const uint FALLOFF_SIZE = 256;
+static const uint FALLOFF_ROWS = 32;
+static const float MIN_EDGE = 0.01;
+groupshared float group_falloff_rows[GROUP_SIZE];
+
+float FalloffRow(float hardness) {
+    float edge = max(MIN_EDGE, 1.0 - hardness);
+    return log(edge) / log(MIN_EDGE) * float(FALLOFF_ROWS - 1);
+}
+
+float Falloff(float row, float distance2) {
+    uint row0 = min((uint)row, FALLOFF_ROWS - 2);
+    float x = saturate(distance2) * float(FALLOFF_SIZE - 1);
+    uint i = min((uint)x, FALLOFF_SIZE - 2);
+    uint top = row0 * FALLOFF_SIZE + i;
+    uint bottom = top + FALLOFF_SIZE;
+    float fx = x - float(i);
+    return lerp(lerp(falloffs[top], falloffs[top + 1], fx), lerp(falloffs[bottom], falloffs[bottom + 1], fx),
+                row - float(row0));
+}
+
 [numthreads(32, 32, 1)]
-void main(uint3 dispatchThreadID : SV_DispatchThreadID) {
+void main(uint3 dispatchThreadID : SV_DispatchThreadID, uint3 groupID : SV_GroupID, uint groupIndex : SV_GroupIndex) {
     int2 tex_coord = (int2)dispatchThreadID.xy;
 
     float2 tile_position = tile_pos * tile_size + (float2)tex_coord;
 
-    for (uint i = 0; i < stroke_points_num; i++) {
-        float d = distance(tile_position, stroke_points[i].position);
-        if (d > stroke_points[i].radius) {
-            continue;
+    float2 block_min = tile_pos * tile_size + (float2)(groupID.xy * 32);
+    float2 block_max = block_min + 31.0.xx;
+
+    // The pixel stays in registers while the dabs are blended, it is loaded and stored once per dispatch
+    float4 dstColor = wet_tex[tex_coord];
+    bool painted = false;
+
+    for (uint chunk = 0; chunk < dab_count; chunk += GROUP_SIZE) {
+        if (groupIndex == 0) {
+            group_dabs_num = 0;
         }
+        GroupMemoryBarrierWithGroupSync();
+        uint slot = chunk + groupIndex;
+        uint dab = NO_DAB;
+        if (slot < dab_count) {
+            dab = dab_indices[dab_offset + slot];
+            if (DabTouches(dab, block_min, block_max)) {
+                InterlockedAdd(group_dabs_num, 1);
+            } else {
+                dab = NO_DAB;
+            }
+        }
+        group_dabs[groupIndex] = dab;
+        if (dab != NO_DAB && round_tip != 0) {
+            group_falloff_rows[groupIndex] = FalloffRow(stroke_points[dab].hardness);
+        }
+        GroupMemoryBarrierWithGroupSync();
 
-        float2 brushAlphaUV = (tile_position - stroke_points[i].position) / (2.0 * stroke_points[i].radius) + 0.5.xx;
-        float mask = tex_alpha.SampleLevel(linearSampler, brushAlphaUV, 0).r;
+        uint chunk_size = group_dabs_num == 0 ? 0 : min(GROUP_SIZE, dab_count - chunk);
+        for (uint k = 0; k < chunk_size; k++) {
+            uint i = group_dabs[k];
+            if (i == NO_DAB) {
+                continue;
+            }
+            float2 delta = tile_position - stroke_points[i].position;
+            float distance2 = dot(delta, delta);
+            float radius2 = stroke_points[i].radius * stroke_points[i].radius;
+            float mask;
+            if (round_tip != 0) {
+                if (distance2 > radius2) {
+                    continue;
+                }
+                mask = Falloff(group_falloff_rows[k], distance2 / radius2);
+            } else {
+                if (sqrt(distance2) > stroke_points[i].radius) {
+                    continue;
+                }
 
-        mask = saturate(smoothstep(0.0, max(0.01, 1.0 - stroke_points[i].hardness), mask));
+                float2 brushAlphaUV = delta / (2.0 * stroke_points[i].radius) + 0.5.xx;
+                mask = tex_alpha.SampleLevel(linearSampler, brushAlphaUV, 0).r;
 
-        float4 dstColor = tile_tex[tex_coord];
-        if(dstColor.a == 1) {
-            continue;
-        }
+                mask = saturate(smoothstep(0.0, max(0.01, 1.0 - stroke_points[i].hardness), mask));
+            }
 
-        float4 srcColor = stroke_points[i].color;
+            if(dstColor.a == 1) {
+                continue;
+            }
 
-        float alpha = stroke_points[i].flow;
-        alpha *= mask;
-        if(alpha == 0) {
-            continue;
-        }
+            float4 srcColor = stroke_points[i].color;
 
-        alpha = (dstColor.a - min(stroke_points[i].color.a, alpha + dstColor.a * (1.0 - alpha))) / (dstColor.a - 1.0);
-        if(alpha <= 0) {
-            continue;
+            float alpha = stroke_points[i].flow;
+            alpha *= mask;
+            if(alpha == 0) {
+                continue;
+            }
+
+            alpha = (dstColor.a - min(stroke_points[i].color.a, alpha + dstColor.a * (1.0 - alpha))) / (dstColor.a - 1.0);
+            if(alpha <= 0) {
+                continue;
+            }
+
+            dstColor.rgb = (srcColor.rgb * alpha) + dstColor.rgb * (1.0 - alpha);
+            dstColor.a = alpha + dstColor.a * (1.0 - alpha);
+            painted = true;
         }
+        // group_dabs is filled again by the next chunk
+        GroupMemoryBarrierWithGroupSync();
+    }
 
-        dstColor.rgb = (srcColor.rgb * alpha) + dstColor.rgb * (1.0 - alpha);
-        dstColor.a = alpha + dstColor.a * (1.0 - alpha);
-        
+    if (painted) {
+        wet_tex[tex_coord] = dstColor;
         tile_tex[tex_coord] = dstColor;
     }
 }
\ No newline at end of file
@@ -0,0 +1,88 @@
+// Flags of a tile before it is saved: empty, uniform and a content hash, so the CPU only downloads the tiles it has to
+// write. src/tile_reduce.cpp is the CPU reference of this shader, both must give the same result for the same tile.
+// One group per tile, every thread takes a strided part of the pixels and the group sums them in shared memory.
+
+Texture2DArray<float4> tile_page : register(t0, space0);
+SamplerState pointSampler : register(s0, space0);
+
+struct TileReduce {
+    uint flags;
+    uint color;
+    uint hash0;
+    uint hash1;
+};
+RWStructuredBuffer<TileReduce> results : register(u0, space1);
+
+cbuffer ReduceCB : register(b0, space2) {
+    uint tile_slice; // Slice of the page
+    uint result_index;
+};
+
+static const uint TILE_SIZE = 256;
+static const uint THREADS = 256;
+static const uint EMPTY = 1;
+static const uint UNIFORM = 2;
+
+groupshared uint group_bits;
+groupshared uint group_differ;
+groupshared uint group_hash0;
+groupshared uint group_hash1;
+
+uint Mix(uint h) {
+    h ^= h >> 16;
+    h *= 0x85EBCA6Bu;
+    h ^= h >> 13;
+    h *= 0xC2B2AE35u;
+    h ^= h >> 16;
+    return h;
+}
+
+uint LoadPixel(uint index) {
+    // RGBA8 unorm, the bytes are recovered exactly
+    uint4 c = (uint4)round(saturate(tile_page.Load(int4(index % TILE_SIZE, index / TILE_SIZE, tile_slice, 0))) * 255.0);
+    return c.r | (c.g << 8) | (c.b << 16) | (c.a << 24);
+}
+
+[numthreads(256, 1, 1)]
+void main(uint thread : SV_GroupIndex) {
+    if (thread == 0) {
+        group_bits = 0;
+        group_differ = 0;
+        group_hash0 = 0;
+        group_hash1 = 0;
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    const uint first = LoadPixel(0);
+    uint bits = 0;
+    uint differ = 0;
+    uint hash0 = 0;
+    uint hash1 = 0;
+    for (uint i = thread; i < TILE_SIZE * TILE_SIZE; i += THREADS) {
+        const uint pixel = LoadPixel(i);
+        bits |= pixel;
+        differ |= pixel != first ? 1u : 0u;
+        hash0 += Mix(pixel ^ (i * 0x9E3779B9u));
+        hash1 += Mix(pixel + i * 0x27D4EB2Fu + 0x165667B1u);
+    }
+    InterlockedOr(group_bits, bits);
+    InterlockedOr(group_differ, differ);
+    InterlockedAdd(group_hash0, hash0);
+    InterlockedAdd(group_hash1, hash1);
+    GroupMemoryBarrierWithGroupSync();
+
+    if (thread == 0) {
+        TileReduce reduce;
+        reduce.flags = 0;
+        if ((group_bits & 0xFEFEFEFEu) == 0) {
+            reduce.flags |= EMPTY;
+        }
+        if (group_differ == 0) {
+            reduce.flags |= UNIFORM;
+        }
+        reduce.color = first;
+        reduce.hash0 = group_hash0;
+        reduce.hash1 = group_hash1;
+        results[result_index] = reduce;
+    }
+}
@@ -1,12 +1,13 @@
 struct PSInput {
     float4 position : SV_POSITION;
     float2 uv : TEXCOORD0;
+    nointerpolation uint slice : TEXCOORD1;
 };
 
-Texture2D<float4> tile_texture : register(t0, space2);
+Texture2DArray<float4> tile_texture : register(t0, space2);
 SamplerState linearSampler : register(s0, space2);
 
 float4 main(PSInput input) : SV_Target0 {
-    float4 color = tile_texture.Sample(linearSampler, input.uv);
+    float4 color = tile_texture.Sample(linearSampler, float3(input.uv, input.slice));
     return color;
-}
\ No newline at end of file
+}
@@ -4,14 +4,22 @@ cbuffer ViewportCB : register(b0, space1) {
     float4x4 view;
 };
 
-cbuffer TileCB : register(b1, space1) {
+cbuffer TileDrawCB : register(b1, space1) {
+    uint instance_offset;
+    float size;
+};
+
+struct TileInstance {
     float2 position;
-    float2 size;
+    uint slice;
+    uint pad0;
 };
+StructuredBuffer<TileInstance> instances : register(t0, space0);
 
 struct VSOutput {
     float4 position : SV_POSITION;
     float2 uv : TEXCOORD0;
+    nointerpolation uint slice : TEXCOORD1;
 };
 
 static const float2 vertices[4] = {
@@ -28,15 +36,17 @@ static const float2 uvs[4] = {
     float2(1.0, 0.0)
 };
 
-VSOutput main(uint vertexID : SV_VertexID) {
+VSOutput main(uint vertexID : SV_VertexID, uint instanceID : SV_InstanceID) {
     VSOutput output;
 
+    TileInstance instance = instances[instance_offset + instanceID];
     float2 localPos = vertices[vertexID];
-    float2 worldPos = (localPos + position) * size;
+    float2 worldPos = (localPos + instance.position) * size;
     float4 clipPos = mul(proj, mul(view, float4(worldPos, 0.0, 1.0)));
 
     output.position = clipPos;
     output.uv = uvs[vertexID];
+    output.slice = instance.slice;
 
     return output;
-}
\ No newline at end of file
+}
@@ -35,17 +35,24 @@ layout(set = 2, binding = 0) uniform Merge {
     uint dst_blend_mode;
     ivec2 dst_pos;
     ivec2 dst_size;
+    uint src_layer;
 };
 
-layout(set = 0, binding = 0) uniform sampler2D src_tex;
+// Tiles are slices of a page, layer textures have a single slice
+layout(set = 0, binding = 0) uniform sampler2DArray src_tex;
 layout(set = 1, binding = 0, rgba8) uniform image2D dst_tex;
 
 layout(local_size_x = 32, local_size_y = 32, local_size_z = 1) in;
 void main() {
-    const ivec2 coord = ivec2(gl_GlobalInvocationID.xy);
+    // Only the region is dispatched
+    const ivec2 id = ivec2(gl_GlobalInvocationID.xy);
+    if (any(greaterThanEqual(id, dst_size))) {
+        return;
+    }
+    const ivec2 coord = dst_pos + id;
 
     vec4 dstColor = imageLoad(dst_tex, coord);
-    vec4 srcColor = texelFetch(src_tex, coord, 0);
+    vec4 srcColor = texelFetch(src_tex, ivec3(src_start + id, src_layer), 0);
     srcColor *= src_opacity;
 
     dstColor.rgb = srcColor.rgb + dstColor.rgb * (1.0 - srcColor.a);
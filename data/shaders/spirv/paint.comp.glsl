@@ -5,7 +5,9 @@ layout(local_size_x = 32, local_size_y = 32, local_size_z = 1) in;
 
 
 layout(set = 2, binding = 0) uniform Stroke {
-    uint stroke_points_num;
+    uint dab_offset; // First dab of the tile in dab_indices, see src/stroke_bins.h
+    uint dab_count;
+    uint round_tip; // BrushTip::Round()
 };
 
 layout(set = 2, binding = 1) uniform Tile {
@@ -30,7 +32,53 @@ layout(std430, set = 0, binding = 1) readonly buffer StrokePointsBuffer {
     StrokePointData stroke_points[];
 };
 
+layout(std430, set = 0, binding = 2) readonly buffer DabIndicesBuffer {
+    uint dab_indices[];
+};
+
+layout(std430, set = 0, binding = 3) readonly buffer FalloffsBuffer {
+    float falloffs[];
+};
+
 layout(set = 1, binding = 0, rgba8) uniform image2D tile_tex;
+// The stroke in float until it ends, see WET_TILE_SIZE in src/blend.h. tile_tex is its RGBA8 copy for display.
+layout(set = 1, binding = 1, rgba16f) uniform image2D wet_tex;
+
+// The dabs of the tile are binned again for the 32x32 block of the group, a chunk at a time. A slot holds its dab or
+// NO_DAB so the pixels still go through the dabs in stroke order. Same test as StrokeBins::DabTouches.
+const uint GROUP_SIZE = 32 * 32;
+const uint NO_DAB = 0xFFFFFFFFu;
+shared uint group_dabs[GROUP_SIZE];
+shared uint group_dabs_num;
+
+bool DabTouches(uint i, vec2 block_min, vec2 block_max) {
+    const vec2 d = stroke_points[i].position - clamp(stroke_points[i].position, block_min, block_max);
+    const float reach = stroke_points[i].radius + 1.0;
+    return dot(d, d) <= reach * reach;
+}
+
+// Round tips read their mask from the falloffs of the tip instead of tex_alpha, see BrushTip in src/blend.h. The row of
+// a dab is worked out once per group.
+const uint FALLOFF_SIZE = 256;
+const uint FALLOFF_ROWS = 32;
+const float MIN_EDGE = 0.01;
+shared float group_falloff_rows[GROUP_SIZE];
+
+float FalloffRow(float hardness) {
+    const float edge = max(MIN_EDGE, 1.0 - hardness);
+    return log(edge) / log(MIN_EDGE) * float(FALLOFF_ROWS - 1);
+}
+
+float Falloff(float row, float distance2) {
+    const uint row0 = min(uint(row), FALLOFF_ROWS - 2);
+    const float x = clamp(distance2, 0.0, 1.0) * float(FALLOFF_SIZE - 1);
+    const uint i = min(uint(x), FALLOFF_SIZE - 2);
+    const uint top = row0 * FALLOFF_SIZE + i;
+    const uint bottom = top + FALLOFF_SIZE;
+    const float fx = x - float(i);
+    return mix(mix(falloffs[top], falloffs[top + 1], fx), mix(falloffs[bottom], falloffs[bottom + 1], fx),
+               row - float(row0));
+}
 
 vec3 sRGBToLinear(vec3 rgb) {
   // See https://gamedev.stackexchange.com/questions/92015/optimized-linear-to-srgb-glsl
@@ -44,37 +92,82 @@ void main() {
     ivec2 tex_coord = ivec2(gl_GlobalInvocationID.xy);
     const vec2 tile_position = vec2(tile_pos * tile_size) + vec2(tex_coord);
 
-    for(int i = 0; i < stroke_points_num; i++) {
-        const float d = distance(tile_position, stroke_points[i].position);
-        if(d <= stroke_points[i].radius) {
-            vec2 brushAlphaUV = (tile_position - stroke_points[i].position) / (2.0 * stroke_points[i].radius) + vec2(0.5);
-            float mask = texture(tex_alpha, brushAlphaUV).r;
-            mask = clamp(smoothstep(0.0, max(0.01, 1.0 - stroke_points[i].hardness), mask), 0.0, 1.0);
+    const vec2 block_min = vec2(tile_pos * tile_size) + vec2(gl_WorkGroupID.xy * gl_WorkGroupSize.xy);
+    const vec2 block_max = block_min + vec2(gl_WorkGroupSize.xy) - vec2(1.0);
 
+    // The pixel stays in registers while the dabs are blended, it is loaded and stored once per dispatch
+    vec4 dstColor = imageLoad(wet_tex, tex_coord);
+    bool painted = false;
 
-            vec4 dstColor = imageLoad(tile_tex, tex_coord);
-            if(dstColor.a == 1) {
-                continue;
+    for(uint chunk = 0; chunk < dab_count; chunk += GROUP_SIZE) {
+        if(gl_LocalInvocationIndex == 0) {
+            group_dabs_num = 0;
+        }
+        barrier();
+        const uint slot = chunk + gl_LocalInvocationIndex;
+        uint dab = NO_DAB;
+        if(slot < dab_count) {
+            dab = dab_indices[dab_offset + slot];
+            if(DabTouches(dab, block_min, block_max)) {
+                atomicAdd(group_dabs_num, 1);
+            } else {
+                dab = NO_DAB;
             }
+        }
+        group_dabs[gl_LocalInvocationIndex] = dab;
+        if(dab != NO_DAB && round_tip != 0) {
+            group_falloff_rows[gl_LocalInvocationIndex] = FalloffRow(stroke_points[dab].hardness);
+        }
+        barrier();
 
-            vec4 srcColor = stroke_points[i].color;
-            // srcColor.rgb = sRGBToLinear(srcColor.rgb);
-
-            float alpha = stroke_points[i].flow;
-            alpha *= mask;
-            if(alpha == 0) {
+        const uint chunk_size = group_dabs_num == 0 ? 0 : min(GROUP_SIZE, dab_count - chunk);
+        for(uint k = 0; k < chunk_size; k++) {
+            const uint i = group_dabs[k];
+            if(i == NO_DAB) {
                 continue;
             }
-
-            alpha = (dstColor.a - min(stroke_points[i].color.a, alpha + dstColor.a * (1.0 - alpha))) / (dstColor.a - 1.0);
-            if(alpha <= 0) {
-                continue;
+            const vec2 delta = tile_position - stroke_points[i].position;
+            const float distance2 = dot(delta, delta);
+            const float radius2 = stroke_points[i].radius * stroke_points[i].radius;
+            if(round_tip != 0 ? distance2 <= radius2 : sqrt(distance2) <= stroke_points[i].radius) {
+                float mask;
+                if(round_tip != 0) {
+                    mask = Falloff(group_falloff_rows[k], distance2 / radius2);
+                } else {
+                    vec2 brushAlphaUV = delta / (2.0 * stroke_points[i].radius) + vec2(0.5);
+                    mask = texture(tex_alpha, brushAlphaUV).r;
+                    mask = clamp(smoothstep(0.0, max(0.01, 1.0 - stroke_points[i].hardness), mask), 0.0, 1.0);
+                }
+
+                if(dstColor.a == 1) {
+                    continue;
+                }
+
+                vec4 srcColor = stroke_points[i].color;
+                // srcColor.rgb = sRGBToLinear(srcColor.rgb);
+
+                float alpha = stroke_points[i].flow;
+                alpha *= mask;
+                if(alpha == 0) {
+                    continue;
+                }
+
+                alpha = (dstColor.a - min(stroke_points[i].color.a, alpha + dstColor.a * (1.0 - alpha))) / (dstColor.a - 1.0);
+                if(alpha <= 0) {
+                    continue;
+                }
+
+                dstColor.rgb = (srcColor.rgb * alpha) + dstColor.rgb * (1.0 - alpha);
+                dstColor.a = alpha + dstColor.a * (1.0 - alpha);
+                painted = true;
             }
-
-            dstColor.rgb = (srcColor.rgb * alpha) + dstColor.rgb * (1.0 - alpha);
-            dstColor.a = alpha + dstColor.a * (1.0 - alpha);
-            
-            imageStore(tile_tex, tex_coord, dstColor);
         }
+        // group_dabs is filled again by the next chunk
+        barrier();
+    }
+
+    if(painted) {
+        imageStore(wet_tex, tex_coord, dstColor);
+        imageStore(tile_tex, tex_coord, dstColor);
     }
 }
@@ -0,0 +1,87 @@
+#version 460
+
+// Flags of a tile before it is saved: empty, uniform and a content hash, so the CPU only downloads the tiles it has to
+// write. src/tile_reduce.cpp is the CPU reference of this shader, both must give the same result for the same tile.
+// One group per tile, every thread takes a strided part of the pixels and the group sums them in shared memory.
+
+layout(set = 2, binding = 0) uniform Reduce {
+    uint tile_slice; // Slice of the page
+    uint result_index;
+};
+
+layout(set = 0, binding = 0) uniform sampler2DArray tile_page;
+
+struct TileReduce {
+    uint flags;
+    uint color;
+    uint hash0;
+    uint hash1;
+};
+layout(std430, set = 1, binding = 0) buffer Results {
+    TileReduce results[];
+};
+
+const uint TILE_SIZE = 256;
+const uint THREADS = 256;
+const uint EMPTY = 1;
+const uint UNIFORM = 2;
+
+shared uint group_bits;
+shared uint group_differ;
+shared uint group_hash0;
+shared uint group_hash1;
+
+uint Mix(uint h) {
+    h ^= h >> 16;
+    h *= 0x85EBCA6Bu;
+    h ^= h >> 13;
+    h *= 0xC2B2AE35u;
+    h ^= h >> 16;
+    return h;
+}
+
+uint LoadPixel(uint index) {
+    // RGBA8 unorm, the bytes are recovered exactly
+    return packUnorm4x8(texelFetch(tile_page, ivec3(index % TILE_SIZE, index / TILE_SIZE, tile_slice), 0));
+}
+
+layout(local_size_x = 256, local_size_y = 1, local_size_z = 1) in;
+void main() {
+    const uint thread = gl_LocalInvocationIndex;
+    if (thread == 0) {
+        group_bits = 0;
+        group_differ = 0;
+        group_hash0 = 0;
+        group_hash1 = 0;
+    }
+    barrier();
+
+    const uint first = LoadPixel(0);
+    uint bits = 0;
+    uint differ = 0;
+    uint hash0 = 0;
+    uint hash1 = 0;
+    for (uint i = thread; i < TILE_SIZE * TILE_SIZE; i += THREADS) {
+        const uint pixel = LoadPixel(i);
+        bits |= pixel;
+        differ |= pixel != first ? 1u : 0u;
+        hash0 += Mix(pixel ^ (i * 0x9E3779B9u));
+        hash1 += Mix(pixel + i * 0x27D4EB2Fu + 0x165667B1u);
+    }
+    atomicOr(group_bits, bits);
+    atomicOr(group_differ, differ);
+    atomicAdd(group_hash0, hash0);
+    atomicAdd(group_hash1, hash1);
+    barrier();
+
+    if (thread == 0) {
+        uint flags = 0;
+        if ((group_bits & 0xFEFEFEFEu) == 0) {
+            flags |= EMPTY;
+        }
+        if (group_differ == 0) {
+            flags |= UNIFORM;
+        }
+        results[result_index] = TileReduce(flags, first, group_hash0, group_hash1);
+    }
+}
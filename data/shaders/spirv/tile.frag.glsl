@@ -3,9 +3,10 @@
 layout(location = 0) out vec4 out_color;
 
 layout(location = 0) in vec2 in_uv;
+layout(location = 1) flat in uint in_slice;
 
-layout(set = 2, binding = 0) uniform sampler2D tile_sampler;
+layout(set = 2, binding = 0) uniform sampler2DArray tile_sampler;
 
 void main() {
-    out_color = texture(tile_sampler, in_uv);
+    out_color = texture(tile_sampler, vec3(in_uv, float(in_slice)));
 }
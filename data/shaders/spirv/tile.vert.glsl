@@ -1,15 +1,26 @@
 #version 460
 
 layout(location = 0) out vec2 out_uv;
+layout(location = 1) flat out uint out_slice;
 
 layout(set = 1, binding = 0) uniform Viewport {
     mat4 proj;
     mat4 view;
 };
 
-layout(set = 1, binding = 1) uniform Tile {
+layout(set = 1, binding = 1) uniform TileDraw {
+    uint instance_offset;
+    float size;
+};
+
+struct TileInstance {
     vec2 position;
-    vec2 size;
+    uint slice;
+    uint pad0;
+};
+
+layout(std430, set = 0, binding = 0) readonly buffer TileInstances {
+    TileInstance instances[];
 };
 
 const vec2 vertices[4] = vec2[](
@@ -27,8 +38,10 @@ const vec2 uvs[4] = vec2[](
 );
 
 void main() {
-    vec2 pos = (vertices[gl_VertexIndex] + position) * size;
+    const TileInstance instance = instances[instance_offset + gl_InstanceIndex];
+    vec2 pos = (vertices[gl_VertexIndex] + instance.position) * size;
     out_uv = uvs[gl_VertexIndex];
+    out_slice = instance.slice;
 
     gl_Position = proj * view * vec4(pos, 0.0, 1.0);
 }
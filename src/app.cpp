@@ -51,6 +51,16 @@ bool App::Init() {
         SDL_LogCritical(SDL_LOG_CATEGORY_APPLICATION, "Failed to initialize renderer");
         return false;
     }
+    // The renderer paints on the GPU unless the CPU kernels are asked for
+    const char* paint_backend = SDL_getenv("MIDORI_PAINT_BACKEND");
+    if (std::ranges::find(args, "--cpu-paint") != args.end() ||
+        (paint_backend != nullptr && SDL_strcmp(paint_backend, "cpu") == 0)) {
+        cpuStrokeBackend = std::make_unique<CpuStrokeBackend>(this, renderer.brush_tip);
+        canvas.paintBackend = cpuStrokeBackend.get();
+        SDL_Log("Painting on the CPU");
+    } else {
+        canvas.paintBackend = &renderer;
+    }
 
     ui.Init();
 
@@ -135,8 +145,9 @@ void App::Update() {
             }
             ImGui::End();
 
-            if (ui_debug_culling && layer > 0) {
-                for (const auto& [pos, tile] : canvas.layerTilePos[layer]) {
+            if (ui_debug_culling && canvas.tileIndex.HasLayer(layer)) {
+                for (const auto& tile : canvas.tileIndex.LayerTiles(layer)) {
+                    const auto pos = canvas.tileIndex.Coord(tile).pos;
                     if (canvas.tile_read_queue.contains(tile)) {
                         ImU32 col = IM_COL32(255, 0, 0, 64);
                         const char* str{};
@@ -144,8 +155,8 @@ void App::Update() {
                         case Canvas::TileReadState::Queued:
                             DrawTileDebug(pos, draw_list, col, "TileReadState::Queued");
                             break;
-                        case Canvas::TileReadState::Read:
-                            DrawTileDebug(pos, draw_list, col, "TileReadState::Read");
+                        case Canvas::TileReadState::Reading:
+                            DrawTileDebug(pos, draw_list, col, "TileReadState::Reading");
                             break;
                         case Canvas::TileReadState::Decompressed:
                             DrawTileDebug(pos, draw_list, col, "TileReadState::Decompressed");
@@ -164,14 +175,20 @@ void App::Update() {
                         case Canvas::TileWriteState::Queued:
                             DrawTileDebug(pos, draw_list, col, "TileReadState::Queued");
                             break;
+                        case Canvas::TileWriteState::Reducing:
+                            DrawTileDebug(pos, draw_list, col, "TileReadState::Reducing");
+                            break;
+                        case Canvas::TileWriteState::Reduced:
+                            DrawTileDebug(pos, draw_list, col, "TileReadState::Reduced");
+                            break;
                         case Canvas::TileWriteState::Downloading:
                             DrawTileDebug(pos, draw_list, col, "TileReadState::Downloading");
                             break;
                         case Canvas::TileWriteState::Downloaded:
                             DrawTileDebug(pos, draw_list, col, "TileReadState::Downloaded");
                             break;
-                        case Canvas::TileWriteState::Encoded:
-                            DrawTileDebug(pos, draw_list, col, "TileReadState::Encoded");
+                        case Canvas::TileWriteState::Encoding:
+                            DrawTileDebug(pos, draw_list, col, "TileReadState::Encoding");
                             break;
                         case Canvas::TileWriteState::Written:
                             DrawTileDebug(pos, draw_list, col, "TileReadState::Written");
@@ -216,9 +233,64 @@ void App::Update() {
                         tileModified += canvas.layerTilesModified.at(la).size();
                     }
 
-                    ImGui::LabelText("tile loaded", "%zu", canvas.tileInfos.size());
-                    ImGui::LabelText("tile textures", "%zu", renderer.tile_textures.size());
+                    ImGui::LabelText("tile loaded", "%zu", canvas.tileIndex.Size());
+                    ImGui::LabelText("tile textures", "%zu in %zu pages", renderer.tile_atlas.Size(),
+                                     renderer.tile_pages.size());
+                    const auto& frame = renderer.last_frame_counters;
+                    ImGui::LabelText("tiles drawn", "%zu", renderer.last_rendered_tiles_num);
+                    ImGui::LabelText("layers redrawn", "%zu", renderer.last_layer_rendered_num);
+                    bool tile_compositing = renderer.composite_mode == Renderer::CompositeMode::Tiles;
+                    if (ImGui::Checkbox("tile compositing", &tile_compositing)) {
+                        renderer.SetCompositeMode(tile_compositing ? Renderer::CompositeMode::Tiles
+                                                                   : Renderer::CompositeMode::LayerTextures);
+                    }
+                    if (tile_compositing) {
+                        ImGui::LabelText("composite tiles", "%zu in %zu pages, %zu blended",
+                                         renderer.composite_tiles.Size(), renderer.composite_pages.size(),
+                                         renderer.last_composited_tiles_num);
+                    }
+                    ImGui::LabelText("draw calls", "%zu", frame.draws);
+                    ImGui::LabelText("dispatches", "%zu", frame.dispatches);
+                    ImGui::LabelText("passes", "%zu", frame.passes);
+                    ImGui::LabelText("transfers", "%zu up / %zu down", frame.uploads, frame.downloads);
+                    ImGui::LabelText("submits", "%zu", frame.submits);
+                    ImGui::LabelText("frame time", "p50 %.2fms / p95 %.2fms / p99 %.2fms",
+                                     renderer.frame_times.Percentile(0.5f), renderer.frame_times.Percentile(0.95f),
+                                     renderer.frame_times.Percentile(0.99f));
                     ImGui::LabelText("tile modified", "%zu", tileModified);
+                    ImGui::LabelText("tile downloads", "%.0f tiles/s, %.1f MB/s, %zu batches",
+                                     renderer.tile_download_stats.tiles_per_second,
+                                     renderer.tile_download_stats.mb_per_second,
+                                     renderer.tile_download_ring.BatchCount());
+                    ImGui::LabelText("tile downloads skipped", "%zu", canvas.tile_downloads_skipped);
+                    ImGui::LabelText("tile write failures", "%zu", canvas.tile_write_failures);
+                    ImGui::LabelText("merge submits", "%llu",
+                                     static_cast<unsigned long long>(renderer.merge_submits));
+                    ImGui::LabelText("paint backend", "%s", cpuStrokeBackend ? "cpu" : "gpu");
+
+                    int budget = static_cast<int>(canvas.tileResidency.Budget());
+                    if (ImGui::SliderInt("tile budget (MB)", &budget, 64, 8192)) {
+                        canvas.tileResidency.SetBudget(static_cast<size_t>(budget));
+                    }
+                    const auto& stats = canvas.tileResidency.stats;
+                    ImGui::LabelText("tile cold", "%zu", canvas.tileResidency.ColdCount());
+                    ImGui::LabelText("tile hits", "%llu", static_cast<unsigned long long>(stats.hits));
+                    ImGui::LabelText("tile misses", "%llu", static_cast<unsigned long long>(stats.misses));
+                    ImGui::LabelText("tile evictions", "%llu / %llu dirty",
+                                     static_cast<unsigned long long>(stats.evictions + stats.evictionsDirty),
+                                     static_cast<unsigned long long>(stats.evictionsDirty));
+
+                    auto& blobCache = canvas.tilePack.Cache();
+                    int blobBudget = static_cast<int>(blobCache.Budget());
+                    if (ImGui::SliderInt("blob cache budget (MB)", &blobBudget, 0, 2048)) {
+                        blobCache.SetBudget(static_cast<size_t>(blobBudget));
+                    }
+                    const auto blobStats = blobCache.GetStats();
+                    ImGui::LabelText("blob cache", "%zu blobs, %.1f MB", blobStats.count,
+                                     static_cast<double>(blobStats.bytes) / (1024.0 * 1024.0));
+                    ImGui::LabelText("blob cache hits", "%llu / %llu",
+                                     static_cast<unsigned long long>(blobStats.hits),
+                                     static_cast<unsigned long long>(blobStats.hits + blobStats.misses));
                 }
                 ImGui::End();
 
@@ -947,7 +1019,10 @@ void App::Save() {
 
     for (const auto& layer : canvas.Layers()) {
         for (const auto& tile : canvas.LayerTiles(layer)) {
-            canvas.QueueSaveTile(layer, tile);
+            // Tiles can still be in flight from a previous save
+            if (!canvas.tile_write_queue.contains(tile)) {
+                canvas.QueueSaveTile(layer, tile);
+            }
         }
     }
 
@@ -1,6 +1,8 @@
 ﻿#pragma once
 
 #include "canvas.h"
+#include "cpu_stroke_backend.h"
+#include "jobs.h"
 #include "renderer.h"
 #include "states.h"
 #include "ui.h"
@@ -9,6 +11,7 @@
 #include <glm/vec2.hpp>
 #include <glm/vec4.hpp>
 #include <imgui.h>
+#include <memory>
 #include <string>
 
 namespace Midori {
@@ -71,6 +74,8 @@ public:
     StateManager stateManager;
     Renderer renderer;
     Canvas canvas;
+    JobSystem jobs; // Declared after canvas so pending jobs finish before the canvas is destroyed
+    std::unique_ptr<CpuStrokeBackend> cpuStrokeBackend; // Only with --cpu-paint or MIDORI_PAINT_BACKEND=cpu
     UI ui;
 
     glm::vec4 bg_color = {1.0F, 1.0F, 1.0F, 1.0F};
@@ -0,0 +1,526 @@
+#include "blend.h"
+
+#include "tiles.h"
+#include <SDL3/SDL_assert.h>
+#include <algorithm>
+#include <cmath>
+#include <tracy/Tracy.hpp>
+
+#if !defined(MIDORI_BLEND_SCALAR) &&                                                                                   \
+    (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define MIDORI_BLEND_SSE2
+#endif
+
+namespace Midori {
+
+static constexpr float INV_255 = 1.0f / 255.0f;
+
+static std::uint8_t ToUnorm(const float value) {
+    return static_cast<std::uint8_t>((std::clamp(value, 0.0f, 1.0f) * 255.0f) + 0.5f);
+}
+
+#if defined(MIDORI_BLEND_SSE2)
+// Four pixels split in channels, from RGBA8 or from the planes of a wet tile
+struct Pixels4 {
+    __m128 r;
+    __m128 g;
+    __m128 b;
+    __m128 a;
+};
+
+static Pixels4 LoadPixels4(const __m128i pixels) {
+    const __m128i byte = _mm_set1_epi32(0xFF);
+    const __m128 scale = _mm_set1_ps(INV_255);
+    return Pixels4{
+        .r = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(pixels, byte)), scale),
+        .g = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(pixels, 8), byte)), scale),
+        .b = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(pixels, 16), byte)), scale),
+        .a = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(pixels, 24)), scale),
+    };
+}
+
+static __m128i ToUnorm4(const __m128 value) {
+    const __m128 clamped = _mm_min_ps(_mm_max_ps(value, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+    return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(clamped, _mm_set1_ps(255.0f)), _mm_set1_ps(0.5f)));
+}
+
+static __m128i StorePixels4(const Pixels4& pixels) {
+    return _mm_or_si128(_mm_or_si128(ToUnorm4(pixels.r), _mm_slli_epi32(ToUnorm4(pixels.g), 8)),
+                        _mm_or_si128(_mm_slli_epi32(ToUnorm4(pixels.b), 16), _mm_slli_epi32(ToUnorm4(pixels.a), 24)));
+}
+
+static __m128 Select(const __m128 mask, const __m128 a, const __m128 b) {
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+#endif
+
+void MergePixels(const std::uint8_t* over, const float over_opacity, std::uint8_t* below, const size_t pixel_count) {
+    size_t i = 0;
+#if defined(MIDORI_BLEND_SSE2)
+    const __m128 opacity = _mm_set1_ps(over_opacity);
+    const __m128 one = _mm_set1_ps(1.0f);
+    for (; i + 4 <= pixel_count; i += 4) {
+        const Pixels4 src = LoadPixels4(_mm_loadu_si128(reinterpret_cast<const __m128i*>(over + (i * 4))));
+        Pixels4 dst = LoadPixels4(_mm_loadu_si128(reinterpret_cast<const __m128i*>(below + (i * 4))));
+        const __m128 src_a = _mm_mul_ps(src.a, opacity);
+        const __m128 keep = _mm_sub_ps(one, src_a);
+        dst.r = _mm_add_ps(_mm_mul_ps(src.r, opacity), _mm_mul_ps(dst.r, keep));
+        dst.g = _mm_add_ps(_mm_mul_ps(src.g, opacity), _mm_mul_ps(dst.g, keep));
+        dst.b = _mm_add_ps(_mm_mul_ps(src.b, opacity), _mm_mul_ps(dst.b, keep));
+        dst.a = _mm_add_ps(src_a, _mm_mul_ps(dst.a, keep));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(below + (i * 4)), StorePixels4(dst));
+    }
+#endif
+    for (i *= 4; i < pixel_count * 4; i += 4) {
+        const float src_a = static_cast<float>(over[i + 3]) * INV_255 * over_opacity;
+        const float keep = 1.0f - src_a;
+        for (size_t c = 0; c < 4; c++) {
+            const float src = c == 3 ? src_a : static_cast<float>(over[i + c]) * INV_255 * over_opacity;
+            const float dst = static_cast<float>(below[i + c]) * INV_255;
+            below[i + c] = ToUnorm(src + (dst * keep));
+        }
+    }
+}
+
+static constexpr float MIN_EDGE = 0.01f;
+
+// Row of the falloffs for a hardness. The edge of the smoothstep goes from 1 to MIN_EDGE, the rows are evenly spaced on
+// its log so the hard brushes, where the mask changes fast with the edge, get as many rows as the soft ones.
+static float FalloffRow(const float hardness) {
+    const float edge = std::max(MIN_EDGE, 1.0f - hardness);
+    return std::log(edge) / std::log(MIN_EDGE) * static_cast<float>(BrushTip::FALLOFF_ROWS - 1);
+}
+
+static float Smoothstep(const float edge, const float x) {
+    // smoothstep(0.0, edge, x)
+    const float t = std::clamp(x / edge, 0.0f, 1.0f);
+    return t * t * (3.0f - (2.0f * t));
+}
+
+BrushTip::BrushTip(const std::uint8_t* rgba, const int width, const int height, const bool detect_round)
+    : width_(width), height_(height) {
+    ZoneScoped;
+    SDL_assert(width > 0 && height > 0);
+    alpha_.resize(static_cast<size_t>(width) * height);
+    for (size_t i = 0; i < alpha_.size(); i++) {
+        alpha_[i] = static_cast<float>(rgba[i * 4]) * INV_255;
+    }
+
+    // Radial profile of the tip, the average over the angles at each falloff entry
+    constexpr int ANGLES = 16;
+    constexpr float TAU = 6.28318530718f;
+    eastl::vector<float> profile(FALLOFF_SIZE);
+    float deviation = 0.0f;
+    for (int i = 0; i < FALLOFF_SIZE; i++) {
+        const float distance = std::sqrt(static_cast<float>(i) / static_cast<float>(FALLOFF_SIZE - 1));
+        float samples[ANGLES];
+        float sum = 0.0f;
+        for (int angle = 0; angle < ANGLES; angle++) {
+            const float theta = TAU * static_cast<float>(angle) / static_cast<float>(ANGLES);
+            // Like the shaders, the dab covers the whole tip
+            const float u = 0.5f + (0.5f * distance * std::cos(theta));
+            const float v = 0.5f + (0.5f * distance * std::sin(theta));
+            samples[angle] = Sample(u, v);
+            sum += samples[angle];
+        }
+        profile[i] = sum / static_cast<float>(ANGLES);
+        for (const float sample : samples) {
+            deviation = std::max(deviation, std::abs(sample - profile[i]));
+        }
+    }
+    round_ = detect_round && deviation <= ROUND_TOLERANCE;
+
+    falloffs_.resize(static_cast<size_t>(FALLOFF_ROWS) * FALLOFF_SIZE);
+    for (int row = 0; row < FALLOFF_ROWS; row++) {
+        // Inverse of FalloffRow
+        const float edge = std::pow(MIN_EDGE, static_cast<float>(row) / static_cast<float>(FALLOFF_ROWS - 1));
+        for (int i = 0; i < FALLOFF_SIZE; i++) {
+            falloffs_[(static_cast<size_t>(row) * FALLOFF_SIZE) + i] = Smoothstep(edge, profile[i]);
+        }
+    }
+}
+
+float BrushTip::Sample(const float u, const float v) const {
+    SDL_assert(!Empty());
+    const float x = (u * static_cast<float>(width_)) - 0.5f;
+    const float y = (v * static_cast<float>(height_)) - 0.5f;
+    const float x_floor = std::floor(x);
+    const float y_floor = std::floor(y);
+    const float fx = x - x_floor;
+    const float fy = y - y_floor;
+
+    const int x0 = std::clamp(static_cast<int>(x_floor), 0, width_ - 1);
+    const int x1 = std::clamp(static_cast<int>(x_floor) + 1, 0, width_ - 1);
+    const int y0 = std::clamp(static_cast<int>(y_floor), 0, height_ - 1);
+    const int y1 = std::clamp(static_cast<int>(y_floor) + 1, 0, height_ - 1);
+    const float* row0 = alpha_.data() + (static_cast<size_t>(y0) * width_);
+    const float* row1 = alpha_.data() + (static_cast<size_t>(y1) * width_);
+    const float top = row0[x0] + ((row0[x1] - row0[x0]) * fx);
+    const float bottom = row1[x0] + ((row1[x1] - row1[x0]) * fx);
+    return top + ((bottom - top) * fy);
+}
+
+bool BrushTip::Empty() const {
+    return alpha_.empty();
+}
+
+bool BrushTip::Round() const {
+    return round_;
+}
+
+BrushTip::Falloff BrushTip::FalloffOf(const float hardness) const {
+    SDL_assert(!Empty());
+    const float y = FalloffRow(hardness);
+    const int row = std::min(static_cast<int>(y), FALLOFF_ROWS - 2);
+    const float* row0 = falloffs_.data() + (static_cast<size_t>(row) * FALLOFF_SIZE);
+    return {.row0 = row0, .row1 = row0 + FALLOFF_SIZE, .weight = y - static_cast<float>(row)};
+}
+
+const eastl::vector<float>& BrushTip::Falloffs() const {
+    return falloffs_;
+}
+
+float BrushTip::Falloff::Sample(const float distance2) const {
+    const float x = std::clamp(distance2, 0.0f, 1.0f) * static_cast<float>(FALLOFF_SIZE - 1);
+    const int i = std::min(static_cast<int>(x), FALLOFF_SIZE - 2);
+    const float fx = x - static_cast<float>(i);
+    const float top = row0[i] + ((row0[i + 1] - row0[i]) * fx);
+    const float bottom = row1[i] + ((row1[i + 1] - row1[i]) * fx);
+    return top + ((bottom - top) * weight);
+}
+
+// Channel c of the i-th pixel of a wet tile is wet[(c * WET_PLANE) + i]
+static constexpr size_t WET_PLANE = TILE_WIDTH * TILE_HEIGHT;
+
+// Pixels of a tile, inclusive, empty when a min is past its max
+struct PixelRect {
+    int x_min;
+    int x_max;
+    int y_min;
+    int y_max;
+
+    [[nodiscard]] bool Empty() const {
+        return x_min > x_max || y_min > y_max;
+    }
+};
+
+// Pixels the dab can reach, the distance test of the kernels is the one of the shaders
+static PixelRect DabRect(const StrokePoint& point, const glm::ivec2 origin) {
+    constexpr int width = static_cast<int>(TILE_WIDTH);
+    constexpr int height = static_cast<int>(TILE_HEIGHT);
+    return {
+        .x_min = std::max(static_cast<int>(std::floor(point.position.x - point.radius)) - origin.x, 0),
+        .x_max = std::min(static_cast<int>(std::ceil(point.position.x + point.radius)) - origin.x, width - 1),
+        .y_min = std::max(static_cast<int>(std::floor(point.position.y - point.radius)) - origin.y, 0),
+        .y_max = std::min(static_cast<int>(std::ceil(point.position.y + point.radius)) - origin.y, height - 1),
+    };
+}
+
+// RGBA8 pixels of the rectangle to the wet tile, the columns are a multiple of 4
+static void LoadWet(const std::uint8_t* pixels, float* wet, const PixelRect& rect) {
+    for (int y = rect.y_min; y <= rect.y_max; y++) {
+        const size_t row = static_cast<size_t>(y) * TILE_WIDTH;
+        int x = rect.x_min;
+#if defined(MIDORI_BLEND_SSE2)
+        for (; x + 4 <= rect.x_max + 1; x += 4) {
+            const auto* src_pixels = reinterpret_cast<const __m128i*>(pixels + ((row + x) * 4));
+            const Pixels4 src = LoadPixels4(_mm_loadu_si128(src_pixels));
+            _mm_storeu_ps(wet + row + x, src.r);
+            _mm_storeu_ps(wet + WET_PLANE + row + x, src.g);
+            _mm_storeu_ps(wet + (2 * WET_PLANE) + row + x, src.b);
+            _mm_storeu_ps(wet + (3 * WET_PLANE) + row + x, src.a);
+        }
+#endif
+        for (; x <= rect.x_max; x++) {
+            for (size_t c = 0; c < 4; c++) {
+                wet[(c * WET_PLANE) + row + x] = static_cast<float>(pixels[((row + x) * 4) + c]) * INV_255;
+            }
+        }
+    }
+}
+
+// Wet tile to the RGBA8 pixels of the rectangle, rounded like a store to an RGBA8 texture
+static void ResolveWet(const float* wet, std::uint8_t* pixels, const PixelRect& rect) {
+    for (int y = rect.y_min; y <= rect.y_max; y++) {
+        const size_t row = static_cast<size_t>(y) * TILE_WIDTH;
+        int x = rect.x_min;
+#if defined(MIDORI_BLEND_SSE2)
+        for (; x + 4 <= rect.x_max + 1; x += 4) {
+            const Pixels4 src = {
+                .r = _mm_loadu_ps(wet + row + x),
+                .g = _mm_loadu_ps(wet + WET_PLANE + row + x),
+                .b = _mm_loadu_ps(wet + (2 * WET_PLANE) + row + x),
+                .a = _mm_loadu_ps(wet + (3 * WET_PLANE) + row + x),
+            };
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(pixels + ((row + x) * 4)), StorePixels4(src));
+        }
+#endif
+        for (; x <= rect.x_max; x++) {
+            for (size_t c = 0; c < 4; c++) {
+                pixels[((row + x) * 4) + c] = ToUnorm(wet[(c * WET_PLANE) + row + x]);
+            }
+        }
+    }
+}
+
+#if !defined(MIDORI_BLEND_SSE2)
+// One pixel of one dab, `x` and `y` are canvas pixels. `pixel` is in the red plane of a wet tile.
+static void PaintPixel(const PaintMode mode, const StrokePoint& point, const BrushTip& tip,
+                       const BrushTip::Falloff& falloff, const float x, const float y, float* pixel) {
+    const float dx = x - point.position.x;
+    const float dy = y - point.position.y;
+    const float distance2 = (dx * dx) + (dy * dy);
+    float mask;
+    if (tip.Round()) {
+        const float radius2 = point.radius * point.radius;
+        if (!(distance2 <= radius2)) {
+            return;
+        }
+        mask = falloff.Sample(distance2 / radius2);
+    } else {
+        if (!(std::sqrt(distance2) <= point.radius)) {
+            return;
+        }
+        const float diameter = 2.0f * point.radius;
+        const float edge = std::max(0.01f, 1.0f - point.hardness);
+        mask = Smoothstep(edge, tip.Sample((dx / diameter) + 0.5f, (dy / diameter) + 0.5f));
+    }
+
+    float& dst_a = pixel[3 * WET_PLANE];
+    if (mode == PaintMode::Erase) {
+        if (dst_a == 0.0f) {
+            return;
+        }
+        const float alpha = point.flow * mask;
+        if (alpha == 0.0f) {
+            return;
+        }
+        for (size_t c = 0; c < 4; c++) {
+            pixel[c * WET_PLANE] *= 1.0f - alpha;
+        }
+        return;
+    }
+
+    if (dst_a == 1.0f) {
+        return;
+    }
+    float alpha = point.flow * mask;
+    if (alpha == 0.0f) {
+        return;
+    }
+    alpha = (dst_a - std::min(point.color.a, alpha + (dst_a * (1.0f - alpha)))) / (dst_a - 1.0f);
+    if (!(alpha > 0.0f)) {
+        return;
+    }
+    for (int c = 0; c < 3; c++) {
+        pixel[c * WET_PLANE] = (point.color[c] * alpha) + (pixel[c * WET_PLANE] * (1.0f - alpha));
+    }
+    dst_a = alpha + (dst_a * (1.0f - alpha));
+}
+#else
+// Four pixels of a row for one dab, same operations as PaintPixel. `pixels` are in the red plane of a wet tile.
+static void PaintPixels4(const PaintMode mode, const StrokePoint& point, const BrushTip& tip,
+                         const BrushTip::Falloff& falloff, const float x, const float y, float* pixels) {
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 dx = _mm_sub_ps(_mm_add_ps(_mm_set1_ps(x), _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f)),
+                                 _mm_set1_ps(point.position.x));
+    const __m128 dy = _mm_set1_ps(y - point.position.y);
+    const __m128 distance2 = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+    __m128 write;
+    __m128 mask;
+    if (tip.Round()) {
+        const float radius2 = point.radius * point.radius;
+        write = _mm_cmple_ps(distance2, _mm_set1_ps(radius2));
+        const int inside = _mm_movemask_ps(write);
+        if (inside == 0) {
+            return;
+        }
+        // The falloff is read lane by lane, there is no gather in SSE2
+        alignas(16) float q[4];
+        _mm_store_ps(q, _mm_div_ps(distance2, _mm_set1_ps(radius2)));
+        alignas(16) float falloff_mask[4] = {};
+        for (int lane = 0; lane < 4; lane++) {
+            if ((inside & (1 << lane)) != 0) {
+                falloff_mask[lane] = falloff.Sample(q[lane]);
+            }
+        }
+        mask = _mm_load_ps(falloff_mask);
+    } else {
+        write = _mm_cmple_ps(_mm_sqrt_ps(distance2), _mm_set1_ps(point.radius));
+        const int inside = _mm_movemask_ps(write);
+        if (inside == 0) {
+            return;
+        }
+
+        // The tip is sampled lane by lane, there is no gather in SSE2
+        const __m128 diameter = _mm_set1_ps(2.0f * point.radius);
+        const __m128 half = _mm_set1_ps(0.5f);
+        alignas(16) float u[4];
+        alignas(16) float v[4];
+        _mm_store_ps(u, _mm_add_ps(_mm_div_ps(dx, diameter), half));
+        _mm_store_ps(v, _mm_add_ps(_mm_div_ps(dy, diameter), half));
+        alignas(16) float tip_alpha[4] = {};
+        for (int lane = 0; lane < 4; lane++) {
+            if ((inside & (1 << lane)) != 0) {
+                tip_alpha[lane] = tip.Sample(u[lane], v[lane]);
+            }
+        }
+        const __m128 edge = _mm_set1_ps(std::max(0.01f, 1.0f - point.hardness));
+        const __m128 t = _mm_min_ps(_mm_max_ps(_mm_div_ps(_mm_load_ps(tip_alpha), edge), _mm_setzero_ps()), one);
+        mask = _mm_mul_ps(_mm_mul_ps(t, t), _mm_sub_ps(_mm_set1_ps(3.0f), _mm_mul_ps(_mm_set1_ps(2.0f), t)));
+    }
+
+    const Pixels4 src = {
+        .r = _mm_loadu_ps(pixels),
+        .g = _mm_loadu_ps(pixels + WET_PLANE),
+        .b = _mm_loadu_ps(pixels + (2 * WET_PLANE)),
+        .a = _mm_loadu_ps(pixels + (3 * WET_PLANE)),
+    };
+    Pixels4 dst = src;
+    __m128 alpha = _mm_mul_ps(_mm_set1_ps(point.flow), mask);
+    write = _mm_andnot_ps(_mm_cmpeq_ps(alpha, _mm_setzero_ps()), write);
+
+    if (mode == PaintMode::Erase) {
+        write = _mm_andnot_ps(_mm_cmpeq_ps(src.a, _mm_setzero_ps()), write);
+        const __m128 keep = _mm_sub_ps(one, alpha);
+        dst.r = _mm_mul_ps(dst.r, keep);
+        dst.g = _mm_mul_ps(dst.g, keep);
+        dst.b = _mm_mul_ps(dst.b, keep);
+        dst.a = _mm_mul_ps(dst.a, keep);
+    } else {
+        write = _mm_andnot_ps(_mm_cmpeq_ps(src.a, one), write);
+        const __m128 over = _mm_add_ps(alpha, _mm_mul_ps(dst.a, _mm_sub_ps(one, alpha)));
+        alpha = _mm_div_ps(_mm_sub_ps(dst.a, _mm_min_ps(_mm_set1_ps(point.color.a), over)), _mm_sub_ps(dst.a, one));
+        write = _mm_and_ps(_mm_cmpgt_ps(alpha, _mm_setzero_ps()), write);
+        const __m128 keep = _mm_sub_ps(one, alpha);
+        dst.r = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(point.color.r), alpha), _mm_mul_ps(dst.r, keep));
+        dst.g = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(point.color.g), alpha), _mm_mul_ps(dst.g, keep));
+        dst.b = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(point.color.b), alpha), _mm_mul_ps(dst.b, keep));
+        dst.a = _mm_add_ps(alpha, _mm_mul_ps(dst.a, keep));
+    }
+
+    _mm_storeu_ps(pixels, Select(write, dst.r, src.r));
+    _mm_storeu_ps(pixels + WET_PLANE, Select(write, dst.g, src.g));
+    _mm_storeu_ps(pixels + (2 * WET_PLANE), Select(write, dst.b, src.b));
+    _mm_storeu_ps(pixels + (3 * WET_PLANE), Select(write, dst.a, src.a));
+}
+#endif
+
+static void PaintDab(const PaintMode mode, const StrokePoint& point, const BrushTip& tip, const glm::ivec2 origin,
+                     float* wet) {
+    static_assert(TILE_WIDTH % 4 == 0);
+    const PixelRect rect = DabRect(point, origin);
+    if (rect.Empty()) {
+        return;
+    }
+    const BrushTip::Falloff falloff = tip.Round() ? tip.FalloffOf(point.hardness) : BrushTip::Falloff{};
+
+    for (int y = rect.y_min; y <= rect.y_max; y++) {
+        float* row = wet + (static_cast<size_t>(y) * TILE_WIDTH);
+        const auto canvas_y = static_cast<float>(origin.y + y);
+#if defined(MIDORI_BLEND_SSE2)
+        for (int x = rect.x_min & ~3; x <= rect.x_max; x += 4) {
+            PaintPixels4(mode, point, tip, falloff, static_cast<float>(origin.x + x), canvas_y, row + x);
+        }
+#else
+        for (int x = rect.x_min; x <= rect.x_max; x++) {
+            PaintPixel(mode, point, tip, falloff, static_cast<float>(origin.x + x), canvas_y, row + x);
+        }
+#endif
+    }
+}
+
+// Pixels of the tile the dabs can reach, in whole groups of four columns as PaintPixels4 writes them back
+static PixelRect DabsRect(const StrokePoint* points, const std::uint32_t* indices, const size_t dabs_num,
+                          const glm::ivec2 origin) {
+    PixelRect reach = {
+        .x_min = static_cast<int>(TILE_WIDTH),
+        .x_max = -1,
+        .y_min = static_cast<int>(TILE_HEIGHT),
+        .y_max = -1,
+    };
+    for (size_t i = 0; i < dabs_num; i++) {
+        const PixelRect rect = DabRect(points[indices != nullptr ? indices[i] : i], origin);
+        if (rect.Empty()) {
+            continue;
+        }
+        reach.x_min = std::min(reach.x_min, rect.x_min & ~3);
+        reach.x_max = std::max(reach.x_max, rect.x_max | 3);
+        reach.y_min = std::min(reach.y_min, rect.y_min);
+        reach.y_max = std::max(reach.y_max, rect.y_max);
+    }
+    return reach;
+}
+
+// `indices` null goes through every dab. The reached pixels are resolved to `pixels` at the end.
+static void PaintWet(const PaintMode mode, const StrokePoint* points, const std::uint32_t* indices,
+                     const size_t dabs_num, const BrushTip& tip, const glm::ivec2 tile_pos, float* wet,
+                     std::uint8_t* pixels) {
+    const glm::ivec2 origin = tile_pos * glm::ivec2(static_cast<int>(TILE_WIDTH), static_cast<int>(TILE_HEIGHT));
+    const PixelRect reach = DabsRect(points, indices, dabs_num, origin);
+    if (reach.Empty()) {
+        return;
+    }
+    for (size_t i = 0; i < dabs_num; i++) {
+        PaintDab(mode, points[indices != nullptr ? indices[i] : i], tip, origin, wet);
+    }
+    ResolveWet(wet, pixels, reach);
+}
+
+// Like the shaders, the pixels the dabs reach are read once, blended with every dab in float and rounded once
+static void PaintRgba8(const PaintMode mode, const StrokePoint* points, const std::uint32_t* indices,
+                       const size_t dabs_num, const BrushTip& tip, const glm::ivec2 tile_pos, std::uint8_t* pixels) {
+    const glm::ivec2 origin = tile_pos * glm::ivec2(static_cast<int>(TILE_WIDTH), static_cast<int>(TILE_HEIGHT));
+    const PixelRect reach = DabsRect(points, indices, dabs_num, origin);
+    if (reach.Empty()) {
+        return;
+    }
+    thread_local eastl::vector<float> wet(WET_TILE_SIZE);
+    LoadWet(pixels, wet.data(), reach);
+    PaintWet(mode, points, indices, dabs_num, tip, tile_pos, wet.data(), pixels);
+}
+
+void PaintPixels(const PaintMode mode, const StrokePoint* points, const size_t points_num, const BrushTip& tip,
+                 const glm::ivec2 tile_pos, std::uint8_t* pixels) {
+    ZoneScoped;
+    PaintRgba8(mode, points, nullptr, points_num, tip, tile_pos, pixels);
+}
+
+void PaintPixels(const PaintMode mode, const StrokePoint* points, const std::uint32_t* indices,
+                 const size_t indices_num, const BrushTip& tip, const glm::ivec2 tile_pos, std::uint8_t* pixels) {
+    ZoneScoped;
+    PaintRgba8(mode, points, indices, indices_num, tip, tile_pos, pixels);
+}
+
+void PaintPixels(const PaintMode mode, const StrokePoint* points, const size_t points_num, const BrushTip& tip,
+                 const glm::ivec2 tile_pos, float* wet, std::uint8_t* pixels) {
+    ZoneScoped;
+    PaintWet(mode, points, nullptr, points_num, tip, tile_pos, wet, pixels);
+}
+
+void PaintPixels(const PaintMode mode, const StrokePoint* points, const std::uint32_t* indices,
+                 const size_t indices_num, const BrushTip& tip, const glm::ivec2 tile_pos, float* wet,
+                 std::uint8_t* pixels) {
+    ZoneScoped;
+    PaintWet(mode, points, indices, indices_num, tip, tile_pos, wet, pixels);
+}
+
+static constexpr PixelRect WHOLE_TILE = {
+    .x_min = 0,
+    .x_max = static_cast<int>(TILE_WIDTH) - 1,
+    .y_min = 0,
+    .y_max = static_cast<int>(TILE_HEIGHT) - 1,
+};
+
+void WetPixels(const std::uint8_t* pixels, float* wet) {
+    ZoneScoped;
+    LoadWet(pixels, wet, WHOLE_TILE);
+}
+
+void ResolveWetPixels(const float* wet, std::uint8_t* pixels) {
+    ZoneScoped;
+    ResolveWet(wet, pixels, WHOLE_TILE);
+}
+
+} // namespace Midori
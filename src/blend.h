@@ -0,0 +1,89 @@
+#pragma once
+
+#include "stroke.h"
+#include "tiles.h"
+#include <EASTL/vector.h>
+#include <cstddef>
+#include <cstdint>
+#include <glm/vec2.hpp>
+
+namespace Midori {
+
+// CPU versions of the blending done by the shaders, to check the GPU results and to run without one.
+//
+// Pixels are RGBA8 premultiplied alpha, like the tile textures. The math follows the shaders: unorm values are turned
+// into floats, blended, then rounded back to the nearest unorm value. Four pixels are blended at once with SSE2 when
+// the compiler targets it (MIDORI_BLEND_SCALAR forces the scalar path), both paths do the same float operations.
+
+// merge.comp: `over` multiplied by `over_opacity` is composited onto `below` with premultiplied alpha, in place.
+void MergePixels(const std::uint8_t* over, float over_opacity, std::uint8_t* below, size_t pixel_count);
+
+// Alpha of the brush tip, sampled like brush_sampler: bilinear on the red channel of the first level, clamped to the
+// edges
+//
+// A tip that looks the same in every direction is round: the mask of a dab then only depends on the distance to its
+// center and its hardness. Its falloffs are precomputed, one per hardness bucket, indexed by the squared distance over
+// the squared radius, so the shaders skip the square root, the tip texture and the smoothstep. Other tips keep the
+// texture path.
+class BrushTip {
+public:
+    static constexpr int FALLOFF_SIZE = 256; // Entries of a falloff, (distance / radius)^2 from 0 to 1
+    static constexpr int FALLOFF_ROWS = 32;  // Hardness buckets, from 0 to 1
+    // How far the tip can be from its average over the angles and still count as round
+    static constexpr float ROUND_TOLERANCE = 2.0f / 255.0f;
+
+    // The falloffs of the two buckets around a hardness
+    struct Falloff {
+        const float* row0 = nullptr;
+        const float* row1 = nullptr;
+        float weight = 0.0f; // Of row1
+
+        // `distance2` is (distance / radius)^2
+        [[nodiscard]] float Sample(float distance2) const;
+    };
+
+    BrushTip() = default;
+    // `rgba` is width x height RGBA8, `detect_round` false always takes the texture path
+    BrushTip(const std::uint8_t* rgba, int width, int height, bool detect_round = true);
+
+    [[nodiscard]] float Sample(float u, float v) const;
+    [[nodiscard]] bool Empty() const;
+    [[nodiscard]] bool Round() const;
+    [[nodiscard]] Falloff FalloffOf(float hardness) const;
+    // FALLOFF_ROWS x FALLOFF_SIZE, the falloff buffer of the shaders
+    [[nodiscard]] const eastl::vector<float>& Falloffs() const;
+
+private:
+    int width_ = 0;
+    int height_ = 0;
+    bool round_ = false;
+    eastl::vector<float> alpha_;
+    eastl::vector<float> falloffs_;
+};
+
+// paint.comp and erase.comp: the dabs are applied in order to the TILE_WIDTH x TILE_HEIGHT `pixels` of the tile at
+// `tile_pos`, in place. Only the pixels under a dab are visited. Like the shaders, which keep a pixel in registers for
+// the whole dispatch, each pixel is rounded once after every dab was blended.
+void PaintPixels(PaintMode mode, const StrokePoint* points, size_t points_num, const BrushTip& tip, glm::ivec2 tile_pos,
+                 std::uint8_t* pixels);
+// Same with only the dabs at `indices`, like a bin of StrokeBins
+void PaintPixels(PaintMode mode, const StrokePoint* points, const std::uint32_t* indices, size_t indices_num,
+                 const BrushTip& tip, glm::ivec2 tile_pos, std::uint8_t* pixels);
+
+// Wet tiles hold the pixels of a brush stroke in float until it ends, so thousands of low flow dabs build up without
+// being rounded to RGBA8 in between (the wet textures of the stroke tiles on the GPU, RGBA16F). They are planar, the
+// WET_TILE_SIZE floats are the red plane of the tile then the green, blue and alpha ones. Premultiplied like the tiles.
+constexpr size_t WET_TILE_SIZE = TILE_WIDTH * TILE_HEIGHT * 4;
+
+// PaintPixels on a wet tile, nothing is rounded there. The pixels the dabs reach are then resolved to the RGBA8
+// `pixels` of the tile, like the shaders store them to the tile texture for display.
+void PaintPixels(PaintMode mode, const StrokePoint* points, size_t points_num, const BrushTip& tip, glm::ivec2 tile_pos,
+                 float* wet, std::uint8_t* pixels);
+void PaintPixels(PaintMode mode, const StrokePoint* points, const std::uint32_t* indices, size_t indices_num,
+                 const BrushTip& tip, glm::ivec2 tile_pos, float* wet, std::uint8_t* pixels);
+// RGBA8 tile to a wet tile
+void WetPixels(const std::uint8_t* pixels, float* wet);
+// Wet tile to an RGBA8 tile, rounded like a store to the tile texture
+void ResolveWetPixels(const float* wet, std::uint8_t* pixels);
+
+} // namespace Midori
@@ -2,6 +2,8 @@
 
 #include "app.h"
 #include "renderer.h"
+#include "tile_codec.h"
+#include "tile_io.h"
 #include <SDL3/SDL_assert.h>
 #include <algorithm>
 #include <cstdint>
@@ -9,14 +11,12 @@
 #include <imgui.h>
 #include <map>
 #include <string>
+#include <thread>
 #include <tracy/Tracy.hpp>
 #include <utility>
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/hash.hpp>
 #include <json.hpp>
-#define QOI_IMPLEMENTATION
-#define QOI_NO_STDIO
-#include <qoi.h>
 
 namespace Midori {
 
@@ -31,6 +31,12 @@ SDL_EnumerationResult findLayersCallback(void* userdata, const char* dirname, co
         const std::string folder = std::format("{}{}", dirname, fname);
         const std::string path = std::format("{}/layer.json", folder);
 
+        // The tile pack lives next to the layer folders
+        SDL_PathInfo info;
+        if (!SDL_GetPathInfo(folder.c_str(), &info) || info.type != SDL_PATHTYPE_DIRECTORY) {
+            return SDL_ENUM_CONTINUE;
+        }
+
         size_t size;
         char* buf = (char*)SDL_LoadFile(path.c_str(), &size);
         SDL_assert(buf && size);
@@ -48,42 +54,14 @@ SDL_EnumerationResult findLayersCallback(void* userdata, const char* dirname, co
         SDL_assert(layer != LAYER_INVALID);
 
         canvas->selectedLayer = layer; // TODO: Move this elsewhere
-        canvas->layerTilesSaved[layer] = eastl::unordered_set<glm::ivec2>();
-
-        int tilesCount;
-        const auto* tilesFile = SDL_GlobDirectory(folder.c_str(), "*.qoi", 0, &tilesCount);
-        for (int i = 0; i < tilesCount; i++) {
-            size_t len = strlen(tilesFile[i]);
-            int stage = 0;
-            glm::ivec2 pos{};
-            std::string tmp;
-            for (size_t c = 0; c < len; c++) {
-                if (tilesFile[i][c] == '.') {
-                    SDL_assert(stage == 1);
-                    if (stage == 1) {
-                        pos.y = std::atoi(tmp.c_str());
-                        stage++;
-                    }
-                    break;
-                } else if (tilesFile[i][c] == '_') {
-                    pos.x = std::atoi(tmp.c_str());
-                    tmp.clear();
-                    stage++;
-                } else {
-                    tmp += tilesFile[i][c];
-                }
-            }
-
-            SDL_assert(stage == 2);
-            canvas->layerTilesSaved[layer].emplace(pos);
-        }
     }
 
     return SDL_ENUM_CONTINUE;
 }
 
 bool Canvas::CanQuit() {
-    return tileToUnload.empty() && layerToDelete.empty() && tileToDelete.empty();
+    return tileToUnload.empty() && layerToDelete.empty() && tileToDelete.empty() && tile_read_jobs == 0 &&
+           tile_write_jobs == 0 && !tilePack.Dirty();
 }
 
 bool Canvas::Open() {
@@ -97,6 +75,11 @@ bool Canvas::Open() {
     const bool exists = SDL_CreateDirectory(filename.c_str());
     SDL_Log("%s", filename.c_str());
 
+    if (!tilePack.Open(std::format("{}/tiles.pack", filename))) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to open the tile pack of %s", filename.c_str());
+        return false;
+    }
+
     // nlohmann::json waypointsJson;
     // std::string waypointsDump = waypointsJson.dump(4);
     // std::string file = std::format("{}/waypoints.json", filename);
@@ -107,9 +90,20 @@ bool Canvas::Open() {
 
     if (exists) {
         SDL_EnumerateDirectory(filename.c_str(), findLayersCallback, this);
+        ImportLegacyTiles();
         CompactLayerHeight();
     }
 
+    for (const auto& coord : tilePack.Tiles()) {
+        if (!layerInfos.contains(coord.layer)) {
+            // Left over from a layer deleted while the pack wasn't flushed
+            tilePack.Erase(coord);
+            continue;
+        }
+        tileIndex.SetSaved(coord.layer, coord.pos, true);
+    }
+    tilePack.Flush();
+
     if (layerInfos.empty()) {
         LayerInfo layerInfo{};
         layerInfo.name = "Base Layer";
@@ -117,7 +111,6 @@ bool Canvas::Open() {
         SDL_assert(layer != LAYER_INVALID);
 
         selectedLayer = layer;
-        layerTilesSaved[layer] = eastl::unordered_set<glm::ivec2>();
         SaveLayer(layer);
     }
 
@@ -127,6 +120,32 @@ bool Canvas::Open() {
     return true;
 }
 
+void Canvas::ImportLegacyTiles() {
+    ZoneScoped;
+
+    // Canvases used to store each tile in <layer>/<x>_<y>.qoi
+    eastl::vector<std::string> imported;
+    for (const auto& [layer, layer_info] : layerInfos) {
+        const std::string folder = std::format("{}/{}", filename, layer);
+        if (!tilePack.ImportLegacyLayer(folder, layer, imported)) {
+            SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Some tiles of layer %d could not be imported", layer);
+        }
+    }
+    if (imported.empty()) {
+        return;
+    }
+
+    // The old files are only removed once the pack is safely on disk
+    if (!tilePack.Flush()) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to flush imported tiles, keeping the old tile files");
+        return;
+    }
+    for (const auto& path : imported) {
+        SDL_RemovePath(path.c_str());
+    }
+    SDL_Log("Imported %zu tiles into the tile pack", imported.size());
+}
+
 void Canvas::CompactLayerHeight() {
     std::map<uint8_t, Layer> sortedHeightLayers;
     for (auto& [layer, layer_info] : layerInfos) {
@@ -144,37 +163,132 @@ void Canvas::Update() {
     ZoneScoped;
 
     CullTiles(viewport);
+    EvictTiles();
     UpdateTileLoading();
 }
 
 void Canvas::CullTiles(Viewport& viewport) {
     ZoneScoped;
 
-    const auto& tilesVisible = viewport.VisibleTiles();
+    const bool viewChanged = viewport.UpdateResidentTiles(tilesEntered, tilesLeft);
+    if (tilesCullAll) {
+        tilesCullAll = false;
+        tilesCullPending.clear();
+        CullAllTiles(viewport);
+        return;
+    }
+
+    if (viewChanged) {
+        for (const auto& [layer, info] : layerInfos) {
+            for (const auto& tilePos : tilesLeft) {
+                const auto tile = tileIndex.Loaded(layer, tilePos);
+                if (tile != TILE_INVALID) {
+                    tileResidency.Release(tile);
+                }
+            }
+            if (info.hidden) {
+                continue;
+            }
+            for (const auto& tilePos : tilesEntered) {
+                const auto slot = tileIndex.At(layer, tilePos);
+                if (slot.tile != TILE_INVALID) {
+                    UseTile(slot.tile);
+                } else if (slot.saved) {
+                    QueueLoadTile(layer, tilePos);
+                }
+            }
+        }
+    }
+
+    // Tiles created outside of the view, or unloaded after coming back into it. Loading pushes to the pending list
+    const auto pending = std::move(tilesCullPending);
+    tilesCullPending.clear();
+    for (const auto& coord : pending) {
+        if (!layerInfos.contains(coord.layer)) {
+            continue;
+        }
+        const bool visible = !layerInfos.at(coord.layer).hidden && viewport.IsTileResident(coord.pos);
+        const auto slot = tileIndex.At(coord.layer, coord.pos);
+        if (slot.tile != TILE_INVALID && !visible) {
+            tileResidency.Release(slot.tile);
+        } else if (slot.tile != TILE_INVALID) {
+            UseTile(slot.tile);
+        } else if (slot.saved && visible) {
+            QueueLoadTile(coord.layer, coord.pos);
+        }
+    }
+}
+
+void Canvas::CullAllTiles(const Viewport& viewport) {
+    ZoneScoped;
+
+    // Saved tiles are looked up in the resident area, a linear scan of the layer chunks
+    glm::ivec2 residentMin, residentMax;
+    viewport.ResidentArea(residentMin, residentMax);
+
+    eastl::vector<glm::ivec2> tilesToLoad;
+
     for (const auto& [layer, info] : layerInfos) {
         if (info.hidden) {
             // A layer with 0 opacity can still be painted on,
             // so we keep it's tile loaded in case
-            for (const auto& tile : layerTiles[layer]) {
-                QueueUnloadTile(layer, tile);
+            for (const auto& tile : tileIndex.LayerTiles(layer)) {
+                tileResidency.Release(tile);
             }
         } else {
-            for (const auto& tile : layerTiles[layer]) {
-                if (!viewport.IsTileVisible(tileInfos[tile].pos)) {
-                    QueueUnloadTile(layer, tile);
+            for (const auto& tile : tileIndex.LayerTiles(layer)) {
+                if (viewport.IsTileResident(tileIndex.Coord(tile).pos)) {
+                    UseTile(tile);
+                } else {
+                    tileResidency.Release(tile);
                 }
             }
-            for (const auto& tilePos : tilesVisible) {
-                if (layerTilesSaved[layer].contains(tilePos)) {
-                    if (!layerTilePos[layer].contains(tilePos)) {
-                        QueueLoadTile(layer, tilePos);
-                    }
-                }
+            // Loading inserts into the index, so the positions are collected before
+            tilesToLoad.clear();
+            tileIndex.ForEachSlot(layer, residentMin, residentMax,
+                                  [&](const glm::ivec2 tilePos, const TileIndex::Slot& slot) {
+                                      if (slot.saved && slot.tile == TILE_INVALID) {
+                                          tilesToLoad.push_back(tilePos);
+                                      }
+                                  });
+            for (const auto& tilePos : tilesToLoad) {
+                QueueLoadTile(layer, tilePos);
             }
         }
     }
 }
 
+void Canvas::EvictTiles() {
+    ZoneScoped;
+
+    // Evicting empties pages until they are released, the slack is only taken once per frame so a fragmented atlas
+    // doesn't evict every cold tile at once
+    tileResidency.SetPageSlack(app->renderer.tile_atlas.FreeSlices() * TileResidency::TILE_TEXTURE_SIZE);
+    for (Tile tile = tileResidency.Evict(); tile != TILE_INVALID; tile = tileResidency.Evict()) {
+        const auto coord = tileIndex.Coord(tile);
+        if (tileToDelete.contains(tile)) {
+            continue;
+        }
+
+        // Modified tiles and tiles still in use somewhere go through the usual save and unload
+        if (layerTilesModified.at(coord.layer).contains(tile) || tile_read_queue.contains(tile) ||
+            tile_write_queue.contains(tile) || tileToUnload.contains(tile) || stroke_tile_affected.contains(tile) ||
+            allTileStrokeAffected.contains(tile)) {
+            tileResidency.stats.evictionsDirty++;
+            QueueUnloadTile(coord.layer, tile);
+            continue;
+        }
+
+        // Clean, the pack already has what the texture holds
+        tileResidency.stats.evictions++;
+        app->renderer.ReleaseTileTexture(tile);
+        tileIndex.Erase(tile);
+        tileResidency.Remove(tile);
+        tilesUnassigned.push_back(tile);
+        tilesCullPending.push_back(coord);
+    }
+}
+
 void Canvas::DeleteUpdate() {
     UpdateTileUnloading();
 
@@ -184,25 +298,21 @@ void Canvas::DeleteUpdate() {
 
         eastl::vector<Tile> clear_tiles;
         for (const auto& tile : tileToDelete) {
-            SDL_assert(!tile_read_queue.contains(tile));
-
-            if (tile_write_queue.contains(tile)) {
+            // A job may still be reading the tile, wait for it to come back
+            if (tile_read_queue.contains(tile) || tile_write_queue.contains(tile)) {
                 continue;
             }
 
-            SDL_assert(tileInfos.contains(tile));
-            const auto tile_info = tileInfos.at(tile);
+            SDL_assert(tileIndex.Contains(tile));
+            const auto tile_info = tileIndex.Coord(tile);
             SDL_assert(layerInfos.contains(tile_info.layer));
 
-            const std::string tilePath =
-                std::format("{}/{}/{}_{}.qoi", filename, tile_info.layer, tile_info.pos.x, tile_info.pos.y);
-            SDL_RemovePath(tilePath.c_str());
+            tilePack.Erase(tile_info);
 
-            layerTiles.at(tile_info.layer).erase(tile);
-            layerTilePos.at(tile_info.layer).erase(tileInfos.at(tile).pos);
-            layerTilesSaved[tile_info.layer].erase(tileInfos.at(tile).pos);
+            tileIndex.SetSaved(tile_info.layer, tile_info.pos, false);
+            tileIndex.Erase(tile);
+            tileResidency.Remove(tile);
             app->renderer.ReleaseTileTexture(tile);
-            tileInfos.erase(tile);
             tilesUnassigned.push_back(tile);
             clear_tiles.push_back(tile);
         }
@@ -216,15 +326,16 @@ void Canvas::DeleteUpdate() {
 
         eastl::vector<Layer> layer_cleared;
         for (const auto layer : layerToDelete) {
-            if (!layerTiles.at(layer).empty()) {
+            if (!tileIndex.LayerTiles(layer).empty()) {
                 continue;
             }
 
-            SDL_assert(layerTiles.at(layer).empty());
+            SDL_assert(tileIndex.LayerTiles(layer).empty());
             SDL_assert(selectedLayer != layer);
 
             app->renderer.DeleteLayerTexture(layer);
             if (!layerInfos.at(layer).internal) {
+                tilePack.EraseLayer(layer);
                 const std::string folderPath = std::format("{}/{}", filename, layer);
                 const std::string infoPath = std::format("{}/layer.json", folderPath);
                 SDL_RemovePath(infoPath.c_str());
@@ -233,10 +344,8 @@ void Canvas::DeleteUpdate() {
 
             layersUnassigned.push_back(layer);
             layerInfos.erase(layer);
-            layerTiles.erase(layer);
+            tileIndex.EraseLayer(layer);
             layerTilesModified.erase(layer);
-            layerTilesSaved.erase(layer);
-            layerTilePos.erase(layer);
 
             layer_cleared.push_back(layer);
         }
@@ -245,6 +354,26 @@ void Canvas::DeleteUpdate() {
             layerToDelete.erase(layer);
         }
     }
+
+    { // Tile pack
+        ZoneScopedN("Tile pack maintenance");
+
+        // Flushing rewrites the whole index, so it waits for writes to settle
+        const Uint64 now = SDL_GetTicks();
+        if (tilePack.Dirty() && tile_write_jobs == 0 &&
+            (app->should_quit || now - tilePackLastFlush >= TILE_PACK_FLUSH_INTERVAL_MS)) {
+            tilePack.Flush();
+            tilePackLastFlush = now;
+        }
+
+        if (!app->should_quit && !tilePackCompacting && tilePack.ShouldCompact()) {
+            tilePackCompacting = true;
+            app->jobs.Submit([this] {
+                tilePack.Compact();
+                tilePackCompacting = false;
+            });
+        }
+    }
 }
 
 eastl::vector<Layer> Canvas::Layers() const {
@@ -264,21 +393,14 @@ bool Canvas::HasLayer(const Layer layer) const {
 
 bool Canvas::LayerHasTile(const Layer layer, const Tile tile) const {
     ZoneScoped;
-    return layerTiles.at(layer).contains(tile);
+    return tileIndex.Contains(tile) && tileIndex.Coord(tile).layer == layer;
 }
 
 eastl::vector<Tile> Canvas::LayerTiles(const Layer layer) const {
     ZoneScoped;
     SDL_assert(HasLayer(layer) && "Layer not found");
 
-    eastl::vector<Tile> tiles;
-    tiles.reserve(layerTiles.at(layer).size());
-    for (const auto& tile : layerTiles.at(layer)) {
-        SDL_assert(tile != 0 && "Invalid tile found");
-        tiles.push_back(tile);
-    }
-
-    return tiles;
+    return tileIndex.LayerTiles(layer);
 }
 
 Layer Canvas::CreateLayer(LayerInfo layerInfo) {
@@ -323,10 +445,9 @@ Layer Canvas::CreateLayer(LayerInfo layerInfo) {
     }
 
     layerInfos[layerInfo.id] = layerInfo;
-    layerTiles[layerInfo.id] = eastl::unordered_set<Tile>();
-    layerTilePos[layerInfo.id] = eastl::unordered_map<glm::ivec2, Tile>();
-    layerTilesSaved[layerInfo.id] = eastl::unordered_set<glm::ivec2>();
+    tileIndex.AddLayer(layerInfo.id);
     layerTilesModified[layerInfo.id] = eastl::unordered_set<Tile>();
+    tilesCullAll = true;
 
     // TODO: do this properly
     layersHeightSorted.push_back(layerInfo.id);
@@ -370,12 +491,10 @@ Layer Canvas::DuplicateLayer(Layer layer, bool temporary) {
     }
 
     if (!temporary) {
-        // Duplicate save folder for layers
-        std::string layerPath = std::format("{}/{}", filename, layerInfos[layer].id);
-        std::string newLayerPath = std::format("{}/{}", filename, layerInfos[newLayer].id);
-        std::filesystem::copy(layerPath, newLayerPath);
+        // Saved tiles are shared with the source layer in the pack
+        tilePack.CopyLayer(layer, newLayer);
+        tileIndex.CopySaved(layer, newLayer);
 
-        // Overwrite copied settings
         SaveLayer(newLayer);
     }
 
@@ -462,45 +581,41 @@ void Canvas::MergeLayer(const Layer over_layer, const Layer below_layer) {
 
     // TODO: Do this for all the tiles stored in file
     eastl::vector<std::pair<Tile, Tile>> tile_to_merge;
-    eastl::vector<Tile> tile_to_move;
-    for (const auto& over_tile : layerTiles.at(over_layer)) {
-        const auto tile_merge_pos = tileInfos.at(over_tile).pos;
-        const auto below_tile = layerTilePos.at(below_layer).at(tile_merge_pos);
+    for (const auto& over_tile : tileIndex.LayerTiles(over_layer)) {
+        const auto tile_merge_pos = tileIndex.Coord(over_tile).pos;
+        const auto below_tile = tileIndex.Loaded(below_layer, tile_merge_pos);
+        SDL_assert(below_tile != TILE_INVALID && "Tile to merge into is not loaded");
         tile_to_merge.emplace_back(over_tile, below_tile);
     }
-    // TODO: Batch all merging action to only have a single command_buffer for this
-    // per frame
-    for (const auto& [over, below] : tile_to_merge) {
-        MergeTiles(over, below);
-    }
+    MergeTiles(tile_to_merge);
 }
 
 Tile Canvas::CreateTile(const Layer layer, const glm::ivec2 position) {
     ZoneScoped;
     SDL_assert(layerInfos.contains(layer) && "Layer missing");
-    SDL_assert(!layerTilePos.at(layer).contains(position) && "Tile already loaded");
+    SDL_assert(tileIndex.Loaded(layer, position) == TILE_INVALID && "Tile already loaded");
 
     Tile tile = TILE_INVALID;
     if (tilesUnassigned.empty()) {
         SDL_assert(tileLastAssigned < TILES_MAX && "Tile limits reached");
         tileLastAssigned++;
-        SDL_assert(!layerTiles.at(layer).contains(tileLastAssigned));
+        SDL_assert(!tileIndex.Contains(tileLastAssigned));
         tile = tileLastAssigned;
     } else {
         tile = tilesUnassigned.back();
-        SDL_assert(!layerTiles.at(layer).contains(tile));
+        SDL_assert(!tileIndex.Contains(tile));
         SDL_assert(tile != TILE_INVALID && "Tile is invalid ?");
         tilesUnassigned.pop_back();
     }
 
-    layerTiles.at(layer).insert(tile);
-    layerTilePos.at(layer)[position] = tile;
-
-    app->renderer.CreateTileTexture(tile);
-    tileInfos[tile] = TileCoord{
+    const TileCoord coord = {
         .layer = layer,
         .pos = position,
     };
+    tileIndex.Insert(tile, coord);
+    tileResidency.Add(tile);
+    app->renderer.CreateTileTexture(tile, layer);
+    tilesCullPending.push_back(coord);
 
     return tile;
 }
@@ -508,11 +623,12 @@ Tile Canvas::CreateTile(const Layer layer, const glm::ivec2 position) {
 Tile Canvas::QueueLoadTile(const Layer layer, const glm::ivec2 position) {
     ZoneScoped;
     SDL_assert(layerInfos.contains(layer) && "Layer missing");
-    SDL_assert(!layerTilePos.at(layer).contains(position) && "Tile already loaded/loading");
-    SDL_assert(layerTilesSaved.at(layer).contains(position) && "Tile not saved");
+    SDL_assert(tileIndex.Loaded(layer, position) == TILE_INVALID && "Tile already loaded/loading");
+    SDL_assert(tileIndex.Saved(layer, position) && "Tile not saved");
 
     const auto tile = CreateTile(layer, position);
     SDL_assert(tile != TILE_INVALID && "Tile invalid ?");
+    tileResidency.stats.misses++;
 
     tile_read_queue[tile] = TileReadStatus{
         .layer = layer,
@@ -527,14 +643,14 @@ bool Canvas::QueueSaveTile(const Layer layer, const Tile tile) {
     ZoneScoped;
     SDL_assert(layerInfos.contains(layer) && "Layer not found");
     SDL_assert(layerTilesModified.contains(layer) && "Tile not found");
-    SDL_assert(tileInfos.contains(tile) && "Tile not found");
+    SDL_assert(tileIndex.Contains(tile) && "Tile not found");
     SDL_assert(!tile_write_queue.contains(tile) && "Tile already being queued for saving");
 
     tile_write_queue[tile] = TileWriteStatus{
         .layer = layer,
         .tile = tile,
         .state = TileWriteState::Queued,
-        .position = tileInfos[tile].pos,
+        .position = tileIndex.Coord(tile).pos,
     };
 
     return true;
@@ -543,44 +659,54 @@ bool Canvas::QueueSaveTile(const Layer layer, const Tile tile) {
 void Canvas::QueueUnloadTile(const Layer layer, const Tile tile) {
     ZoneScoped;
     SDL_assert(layerInfos.contains(layer) && "Layer not found");
-    SDL_assert(tileInfos.contains(tile) && "Tile not found");
+    SDL_assert(tileIndex.Contains(tile) && "Tile not found");
 
     if (!tile_write_queue.contains(tile)) {
         QueueSaveTile(layer, tile);
     }
 
     tileToUnload.insert(tile);
+    // Not drawn anymore
+    app->renderer.MarkTileDirty(tile);
+}
+
+void Canvas::UseTile(const Tile tile) {
+    // Evicted tiles that had to be saved wait in the unload queue, the save goes on but the tile stays loaded
+    if (tileResidency.Use(tile) && tileToUnload.erase(tile) > 0) {
+        app->renderer.MarkTileDirty(tile);
+    }
 }
 
 void Canvas::QueueTileDelete(const Layer layer, const Tile tile) {
     ZoneScoped;
     SDL_assert(layerInfos.contains(layer) && "Layer not found");
-    SDL_assert(tileInfos.contains(tile) && "Tile not found");
+    SDL_assert(tileIndex.Contains(tile) && "Tile not found");
     SDL_assert(!tileToDelete.contains(tile) && "Tile already being deleted");
 
     tileToDelete.insert(tile);
+    app->renderer.MarkTileDirty(tile);
 }
 
 Tile Canvas::GetLoadedTileAt(const Layer layer, const glm::ivec2 position) const {
     ZoneScoped;
-    SDL_assert(layerTilePos.contains(layer));
-
-    Tile tile = TILE_INVALID;
-    if (layerTilePos.at(layer).contains(position)) {
-        tile = layerTilePos.at(layer).at(position);
-    }
+    SDL_assert(tileIndex.HasLayer(layer));
 
-    return tile;
+    return tileIndex.Loaded(layer, position);
 }
 
-void Canvas::MergeTiles(Tile over_tile, Tile below_tile) {
-    SDL_assert(tileInfos.contains(over_tile));
-    SDL_assert(!tileToDelete.contains(over_tile));
-    SDL_assert(tileInfos.contains(below_tile));
-    SDL_assert(!tileToDelete.contains(below_tile));
+void Canvas::MergeTiles(const eastl::vector<std::pair<Tile, Tile>>& tiles) {
+    ZoneScoped;
+    for (const auto& [over_tile, below_tile] : tiles) {
+        SDL_assert(tileIndex.Contains(over_tile));
+        SDL_assert(!tileToDelete.contains(over_tile));
+        SDL_assert(tileIndex.Contains(below_tile));
+        SDL_assert(!tileToDelete.contains(below_tile));
+    }
 
-    app->renderer.MergeTileTextures(over_tile, below_tile);
-    layerTilesModified[tileInfos.at(below_tile).layer].insert(below_tile);
+    paintBackend->MergeTileTextures(tiles);
+    for (const auto& [over_tile, below_tile] : tiles) {
+        layerTilesModified[tileIndex.Coord(below_tile).layer].insert(below_tile);
+    }
 }
 
 void Canvas::ViewUpdateState(glm::vec2 cursor_pos) {
@@ -634,155 +760,257 @@ void Canvas::ViewUpdateCursor(glm::vec2 cursor_pos) {
     }
 }
 
-// TODO: Make multithreaded
 void Canvas::UpdateTileLoading() {
     ZoneScoped;
 
-    eastl::vector<Tile> tiles_unqueued;
-    size_t i = 0;
-    for (auto& [tile, tile_load] : tile_read_queue) {
-        if (i >= Midori::Renderer::TILE_MAX_UPLOAD_TRANSFER) {
-            break;
+    {
+        ZoneScopedN("Collecting decoded tiles");
+        TileReadStatus tile_read;
+        while (tile_read_completed.TryPop(tile_read)) {
+            SDL_assert(tile_read_jobs > 0);
+            tile_read_jobs--;
+
+            auto it = tile_read_queue.find(tile_read.tile);
+            SDL_assert(it != tile_read_queue.end() && "Tile read without being queued");
+            SDL_assert(it->second.state == TileReadState::Reading);
+
+            if (tile_read.state != TileReadState::Decompressed) {
+                // The tile stays blank, it is not marked modified so the pack is left untouched
+                SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to load tile %d of layer %d", tile_read.tile,
+                             tile_read.layer);
+                app->renderer.CancelTileUpload(tile_read.uploadSlot);
+                tile_read_queue.erase(it);
+                continue;
+            }
+
+            // The pixels are already in the upload buffer, only the copy to the texture is left
+            ZoneScopedN("Uploading Tile");
+            app->renderer.CommitTileUpload(tile_read.tile, tile_read.uploadSlot);
+            tile_read_queue.erase(it);
         }
+    }
 
+    // Queued tiles are read in priority order, the visible ones before the prefetched ones
+    tile_read_order.clear();
+    for (const auto& [tile, tile_load] : tile_read_queue) {
         if (tile_load.state == TileReadState::Queued) {
-            SDL_assert(tileInfos.contains(tile));
-            const auto tile_info = tileInfos.at(tile);
-            const std::string tile_filename =
-                std::format("{}/{}/{}_{}.qoi", filename, tile_load.layer, tile_info.pos.x, tile_info.pos.y);
+            SDL_assert(tileIndex.Contains(tile));
+            tile_read_order.emplace_back(viewport.TileLoadPriority(tileIndex.Coord(tile).pos), tile);
+        }
+    }
+    std::ranges::sort(tile_read_order);
 
-            ZoneScopedN("Reading Tile");
-            size_t buf_size;
-            auto* buf = (uint8_t*)SDL_LoadFile(tile_filename.c_str(), &buf_size);
-            SDL_assert(buf_size > 0);
-            SDL_assert(buf);
-
-            // SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Found tile encoded texture");
-            SDL_assert(buf_size > 0);
-            SDL_assert(buf != nullptr);
-            tile_load.encodedTexture.resize(buf_size);
-            memcpy(tile_load.encodedTexture.data(), buf, buf_size);
-            SDL_free(buf);
-
-            tile_load.state = TileReadState::Read;
+    eastl::vector<Tile> tiles_solid;
+    for (const auto& [priority, tile] : tile_read_order) {
+        auto& tile_load = tile_read_queue.at(tile);
+
+        const auto tile_info = tileIndex.Coord(tile);
+
+        // Solid tiles are only an entry of the pack index, they are filled on the GPU without reading anything
+        std::uint32_t color = 0;
+        if (tilePack.Solid(tile_info, color)) {
+            app->renderer.ClearTileTexture(tile, color);
+            tiles_solid.push_back(tile);
+            continue;
         }
-        if (tile_load.state == TileReadState::Read) {
-            ZoneScopedN("Decoding Tile");
-            qoi_desc desc;
-            auto* buf = (uint8_t*)qoi_decode(tile_load.encodedTexture.data(),
-                                             static_cast<int>(tile_load.encodedTexture.size()), &desc, 4);
-            SDL_assert(buf != nullptr);
-            SDL_assert(desc.channels = 4);
-            SDL_assert(desc.width = TILE_WIDTH);
-            SDL_assert(desc.height = TILE_HEIGHT);
-            tile_load.encodedTexture.clear();
-
-            tile_load.rawTexture.resize(TILE_WIDTH * TILE_HEIGHT * 4);
-            memcpy(tile_load.rawTexture.data(), buf, TILE_WIDTH * TILE_HEIGHT * 4);
-            free(buf);
-
-            tile_load.state = TileReadState::Decompressed;
+
+        if (tile_read_jobs >= TILE_MAX_READ_JOBS) {
+            continue;
         }
-        if (tile_load.state == TileReadState::Decompressed) {
-            ZoneScopedN("Uploading Tile");
-            app->renderer.UploadTileTexture(tile, tile_load.rawTexture);
-            tile_load.state = TileReadState::Uploaded;
-            tiles_unqueued.push_back(tile);
+
+        ZoneScopedN("Queue Tile read");
+        TileReadStatus tile_read = {
+            .layer = tile_load.layer,
+            .tile = tile,
+            .state = TileReadState::Reading,
+        };
+        if (!app->renderer.ReserveTileUpload(tile_read.uploadSlot)) {
+            // Every upload slot is in use until the next frame is submitted
+            continue;
         }
-        i++;
+
+        tile_load.state = TileReadState::Reading;
+        tile_read_jobs++;
+        app->jobs.Submit([this, tile_read, tile_info]() mutable {
+            ZoneScopedN("Reading Tile");
+
+            // The blob is decoded straight from the mapped pack into the mapped upload buffer
+            TilePack::BlobView view;
+            if (tilePack.View(tile_info, view) && DecodeTileQoi(view.data, view.size, tile_read.uploadSlot.pixels)) {
+                tile_read.state = TileReadState::Decompressed;
+            } else {
+                tile_read.state = TileReadState::Queued;
+            }
+
+            // The queue holds twice the number of jobs in flight, this should never spin
+            while (!tile_read_completed.TryPush(tile_read)) {
+                std::this_thread::yield();
+            }
+        });
     }
-    for (const auto& tile : tiles_unqueued) {
+    for (const auto& tile : tiles_solid) {
         tile_read_queue.erase(tile);
     }
 }
 
-// TODO: Make multithreaded
 void Canvas::UpdateTileUnloading() {
     ZoneScoped;
 
+    {
+        ZoneScopedN("Collecting written tiles");
+        TileWriteStatus tile_written;
+        while (tile_write_completed.TryPop(tile_written)) {
+            SDL_assert(tile_write_jobs > 0);
+            tile_write_jobs--;
+
+            auto it = tile_write_queue.find(tile_written.tile);
+            SDL_assert(it != tile_write_queue.end() && "Tile written without being queued");
+            SDL_assert(it->second.state == TileWriteState::Encoding);
+
+            if (tile_written.state != TileWriteState::Written) {
+                auto& tile_write = it->second;
+                layerTilesModified[tile_written.layer].insert(tile_written.tile);
+                tile_write.failures++;
+                if (tile_write.failures < TILE_WRITE_MAX_FAILURES) {
+                    const Uint64 delay = TILE_WRITE_RETRY_MS << (tile_write.failures - 1);
+                    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                                 "Failed to save tile %d of layer %d, retrying in %llu ms", tile_written.tile,
+                                 tile_written.layer, static_cast<unsigned long long>(delay));
+                    tile_write.retryTicks = SDL_GetTicks() + delay;
+                    tile_write.state = TileWriteState::Queued;
+                    continue;
+                }
+
+                // Unloading it would lose its pixels, the next save or unload of the tile tries again
+                SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                             "Failed to save tile %d of layer %d %u times, keeping it loaded", tile_written.tile,
+                             tile_written.layer, tile_write.failures);
+                tile_write_failures++;
+                tile_write_queue.erase(it);
+                if (tileToUnload.erase(tile_written.tile) > 0) {
+                    tileResidency.Use(tile_written.tile);
+                    app->renderer.MarkTileDirty(tile_written.tile);
+                }
+                continue;
+            }
+            it->second.state = TileWriteState::Written;
+            it->second.empty = tile_written.empty;
+        }
+    }
+
     eastl::vector<Tile> tiles_written;
-    size_t i = 0;
+    const Uint64 now = SDL_GetTicks();
+    bool reduce_ring_full = false;
+    bool download_ring_full = false;
     for (auto& [tile, tile_write] : tile_write_queue) {
-        const auto tile_info = tileInfos.at(tile);
+        // Wait for the tile to be uploaded before saving or releasing it
+        if (tile_read_queue.contains(tile)) {
+            continue;
+        }
+
+        const auto tile_info = tileIndex.Coord(tile);
 
         // If the tile is already saved marked it as finished
-        if (!layerTilesModified.at(tile_info.layer).contains(tile)) {
+        if (tile_write.state == TileWriteState::Queued && !layerTilesModified.at(tile_info.layer).contains(tile)) {
             tile_write.state = TileWriteState::Written;
             tiles_written.push_back(tile);
             continue;
         }
 
-        // limit the amount of download per frame
-        if (i >= Midori::Renderer::TILE_MAX_DOWNLOAD_TRANSFER) {
-            break;
+        // The tile is reduced on the GPU first, empty, uniform and unchanged tiles are never downloaded
+        if (tile_write.state == TileWriteState::Queued && tile_write.retryTicks <= now && !reduce_ring_full) {
+            if (app->renderer.ReduceTileTexture(tile)) {
+                // The reduced tile is the saved snapshot, any later modification queues the tile again
+                layerTilesModified.at(tile_info.layer).erase(tile);
+                tile_write.state = TileWriteState::Reducing;
+            } else {
+                reduce_ring_full = true;
+            }
+        }
+        if (tile_write.state == TileWriteState::Reducing && app->renderer.IsTileTextureReduced(tile)) {
+            tile_write.reduce = app->renderer.TileTextureReduced(tile);
+            if (tile_write.reduce.Empty()) {
+                tile_write.empty = true;
+                tile_write.state = TileWriteState::Written;
+                tile_downloads_skipped++;
+            } else if (tile_write.reduce.Hash() == tileIndex.SavedHash(tile)) {
+                // The pack already has it
+                tile_write.state = TileWriteState::Written;
+                tile_downloads_skipped++;
+            } else if (tile_write.reduce.Uniform()) {
+                // Written as a solid tile, the color is all the job needs
+                tile_write.state = TileWriteState::Downloaded;
+                tile_downloads_skipped++;
+            } else {
+                tile_write.state = TileWriteState::Reduced;
+            }
         }
 
-        //  The queue to allow multithreading later on
-        if (tile_write.state == TileWriteState::Queued) {
+        // The download ring grows with the queue, until every batch it can have is busy
+        if (tile_write.state == TileWriteState::Reduced && !download_ring_full) {
             if (app->renderer.DownloadTileTexture(tile)) {
                 tile_write.state = TileWriteState::Downloading;
+            } else {
+                download_ring_full = true;
             }
         }
         if (tile_write.state == TileWriteState::Downloading) {
             if (app->renderer.IsTileTextureDownloaded(tile)) {
                 if (app->renderer.CopyTileTextureDownloaded(tile, tile_write.rawTexture)) {
-                    ZoneScopedN("Check if tile is empty");
-                    bool empty = true;
-                    for (const auto& v : tile_write.rawTexture) {
-                        if (v > 1) {
-                            empty = false;
-                            break;
-                        }
-                    }
-                    if (empty) {
-                        QueueTileDelete(tile_info.layer, tile);
-                        tiles_written.push_back(tile);
-                        tile_write.state = TileWriteState::Written;
-                    } else {
-                        tile_write.state = TileWriteState::Downloaded;
-                    }
+                    tile_write.state = TileWriteState::Downloaded;
                 }
             }
         }
-        if (tile_write.state == TileWriteState::Downloaded) {
-            ZoneScopedN("Encoding tile");
-            const qoi_desc desc = {
-                .width = TILE_WIDTH,
-                .height = TILE_HEIGHT,
-                .channels = 4,
-                .colorspace = QOI_LINEAR,
+        if (tile_write.state == TileWriteState::Downloaded && tile_write_jobs < TILE_MAX_WRITE_JOBS) {
+            ZoneScopedN("Queue Tile write");
+            TileWriteStatus tile_job = {
+                .layer = tile_write.layer,
+                .tile = tile,
+                .state = TileWriteState::Encoding,
+                .position = tile_write.position,
+                .rawTexture = std::move(tile_write.rawTexture),
+                .reduce = tile_write.reduce,
             };
-            int out_len = 0;
-            auto* buf = (uint8_t*)qoi_encode(tile_write.rawTexture.data(), &desc, &out_len);
-            SDL_assert(out_len > 0);
-            SDL_assert(buf != nullptr);
-
-            tile_write.encodedTexture.resize(out_len);
-            memcpy(tile_write.encodedTexture.data(), buf, out_len);
-            free(buf);
 
-            tile_write.state = TileWriteState::Encoded;
-        }
-        if (tile_write.state == TileWriteState::Encoded) {
-            ZoneScopedN("Write Tile file");
-            const std::string tile_filename = std::format("{}/{}/{}_{}.qoi", filename, tile_write.layer,
-                                                          tile_write.position.x, tile_write.position.y);
+            tile_write.state = TileWriteState::Encoding;
+            tile_write_jobs++;
+            app->jobs.Submit([this, tile_job = std::move(tile_job), tile_info]() mutable {
+                // Empty tiles never get here, the reduction already deleted them
+                if (tile_job.reduce.Uniform()) {
+                    tilePack.WriteSolid(tile_info, tile_job.reduce.color);
+                    tile_job.state = TileWriteState::Written;
+                } else {
+                    ZoneScopedN("Encoding tile");
+                    if (EncodeTile(tile_job.rawTexture, tile_job.encodedTexture)) {
+                        ZoneScopedN("Write Tile file");
+                        if (tilePack.Write(tile_info, tile_job.encodedTexture.data(),
+                                           tile_job.encodedTexture.size())) {
+                            tile_job.state = TileWriteState::Written;
+                        }
+                    }
+                }
 
-            SDL_IOStream* file_io = SDL_IOFromFile(tile_filename.c_str(), "wb");
-            SDL_assert(file_io != nullptr);
-            SDL_WriteIO(file_io, tile_write.encodedTexture.data(), tile_write.encodedTexture.size());
-            SDL_CloseIO(file_io);
-            // SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Wrote tile encoded texture");
+                // Free the buffers here instead of on the main thread
+                eastl::vector<std::uint8_t>().swap(tile_job.rawTexture);
+                eastl::vector<std::uint8_t>().swap(tile_job.encodedTexture);
 
-            tile_write.state = TileWriteState::Written;
+                while (!tile_write_completed.TryPush(std::move(tile_job))) {
+                    std::this_thread::yield();
+                }
+            });
         }
         if (tile_write.state == TileWriteState::Written) {
-            ZoneScopedN("Write Tile file");
-            const auto& tileInfo = tileInfos[tile];
-            SDL_assert(tileInfos.contains(tile));
-            SDL_assert(layerInfos.contains(tileInfo.layer));
-            layerTilesSaved[tileInfo.layer].insert(tileInfo.pos);
-            layerTilesModified[tileInfo.layer].erase(tile);
+            SDL_assert(layerInfos.contains(tile_info.layer));
+            if (tile_write.empty) {
+                if (!tileToDelete.contains(tile)) {
+                    QueueTileDelete(tile_info.layer, tile);
+                }
+            } else {
+                tileIndex.SetSaved(tile_info.layer, tile_info.pos, true);
+                // Modified since it was reduced, the pack may hold something newer than the hash
+                const bool modified = layerTilesModified.at(tile_info.layer).contains(tile);
+                tileIndex.SetSavedHash(tile, modified ? TileIndex::HASH_NONE : tile_write.reduce.Hash());
+            }
             tiles_written.push_back(tile);
         }
     }
@@ -795,12 +1023,17 @@ void Canvas::UpdateTileUnloading() {
             if (!tileToUnload.contains(tile)) {
                 continue;
             }
-            const auto& tile_info = tileInfos.at(tile);
+            const auto tile_info = tileIndex.Coord(tile);
+            if (!tileToDelete.contains(tile) && layerTilesModified.at(tile_info.layer).contains(tile)) {
+                // Modified while it was being written, save it again before releasing it
+                QueueSaveTile(tile_info.layer, tile);
+                continue;
+            }
             if (!tileToDelete.contains(tile)) {
                 app->renderer.ReleaseTileTexture(tile);
-                layerTiles.at(tile_info.layer).erase(tile);
-                layerTilePos.at(tile_info.layer).erase(tileInfos.at(tile).pos);
-                tileInfos.erase(tile);
+                tileIndex.Erase(tile);
+                tileResidency.Remove(tile);
+                tilesCullPending.push_back(tile_info);
                 tilesUnassigned.push_back(tile);
             }
 
@@ -883,11 +1116,11 @@ void Canvas::StartBrushStroke(StrokePoint point) {
         }
         stroke_tile_affected.insert(tile);
 
-        if (!layerTilePos.at(selectedLayer).contains(tilePos)) {
+        if (tileIndex.Loaded(selectedLayer, tilePos) == TILE_INVALID) {
             const auto srcLayerTile = CreateTile(selectedLayer, tilePos);
             SDL_assert(srcLayerTile != TILE_INVALID && "Failed to create on selected layer during stroke");
         }
-        allTileStrokeAffected.insert(layerTilePos.at(selectedLayer).at(tilePos));
+        allTileStrokeAffected.insert(tileIndex.Loaded(selectedLayer, tilePos));
     }
 
     stroke_points.push_back(point);
@@ -952,11 +1185,11 @@ void Canvas::UpdateBrushStroke(StrokePoint point) {
             }
             stroke_tile_affected.insert(strokeLayerTile);
 
-            if (!layerTilePos.at(selectedLayer).contains(tile_pos)) {
+            if (tileIndex.Loaded(selectedLayer, tile_pos) == TILE_INVALID) {
                 const auto selectedLayerTile = CreateTile(selectedLayer, tile_pos);
                 SDL_assert(selectedLayerTile != TILE_INVALID && "Failed to create tile on selected layer");
             }
-            allTileStrokeAffected.insert(layerTilePos.at(selectedLayer).at(tile_pos));
+            allTileStrokeAffected.insert(tileIndex.Loaded(selectedLayer, tile_pos));
         }
     }
 }
@@ -969,6 +1202,8 @@ void Canvas::EndBrushStroke(StrokePoint point) {
 
     currentTileModificationCommand->SavePreviousTilesTexture(allTileStrokeAffected);
 
+    // The stroke tiles were resolved to RGBA8 by each paint, the merge reads them
+    app->renderer.ReleaseWetTextures();
     MergeLayer(strokeLayer, selectedLayer);
     DeleteLayer(strokeLayer);
     strokeLayer = 0;
@@ -1321,7 +1556,7 @@ void Canvas::StartEraserStroke(StrokePoint point) {
         if (tile != TILE_INVALID) {
             stroke_tile_affected.insert(tile);
             layerTilesModified[selectedLayer].insert(tile);
-            allTileStrokeAffected.insert(layerTilePos.at(selectedLayer).at(tile_pos));
+            allTileStrokeAffected.insert(tileIndex.Loaded(selectedLayer, tile_pos));
             tileTexturesToSave.insert(tile);
         }
     }
@@ -1388,7 +1623,7 @@ void Canvas::UpdateEraserStroke(StrokePoint point) {
                 stroke_tile_affected.insert(tile);
                 layerTilesModified[selectedLayer].insert(tile);
                 if (!allTileStrokeAffected.contains(tile)) {
-                    allTileStrokeAffected.insert(layerTilePos.at(selectedLayer).at(tile_pos));
+                    allTileStrokeAffected.insert(tileIndex.Loaded(selectedLayer, tile_pos));
                     tileTexturesToSave.insert(tile);
                 }
             }
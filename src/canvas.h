@@ -2,10 +2,17 @@
 
 #include "colors.h"
 #include "commands.h"
+#include "renderer.h"
+#include "ring_queue.h"
+#include "stroke.h"
+#include "tile_index.h"
+#include "tile_residency.h"
+#include "tile_pack.h"
 #include "viewport.h"
 #include <EASTL/unordered_map.h>
 #include <EASTL/unordered_set.h>
 #include <SDL3/SDL_gpu.h>
+#include <atomic>
 #include <cstdint>
 #include <glm/mat4x4.hpp>
 #include <glm/vec2.hpp>
@@ -39,13 +46,19 @@ public:
     ~Canvas() = default;
 
     void Update();
+    // Only the tiles entering or leaving the resident area of the view are culled, plus the ones loaded/unloaded since
+    // the last call
     void CullTiles(Viewport& viewport);
+    void CullAllTiles(const Viewport& viewport);
+    // Unload the least recently used tiles outside of the view while over the residency budget
+    void EvictTiles();
 
     void DeleteUpdate();
 
     // File Stuff
     bool CanQuit();
     bool Open();
+    void ImportLegacyTiles();
 
     // Viewport Stuff
     void ViewUpdateState(glm::vec2 cursor_pos);
@@ -78,17 +91,18 @@ public:
 
     Tile QueueLoadTile(Layer layer, glm::ivec2 position);
     void QueueUnloadTile(Layer layer, Tile tile);
+    // The tile is in the resident area, an eviction still saving it is cancelled
+    void UseTile(Tile tile);
     Tile CreateTile(Layer layer, glm::ivec2 position);
     bool QueueSaveTile(Layer layer, Tile tile);
     void QueueTileDelete(Layer layer, Tile tile);
-    void MergeTiles(Tile over_tile, Tile below_tile);
+    // Merge every (over, below) pair at once, the below tiles are marked modified
+    void MergeTiles(const eastl::vector<std::pair<Tile, Tile>>& tiles);
 
     App* app;
 
     LayerHeight layersCurrentMaxHeight = 0;
     eastl::unordered_map<Layer, LayerInfo> layerInfos;
-    eastl::unordered_map<Layer, eastl::unordered_set<Tile>> layerTiles;
-    eastl::unordered_map<Layer, eastl::unordered_map<glm::ivec2, Tile>> layerTilePos;
     eastl::unordered_set<Layer> layerToDelete;
     eastl::unordered_set<Layer> layersModified;
 
@@ -104,23 +118,36 @@ public:
     Layer layerLastAssigned = 0;
     eastl::vector<Layer> layersUnassigned;
 
-    // Move to a Tile Structs
-    eastl::unordered_map<Tile, TileCoord> tileInfos;
+    // Loaded and saved tiles of every layer
+    TileIndex tileIndex;
+    TileResidency tileResidency;
     Tile tileLastAssigned = 0;
     eastl::vector<Tile> tilesUnassigned;
     eastl::unordered_set<Tile> tileToUnload;
     eastl::unordered_set<Tile> tileToDelete;
-    eastl::unordered_map<Layer, eastl::unordered_set<glm::ivec2>> layerTilesSaved;
     eastl::unordered_map<Layer, eastl::unordered_set<Tile>> layerTilesModified;
     eastl::unordered_map<Layer, eastl::unordered_set<Tile>> allTileModified;
 
+    // Culling state, tilesCullAll is set when the layers change in a way the view delta can't see
+    bool tilesCullAll = true;
+    eastl::vector<TileCoord> tilesCullPending;
+    std::vector<glm::ivec2> tilesEntered;
+    std::vector<glm::ivec2> tilesLeft;
+
     std::string filename;
 
+    static constexpr Uint64 TILE_PACK_FLUSH_INTERVAL_MS = 1000;
+    TilePack tilePack;
+    Uint64 tilePackLastFlush = 0;
+    std::atomic<bool> tilePackCompacting = false;
+
+    // Runs the paint, erase and merge kernels on the tiles, the renderer or App::cpuStrokeBackend set by App::Init
+    PaintBackend* paintBackend = nullptr;
     bool stroke_started = false;
 
     enum class TileReadState : std::uint8_t {
         Queued,
-        Read,
+        Reading, // Owned by a job thread until it is decompressed in its upload slot
         Decompressed,
         Uploaded,
     };
@@ -129,17 +156,24 @@ public:
         Layer layer;
         Tile tile;
         TileReadState state;
-        eastl::vector<std::uint8_t> encodedTexture;
-        eastl::vector<std::uint8_t> rawTexture;
+        Renderer::TileUploadSlot uploadSlot;
     };
     eastl::unordered_map<Tile, TileReadStatus> tile_read_queue;
+    eastl::vector<std::pair<float, Tile>> tile_read_order; // Queued tiles sorted by Viewport::TileLoadPriority
     void UpdateTileLoading();
 
+    // Tiles being read and decoded on the job threads, the completion queue must be able to hold all of them
+    static constexpr size_t TILE_MAX_READ_JOBS = 64;
+    RingQueue<TileReadStatus> tile_read_completed{TILE_MAX_READ_JOBS * 2};
+    size_t tile_read_jobs = 0;
+
     enum class TileWriteState : std::uint8_t {
         Queued,
+        Reducing, // Waiting for its TileReduce
+        Reduced,  // Has to be downloaded
         Downloading,
         Downloaded,
-        Encoded,
+        Encoding, // Owned by a job thread until it is written
         Written,
     };
 
@@ -150,20 +184,26 @@ public:
         glm::ivec2 position;
         eastl::vector<std::uint8_t> encodedTexture;
         eastl::vector<std::uint8_t> rawTexture;
+        TileReduce reduce;
+        bool empty = false;
+        std::uint32_t failures = 0;
+        Uint64 retryTicks = 0; // A failed write is queued again, it waits for SDL_GetTicks to reach this
     };
     eastl::unordered_map<Tile, TileWriteStatus> tile_write_queue;
     void UpdateTileUnloading();
 
-    struct StrokePoint {
-        glm::vec4 color = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
-        glm::vec2 position;
-        float radius = 8.0f;
-        float flow = 0.5f;
-        float hardness = 0.5f;
-        float _pad0;
-        float _pad1;
-        float _pad2;
-    };
+    // Tiles being checked, encoded and written on the job threads
+    static constexpr size_t TILE_MAX_WRITE_JOBS = 64;
+    RingQueue<TileWriteStatus> tile_write_completed{TILE_MAX_WRITE_JOBS * 2};
+    size_t tile_write_jobs = 0;
+    size_t tile_downloads_skipped = 0; // Saves the reduction answered without downloading the tile
+    // A failed write is tried again after TILE_WRITE_RETRY_MS, doubled on every failure. After
+    // TILE_WRITE_MAX_FAILURES the tile isn't unloaded anymore, it stays loaded and modified.
+    static constexpr std::uint32_t TILE_WRITE_MAX_FAILURES = 5;
+    static constexpr Uint64 TILE_WRITE_RETRY_MS = 250;
+    size_t tile_write_failures = 0; // Tiles given up on
+
+    using StrokePoint = Midori::StrokePoint;
     eastl::vector<StrokePoint> stroke_points;
     eastl::unordered_set<Tile> stroke_tile_affected;
     eastl::hash_set<Tile> allTileStrokeAffected;
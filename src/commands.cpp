@@ -14,14 +14,15 @@ TileModificationCommand::TileModificationCommand(Canvas* canvas, Layer layer) :
 
 TileModificationCommand::~TileModificationCommand() {
     ZoneScoped;
+    // A copy into or from them may still be in flight
     for (const auto& [tile, texture] : previousTileTextures_) {
         SDL_assert(texture && "Texture is invalid");
-        SDL_ReleaseGPUTexture(canvas_->app->renderer.device, texture);
+        canvas_->app->renderer.ReleaseDeferred(texture);
     }
 
     for (const auto& [coord, texture] : newTileTextures_) {
         SDL_assert(texture && "Texture is invalid");
-        SDL_ReleaseGPUTexture(canvas_->app->renderer.device, texture);
+        canvas_->app->renderer.ReleaseDeferred(texture);
     }
 }
 
@@ -76,36 +77,17 @@ void TileModificationCommand::ApplyTilesTexture(
         return;
     }
 
-    eastl::hash_map<TileCoord, SDL_GPUTexture*> copiedTileToChange(tileCoordsTexture.size());
-
-    SDL_GPUCommandBuffer* cmd = SDL_AcquireGPUCommandBuffer(canvas_->app->renderer.device);
-    SDL_assert(cmd && "Failed to create copyPass command buffer");
-    SDL_GPUCopyPass* copyPass = SDL_BeginGPUCopyPass(cmd);
-
+    // The archived textures are copied into the slices of the tiles, every tile must be loaded first
+    eastl::vector<eastl::pair<Tile, SDL_GPUTexture*>> tilesToChange;
+    tilesToChange.reserve(tileCoordsTexture.size());
     for (const auto& [tileCoord, texture] : tileCoordsTexture) {
-        const auto duplicatedTileTexture = canvas_->app->renderer.DuplicateTileTexture(copyPass, texture);
-        SDL_assert(duplicatedTileTexture && "Failed to duplicate tile texture");
-        copiedTileToChange[tileCoord] = duplicatedTileTexture;
-    }
-
-    SDL_EndGPUCopyPass(copyPass);
-    auto* fence = SDL_SubmitGPUCommandBufferAndAcquireFence(cmd);
-    SDL_assert(fence && "Failed to submit copyPass command buffer");
-
-    // TODO: Think about a way to make this less blocking. Especialy when
-    // spamming Undo or Redo
-    SDL_WaitForGPUFences(canvas_->app->renderer.device, true, &fence, 1);
-    SDL_ReleaseGPUFence(canvas_->app->renderer.device, fence);
-
-    for (const auto& [tileCoord, texture] : copiedTileToChange) {
         SDL_assert(texture && "Texture is invalid");
         Tile tile = canvas_->GetLoadedTileAt(layer_, tileCoord.pos);
         if (tile == TILE_INVALID) {
             tile = canvas_->CreateTile(layer_, tileCoord.pos);
             SDL_assert(tile != TILE_INVALID && "Failed to create tile");
 
-            // We don't need to upload a blank texture to this tile, this could be avoided by providing an override to
-            // CreateTile with the SDL_GPUTexture* as an input, stating this is the texture you will use
+            // We don't need to clear this tile, the archived texture is copied over it
             canvas_->app->renderer.tile_texture_uninitialized.erase(tile);
 
             // This tile was originally unloaded, so we unload it as soon as possible, the Tile is still save to use for
@@ -113,14 +95,23 @@ void TileModificationCommand::ApplyTilesTexture(
             canvas_->QueueUnloadTile(layer_, tile);
         }
         SDL_assert(tile != TILE_INVALID && "Failed to create tile");
+        SDL_assert(canvas_->app->renderer.HasTileTexture(tile) && "No tile texture found");
+        tilesToChange.emplace_back(tile, texture);
+    }
 
-        SDL_assert(canvas_->app->renderer.tile_textures.contains(tile) && "No tile texture found");
-        SDL_GPUTexture* originalTexture = canvas_->app->renderer.tile_textures.at(tile);
-        SDL_ReleaseGPUTexture(canvas_->app->renderer.device, originalTexture);
+    SDL_GPUCommandBuffer* cmd = SDL_AcquireGPUCommandBuffer(canvas_->app->renderer.device);
+    SDL_assert(cmd && "Failed to create copyPass command buffer");
+    SDL_GPUCopyPass* copyPass = SDL_BeginGPUCopyPass(cmd);
 
-        canvas_->app->renderer.tile_textures[tile] = texture;
+    for (const auto& [tile, texture] : tilesToChange) {
+        canvas_->app->renderer.CopyToTileTexture(copyPass, texture, tile);
         canvas_->layerTilesModified.at(layer_).insert(tile);
     }
+
+    SDL_EndGPUCopyPass(copyPass);
+    // Only the GPU reads the tiles afterwards, the frames are submitted after this on the same queue
+    const bool submitted = SDL_SubmitGPUCommandBuffer(cmd);
+    SDL_assert(submitted && "Failed to submit copyPass command buffer");
 }
 
 eastl::hash_map<TileCoord, SDL_GPUTexture*>
@@ -137,22 +128,17 @@ TileModificationCommand::DuplicateTileTextures(const eastl::hash_set<Tile>& tile
 
     for (const auto& tile : tiles) {
         SDL_assert(tile != TILE_INVALID && "Tile is invalid");
-        SDL_assert(canvas_->app->renderer.tile_textures.contains(tile) && "Tile texture not found");
+        SDL_assert(canvas_->app->renderer.HasTileTexture(tile) && "Tile texture not found");
 
-        const auto tileTexture = canvas_->app->renderer.tile_textures.at(tile);
-        const auto duplicatedTileTexture = canvas_->app->renderer.DuplicateTileTexture(copyPass, tileTexture);
+        const auto duplicatedTileTexture = canvas_->app->renderer.DuplicateTileTexture(copyPass, tile);
         SDL_assert(duplicatedTileTexture && "Failed to duplicate tile texture");
-        duplicatedTilesTexture[canvas_->tileInfos.at(tile)] = duplicatedTileTexture;
+        duplicatedTilesTexture[canvas_->tileIndex.Coord(tile)] = duplicatedTileTexture;
     }
 
     SDL_EndGPUCopyPass(copyPass);
-    auto* fence = SDL_SubmitGPUCommandBufferAndAcquireFence(cmd);
-    SDL_assert(fence && "Failed to submit copyPass command buffer");
-
-    // TODO: Think about a way to make this less blocking. Especialy when
-    // spamming Undo or Redo
-    SDL_WaitForGPUFences(canvas_->app->renderer.device, true, &fence, 1);
-    SDL_ReleaseGPUFence(canvas_->app->renderer.device, fence);
+    // The duplicates are only ever copied back by the GPU, ordered after this submit
+    const bool submitted = SDL_SubmitGPUCommandBuffer(cmd);
+    SDL_assert(submitted && "Failed to submit copyPass command buffer");
 
     return duplicatedTilesTexture;
 }
@@ -0,0 +1,87 @@
+#include "composite_tiles.h"
+
+#include <SDL3/SDL_assert.h>
+#include <algorithm>
+#include <utility>
+
+namespace Midori {
+
+void CompositeTileCache::BeginFrame() {
+    frame_++;
+}
+
+CompositeTileCache::Slot CompositeTileCache::Use(const glm::ivec2 pos, bool& stale) {
+    auto it = entries_.find(pos);
+    if (it == entries_.end()) {
+        Entry entry;
+        if (!freeIds_.empty()) {
+            entry.id = freeIds_.back();
+            freeIds_.pop_back();
+        } else {
+            SDL_assert(nextId_ < TILES_MAX && "Too many composite tiles");
+            entry.id = nextId_++;
+        }
+        atlas_.Allocate(entry.id, COMPOSITE_LAYER);
+        it = entries_.emplace(pos, entry).first;
+    }
+
+    it->second.used = frame_;
+    stale = it->second.stale;
+    return atlas_.At(it->second.id);
+}
+
+void CompositeTileCache::Composited(const glm::ivec2 pos) {
+    auto it = entries_.find(pos);
+    SDL_assert(it != entries_.end() && "Composite not found");
+    it->second.stale = false;
+}
+
+void CompositeTileCache::Mark(const glm::ivec2 pos) {
+    auto it = entries_.find(pos);
+    if (it != entries_.end()) {
+        it->second.stale = true;
+    }
+}
+
+void CompositeTileCache::MarkAll() {
+    for (auto& [pos, entry] : entries_) {
+        entry.stale = true;
+    }
+}
+
+void CompositeTileCache::Trim(const size_t budget) {
+    if (entries_.size() <= budget) {
+        return;
+    }
+
+    eastl::vector<std::pair<std::uint64_t, glm::ivec2>> unused;
+    for (const auto& [pos, entry] : entries_) {
+        if (entry.used != frame_) {
+            unused.emplace_back(entry.used, pos);
+        }
+    }
+    const size_t count = std::min(entries_.size() - budget, unused.size());
+    std::partial_sort(unused.begin(), unused.begin() + count, unused.end(),
+                      [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    for (size_t i = 0; i < count; i++) {
+        const auto it = entries_.find(unused[i].second);
+        atlas_.Free(it->second.id);
+        freeIds_.push_back(it->second.id);
+        entries_.erase(it);
+    }
+}
+
+bool CompositeTileCache::Contains(const glm::ivec2 pos) const {
+    return entries_.find(pos) != entries_.end();
+}
+
+size_t CompositeTileCache::PageCount() const {
+    return atlas_.PageCount();
+}
+
+size_t CompositeTileCache::Size() const {
+    return entries_.size();
+}
+
+} // namespace Midori
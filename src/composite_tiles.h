@@ -0,0 +1,60 @@
+#pragma once
+
+#include "tile_atlas.h"
+#include "tiles.h"
+#include <EASTL/unordered_map.h>
+#include <EASTL/vector.h>
+#include <cstddef>
+#include <cstdint>
+#include <glm/vec2.hpp>
+
+namespace Midori {
+
+// Composites of the layer stack, one per canvas tile position.
+//
+// Instead of blending a window sized texture per layer, the visible layers are blended tile by tile into a composite
+// tile, kept in texture array pages like the layer tiles. Memory follows the number of visible tiles instead of the
+// number of layers, and a composite is only blended again once a tile under it changed, so panning reuses the ones
+// already made.
+
+class CompositeTileCache {
+public:
+    using Slot = TileAtlas::Slot;
+
+    // Composites not used since the last frame are the first to be evicted
+    void BeginFrame();
+    // The composite of the position, allocated if needed. `stale` is set when it has to be blended again.
+    Slot Use(glm::ivec2 pos, bool& stale);
+    // The composite was blended, it is up to date until the position is marked again
+    void Composited(glm::ivec2 pos);
+
+    // A tile at the position changed
+    void Mark(glm::ivec2 pos);
+    // The layer stack or the background changed
+    void MarkAll();
+
+    // Evicts the least recently used composites, never one used this frame, until at most `budget` are left
+    void Trim(size_t budget);
+
+    [[nodiscard]] bool Contains(glm::ivec2 pos) const;
+    [[nodiscard]] size_t PageCount() const;
+    [[nodiscard]] size_t Size() const;
+
+private:
+    // The atlas wants an owner for its pages, every composite shares one
+    static constexpr Layer COMPOSITE_LAYER = 0;
+
+    struct Entry {
+        Tile id = TILE_INVALID; // Slot in the atlas
+        bool stale = true;
+        std::uint64_t used = 0; // Frame
+    };
+
+    TileAtlas atlas_;
+    eastl::unordered_map<glm::ivec2, Entry> entries_;
+    eastl::vector<Tile> freeIds_;
+    Tile nextId_ = 0;
+    std::uint64_t frame_ = 0;
+};
+
+} // namespace Midori
@@ -0,0 +1,60 @@
+#include "cpu_stroke_backend.h"
+
+#include "app.h"
+#include <SDL3/SDL_assert.h>
+#include <SDL3/SDL_log.h>
+#include <cstring>
+#include <tracy/Tracy.hpp>
+
+namespace Midori {
+
+CpuStrokeBackend::CpuStrokeBackend(App* app, BrushTip tip) : app_(app), cpu_(jobs_, std::move(tip)) {
+}
+
+bool CpuStrokeBackend::PaintTiles(const eastl::vector<Tile>& tiles, const eastl::vector<StrokePoint>& points,
+                                  const PaintMode mode) {
+    ZoneScoped;
+    for (const auto tile : tiles) {
+        if (!cpu_.HasTile(tile)) {
+            cpu_.CreateTile(tile, app_->canvas.tileIndex.Coord(tile));
+        }
+    }
+    if (!cpu_.PaintTiles(tiles, points, mode)) {
+        return false;
+    }
+
+    Renderer& renderer = app_->renderer;
+    for (const auto tile : tiles) {
+        Renderer::TileUploadSlot slot;
+        if (!renderer.ReserveTileUpload(slot)) {
+            // Every slot waits for a submit, make room and try again
+            if (!renderer.SubmitTileUploads() || !renderer.ReserveTileUpload(slot)) {
+                SDL_LogError(SDL_LOG_CATEGORY_RENDER, "No upload slot for stroke tile %u", tile);
+                return false;
+            }
+        }
+        std::memcpy(slot.pixels, cpu_.TilePixels(tile), TILE_WIDTH * TILE_HEIGHT * 4);
+        if (renderer.CommitTileUpload(tile, slot) != Renderer::TileTextureError::None) {
+            return false;
+        }
+    }
+    // Shown this frame rather than the next. An upload landing in a page that tile reads are still decoding into waits
+    // for the next frame.
+    return renderer.SubmitTileUploads();
+}
+
+bool CpuStrokeBackend::MergeTileTextures(const eastl::vector<std::pair<Tile, Tile>>& tiles) {
+    ZoneScoped;
+    if (!app_->renderer.SubmitTileUploads() || !app_->renderer.MergeTileTextures(tiles)) {
+        return false;
+    }
+    for (const auto& [over_tile, below_tile] : tiles) {
+        SDL_assert(!cpu_.HasTile(below_tile) && "Painted tiles are only merged into other tiles");
+        if (cpu_.HasTile(over_tile)) {
+            cpu_.ReleaseTile(over_tile);
+        }
+    }
+    return true;
+}
+
+} // namespace Midori
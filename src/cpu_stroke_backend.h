@@ -0,0 +1,28 @@
+#pragma once
+
+#include "jobs.h"
+#include "paint_backend.h"
+
+namespace Midori {
+
+class App;
+
+// Selected with --cpu-paint or MIDORI_PAINT_BACKEND=cpu, for the GPUs the paint shaders misbehave on and to compare the
+// two paths. The stroke tiles are painted by CpuPaintBackend and uploaded to their tile textures after each paint, the
+// merges still run on the GPU. Stroke tiles start transparent on both sides, nothing has to be downloaded first.
+class CpuStrokeBackend final : public PaintBackend {
+public:
+    CpuStrokeBackend(App* app, BrushTip tip);
+
+    bool PaintTiles(const eastl::vector<Tile>& tiles, const eastl::vector<StrokePoint>& points,
+                    PaintMode mode) override;
+    // The CPU copies of the over tiles are dropped, like the stroke layer after the merge
+    bool MergeTileTextures(const eastl::vector<std::pair<Tile, Tile>>& tiles) override;
+
+private:
+    App* app_;
+    JobSystem jobs_; // Its own workers, a paint doesn't wait on the tile reads
+    CpuPaintBackend cpu_;
+};
+
+} // namespace Midori
@@ -0,0 +1,80 @@
+#include "dirty_regions.h"
+
+#include <SDL3/SDL_assert.h>
+
+namespace Midori {
+
+bool TileRect::Empty() const {
+    return min.x >= max.x || min.y >= max.y;
+}
+
+void TileRect::Add(const glm::ivec2 pos) {
+    if (Empty()) {
+        min = pos;
+        max = pos + 1;
+        return;
+    }
+    min = glm::min(min, pos);
+    max = glm::max(max, pos + 1);
+}
+
+DirtyRegions::Region& DirtyRegions::Get(const Layer layer) {
+    SDL_assert(layer != LAYER_INVALID);
+    if (layer >= layers_.size()) {
+        layers_.resize(static_cast<size_t>(layer) + 1);
+    }
+    return layers_[layer];
+}
+
+void DirtyRegions::MarkTile(const Layer layer, const glm::ivec2 pos) {
+    auto& region = Get(layer);
+    if (!region.full) {
+        region.rect.Add(pos);
+    }
+}
+
+void DirtyRegions::MarkLayer(const Layer layer) {
+    auto& region = Get(layer);
+    region.full = true;
+    region.rect = {};
+}
+
+void DirtyRegions::MarkAll() {
+    for (auto& region : layers_) {
+        region.full = true;
+        region.rect = {};
+    }
+}
+
+bool DirtyRegions::Dirty(const Layer layer) const {
+    return layer < layers_.size() && (layers_[layer].full || !layers_[layer].rect.Empty());
+}
+
+bool DirtyRegions::Full(const Layer layer) const {
+    return layer < layers_.size() && layers_[layer].full;
+}
+
+TileRect DirtyRegions::Rect(const Layer layer) const {
+    return layer < layers_.size() ? layers_[layer].rect : TileRect{};
+}
+
+void DirtyRegions::Clean(const Layer layer) {
+    if (layer < layers_.size()) {
+        layers_[layer] = Region{};
+    }
+}
+
+CompositeGroup LayerCompositeGroup(const LayerInfo& layer, const LayerInfo* selected, const Layer stroke) {
+    if (selected != nullptr && layer.id == selected->id) {
+        return CompositeGroup::Selected;
+    }
+    if (layer.id == stroke) {
+        return CompositeGroup::Stroke;
+    }
+    if (selected == nullptr || layer.height > selected->height) {
+        return CompositeGroup::Below;
+    }
+    return CompositeGroup::Above;
+}
+
+} // namespace Midori
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "layers.h"
+#include <EASTL/vector.h>
+#include <cstdint>
+#include <glm/vec2.hpp>
+
+namespace Midori {
+
+// Rectangle of tiles, `max` is exclusive
+struct TileRect {
+    glm::ivec2 min{0};
+    glm::ivec2 max{0};
+
+    [[nodiscard]] bool Empty() const;
+    void Add(glm::ivec2 pos);
+};
+
+// What changed in each layer texture since it was last drawn. The layer textures are cached between frames, only the
+// tiles marked here are redrawn and composited again. A full layer is redrawn whole, because the view moved, the window
+// was resized or the texture was just created.
+class DirtyRegions {
+public:
+    void MarkTile(Layer layer, glm::ivec2 pos);
+    void MarkLayer(Layer layer);
+    void MarkAll();
+
+    [[nodiscard]] bool Dirty(Layer layer) const;
+    [[nodiscard]] bool Full(Layer layer) const;
+    [[nodiscard]] TileRect Rect(Layer layer) const;
+    // The layer was drawn
+    void Clean(Layer layer);
+
+private:
+    struct Region {
+        TileRect rect;
+        bool full = false;
+    };
+
+    Region& Get(Layer layer);
+
+    eastl::vector<Region> layers_; // Indexed by Layer
+};
+
+// The layers below and above the selected one are flattened in two caches, a redrawn layer dirties the cache of its
+// group. The stroke layer is redrawn every frame of a stroke, so like the selected layer it stays out of the caches and
+// is blended on its own. A layer with a greater height is further down.
+enum class CompositeGroup : std::uint8_t {
+    Below,
+    Selected,
+    Stroke,
+    Above,
+};
+[[nodiscard]] CompositeGroup LayerCompositeGroup(const LayerInfo& layer, const LayerInfo* selected, Layer stroke);
+
+} // namespace Midori
@@ -0,0 +1,40 @@
+#include "frame_times.h"
+
+#include <SDL3/SDL_assert.h>
+#include <algorithm>
+#include <cmath>
+
+namespace Midori {
+
+void FrameTimes::Add(const float ms) {
+    if (times_.size() < CAPACITY) {
+        times_.push_back(ms);
+        return;
+    }
+    times_[next_] = ms;
+    next_ = (next_ + 1) % CAPACITY;
+}
+
+void FrameTimes::Clear() {
+    times_.clear();
+    next_ = 0;
+}
+
+float FrameTimes::Percentile(const float p) const {
+    SDL_assert(p >= 0.0f && p <= 1.0f);
+    if (times_.empty()) {
+        return 0.0f;
+    }
+    // Nearest rank
+    eastl::vector<float> sorted = times_;
+    const size_t rank = static_cast<size_t>(std::ceil(p * static_cast<float>(sorted.size())));
+    const size_t index = std::min(rank > 0 ? rank - 1 : 0, sorted.size() - 1);
+    std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+    return sorted[index];
+}
+
+size_t FrameTimes::Size() const {
+    return times_.size();
+}
+
+} // namespace Midori
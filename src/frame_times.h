@@ -0,0 +1,25 @@
+#pragma once
+
+#include <EASTL/vector.h>
+#include <cstddef>
+
+namespace Midori {
+
+// The last frame times, in milliseconds. Averages hide the stalls, percentiles of the window show them.
+class FrameTimes {
+public:
+    static constexpr size_t CAPACITY = 240;
+
+    void Add(float ms);
+    void Clear();
+
+    // p in [0, 1], 0 when empty
+    [[nodiscard]] float Percentile(float p) const;
+    [[nodiscard]] size_t Size() const;
+
+private:
+    eastl::vector<float> times_; // Ring once full
+    size_t next_ = 0;
+};
+
+} // namespace Midori
@@ -0,0 +1,90 @@
+#include "jobs.h"
+
+#include <algorithm>
+#include <format>
+#include <string>
+#include <tracy/Tracy.hpp>
+#include <utility>
+
+namespace Midori {
+
+JobSystem::JobSystem(size_t threadCount) {
+    if (threadCount == 0) {
+        const size_t hardwareThreads = std::thread::hardware_concurrency();
+        threadCount = std::max<size_t>(hardwareThreads > 1 ? hardwareThreads - 1 : 1, 1);
+    }
+
+    threads_.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; i++) {
+        threads_.emplace_back(&JobSystem::WorkerLoop, this, i);
+    }
+}
+
+JobSystem::~JobSystem() {
+    // Jobs already submitted are still run so their results are not lost
+    Wait();
+    {
+        std::scoped_lock lock(mutex_);
+        stopping_ = true;
+    }
+    jobAvailable_.notify_all();
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+void JobSystem::Submit(Job job) {
+    {
+        std::scoped_lock lock(mutex_);
+        jobs_.push_back(std::move(job));
+        pending_++;
+    }
+    jobAvailable_.notify_one();
+}
+
+void JobSystem::Wait() {
+    ZoneScoped;
+    std::unique_lock lock(mutex_);
+    jobsDone_.wait(lock, [this] { return pending_ == 0; });
+}
+
+size_t JobSystem::ThreadCount() const {
+    return threads_.size();
+}
+
+size_t JobSystem::Pending() {
+    std::scoped_lock lock(mutex_);
+    return pending_;
+}
+
+void JobSystem::WorkerLoop(const size_t index) {
+    const std::string name = std::format("Midori Worker {}", index);
+    tracy::SetThreadName(name.c_str());
+
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock lock(mutex_);
+            jobAvailable_.wait(lock, [this] { return stopping_ || !jobs_.empty(); });
+            if (jobs_.empty()) {
+                return;
+            }
+            job = std::move(jobs_.front());
+            jobs_.pop_front();
+        }
+
+        job();
+
+        bool done = false;
+        {
+            std::scoped_lock lock(mutex_);
+            pending_--;
+            done = pending_ == 0;
+        }
+        if (done) {
+            jobsDone_.notify_all();
+        }
+    }
+}
+
+} // namespace Midori
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Midori {
+
+// Small fixed size worker pool, jobs are executed in submission order by the first available thread.
+// Anything touching SDL_GPU or the canvas state must stay on the main thread, jobs should only work on data they own
+// and hand their result back through a RingQueue.
+class JobSystem {
+public:
+    using Job = std::function<void()>;
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem(JobSystem&&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+    JobSystem& operator=(JobSystem&&) = delete;
+
+    // 0 picks the hardware concurrency minus the main thread
+    explicit JobSystem(size_t threadCount = 0);
+    ~JobSystem();
+
+    void Submit(Job job);
+
+    // Block until every submitted job has finished
+    void Wait();
+
+    [[nodiscard]] size_t ThreadCount() const;
+    [[nodiscard]] size_t Pending();
+
+private:
+    void WorkerLoop(size_t index);
+
+    std::vector<std::thread> threads_;
+    std::mutex mutex_;
+    std::condition_variable jobAvailable_;
+    std::condition_variable jobsDone_;
+    std::deque<Job> jobs_;
+    size_t pending_ = 0;
+    bool stopping_ = false;
+};
+
+} // namespace Midori
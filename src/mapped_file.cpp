@@ -0,0 +1,107 @@
+#include "mapped_file.h"
+
+#include <SDL3/SDL_log.h>
+#include <tracy/Tracy.hpp>
+
+#if defined(MIDORI_WINDOWS)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Midori {
+
+#if defined(MIDORI_WINDOWS)
+
+std::shared_ptr<MappedFile> MappedFile::Open(const std::string& path) {
+    ZoneScoped;
+
+    const int length = MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, nullptr, 0);
+    std::wstring wpath(length, L'\0');
+    MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, wpath.data(), length);
+
+    // Share write and delete so the file can still be appended to and replaced while it is mapped
+    HANDLE file = CreateFileW(wpath.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                              nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to open %s for mapping", path.c_str());
+        return nullptr;
+    }
+
+    LARGE_INTEGER size{};
+    GetFileSizeEx(file, &size);
+
+    std::shared_ptr<MappedFile> mapped(new MappedFile());
+    mapped->size_ = static_cast<size_t>(size.QuadPart);
+    if (mapped->size_ > 0) {
+        mapped->mapping_ = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapped->mapping_ != nullptr) {
+            mapped->data_ = static_cast<const std::uint8_t*>(MapViewOfFile(mapped->mapping_, FILE_MAP_READ, 0, 0, 0));
+        }
+    }
+    CloseHandle(file);
+
+    if (mapped->size_ > 0 && mapped->data_ == nullptr) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to map %s", path.c_str());
+        return nullptr;
+    }
+
+    return mapped;
+}
+
+MappedFile::~MappedFile() {
+    if (data_ != nullptr) {
+        UnmapViewOfFile(data_);
+    }
+    if (mapping_ != nullptr) {
+        CloseHandle(mapping_);
+    }
+}
+
+#else
+
+std::shared_ptr<MappedFile> MappedFile::Open(const std::string& path) {
+    ZoneScoped;
+
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to open %s for mapping: %s", path.c_str(),
+                     strerror(errno));
+        return nullptr;
+    }
+
+    struct stat st{};
+    fstat(fd, &st);
+
+    std::shared_ptr<MappedFile> mapped(new MappedFile());
+    mapped->size_ = static_cast<size_t>(st.st_size);
+    if (mapped->size_ > 0) {
+        void* data = mmap(nullptr, mapped->size_, PROT_READ, MAP_SHARED, fd, 0);
+        if (data == MAP_FAILED) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to map %s: %s", path.c_str(), strerror(errno));
+            close(fd);
+            return nullptr;
+        }
+        mapped->data_ = static_cast<const std::uint8_t*>(data);
+    }
+    close(fd);
+
+    return mapped;
+}
+
+MappedFile::~MappedFile() {
+    if (data_ != nullptr) {
+        munmap(const_cast<std::uint8_t*>(data_), size_);
+    }
+}
+
+#endif
+
+} // namespace Midori
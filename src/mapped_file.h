@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace Midori {
+
+// Read only view of a whole file mapped in memory. The view stays valid as long as the object is alive, even if the
+// file is appended to or replaced, so readers on other threads keep a shared_ptr to it while they use the data.
+class MappedFile {
+public:
+    MappedFile(const MappedFile&) = delete;
+    MappedFile(MappedFile&&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile& operator=(MappedFile&&) = delete;
+
+    [[nodiscard]] static std::shared_ptr<MappedFile> Open(const std::string& path);
+    ~MappedFile();
+
+    [[nodiscard]] const std::uint8_t* Data() const {
+        return data_;
+    }
+    [[nodiscard]] size_t Size() const {
+        return size_;
+    }
+
+private:
+    MappedFile() = default;
+
+    const std::uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+#if defined(MIDORI_WINDOWS)
+    void* mapping_ = nullptr;
+#endif
+};
+
+} // namespace Midori
@@ -0,0 +1,132 @@
+#include "paint_backend.h"
+
+#include "jobs.h"
+#include <SDL3/SDL_assert.h>
+#include <tracy/Tracy.hpp>
+
+namespace Midori {
+
+CpuPaintBackend::CpuPaintBackend(JobSystem& jobs, BrushTip tip) : jobs_(jobs), tip_(std::move(tip)) {
+    SDL_assert(!tip_.Empty());
+}
+
+void CpuPaintBackend::CreateTile(const Tile tile, const TileCoord coord) {
+    SDL_assert(tile != TILE_INVALID);
+    SDL_assert(!HasTile(tile) && "Tile already created");
+    tiles_[tile] = CpuTile{
+        .coord = coord,
+        .pixels = eastl::vector<std::uint8_t>(TILE_WIDTH * TILE_HEIGHT * 4, 0),
+    };
+}
+
+void CpuPaintBackend::ReleaseTile(const Tile tile) {
+    SDL_assert(HasTile(tile));
+    tiles_.erase(tile);
+}
+
+bool CpuPaintBackend::HasTile(const Tile tile) const {
+    return tiles_.find(tile) != tiles_.end();
+}
+
+std::uint8_t* CpuPaintBackend::TilePixels(const Tile tile) {
+    SDL_assert(HasTile(tile));
+    return tiles_.at(tile).pixels.data();
+}
+
+void CpuPaintBackend::SetLayerOpacity(const Layer layer, const float opacity) {
+    layerOpacity_[layer] = opacity;
+}
+
+const StrokeStream& CpuPaintBackend::Stream() const {
+    return stream_;
+}
+
+bool CpuPaintBackend::PaintTiles(const eastl::vector<Tile>& tiles, const eastl::vector<StrokePoint>& points,
+                                 const PaintMode mode) {
+    ZoneScoped;
+    for (const auto tile : tiles) {
+        if (!HasTile(tile)) {
+            return false;
+        }
+    }
+
+    // Like the renderer, an erase gives back the wet tiles even where no dab lands and the next paint starts them again
+    // from the RGBA8 pixels
+    tilePositions_.clear();
+    for (const auto tile : tiles) {
+        CpuTile& cpu_tile = tiles_.at(tile);
+        tilePositions_.push_back(cpu_tile.coord.pos);
+        if (mode == PaintMode::Erase) {
+            cpu_tile.wet.clear();
+        }
+    }
+
+    // Streamed in the chunks the renderer would use, a chunk is done before the next one starts
+    for (const auto& chunk : stream_.Plan(points.size())) {
+        // Each tile only goes through the dabs touching it, like the shaders
+        const StrokePoint* chunk_points = points.data() + chunk.first;
+        bins_.Build(tilePositions_.data(), tilePositions_.size(), chunk_points, chunk.count);
+
+        // Tiles don't share pixels, no job waits on another
+        for (size_t i = 0; i < tiles.size(); i++) {
+            if (bins_.Count(i) == 0) {
+                continue;
+            }
+            CpuTile* cpu_tile = &tiles_.at(tiles[i]);
+            const std::uint32_t* indices = bins_.Indices().data() + bins_.Offset(i);
+            const size_t indices_num = bins_.Count(i);
+            jobs_.Submit([this, cpu_tile, chunk_points, indices, indices_num, mode]() {
+                if (mode == PaintMode::Erase) {
+                    PaintPixels(mode, chunk_points, indices, indices_num, tip_, cpu_tile->coord.pos,
+                                cpu_tile->pixels.data());
+                    return;
+                }
+                if (cpu_tile->wet.empty()) {
+                    cpu_tile->wet.resize(WET_TILE_SIZE);
+                    WetPixels(cpu_tile->pixels.data(), cpu_tile->wet.data());
+                }
+                PaintPixels(mode, chunk_points, indices, indices_num, tip_, cpu_tile->coord.pos,
+                            cpu_tile->wet.data(), cpu_tile->pixels.data());
+            });
+        }
+        jobs_.Wait();
+    }
+    return true;
+}
+
+bool CpuPaintBackend::MergeTileTextures(const eastl::vector<std::pair<Tile, Tile>>& tiles) {
+    ZoneScoped;
+    for (const auto& [over_tile, below_tile] : tiles) {
+        if (!HasTile(over_tile) || !HasTile(below_tile)) {
+            return false;
+        }
+    }
+
+    // A job per below tile, the tiles merged into the same one are merged in order
+    eastl::unordered_map<Tile, size_t> below_group;
+    eastl::vector<eastl::vector<std::pair<Tile, Tile>>> groups;
+    for (const auto& pair : tiles) {
+        const auto [it, inserted] = below_group.insert({pair.second, groups.size()});
+        if (inserted) {
+            groups.emplace_back();
+        }
+        groups[it->second].push_back(pair);
+    }
+
+    for (auto& group : groups) {
+        jobs_.Submit([this, group = std::move(group)]() {
+            for (const auto& [over_tile, below_tile] : group) {
+                const CpuTile& over = tiles_.at(over_tile);
+                CpuTile& below = tiles_.at(below_tile);
+                below.wet.clear();
+                const auto opacity = layerOpacity_.find(over.coord.layer);
+                const float over_opacity = opacity != layerOpacity_.end() ? opacity->second : 1.0f;
+                MergePixels(over.pixels.data(), over_opacity, below.pixels.data(), TILE_WIDTH * TILE_HEIGHT);
+            }
+        });
+    }
+    jobs_.Wait();
+    return true;
+}
+
+} // namespace Midori
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "blend.h"
+#include "stroke.h"
+#include "stroke_bins.h"
+#include "stroke_stream.h"
+#include "tiles.h"
+#include <EASTL/unordered_map.h>
+#include <EASTL/vector.h>
+#include <cstdint>
+#include <utility>
+
+namespace Midori {
+
+class JobSystem;
+
+// What runs the paint, erase and merge kernels on the tiles. The renderer runs paint.comp, erase.comp and merge.comp on
+// the GPU tiles, CpuPaintBackend runs their CPU versions from blend.h on tiles it keeps in memory.
+class PaintBackend {
+public:
+    PaintBackend() = default;
+    PaintBackend(const PaintBackend&) = delete;
+    PaintBackend(PaintBackend&&) = delete;
+    PaintBackend& operator=(const PaintBackend&) = delete;
+    PaintBackend& operator=(PaintBackend&&) = delete;
+    virtual ~PaintBackend() = default;
+
+    // Every dab is applied to the tiles it touches, in order. The tiles are on the same layer.
+    virtual bool PaintTiles(const eastl::vector<Tile>& tiles, const eastl::vector<StrokePoint>& points,
+                            PaintMode mode) = 0;
+    // Merge every (over, below) pair, the below tiles are modified
+    virtual bool MergeTileTextures(const eastl::vector<std::pair<Tile, Tile>>& tiles) = 0;
+};
+
+// Headless backend for the machines without a GPU, the tests and the benchmarks. Tiles are RGBA8 buffers, each tile is
+// painted or merged by its own job and its pixels are blended four at a time.
+//
+// Like the stroke tiles of the renderer, a tile painted in PaintMode::Paint gets a wet tile: the dabs build up in float
+// there and the RGBA8 pixels are resolved from it after each paint. It lives until the tile is released, or until the
+// RGBA8 pixels are changed some other way (an erase or a merge into it).
+class CpuPaintBackend final : public PaintBackend {
+public:
+    CpuPaintBackend(JobSystem& jobs, BrushTip tip);
+
+    // Transparent, like a tile texture that was just created
+    void CreateTile(Tile tile, TileCoord coord);
+    void ReleaseTile(Tile tile);
+    [[nodiscard]] bool HasTile(Tile tile) const;
+    // TILE_WIDTH x TILE_HEIGHT RGBA8
+    [[nodiscard]] std::uint8_t* TilePixels(Tile tile);
+    // Used by the merge like LayerInfo::opacity, 1 by default
+    void SetLayerOpacity(Layer layer, float opacity);
+    [[nodiscard]] const StrokeStream& Stream() const;
+
+    bool PaintTiles(const eastl::vector<Tile>& tiles, const eastl::vector<StrokePoint>& points,
+                    PaintMode mode) override;
+    bool MergeTileTextures(const eastl::vector<std::pair<Tile, Tile>>& tiles) override;
+
+private:
+    struct CpuTile {
+        TileCoord coord;
+        eastl::vector<std::uint8_t> pixels;
+        eastl::vector<float> wet; // Empty without a wet tile
+    };
+
+    JobSystem& jobs_;
+    BrushTip tip_;
+    StrokeStream stream_;
+    StrokeBins bins_;
+    eastl::vector<glm::ivec2> tilePositions_;
+    eastl::unordered_map<Tile, CpuTile> tiles_;
+    eastl::unordered_map<Layer, float> layerOpacity_;
+};
+
+} // namespace Midori
@@ -14,6 +14,7 @@
 #include <cstdint>
 #include <cstring>
 #include <format>
+#include <limits>
 #include <glm/gtc/matrix_transform.hpp>
 #include <imgui.h>
 #include <qoi.h>
@@ -25,6 +26,7 @@
 // #include "shaders/dxil/layer.vs.h"
 // #include "shaders/dxil/merge.cs.h"
 // #include "shaders/dxil/paint.cs.h"
+// #include "shaders/dxil/reduce.cs.h"
 // #include "shaders/dxil/tile.ps.h"
 // #include "shaders/dxil/tile.vs.h"
 // #elif defined(MIDORI_LINUX)
@@ -33,6 +35,7 @@
 #include "shaders/spirv/layer.vert.h"
 #include "shaders/spirv/merge.comp.h"
 #include "shaders/spirv/paint.comp.h"
+#include "shaders/spirv/reduce.comp.h"
 #include "shaders/spirv/tile.frag.h"
 #include "shaders/spirv/tile.vert.h"
 // #endif
@@ -79,7 +82,7 @@ bool Renderer::Init() {
         return false;
     }
     SDL_SetGPUSwapchainParameters(device, app->window, SDL_GPU_SWAPCHAINCOMPOSITION_SDR, SDL_GPU_PRESENTMODE_VSYNC);
-    SDL_SetGPUAllowedFramesInFlight(device, 1);
+    SDL_SetGPUAllowedFramesInFlight(device, FRAMES_IN_FLIGHT);
 
     swapchain_format = SDL_GetGPUSwapchainTextureFormat(device, app->window);
 
@@ -97,6 +100,11 @@ bool Renderer::Init() {
         return false;
     }
 
+    if (!InitReduce()) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to initialize reduce compute pipeline");
+        return false;
+    }
+
     if (!InitLayers()) {
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to initialize renderer layers");
         return false;
@@ -252,9 +260,573 @@ bool Renderer::InitLayers() {
         return false;
     }
 
+    return CreateWindowTextures();
+}
+
+bool Renderer::CreateWindowTextures() {
+    ZoneScoped;
+    ReleaseDeferred(clear_texture);
+    ReleaseDeferred(background_texture);
+    ReleaseDeferred(below_texture);
+    ReleaseDeferred(above_texture);
+    ReleaseDeferred(background_tile_texture);
+
+    const SDL_GPUTextureCreateInfo texture_create_info = {
+        .type = SDL_GPU_TEXTURETYPE_2D,
+        .format = texture_format,
+        .usage = SDL_GPU_TEXTUREUSAGE_SAMPLER | SDL_GPU_TEXTUREUSAGE_COLOR_TARGET,
+        .width = (Uint32)app->window_size.x,
+        .height = (Uint32)app->window_size.y,
+        .layer_count_or_depth = 1,
+        .num_levels = 1,
+        .sample_count = SDL_GPU_SAMPLECOUNT_1,
+    };
+    clear_texture = SDL_CreateGPUTexture(device, &texture_create_info);
+    background_texture = SDL_CreateGPUTexture(device, &texture_create_info);
+    if (clear_texture == nullptr || background_texture == nullptr) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create clear textures: %s", SDL_GetError());
+        return false;
+    }
+
+    // Sampled by the merge like the layer textures, an array of one slice
+    SDL_GPUTextureCreateInfo cache_create_info = texture_create_info;
+    cache_create_info.type = SDL_GPU_TEXTURETYPE_2D_ARRAY;
+    cache_create_info.usage |= SDL_GPU_TEXTUREUSAGE_COMPUTE_STORAGE_SIMULTANEOUS_READ_WRITE;
+    below_texture = SDL_CreateGPUTexture(device, &cache_create_info);
+    above_texture = SDL_CreateGPUTexture(device, &cache_create_info);
+    if (below_texture == nullptr || above_texture == nullptr) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create composite cache textures: %s", SDL_GetError());
+        return false;
+    }
+
+    SDL_GPUTextureCreateInfo tile_create_info = texture_create_info;
+    tile_create_info.width = TILE_WIDTH;
+    tile_create_info.height = TILE_HEIGHT;
+    background_tile_texture = SDL_CreateGPUTexture(device, &tile_create_info);
+    if (background_tile_texture == nullptr) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create background tile texture: %s", SDL_GetError());
+        return false;
+    }
+
+    // Filled by the next frame, everything is drawn again meanwhile
+    clear_textures_stale = true;
+    composite_full = true;
+    layer_dirty.MarkAll();
+    return true;
+}
+
+SDL_Rect Renderer::TileRectToScreen(const TileRect& rect) const {
+    const glm::mat4 clip = viewport_render_data.projection * viewport_render_data.view;
+    const glm::vec2 tile_size = glm::vec2(TILE_WIDTH, TILE_HEIGHT);
+    const glm::vec2 window_size = glm::vec2(app->window_size);
+
+    glm::vec2 min = glm::vec2(std::numeric_limits<float>::max());
+    glm::vec2 max = glm::vec2(std::numeric_limits<float>::lowest());
+    const glm::vec2 corners[] = {
+        glm::vec2(rect.min),
+        glm::vec2(rect.max.x, rect.min.y),
+        glm::vec2(rect.min.x, rect.max.y),
+        glm::vec2(rect.max),
+    };
+    for (const auto& corner : corners) {
+        const glm::vec4 ndc = clip * glm::vec4(corner * tile_size, 0.0f, 1.0f);
+        // NDC y goes up, texture rows go down
+        const glm::vec2 pixel = glm::vec2(ndc.x / ndc.w + 1.0f, 1.0f - (ndc.y / ndc.w)) * 0.5f * window_size;
+        min = glm::min(min, pixel);
+        max = glm::max(max, pixel);
+    }
+
+    // A pixel of margin for the filtering at the edges of the tiles
+    const glm::ivec2 screen_min = glm::max(glm::ivec2(glm::floor(min)) - 1, glm::ivec2(0));
+    const glm::ivec2 screen_max = glm::min(glm::ivec2(glm::ceil(max)) + 1, app->window_size);
+    if (screen_max.x <= screen_min.x || screen_max.y <= screen_min.y) {
+        return SDL_Rect{};
+    }
+    return SDL_Rect{
+        .x = screen_min.x,
+        .y = screen_min.y,
+        .w = screen_max.x - screen_min.x,
+        .h = screen_max.y - screen_min.y,
+    };
+}
+
+void Renderer::CopyTextureRegion(SDL_GPUCopyPass* copy_pass, SDL_GPUTexture* src, SDL_GPUTexture* dst,
+                                 const SDL_Rect& rect) {
+    const SDL_GPUTextureLocation source = {
+        .texture = src, .mip_level = 0, .layer = 0, .x = (Uint32)rect.x, .y = (Uint32)rect.y, .z = 0};
+    const SDL_GPUTextureLocation destination = {
+        .texture = dst, .mip_level = 0, .layer = 0, .x = (Uint32)rect.x, .y = (Uint32)rect.y, .z = 0};
+    SDL_CopyGPUTextureToTexture(copy_pass, &source, &destination, rect.w, rect.h, 1, false);
+}
+
+bool Renderer::CompositeRegion(SDL_GPUCommandBuffer* command_buffer, SDL_GPUTexture* dst,
+                               const std::uint32_t dst_layer, const SDL_Rect& rect,
+                               const eastl::vector<CompositeSource>& sources) {
+    ZoneScoped;
+    const glm::ivec2 pos = {rect.x, rect.y};
+    const glm::ivec2 size = {rect.w, rect.h};
+    const glm::ivec2 merge_compute_invocations = glm::ceil(glm::vec2(size) / 32.0f);
+    MergeRenderData merge_render_data = {
+        .src_blend_mode = static_cast<std::uint32_t>(BlendMode::Alpha),
+        .src_opacity = 1.0f,
+        .src_pos = pos,
+        .src_size = size,
+        .dst_blend_mode = static_cast<std::uint32_t>(BlendMode::Alpha),
+        .dst_opacity = 1.0f,
+        .dst_pos = pos,
+        .dst_size = size,
+        .src_layer = 0,
+    };
+    const SDL_GPUStorageTextureReadWriteBinding merge_layer_binding[1] = {{
+        .texture = dst,
+        .mip_level = 0,
+        .layer = dst_layer,
+    }};
+    SDL_GPUComputePass* merge_compute_pass =
+        SDL_BeginGPUComputePass(command_buffer, merge_layer_binding, 1, nullptr, 0);
+    frame_counters.passes++;
+    if (merge_compute_pass == nullptr) {
+        SDL_LogError(SDL_LOG_CATEGORY_RENDER, "Failed to create merge compute pass: %s", SDL_GetError());
+        return false;
+    }
+    SDL_BindGPUComputePipeline(merge_compute_pass, merge_compute_pipeline);
+
+    for (const auto& source : sources) {
+        ZoneScopedN("Blend layer");
+        merge_render_data.src_blend_mode = static_cast<std::uint32_t>(source.blend_mode);
+        merge_render_data.src_opacity = source.opacity;
+        merge_render_data.src_layer = source.slice;
+        SDL_PushGPUComputeUniformData(command_buffer, 0, &merge_render_data, sizeof(MergeRenderData));
+
+        const SDL_GPUTextureSamplerBinding samplers[] = {{
+            .texture = source.texture,
+            .sampler = layer_sampler,
+        }};
+        SDL_BindGPUComputeSamplers(merge_compute_pass, 0, samplers, 1);
+        SDL_DispatchGPUCompute(merge_compute_pass, merge_compute_invocations.x, merge_compute_invocations.y, 1);
+        frame_counters.dispatches++;
+    }
+
+    SDL_EndGPUComputePass(merge_compute_pass);
+    return true;
+}
+
+bool Renderer::UploadTileInstances(SDL_GPUCopyPass* copy_pass) {
+    const auto& tile_instances = tile_instance_batch.Instances();
+    if (tile_instances.empty()) {
+        return true;
+    }
+    if (!ReserveTileInstances(tile_instances.size())) {
+        return false;
+    }
+
+    auto* instances_ptr = SDL_MapGPUTransferBuffer(device, tile_instance_transfer_buffer, true);
+    if (instances_ptr == nullptr) {
+        SDL_LogError(SDL_LOG_CATEGORY_RENDER, "Failed to map tile instance transfer buffer: %s", SDL_GetError());
+        return false;
+    }
+    memcpy(instances_ptr, tile_instances.data(), tile_instances.size() * sizeof(TileInstance));
+    SDL_UnmapGPUTransferBuffer(device, tile_instance_transfer_buffer);
+
+    const SDL_GPUTransferBufferLocation source = {
+        .transfer_buffer = tile_instance_transfer_buffer,
+        .offset = 0,
+    };
+    const SDL_GPUBufferRegion destination = {
+        .buffer = tile_instance_buffer,
+        .offset = 0,
+        .size = static_cast<Uint32>(tile_instances.size() * sizeof(TileInstance)),
+    };
+    SDL_UploadToGPUBuffer(copy_pass, &source, &destination, true);
+    frame_counters.uploads++;
+    return true;
+}
+
+bool Renderer::CompositeLayerTextures(SDL_GPUCommandBuffer* command_buffer,
+                                      const eastl::vector<LayerInfo>& layer_rendering) {
+    ZoneScoped;
+    // Only the dirty regions of the layers are drawn again. The layers below and above the selected one are kept
+    // flattened in two caches, a cache is only blended again where one of its layers changed. The selected and the
+    // stroke layers are blended between them on every composite.
+    const SDL_Rect window_rect = {.x = 0, .y = 0, .w = app->window_size.x, .h = app->window_size.y};
+    eastl::vector<eastl::pair<Layer, SDL_Rect>> layer_redraw;
+    eastl::vector<LayerInfo> layers_below;
+    eastl::vector<LayerInfo> layers_above;
+    const LayerInfo* layer_selected = nullptr;
+    const LayerInfo* layer_stroke = nullptr;
+    SDL_Rect below_rect = {};
+    SDL_Rect above_rect = {};
+    SDL_Rect composite_rect = {};
+    {
+        ZoneScopedN("Dirty regions");
+        const auto selected = std::ranges::find(layer_rendering, app->canvas.selectedLayer, &LayerInfo::id);
+        layer_selected = selected != layer_rendering.end() ? &*selected : nullptr;
+        const Layer stroke_layer = app->canvas.strokeLayer != 0 ? app->canvas.strokeLayer : LAYER_INVALID;
+
+        // Bottom to top
+        for (const auto& layer_info : layer_rendering) {
+            const CompositeGroup group = LayerCompositeGroup(layer_info, layer_selected, stroke_layer);
+            if (group == CompositeGroup::Below) {
+                layers_below.push_back(layer_info);
+            } else if (group == CompositeGroup::Above) {
+                layers_above.push_back(layer_info);
+            } else if (group == CompositeGroup::Stroke) {
+                layer_stroke = &layer_info;
+            }
+
+            if (!layer_dirty.Dirty(layer_info.id)) {
+                continue;
+            }
+            const SDL_Rect rect = layer_dirty.Full(layer_info.id)
+                                      ? window_rect
+                                      : TileRectToScreen(layer_dirty.Rect(layer_info.id));
+            layer_dirty.Clean(layer_info.id);
+            if (SDL_RectEmpty(&rect)) {
+                continue;
+            }
+            layer_redraw.emplace_back(layer_info.id, rect);
+            SDL_GetRectUnion(&composite_rect, &rect, &composite_rect);
+            if (group == CompositeGroup::Below) {
+                SDL_GetRectUnion(&below_rect, &rect, &below_rect);
+            } else if (group == CompositeGroup::Above) {
+                SDL_GetRectUnion(&above_rect, &rect, &above_rect);
+            }
+        }
+        if (composite_full) {
+            below_rect = window_rect;
+            above_rect = window_rect;
+            composite_rect = window_rect;
+            composite_full = false;
+        }
+        last_layer_rendered_num = layer_redraw.size();
+    }
+
+    { // Tile instances
+        ZoneScopedN("Gathering tile instances");
+        tile_instance_batch.Begin(tile_pages.size());
+        for (const auto& [layer, rect] : layer_redraw) {
+            tile_instance_batch.BeginLayer(layer);
+            for (const auto& tile : app->canvas.tileIndex.LayerTiles(layer)) {
+                if (app->canvas.tileToDelete.contains(tile) || app->canvas.tileToUnload.contains(tile)) {
+                    continue;
+                }
+                const auto slot = tile_atlas.At(tile);
+                tile_instance_batch.Add(slot.page, slot.slice, app->canvas.tileIndex.Coord(tile).pos);
+            }
+            tile_instance_batch.EndLayer();
+        }
+    }
+
+    const auto& tile_instances = tile_instance_batch.Instances();
+    const auto& tile_draws = tile_instance_batch.Draws();
+    if (!tile_instances.empty() || !layer_redraw.empty() || !SDL_RectEmpty(&composite_rect)) {
+        ZoneScopedN("Uploading tile instances and clearing dirty regions");
+        SDL_GPUCopyPass* copy_pass = SDL_BeginGPUCopyPass(command_buffer);
+        frame_counters.passes++;
+
+        if (!UploadTileInstances(copy_pass)) {
+            SDL_EndGPUCopyPass(copy_pass);
+            return false;
+        }
+
+        // Full regions are cleared by the load op of their pass instead
+        for (const auto& [layer, rect] : layer_redraw) {
+            if (SDL_RectsEqual(&rect, &window_rect)) {
+                continue;
+            }
+            CopyTextureRegion(copy_pass, clear_texture, layer_textures[layer], rect);
+        }
+        // The caches start from what is under them
+        if (!SDL_RectEmpty(&below_rect)) {
+            CopyTextureRegion(copy_pass, background_texture, below_texture, below_rect);
+        }
+        if (!SDL_RectEmpty(&above_rect) && !layers_above.empty()) {
+            CopyTextureRegion(copy_pass, clear_texture, above_texture, above_rect);
+        }
+
+        SDL_EndGPUCopyPass(copy_pass);
+    }
+
+    { // Tile Rendering
+        ZoneScopedN("Rendering Tile");
+        size_t draw = 0;
+        for (const auto& [layer, rect] : layer_redraw) {
+            ZoneScopedN("Render Tile");
+            const SDL_GPUColorTargetInfo target_info = {
+                .texture = layer_textures[layer],
+                .clear_color = SDL_FColor{.r = 0.0f, .g = 0.0f, .b = 0.0f, .a = 0.0f},
+                .load_op = SDL_RectsEqual(&rect, &window_rect) ? SDL_GPU_LOADOP_CLEAR : SDL_GPU_LOADOP_LOAD,
+                .store_op = SDL_GPU_STOREOP_STORE,
+            };
+            SDL_GPURenderPass* render_pass = SDL_BeginGPURenderPass(command_buffer, &target_info, 1, nullptr);
+            frame_counters.passes++;
+            if (draw == tile_draws.size() || tile_draws[draw].layer != layer) {
+                // Nothing loaded in this layer, it is only cleared
+                SDL_EndGPURenderPass(render_pass);
+                continue;
+            }
+
+            SDL_BindGPUGraphicsPipeline(render_pass, tile_graphics_pipeline);
+            SDL_SetGPUScissor(render_pass, &rect);
+            SDL_PushGPUVertexUniformData(command_buffer, 0, &viewport_render_data, sizeof(ViewportRenderData));
+            SDL_BindGPUVertexStorageBuffers(render_pass, 0, &tile_instance_buffer, 1);
+
+            for (; draw < tile_draws.size() && tile_draws[draw].layer == layer; draw++) {
+                const TileDraw& tile_draw = tile_draws[draw];
+                const TileDrawRenderData tile_draw_render_data = {
+                    .instance_offset = tile_draw.instance_offset,
+                    .size = TILE_WIDTH,
+                };
+                SDL_PushGPUVertexUniformData(command_buffer, 1, &tile_draw_render_data,
+                                             sizeof(TileDrawRenderData));
+
+                const SDL_GPUTextureSamplerBinding samplers[] = {{
+                    .texture = tile_pages[tile_draw.page],
+                    .sampler = tile_sampler,
+                }};
+                SDL_BindGPUFragmentSamplers(render_pass, 0, samplers, 1);
+
+                // The instance id starts at 0 whatever the first instance is on some backends, the offset is
+                // pushed instead
+                SDL_DrawGPUPrimitives(render_pass, 4, tile_draw.instance_count, 0, 0);
+                last_rendered_tiles_num += tile_draw.instance_count;
+                frame_counters.draws++;
+            }
+
+            SDL_EndGPURenderPass(render_pass);
+        }
+    }
+
+    if (!SDL_RectEmpty(&composite_rect)) { // Layer rendering
+        ZoneScopedN("Layer blending and rendering");
+
+        // Blending is associative, so the layers above can be flattened on their own and blended at once
+        eastl::vector<CompositeSource> sources;
+        sources.reserve(layers_below.size() + layers_above.size());
+        const auto add_layers = [&](const eastl::vector<LayerInfo>& layers) {
+            sources.clear();
+            for (const auto& layer_info : layers) {
+                sources.push_back(CompositeSource{
+                    .texture = layer_textures[layer_info.id],
+                    .opacity = layer_info.opacity,
+                    .blend_mode = layer_info.blendMode,
+                });
+            }
+        };
+        if (!SDL_RectEmpty(&below_rect) && !layers_below.empty()) {
+            add_layers(layers_below);
+            if (!CompositeRegion(command_buffer, below_texture, 0, below_rect, sources)) {
+                return false;
+            }
+        }
+        if (!SDL_RectEmpty(&above_rect) && !layers_above.empty()) {
+            add_layers(layers_above);
+            if (!CompositeRegion(command_buffer, above_texture, 0, above_rect, sources)) {
+                return false;
+            }
+        }
+
+        {
+            SDL_GPUCopyPass* copy_pass = SDL_BeginGPUCopyPass(command_buffer);
+            frame_counters.passes++;
+            CopyTextureRegion(copy_pass, below_texture, canvas_texture, composite_rect);
+            SDL_EndGPUCopyPass(copy_pass);
+        }
+
+        sources.clear();
+        for (const LayerInfo* layer_info : {layer_selected, layer_stroke}) {
+            if (layer_info != nullptr) {
+                sources.push_back(CompositeSource{
+                    .texture = layer_textures[layer_info->id],
+                    .opacity = layer_info->opacity,
+                    .blend_mode = layer_info->blendMode,
+                });
+            }
+        }
+        if (!layers_above.empty()) {
+            sources.push_back(CompositeSource{.texture = above_texture});
+        }
+        if (!sources.empty() && !CompositeRegion(command_buffer, canvas_texture, 0, composite_rect, sources)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Renderer::CompositeTiles(SDL_GPUCommandBuffer* command_buffer, const eastl::vector<LayerInfo>& layer_rendering,
+                              const SDL_FColor& bg_color) {
+    ZoneScoped;
+    const std::vector<glm::ivec2> visible_tiles = app->canvas.viewport.VisibleTiles();
+
+    // Composites missing or changed since they were blended
+    eastl::vector<std::pair<glm::ivec2, CompositeTileCache::Slot>> stale_composites;
+    {
+        ZoneScopedN("Gathering composite tiles");
+        composite_tiles.BeginFrame();
+        eastl::vector<CompositeTileCache::Slot> slots;
+        slots.reserve(visible_tiles.size());
+        for (const auto& pos : visible_tiles) {
+            bool stale = false;
+            const auto slot = composite_tiles.Use(pos, stale);
+            if (slot.page == composite_pages.size()) {
+                ZoneScopedN("Creating composite page");
+                const SDL_GPUTextureCreateInfo texture_create_info = {
+                    .type = SDL_GPU_TEXTURETYPE_2D_ARRAY,
+                    .format = texture_format,
+                    .usage = SDL_GPU_TEXTUREUSAGE_SAMPLER | SDL_GPU_TEXTUREUSAGE_COMPUTE_STORAGE_SIMULTANEOUS_READ_WRITE,
+                    .width = (Uint32)TILE_WIDTH,
+                    .height = (Uint32)TILE_HEIGHT,
+                    .layer_count_or_depth = TileAtlas::PAGE_SLICES,
+                    .num_levels = 1,
+                    .sample_count = SDL_GPU_SAMPLECOUNT_1,
+                };
+                SDL_GPUTexture* texture = SDL_CreateGPUTexture(device, &texture_create_info);
+                if (texture == nullptr) {
+                    SDL_LogError(SDL_LOG_CATEGORY_RENDER, "Failed to create composite page: %s", SDL_GetError());
+                    return false;
+                }
+                composite_pages.push_back(texture);
+            }
+            if (stale) {
+                stale_composites.emplace_back(pos, slot);
+            }
+            slots.push_back(slot);
+        }
+
+        // The composites aren't in any layer, they are all drawn as one
+        tile_instance_batch.Begin(composite_pages.size());
+        tile_instance_batch.BeginLayer(0);
+        for (size_t i = 0; i < visible_tiles.size(); i++) {
+            tile_instance_batch.Add(slots[i].page, slots[i].slice, visible_tiles[i]);
+        }
+        tile_instance_batch.EndLayer();
+        last_composited_tiles_num = stale_composites.size();
+    }
+
+    {
+        SDL_GPUCopyPass* copy_pass = SDL_BeginGPUCopyPass(command_buffer);
+        frame_counters.passes++;
+        if (!UploadTileInstances(copy_pass)) {
+            SDL_EndGPUCopyPass(copy_pass);
+            return false;
+        }
+        // The composites start from the background
+        for (const auto& [pos, slot] : stale_composites) {
+            const SDL_GPUTextureLocation source = {
+                .texture = background_tile_texture, .mip_level = 0, .layer = 0, .x = 0, .y = 0, .z = 0};
+            const SDL_GPUTextureLocation destination = {
+                .texture = composite_pages[slot.page], .mip_level = 0, .layer = slot.slice, .x = 0, .y = 0, .z = 0};
+            SDL_CopyGPUTextureToTexture(copy_pass, &source, &destination, TILE_WIDTH, TILE_HEIGHT, 1, false);
+        }
+        SDL_EndGPUCopyPass(copy_pass);
+    }
+
+    { // Blending the layer tiles of each position, bottom to top
+        ZoneScopedN("Blending composite tiles");
+        const SDL_Rect tile_rect = {.x = 0, .y = 0, .w = (int)TILE_WIDTH, .h = (int)TILE_HEIGHT};
+        eastl::vector<CompositeSource> sources;
+        sources.reserve(layer_rendering.size());
+        for (const auto& [pos, slot] : stale_composites) {
+            sources.clear();
+            for (const auto& layer_info : layer_rendering) {
+                const Tile tile = app->canvas.tileIndex.Loaded(layer_info.id, pos);
+                if (tile == TILE_INVALID || !HasTileTexture(tile) || app->canvas.tileToDelete.contains(tile) ||
+                    app->canvas.tileToUnload.contains(tile)) {
+                    continue;
+                }
+                sources.push_back(CompositeSource{
+                    .texture = TilePage(tile),
+                    .slice = TileSlice(tile),
+                    .opacity = layer_info.opacity,
+                    .blend_mode = layer_info.blendMode,
+                });
+            }
+            composite_tiles.Composited(pos);
+            if (sources.empty()) {
+                continue;
+            }
+            if (!CompositeRegion(command_buffer, composite_pages[slot.page], slot.slice, tile_rect, sources)) {
+                return false;
+            }
+        }
+    }
+
+    // Enough to pan back and forth without blending everything again
+    composite_tiles.Trim(std::max(visible_tiles.size() * 2, (size_t)TileAtlas::PAGE_SLICES));
+
+    { // Drawing the composites
+        ZoneScopedN("Drawing composite tiles");
+        const SDL_GPUColorTargetInfo target_info = {
+            .texture = canvas_texture,
+            .clear_color = bg_color,
+            .load_op = SDL_GPU_LOADOP_CLEAR,
+            .store_op = SDL_GPU_STOREOP_STORE,
+        };
+        SDL_GPURenderPass* render_pass = SDL_BeginGPURenderPass(command_buffer, &target_info, 1, nullptr);
+        frame_counters.passes++;
+        SDL_BindGPUGraphicsPipeline(render_pass, tile_graphics_pipeline);
+        SDL_PushGPUVertexUniformData(command_buffer, 0, &viewport_render_data, sizeof(ViewportRenderData));
+        SDL_BindGPUVertexStorageBuffers(render_pass, 0, &tile_instance_buffer, 1);
+        for (const auto& tile_draw : tile_instance_batch.Draws()) {
+            const TileDrawRenderData tile_draw_render_data = {
+                .instance_offset = tile_draw.instance_offset,
+                .size = TILE_WIDTH,
+            };
+            SDL_PushGPUVertexUniformData(command_buffer, 1, &tile_draw_render_data, sizeof(TileDrawRenderData));
+
+            const SDL_GPUTextureSamplerBinding samplers[] = {{
+                .texture = composite_pages[tile_draw.page],
+                .sampler = tile_sampler,
+            }};
+            SDL_BindGPUFragmentSamplers(render_pass, 0, samplers, 1);
+            SDL_DrawGPUPrimitives(render_pass, 4, tile_draw.instance_count, 0, 0);
+            last_rendered_tiles_num += tile_draw.instance_count;
+            frame_counters.draws++;
+        }
+        SDL_EndGPURenderPass(render_pass);
+    }
+
+    return true;
+}
+
+void Renderer::MarkTileDirty(const TileCoord coord) {
+    layer_dirty.MarkTile(coord.layer, coord.pos);
+    composite_tiles.Mark(coord.pos);
+}
+
+bool Renderer::SetCompositeMode(const CompositeMode mode) {
+    ZoneScoped;
+    if (mode == composite_mode) {
+        return true;
+    }
+
+    if (mode == CompositeMode::Tiles) {
+        // Only the composite tiles are needed now
+        for (auto& [layer, texture] : layer_textures) {
+            ReleaseDeferred(texture);
+        }
+        layer_textures.clear();
+        composite_tiles.MarkAll();
+        composite_mode = mode;
+        return true;
+    }
+
+    composite_mode = mode;
+    for (const auto& [layer, info] : app->canvas.layerInfos) {
+        if (!CreateLayerTexture(layer)) {
+            return false;
+        }
+    }
+    composite_full = true;
     return true;
 }
 
+void Renderer::MarkTileDirty(const Tile tile) {
+    if (app->canvas.tileIndex.Contains(tile)) {
+        MarkTileDirty(app->canvas.tileIndex.Coord(tile));
+    }
+}
+
 bool Renderer::InitTiles() {
     ZoneScoped;
     const SDL_GPUShaderCreateInfo vertex_shader_create_info = {
@@ -265,7 +837,7 @@ bool Renderer::InitTiles() {
         .stage = SDL_GPU_SHADERSTAGE_VERTEX,
         .num_samplers = 0,
         .num_storage_textures = 0,
-        .num_storage_buffers = 0,
+        .num_storage_buffers = 1,
         .num_uniform_buffers = 2,
     };
     tile_vertex_shader = SDL_CreateGPUShader(device, &vertex_shader_create_info);
@@ -386,55 +958,26 @@ bool Renderer::InitTiles() {
         .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
         .size = TILE_MAX_UPLOAD_TRANSFER * TILE_WIDTH * TILE_HEIGHT * 4,
     };
-    tile_upload_buffer = SDL_CreateGPUTransferBuffer(device, &upload_buffer_create_info);
-    if (tile_upload_buffer == nullptr) {
-        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create tile upload buffer: %s", SDL_GetError());
-        return false;
-    }
-
-    tile_upload_buffer_ptr = (std::uint8_t*)SDL_MapGPUTransferBuffer(device, tile_upload_buffer, false);
-    if (tile_upload_buffer_ptr == nullptr) {
-        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to map tile upload transfer buffer: %s", SDL_GetError());
-        return false;
-    }
-    free_tile_upload_offset.reserve(TILE_MAX_UPLOAD_TRANSFER);
-    for (size_t i = 0; i < TILE_MAX_UPLOAD_TRANSFER; i++) {
-        free_tile_upload_offset.push_back(i * TILE_WIDTH * TILE_HEIGHT * 4);
-    }
-
-    const SDL_GPUTransferBufferCreateInfo download_buffer_create_info = {
-        .usage = SDL_GPU_TRANSFERBUFFERUSAGE_DOWNLOAD,
-        .size = TILE_MAX_DOWNLOAD_TRANSFER * TILE_WIDTH * TILE_HEIGHT * 4,
-    };
-    tile_download_buffer = SDL_CreateGPUTransferBuffer(device, &download_buffer_create_info);
-    if (tile_download_buffer == nullptr) {
-        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create tile download buffer: %s", SDL_GetError());
-        return false;
-    }
-    tile_download_buffer_ptr = (std::uint8_t*)SDL_MapGPUTransferBuffer(device, tile_download_buffer, false);
-    if (tile_download_buffer_ptr == nullptr) {
-        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to map tile download transfer buffer: %s", SDL_GetError());
-        return false;
-    }
-    free_tile_download_offset.reserve(TILE_MAX_DOWNLOAD_TRANSFER);
-    for (size_t i = 0; i < TILE_MAX_DOWNLOAD_TRANSFER; i++) {
-        free_tile_download_offset.push_back(i * TILE_WIDTH * TILE_HEIGHT * 4);
-    }
+    for (auto& page : tile_upload_pages) {
+        page.buffer = SDL_CreateGPUTransferBuffer(device, &upload_buffer_create_info);
+        if (page.buffer == nullptr) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create tile upload buffer: %s", SDL_GetError());
+            return false;
+        }
 
-    const SDL_GPUTransferBufferCreateInfo tile_blank_texture_buffer_create_info = {
-        .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
-        .size = TILE_WIDTH * TILE_HEIGHT * 4,
-    };
-    tile_blank_texture_buffer = SDL_CreateGPUTransferBuffer(device, &tile_blank_texture_buffer_create_info);
-    if (tile_blank_texture_buffer == nullptr) {
-        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create tile upload buffer: %s", SDL_GetError());
-        return false;
+        page.ptr = (std::uint8_t*)SDL_MapGPUTransferBuffer(device, page.buffer, false);
+        if (page.ptr == nullptr) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to map tile upload transfer buffer: %s",
+                         SDL_GetError());
+            return false;
+        }
+        page.free_offsets.reserve(TILE_MAX_UPLOAD_TRANSFER);
+        for (size_t i = 0; i < TILE_MAX_UPLOAD_TRANSFER; i++) {
+            page.free_offsets.push_back(i * TILE_WIDTH * TILE_HEIGHT * 4);
+        }
     }
 
-    auto* buf = (uint8_t*)SDL_MapGPUTransferBuffer(device, tile_blank_texture_buffer, false);
-    memset(buf, 0, TILE_WIDTH * TILE_HEIGHT * 4);
-    SDL_UnmapGPUTransferBuffer(device, tile_blank_texture_buffer);
-
+    // The download batches are made when the ring first needs them
     return true;
 }
 
@@ -463,6 +1006,32 @@ bool Renderer::InitMerge() {
     return true;
 }
 
+bool Renderer::InitReduce() {
+    const SDL_GPUComputePipelineCreateInfo create_info = {
+        .code_size = sizeof(shader_reduce_comp),
+        .code = reinterpret_cast<const Uint8*>(shader_reduce_comp),
+        .entrypoint = "main",
+        .format = shaderFormat,
+        .num_samplers = 1, // tile page
+        .num_readonly_storage_textures = 0,
+        .num_readonly_storage_buffers = 0,
+        .num_readwrite_storage_textures = 0,
+        .num_readwrite_storage_buffers = 1, // results
+        .num_uniform_buffers = 1,
+        .threadcount_x = 256,
+        .threadcount_y = 1,
+        .threadcount_z = 1,
+    };
+    reduce_compute_pipeline = SDL_CreateGPUComputePipeline(device, &create_info);
+    if (reduce_compute_pipeline == nullptr) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to initialize reduce compute pipeline: %s", SDL_GetError());
+        return false;
+    }
+
+    // The batches are made when the ring first needs them
+    return true;
+}
+
 bool Renderer::InitPaint() {
     const SDL_GPUComputePipelineCreateInfo paint_create_info = {
         .code_size = sizeof(shader_paint_comp),
@@ -471,8 +1040,8 @@ bool Renderer::InitPaint() {
         .format = shaderFormat,
         .num_samplers = 1, // alpha brush
         .num_readonly_storage_textures = 0,
-        .num_readonly_storage_buffers = 1,   // stroke buffer
-        .num_readwrite_storage_textures = 1, // dst texture
+        .num_readonly_storage_buffers = 3,   // stroke buffer + dab indices + brush falloffs
+        .num_readwrite_storage_textures = 2, // dst texture + wet texture
         .num_readwrite_storage_buffers = 0,
         .num_uniform_buffers = 2, // tile + stroke
         .threadcount_x = 32,
@@ -492,7 +1061,7 @@ bool Renderer::InitPaint() {
         .format = shaderFormat,
         .num_samplers = 1, // alpha brush
         .num_readonly_storage_textures = 0,
-        .num_readonly_storage_buffers = 1,   // stroke buffer
+        .num_readonly_storage_buffers = 3,   // stroke buffer + dab indices + brush falloffs
         .num_readwrite_storage_textures = 1, // dst texture
         .num_readwrite_storage_buffers = 0,
         .num_uniform_buffers = 2, // tile + stroke
@@ -506,23 +1075,7 @@ bool Renderer::InitPaint() {
         return false;
     }
 
-    const SDL_GPUBufferCreateInfo buffer_create_info = {
-        .usage = SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_READ,
-        .size = MAX_PAINT_STROKE_POINTS * sizeof(Canvas::StrokePoint),
-    };
-    paint_stroke_point_buffer = SDL_CreateGPUBuffer(device, &buffer_create_info);
-    if (paint_stroke_point_buffer == nullptr) {
-        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create paint stroke buffer: %s", SDL_GetError());
-        return false;
-    }
-
-    const SDL_GPUTransferBufferCreateInfo upload_buffer_create_info = {
-        .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
-        .size = MAX_PAINT_STROKE_POINTS * sizeof(Canvas::StrokePoint),
-    };
-    paint_stroke_point_transfer_buffer = SDL_CreateGPUTransferBuffer(device, &upload_buffer_create_info);
-    if (paint_stroke_point_transfer_buffer == nullptr) {
-        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create paint stroke upload buffer: %s", SDL_GetError());
+    if (!ReserveStrokePoints(StrokeStream::MIN_CAPACITY)) {
         return false;
     }
 
@@ -581,14 +1134,44 @@ bool Renderer::InitPaint() {
     auto* buf = (uint8_t*)SDL_MapGPUTransferBuffer(device, brushTransferBuffer, false);
     memcpy(buf, pixels, (size_t)desc.width * desc.height * 4);
     SDL_UnmapGPUTransferBuffer(device, brushTransferBuffer);
+
+    // Round tips are painted from their falloffs
+    brush_tip = BrushTip(pixels, static_cast<int>(desc.width), static_cast<int>(desc.height));
     free(pixels);
+    brush_round = brush_tip.Round();
+    const auto falloffs_size = static_cast<Uint32>(brush_tip.Falloffs().size() * sizeof(float));
 
-    SDL_GPUCommandBuffer* command_buffer = SDL_AcquireGPUCommandBuffer(device);
-    if (command_buffer == nullptr) {
-        SDL_LogError(SDL_LOG_CATEGORY_RENDER, "Failed to acquire gpu command buffer: %s", SDL_GetError());
+    const SDL_GPUBufferCreateInfo falloff_buffer_create_info = {
+        .usage = SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_READ,
+        .size = falloffs_size,
+    };
+    brush_falloff_buffer = SDL_CreateGPUBuffer(device, &falloff_buffer_create_info);
+    if (brush_falloff_buffer == nullptr) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create brush falloff buffer: %s", SDL_GetError());
         return false;
     }
-    SDL_GPUCopyPass* upload_pass = SDL_BeginGPUCopyPass(command_buffer);
+
+    const SDL_GPUTransferBufferCreateInfo falloff_transfer_buffer_create_info = {
+        .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
+        .size = falloffs_size,
+    };
+    SDL_GPUTransferBuffer* falloff_transfer_buffer =
+        SDL_CreateGPUTransferBuffer(device, &falloff_transfer_buffer_create_info);
+    if (falloff_transfer_buffer == nullptr) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create brush falloff transfer buffer: %s",
+                     SDL_GetError());
+        return false;
+    }
+    auto* falloffs = SDL_MapGPUTransferBuffer(device, falloff_transfer_buffer, false);
+    memcpy(falloffs, brush_tip.Falloffs().data(), falloffs_size);
+    SDL_UnmapGPUTransferBuffer(device, falloff_transfer_buffer);
+
+    SDL_GPUCommandBuffer* command_buffer = SDL_AcquireGPUCommandBuffer(device);
+    if (command_buffer == nullptr) {
+        SDL_LogError(SDL_LOG_CATEGORY_RENDER, "Failed to acquire gpu command buffer: %s", SDL_GetError());
+        return false;
+    }
+    SDL_GPUCopyPass* upload_pass = SDL_BeginGPUCopyPass(command_buffer);
     const SDL_GPUTextureTransferInfo transfer_info = {
         .transfer_buffer = brushTransferBuffer,
         .pixels_per_row = desc.width,
@@ -601,6 +1184,16 @@ bool Renderer::InitPaint() {
         .d = 1,
     };
     SDL_UploadToGPUTexture(upload_pass, &transfer_info, &texture_region, false);
+    const SDL_GPUTransferBufferLocation falloff_source = {
+        .transfer_buffer = falloff_transfer_buffer,
+        .offset = 0,
+    };
+    const SDL_GPUBufferRegion falloff_destination = {
+        .buffer = brush_falloff_buffer,
+        .offset = 0,
+        .size = falloffs_size,
+    };
+    SDL_UploadToGPUBuffer(upload_pass, &falloff_source, &falloff_destination, false);
     SDL_EndGPUCopyPass(upload_pass);
     SDL_GenerateMipmapsForGPUTexture(command_buffer, brush_texture);
     if (!SDL_SubmitGPUCommandBuffer(command_buffer)) {
@@ -609,6 +1202,7 @@ bool Renderer::InitPaint() {
     }
 
     SDL_ReleaseGPUTransferBuffer(device, brushTransferBuffer);
+    SDL_ReleaseGPUTransferBuffer(device, falloff_transfer_buffer);
 
     const SDL_GPUSamplerCreateInfo brush_sampler_create_info = {
         .min_filter = SDL_GPU_FILTER_LINEAR,
@@ -634,12 +1228,73 @@ bool Renderer::InitPaint() {
     return true;
 } // namespace Midori
 
-bool Renderer::Render() {
+void Renderer::BeginFrameInFlight() {
+    ZoneScoped;
+    frame_in_flight = (frame_in_flight + 1) % FRAMES_IN_FLIGHT;
+    FrameInFlight& frame = frames_in_flight[frame_in_flight];
+    if (frame.fence == nullptr) {
+        // Nothing was presented by this frame (hidden window), what it released waits for a frame that is
+        return;
+    }
+
+    {
+        ZoneScopedN("Waiting for frame in flight");
+        SDL_WaitForGPUFences(device, true, &frame.fence, 1);
+        SDL_ReleaseGPUFence(device, frame.fence);
+        frame.fence = nullptr;
+    }
+    ReleaseFrameInFlight(frame);
+}
+
+void Renderer::ReleaseFrameInFlight(FrameInFlight& frame) {
+    for (auto* texture : frame.textures_to_delete) {
+        SDL_ReleaseGPUTexture(device, texture);
+    }
+    for (auto* buffer : frame.buffers_to_delete) {
+        SDL_ReleaseGPUBuffer(device, buffer);
+    }
+    for (auto* transfer_buffer : frame.transfer_buffers_to_delete) {
+        SDL_ReleaseGPUTransferBuffer(device, transfer_buffer);
+    }
+    frame.textures_to_delete.clear();
+    frame.buffers_to_delete.clear();
+    frame.transfer_buffers_to_delete.clear();
+}
+
+void Renderer::WaitFramesInFlight() {
+    ZoneScoped;
+    SDL_WaitForGPUIdle(device);
+    for (auto& frame : frames_in_flight) {
+        if (frame.fence != nullptr) {
+            SDL_ReleaseGPUFence(device, frame.fence);
+            frame.fence = nullptr;
+        }
+        ReleaseFrameInFlight(frame);
+    }
+}
+
+void Renderer::ReleaseDeferred(SDL_GPUTexture* texture) {
+    if (texture != nullptr) {
+        frames_in_flight[frame_in_flight].textures_to_delete.push_back(texture);
+    }
+}
+
+void Renderer::ReleaseDeferred(SDL_GPUBuffer* buffer) {
+    if (buffer != nullptr) {
+        frames_in_flight[frame_in_flight].buffers_to_delete.push_back(buffer);
+    }
+}
+
+void Renderer::ReleaseDeferred(SDL_GPUTransferBuffer* transfer_buffer) {
+    if (transfer_buffer != nullptr) {
+        frames_in_flight[frame_in_flight].transfer_buffers_to_delete.push_back(transfer_buffer);
+    }
+}
+
+// The clears go first, a tile created and uploaded before a frame keeps its pixels
+bool Renderer::SubmitTileUploads() {
     ZoneScoped;
-    last_rendered_tiles_num = 0;
-    last_layer_rendered_num = 0;
     SDL_GPUCommandBuffer* command_buffer = nullptr;
-    SDL_GPUTexture* swapchain_texture = nullptr;
 
     // Initializing undefined tiles
     if (!tile_texture_uninitialized.empty()) {
@@ -653,31 +1308,24 @@ bool Renderer::Render() {
             }
         }
 
-        SDL_GPUCopyPass* upload_pass = SDL_BeginGPUCopyPass(command_buffer);
-        for (const auto& tile : tile_texture_uninitialized) {
-            const SDL_GPUTextureTransferInfo transfer_info = {
-                .transfer_buffer = tile_blank_texture_buffer,
-                .pixels_per_row = TILE_WIDTH,
-                .rows_per_layer = TILE_HEIGHT,
-            };
-            const SDL_GPUTextureRegion texture_region = {
-                .texture = tile_textures.at(tile),
-                .mip_level = 0,
-                .layer = 0,
-                .x = 0,
-                .y = 0,
-                .z = 0,
-                .w = TILE_WIDTH,
-                .h = TILE_HEIGHT,
-                .d = 1,
+        // A load op clear is all it takes, no pixel goes through a transfer buffer
+        for (const auto& [tile, color] : tile_texture_uninitialized) {
+            const SDL_GPUColorTargetInfo color_target_info = {
+                .texture = TilePage(tile),
+                .layer_or_depth_plane = TileSlice(tile),
+                .clear_color = color,
+                .load_op = SDL_GPU_LOADOP_CLEAR,
+                .store_op = SDL_GPU_STOREOP_STORE,
             };
-            SDL_UploadToGPUTexture(upload_pass, &transfer_info, &texture_region, false);
+            SDL_GPURenderPass* clear_pass = SDL_BeginGPURenderPass(command_buffer, &color_target_info, 1, nullptr);
+            frame_counters.passes++;
+            SDL_EndGPURenderPass(clear_pass);
         }
-        SDL_EndGPUCopyPass(upload_pass);
         tile_texture_uninitialized.clear();
 
         {
             ZoneScopedN("Submiting GPU command buffer");
+            frame_counters.submits++;
             if (!SDL_SubmitGPUCommandBuffer(command_buffer)) {
                 SDL_LogError(SDL_LOG_CATEGORY_RENDER, "Failed to submit gpu command buffer: %s", SDL_GetError());
                 return false;
@@ -686,8 +1334,17 @@ bool Renderer::Render() {
     }
 
     // Uploading Tiles
-    if (!allocated_tile_upload_offset.empty()) {
-        SDL_UnmapGPUTransferBuffer(device, tile_upload_buffer);
+    for (auto& page : tile_upload_pages) {
+        if (page.committed.empty()) {
+            continue;
+        }
+        if (page.reserved > 0) {
+            // Jobs are still decoding into this page, stop handing out its slots so it gets submitted soon
+            page.sealed = true;
+            continue;
+        }
+
+        SDL_UnmapGPUTransferBuffer(device, page.buffer);
 
         { // Acquire GPU command buffer
             ZoneScopedN("Acquire GPU command buffer");
@@ -700,25 +1357,27 @@ bool Renderer::Render() {
 
         ZoneScopedN("Uploading Tiles");
         SDL_GPUCopyPass* upload_pass = SDL_BeginGPUCopyPass(command_buffer);
+        frame_counters.passes++;
 
-        for (const auto& [tile, offset] : allocated_tile_upload_offset) {
+        for (const auto& [tile, offset] : page.committed) {
             ZoneScopedN("Uploading Tile");
-            if (!tile_textures.contains(tile)) {
+            page.free_offsets.push_back(offset);
+            if (!HasTileTexture(tile)) {
                 SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Tile not found, discard tile gpu upload");
-                free_tile_upload_offset.push_back(offset);
                 continue;
             }
 
             const SDL_GPUTextureTransferInfo transfer_info = {
-                .transfer_buffer = tile_upload_buffer,
+                .transfer_buffer = page.buffer,
                 .offset = (Uint32)offset,
                 .pixels_per_row = TILE_WIDTH,
                 .rows_per_layer = TILE_HEIGHT,
             };
+            MarkTileDirty(tile);
             const SDL_GPUTextureRegion texture_region = {
-                .texture = tile_textures.at(tile),
+                .texture = TilePage(tile),
                 .mip_level = 0,
-                .layer = 0,
+                .layer = TileSlice(tile),
                 .x = 0,
                 .y = 0,
                 .z = 0,
@@ -727,96 +1386,149 @@ bool Renderer::Render() {
                 .d = 1,
             };
             SDL_UploadToGPUTexture(upload_pass, &transfer_info, &texture_region, false);
-            free_tile_upload_offset.push_back(offset);
+            frame_counters.uploads++;
         }
 
-        allocated_tile_upload_offset.clear();
+        page.committed.clear();
+        page.sealed = false;
         SDL_EndGPUCopyPass(upload_pass);
 
         {
             ZoneScopedN("Submiting GPU command buffer");
+            frame_counters.submits++;
             if (!SDL_SubmitGPUCommandBuffer(command_buffer)) {
                 SDL_LogError(SDL_LOG_CATEGORY_RENDER, "Failed to submit gpu command buffer: %s", SDL_GetError());
                 return false;
             }
         }
 
-        tile_upload_buffer_ptr = (std::uint8_t*)SDL_MapGPUTransferBuffer(device, tile_upload_buffer, false);
+        // Cycle so the slots can be written again while the GPU is still reading the previous data
+        page.ptr = (std::uint8_t*)SDL_MapGPUTransferBuffer(device, page.buffer, true);
     }
 
-    // Download Tiles
-    if (!allocated_tile_download_offset.empty()) {
-        SDL_UnmapGPUTransferBuffer(device, tile_download_buffer);
+    return true;
+}
+
+bool Renderer::Render() {
+    ZoneScoped;
+    last_rendered_tiles_num = 0;
+    last_layer_rendered_num = 0;
+    last_composited_tiles_num = 0;
+    last_frame_counters = frame_counters;
+    frame_counters = {};
+    const std::uint64_t frame_ticks = SDL_GetTicksNS();
+    if (last_frame_ticks != 0) {
+        frame_times.Add(static_cast<float>(frame_ticks - last_frame_ticks) / 1'000'000.0f);
+    }
+    last_frame_ticks = frame_ticks;
+    BeginFrameInFlight();
+    SDL_GPUCommandBuffer* command_buffer = nullptr;
+    SDL_GPUTexture* swapchain_texture = nullptr;
+
+    if (!SubmitTileUploads()) {
+        return false;
+    }
+
+    // Reduce Tiles
+    if (!PollTileReduces()) {
+        return false;
+    }
+    if (const auto batches = tile_reduce_ring.Submit(); !batches.empty()) {
+        ZoneScopedN("Reducing Tiles");
+        for (const size_t batch : batches) {
+            if (batch >= tile_reduce_batches.size()) {
+                SDL_assert(batch == tile_reduce_batches.size());
+                constexpr Uint32 results_size = TileDownloadRing::BATCH_TILES * sizeof(TileReduce);
+                const SDL_GPUBufferCreateInfo buffer_create_info = {
+                    .usage = SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_WRITE,
+                    .size = results_size,
+                };
+                const SDL_GPUTransferBufferCreateInfo transfer_buffer_create_info = {
+                    .usage = SDL_GPU_TRANSFERBUFFERUSAGE_DOWNLOAD,
+                    .size = results_size,
+                };
+                TileReduceBatch reduce_batch = {
+                    .buffer = SDL_CreateGPUBuffer(device, &buffer_create_info),
+                    .transfer_buffer = SDL_CreateGPUTransferBuffer(device, &transfer_buffer_create_info),
+                };
+                if (reduce_batch.buffer == nullptr || reduce_batch.transfer_buffer == nullptr) {
+                    SDL_LogError(SDL_LOG_CATEGORY_RENDER, "Failed to create tile reduce buffers: %s", SDL_GetError());
+                    SDL_ReleaseGPUBuffer(device, reduce_batch.buffer);
+                    SDL_ReleaseGPUTransferBuffer(device, reduce_batch.transfer_buffer);
+                    return false;
+                }
+                tile_reduce_batches.push_back(reduce_batch);
+            }
+            TileReduceBatch& reduce_batch = tile_reduce_batches[batch];
+            SDL_assert(reduce_batch.fence == nullptr && reduce_batch.ptr == nullptr);
 
-        { // Acquire GPU command buffer
-            ZoneScopedN("Acquire GPU command buffer");
             command_buffer = SDL_AcquireGPUCommandBuffer(device);
             if (command_buffer == nullptr) {
                 SDL_LogError(SDL_LOG_CATEGORY_RENDER, "Failed to acquire gpu command buffer: %s", SDL_GetError());
                 return false;
             }
-        }
 
-        ZoneScopedN("Downloading Tiles");
-        SDL_GPUCopyPass* download_pass = SDL_BeginGPUCopyPass(command_buffer);
-
-        for (const auto& [tile, offset] : allocated_tile_download_offset) {
-            ZoneScopedN("Downloading Tile");
-            SDL_assert(tile_textures.contains(tile) && "Downloading missing texture");
-
-            const SDL_GPUTextureTransferInfo destination = {
-                .transfer_buffer = tile_download_buffer,
-                .offset = (Uint32)offset,
-                .pixels_per_row = TILE_WIDTH,
-                .rows_per_layer = TILE_HEIGHT,
+            const SDL_GPUStorageBufferReadWriteBinding results_binding = {
+                .buffer = reduce_batch.buffer,
+                .cycle = false,
             };
-            const SDL_GPUTextureRegion source = {
-                .texture = tile_textures.at(tile),
-                .mip_level = 0,
-                .layer = 0,
-                .x = 0,
-                .y = 0,
-                .z = 0,
-                .w = TILE_WIDTH,
-                .h = TILE_HEIGHT,
-                .d = 1,
+            SDL_GPUComputePass* reduce_pass = SDL_BeginGPUComputePass(command_buffer, nullptr, 0, &results_binding, 1);
+            frame_counters.passes++;
+            if (reduce_pass == nullptr) {
+                SDL_LogError(SDL_LOG_CATEGORY_RENDER, "Failed to create reduce compute pass: %s", SDL_GetError());
+                SDL_CancelGPUCommandBuffer(command_buffer);
+                return false;
+            }
+            SDL_BindGPUComputePipeline(reduce_pass, reduce_compute_pipeline);
+            const auto& tiles = tile_reduce_ring.BatchTiles(batch);
+            for (size_t slot = 0; slot < tiles.size(); slot++) {
+                const Tile tile = tiles[slot];
+                SDL_assert(HasTileTexture(tile) && "Reducing missing texture");
+
+                const ReduceRenderData reduce_render_data = {
+                    .tile_slice = static_cast<std::uint32_t>(TileSlice(tile)),
+                    .result_index = static_cast<std::uint32_t>(slot),
+                };
+                SDL_PushGPUComputeUniformData(command_buffer, 0, &reduce_render_data, sizeof(ReduceRenderData));
+                const SDL_GPUTextureSamplerBinding samplers[] = {{
+                    .texture = TilePage(tile),
+                    .sampler = tile_sampler,
+                }};
+                SDL_BindGPUComputeSamplers(reduce_pass, 0, samplers, 1);
+                SDL_DispatchGPUCompute(reduce_pass, 1, 1, 1);
+                frame_counters.dispatches++;
+            }
+            SDL_EndGPUComputePass(reduce_pass);
+
+            SDL_GPUCopyPass* download_pass = SDL_BeginGPUCopyPass(command_buffer);
+            frame_counters.passes++;
+            const SDL_GPUBufferRegion source = {
+                .buffer = reduce_batch.buffer,
+                .offset = 0,
+                .size = static_cast<Uint32>(tiles.size() * sizeof(TileReduce)),
             };
-            SDL_DownloadFromGPUTexture(download_pass, &source, &destination);
-        }
-
-        SDL_EndGPUCopyPass(download_pass);
+            const SDL_GPUTransferBufferLocation destination = {
+                .transfer_buffer = reduce_batch.transfer_buffer,
+                .offset = 0,
+            };
+            SDL_DownloadFromGPUBuffer(download_pass, &source, &destination);
+            frame_counters.downloads++;
+            SDL_EndGPUCopyPass(download_pass);
 
-        {
-            ZoneScopedN("Submiting GPU command buffer");
-            tile_download_fence = SDL_SubmitGPUCommandBufferAndAcquireFence(command_buffer);
-            if (tile_download_fence == nullptr) {
+            frame_counters.submits++;
+            reduce_batch.fence = SDL_SubmitGPUCommandBufferAndAcquireFence(command_buffer);
+            if (reduce_batch.fence == nullptr) {
                 SDL_LogError(SDL_LOG_CATEGORY_RENDER, "Failed to submit gpu command buffer: %s", SDL_GetError());
                 return false;
             }
         }
-
-        {
-            ZoneScopedN("Waiting for texture download");
-            // This can be a silent trigger
-            SDL_WaitForGPUFences(device, true, &tile_download_fence, 1);
-            SDL_ReleaseGPUFence(device, tile_download_fence);
-            tile_download_fence = nullptr;
-            tile_download_buffer_ptr = (std::uint8_t*)SDL_MapGPUTransferBuffer(device, tile_download_buffer, false);
-            for (const auto [tile, offset] : allocated_tile_download_offset) {
-                tile_downloaded.insert(tile);
-            }
-        }
     }
 
-    // Start painting the tiles
-    if (!app->canvas.stroke_points.empty() && app->canvas.stroke_started) {
-        paint_stroke_point_transfer_buffer_ptr =
-            (std::uint8_t*)SDL_MapGPUTransferBuffer(device, paint_stroke_point_transfer_buffer, false);
-        memset(paint_stroke_point_transfer_buffer_ptr, 0, MAX_PAINT_STROKE_POINTS * sizeof(Canvas::StrokePoint));
-        memcpy(paint_stroke_point_transfer_buffer_ptr, app->canvas.stroke_points.data(),
-               app->canvas.stroke_points.size() * sizeof(Canvas::StrokePoint));
-        SDL_UnmapGPUTransferBuffer(device, paint_stroke_point_transfer_buffer);
-
+    // Download Tiles
+    if (!PollTileDownloads()) {
+        return false;
+    }
+    if (const auto batches = tile_download_ring.Submit(); !batches.empty()) {
         { // Acquire GPU command buffer
             ZoneScopedN("Acquire GPU command buffer");
             command_buffer = SDL_AcquireGPUCommandBuffer(device);
@@ -826,104 +1538,95 @@ bool Renderer::Render() {
             }
         }
 
-        ZoneScopedN("Painting Tiles");
-
-        // Copying data to the storage buffer
-        SDL_GPUCopyPass* stroke_copy_pass = SDL_BeginGPUCopyPass(command_buffer);
-
-        const SDL_GPUTransferBufferLocation source = {
-            .transfer_buffer = paint_stroke_point_transfer_buffer,
-            .offset = 0,
-        };
-        const SDL_GPUBufferRegion destination = {
-            .buffer = paint_stroke_point_buffer,
-            .offset = 0,
-            .size = static_cast<Uint32>(app->canvas.stroke_points.size() * sizeof(Canvas::StrokePoint)),
-            // .size = MAX_PAINT_STROKE_POINTS * sizeof(Canvas::StrokePoint),
-        };
-
-        SDL_UploadToGPUBuffer(stroke_copy_pass, &source, &destination, true);
-        SDL_EndGPUCopyPass(stroke_copy_pass);
-
-        const StrokeRenderData stroke_render_data = {
-            .points_num = static_cast<std::uint32_t>(app->canvas.stroke_points.size()),
-        };
-        SDL_PushGPUComputeUniformData(command_buffer, 0, &stroke_render_data, sizeof(StrokeRenderData));
-        const glm::ivec2 paint_compute_invocations = glm::ceil(glm::vec2(TILE_WIDTH / 32.0f, TILE_HEIGHT / 32.0f));
-        for (const auto& tile : app->canvas.stroke_tile_affected) {
-            if (!tile_textures.contains(tile)) {
-                SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Failed to get tile texture to paint");
-                continue;
-            }
-            if (!app->canvas.tileInfos.contains(tile)) {
-                SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Failed to get tile info to paint");
-                continue;
+        // Every batch gets its own submit, they are fenced separately
+        ZoneScopedN("Downloading Tiles");
+        for (size_t i = 0; i < batches.size(); i++) {
+            const size_t batch = batches[i];
+            if (batch >= tile_download_batches.size()) {
+                // The ring grew under save pressure
+                SDL_assert(batch == tile_download_batches.size());
+                const SDL_GPUTransferBufferCreateInfo download_buffer_create_info = {
+                    .usage = SDL_GPU_TRANSFERBUFFERUSAGE_DOWNLOAD,
+                    .size = TileDownloadRing::BATCH_TILES * TILE_WIDTH * TILE_HEIGHT * 4,
+                };
+                SDL_GPUTransferBuffer* buffer = SDL_CreateGPUTransferBuffer(device, &download_buffer_create_info);
+                if (buffer == nullptr) {
+                    SDL_LogError(SDL_LOG_CATEGORY_RENDER, "Failed to create tile download buffer: %s", SDL_GetError());
+                    SDL_CancelGPUCommandBuffer(command_buffer);
+                    return false;
+                }
+                tile_download_batches.push_back(TileDownloadBatch{.buffer = buffer});
             }
-            const SDL_GPUStorageTextureReadWriteBinding paint_tile_binding[1] = {{
-                .texture = tile_textures.at(tile),
-                .mip_level = 0,
-                .layer = 0,
-            }};
-            if (app->canvas.brushMode) {
-                SDL_GPUComputePass* paint_compute_pass =
-                    SDL_BeginGPUComputePass(command_buffer, paint_tile_binding, 1, nullptr, 0);
-                SDL_BindGPUComputePipeline(paint_compute_pass, paint_compute_pipeline);
-
-                tile_render_data.position = app->canvas.tileInfos.at(tile).pos;
-                tile_render_data.size = glm::vec2(TILE_WIDTH, TILE_WIDTH);
-                SDL_PushGPUComputeUniformData(command_buffer, 1, &tile_render_data, sizeof(TileRenderData));
-
-                SDL_GPUTextureSamplerBinding samplerBinding = {
-                    .texture = brush_texture,
-                    .sampler = brush_sampler,
+            TileDownloadBatch& download_batch = tile_download_batches[batch];
+            SDL_assert(download_batch.fence == nullptr && download_batch.ptr == nullptr);
+
+            SDL_GPUCopyPass* download_pass = SDL_BeginGPUCopyPass(command_buffer);
+            frame_counters.passes++;
+            const auto& tiles = tile_download_ring.BatchTiles(batch);
+            for (size_t slot = 0; slot < tiles.size(); slot++) {
+                const Tile tile = tiles[slot];
+                SDL_assert(HasTileTexture(tile) && "Downloading missing texture");
+
+                const SDL_GPUTextureTransferInfo destination = {
+                    .transfer_buffer = download_batch.buffer,
+                    .offset = (Uint32)(slot * TILE_WIDTH * TILE_HEIGHT * 4),
+                    .pixels_per_row = TILE_WIDTH,
+                    .rows_per_layer = TILE_HEIGHT,
                 };
-                SDL_BindGPUComputeSamplers(paint_compute_pass, 0, &samplerBinding, 1);
-
-                SDL_BindGPUComputeStorageBuffers(paint_compute_pass, 0, &paint_stroke_point_buffer, 1);
-
-                SDL_DispatchGPUCompute(paint_compute_pass, paint_compute_invocations.x, paint_compute_invocations.y, 1);
-
-                SDL_EndGPUComputePass(paint_compute_pass);
-
-            } else if (app->canvas.eraserMode) {
-                SDL_GPUComputePass* erase_compute_pass =
-                    SDL_BeginGPUComputePass(command_buffer, paint_tile_binding, 1, nullptr, 0);
-                SDL_BindGPUComputePipeline(erase_compute_pass, erase_compute_pipeline);
-
-                tile_render_data.position = app->canvas.tileInfos.at(tile).pos;
-                tile_render_data.size = glm::vec2(TILE_WIDTH, TILE_HEIGHT);
-                SDL_PushGPUComputeUniformData(command_buffer, 1, &tile_render_data, sizeof(TileRenderData));
-
-                SDL_GPUTextureSamplerBinding samplerBinding = {
-                    .texture = brush_texture,
-                    .sampler = brush_sampler,
+                const SDL_GPUTextureRegion source = {
+                    .texture = TilePage(tile),
+                    .mip_level = 0,
+                    .layer = TileSlice(tile),
+                    .x = 0,
+                    .y = 0,
+                    .z = 0,
+                    .w = TILE_WIDTH,
+                    .h = TILE_HEIGHT,
+                    .d = 1,
                 };
-                SDL_BindGPUComputeSamplers(erase_compute_pass, 0, &samplerBinding, 1);
-
-                SDL_BindGPUComputeStorageBuffers(erase_compute_pass, 0, &paint_stroke_point_buffer, 1);
-
-                SDL_DispatchGPUCompute(erase_compute_pass, paint_compute_invocations.x, paint_compute_invocations.y, 1);
+                SDL_DownloadFromGPUTexture(download_pass, &source, &destination);
+                frame_counters.downloads++;
+            }
+            SDL_EndGPUCopyPass(download_pass);
 
-                SDL_EndGPUComputePass(erase_compute_pass);
+            frame_counters.submits++;
+            download_batch.fence = SDL_SubmitGPUCommandBufferAndAcquireFence(command_buffer);
+            if (download_batch.fence == nullptr) {
+                SDL_LogError(SDL_LOG_CATEGORY_RENDER, "Failed to submit gpu command buffer: %s", SDL_GetError());
+                return false;
+            }
+            if (i + 1 < batches.size()) {
+                command_buffer = SDL_AcquireGPUCommandBuffer(device);
+                if (command_buffer == nullptr) {
+                    SDL_LogError(SDL_LOG_CATEGORY_RENDER, "Failed to acquire gpu command buffer: %s", SDL_GetError());
+                    return false;
+                }
             }
         }
-        app->canvas.stroke_tile_affected.clear();
-        app->canvas.stroke_points.clear();
+    }
 
-        {
-            ZoneScopedN("Submiting GPU command buffer");
-            auto* fence = SDL_SubmitGPUCommandBufferAndAcquireFence(command_buffer);
-            if (fence == nullptr) {
-                SDL_LogError(SDL_LOG_CATEGORY_RENDER, "Failed to submit gpu command buffer: %s", SDL_GetError());
+    // Start painting the tiles
+    if (!app->canvas.stroke_points.empty() && app->canvas.stroke_started) {
+        if (app->canvas.brushMode || app->canvas.eraserMode) {
+            const eastl::vector<Tile> tiles(app->canvas.stroke_tile_affected.begin(),
+                                            app->canvas.stroke_tile_affected.end());
+            const PaintMode mode = app->canvas.brushMode ? PaintMode::Paint : PaintMode::Erase;
+            if (!app->canvas.paintBackend->PaintTiles(tiles, app->canvas.stroke_points, mode)) {
                 return false;
             }
-            SDL_WaitForGPUFences(device, true, &fence, 1);
-            SDL_ReleaseGPUFence(device, fence);
         }
+        app->canvas.stroke_tile_affected.clear();
+        app->canvas.stroke_points.clear();
     }
 
     if (app->window_size.x > 0 && app->window_size.y > 0 && !app->hidden) {
         viewport_render_data.view = app->canvas.viewport.ViewMatrix();
+        view_changed = viewport_render_data.view != last_view;
+        if (view_changed) {
+            // The layer textures are in screen space
+            last_view = viewport_render_data.view;
+            layer_dirty.MarkAll();
+        }
 
         { // Acquire GPU command buffer
             ZoneScopedN("Acquire GPU command buffer");
@@ -949,7 +1652,8 @@ bool Renderer::Render() {
                         continue;
                     }
 
-                    SDL_assert(layer_textures.contains(layer) && "Layer texture not found");
+                    SDL_assert((composite_mode == CompositeMode::Tiles || layer_textures.contains(layer)) &&
+                               "Layer texture not found");
                     layer_rendering.push_back(info);
                 }
             }
@@ -960,103 +1664,83 @@ bool Renderer::Render() {
             }
         }
 
-        { // Tile Rendering
-            ZoneScopedN("Rendering Tile");
+        { // Composite invalidation
+            // The stroke layer comes and goes with each stroke, it is in neither cache and its tiles mark what they
+            // cover as they are painted or merged
+            eastl::vector<CompositeLayer> composite_layers;
+            composite_layers.reserve(layer_rendering.size());
             for (const auto& layer_info : layer_rendering) {
-                ZoneScopedN("Render Tile");
-                // TODO: only redraw changed & visible tiles
-                const SDL_GPUColorTargetInfo target_info = {
-                    .texture = layer_textures[layer_info.id],
-                    .clear_color = SDL_FColor{.r = 0.0f, .g = 0.0f, .b = 0.0f, .a = 0.0f},
-                    .load_op = SDL_GPU_LOADOP_CLEAR,
-                    .store_op = SDL_GPU_STOREOP_STORE,
-                };
-                SDL_GPURenderPass* render_pass = SDL_BeginGPURenderPass(command_buffer, &target_info, 1, nullptr);
-                SDL_BindGPUGraphicsPipeline(render_pass, tile_graphics_pipeline);
-
-                SDL_PushGPUVertexUniformData(command_buffer, 0, &viewport_render_data, sizeof(ViewportRenderData));
-
-                for (const auto& tile : app->canvas.layerTiles[layer_info.id]) {
-                    if (app->canvas.tileToDelete.contains(tile) || app->canvas.tileToUnload.contains(tile)) {
-                        continue;
-                    }
-
-                    const TileCoord tile_info = app->canvas.tileInfos.at(tile);
-                    tile_render_data.position = tile_info.pos;
-                    tile_render_data.size = glm::vec2(TILE_WIDTH, TILE_HEIGHT);
-                    SDL_PushGPUVertexUniformData(command_buffer, 1, &tile_render_data, sizeof(TileRenderData));
-
-                    const SDL_GPUTextureSamplerBinding samplers[] = {{
-                        .texture = tile_textures.at(tile),
-                        .sampler = tile_sampler,
-                    }};
-                    SDL_BindGPUFragmentSamplers(render_pass, 0, samplers, 1);
-
-                    SDL_DrawGPUPrimitives(render_pass, 4, 1, 0, 0);
-                    last_rendered_tiles_num++;
+                if (app->canvas.strokeLayer != 0 && layer_info.id == app->canvas.strokeLayer) {
+                    continue;
                 }
-
-                SDL_EndGPURenderPass(render_pass);
+                composite_layers.push_back(CompositeLayer{
+                    .id = layer_info.id,
+                    .opacity = layer_info.opacity,
+                    .blend_mode = layer_info.blendMode,
+                });
+            }
+            if (composite_layers != last_composite_layers) {
+                last_composite_layers = std::move(composite_layers);
+                composite_full = true;
+                composite_tiles.MarkAll();
+            }
+            if (app->canvas.selectedLayer != last_selected_layer) {
+                last_selected_layer = app->canvas.selectedLayer;
+                composite_full = true;
+            }
+            if (app->bg_color != last_bg_color) {
+                last_bg_color = app->bg_color;
+                clear_textures_stale = true;
+                composite_full = true;
+                composite_tiles.MarkAll();
             }
         }
 
-        { // Layer rendering
-            ZoneScopedN("Layer blending and rendering");
-
-            auto rgb = glm::vec3(app->bg_color);
-            rgb = glm::mix(glm::pow((rgb + glm::vec3(0.055f)) * glm::vec3(1.0f / 1.055f), glm::vec3(2.4f)),
-                           rgb * glm::vec3(1.0f / 12.92f), glm::lessThanEqual(rgb, glm::vec3(0.04045f)));
-            rgb *= app->bg_color.a;
+        // Background color, premultiplied and linear
+        auto rgb = glm::vec3(app->bg_color);
+        rgb = glm::mix(glm::pow((rgb + glm::vec3(0.055f)) * glm::vec3(1.0f / 1.055f), glm::vec3(2.4f)),
+                       rgb * glm::vec3(1.0f / 12.92f), glm::lessThanEqual(rgb, glm::vec3(0.04045f)));
+        rgb *= app->bg_color.a;
+        const SDL_FColor bg_color = {.r = rgb.r, .g = rgb.g, .b = rgb.b, .a = app->bg_color.a};
+
+        if (clear_textures_stale) {
+            const SDL_GPUColorTargetInfo target_infos[] = {
+                {
+                    .texture = clear_texture,
+                    .clear_color = SDL_FColor{.r = 0.0f, .g = 0.0f, .b = 0.0f, .a = 0.0f},
+                    .load_op = SDL_GPU_LOADOP_CLEAR,
+                    .store_op = SDL_GPU_STOREOP_STORE,
+                },
+                {
+                    .texture = background_texture,
+                    .clear_color = bg_color,
+                    .load_op = SDL_GPU_LOADOP_CLEAR,
+                    .store_op = SDL_GPU_STOREOP_STORE,
+                },
+            };
+            SDL_GPURenderPass* render_pass = SDL_BeginGPURenderPass(command_buffer, target_infos, 2, nullptr);
+            frame_counters.passes++;
+            SDL_EndGPURenderPass(render_pass);
 
-            const SDL_GPUColorTargetInfo target_info = {
-                .texture = canvas_texture,
-                .clear_color = SDL_FColor{.r = rgb.r, .g = rgb.g, .b = rgb.b, .a = app->bg_color.a},
+            // Not the size of the others
+            const SDL_GPUColorTargetInfo tile_target_info = {
+                .texture = background_tile_texture,
+                .clear_color = bg_color,
                 .load_op = SDL_GPU_LOADOP_CLEAR,
                 .store_op = SDL_GPU_STOREOP_STORE,
             };
-            SDL_GPURenderPass* render_pass = SDL_BeginGPURenderPass(command_buffer, &target_info, 1, nullptr);
+            render_pass = SDL_BeginGPURenderPass(command_buffer, &tile_target_info, 1, nullptr);
+            frame_counters.passes++;
             SDL_EndGPURenderPass(render_pass);
+            clear_textures_stale = false;
+        }
 
-            const glm::ivec2 merge_compute_invocations = glm::ceil(glm::vec2(app->window_size) / 32.0f);
-            MergeRenderData merge_render_data = {
-                .src_blend_mode = static_cast<std::uint32_t>(BlendMode::Alpha),
-                .src_opacity = 1.0f,
-                .src_pos = glm::vec2(0.0),
-                .src_size = app->window_size,
-                .dst_blend_mode = static_cast<std::uint32_t>(BlendMode::Alpha),
-                .dst_opacity = 1.0f,
-                .dst_pos = glm::vec2(0.0),
-                .dst_size = app->window_size,
-            };
-            const SDL_GPUStorageTextureReadWriteBinding merge_layer_binding[1] = {{
-                .texture = canvas_texture,
-                .mip_level = 0,
-                .layer = 0,
-            }};
-            SDL_GPUComputePass* merge_compute_pass =
-                SDL_BeginGPUComputePass(command_buffer, merge_layer_binding, 1, nullptr, 0);
-            if (merge_compute_pass == nullptr) {
-                SDL_LogError(SDL_LOG_CATEGORY_RENDER, "Failed to create merge compute pass: %s", SDL_GetError());
+        if (composite_mode == CompositeMode::Tiles) {
+            if (!CompositeTiles(command_buffer, layer_rendering, bg_color)) {
                 return false;
             }
-            SDL_BindGPUComputePipeline(merge_compute_pass, merge_compute_pipeline);
-
-            for (const auto& layer_info : layer_rendering) {
-                ZoneScopedN("Blend layer to canvas");
-                merge_render_data.src_blend_mode = static_cast<std::uint32_t>(layer_info.blendMode);
-                merge_render_data.src_opacity = layer_info.opacity;
-                // Maybe dividing the buffer into a dst and src could be benificial
-                SDL_PushGPUComputeUniformData(command_buffer, 0, &merge_render_data, sizeof(MergeRenderData));
-
-                const SDL_GPUTextureSamplerBinding samplers[] = {{
-                    .texture = layer_textures[layer_info.id],
-                    .sampler = layer_sampler,
-                }};
-                SDL_BindGPUComputeSamplers(merge_compute_pass, 0, samplers, 1);
-                SDL_DispatchGPUCompute(merge_compute_pass, merge_compute_invocations.x, merge_compute_invocations.y, 1);
-            }
-
-            SDL_EndGPUComputePass(merge_compute_pass);
+        } else if (!CompositeLayerTextures(command_buffer, layer_rendering)) {
+            return false;
         }
 
         { // Wait and acquire GPU swapchain texture
@@ -1076,6 +1760,7 @@ bool Renderer::Render() {
                 .store_op = SDL_GPU_STOREOP_STORE,
             };
             SDL_GPURenderPass* render_pass = SDL_BeginGPURenderPass(command_buffer, &target_info, 1, nullptr);
+            frame_counters.passes++;
             SDL_BindGPUGraphicsPipeline(render_pass, layer_graphics_pipeline);
 
             const SDL_GPUTextureSamplerBinding samplers[] = {{
@@ -1085,6 +1770,7 @@ bool Renderer::Render() {
             SDL_BindGPUFragmentSamplers(render_pass, 0, samplers, 1);
 
             SDL_DrawGPUPrimitives(render_pass, 3, 1, 0, 0);
+            frame_counters.draws++;
 
             SDL_EndGPURenderPass(render_pass);
         }
@@ -1100,19 +1786,21 @@ bool Renderer::Render() {
                 .store_op = SDL_GPU_STOREOP_STORE,
             };
             SDL_GPURenderPass* render_pass = SDL_BeginGPURenderPass(command_buffer, &target_info, 1, nullptr);
+            frame_counters.passes++;
             ImGui_ImplSDLGPU3_RenderDrawData(draw_data, command_buffer, render_pass);
             SDL_EndGPURenderPass(render_pass);
         }
 
         {
             ZoneScopedN("Submiting GPU command buffer");
-            auto* fence = SDL_SubmitGPUCommandBufferAndAcquireFence(command_buffer);
-            if (fence == nullptr) {
+            frame_counters.submits++;
+            // Waited on when the slot comes around again
+            FrameInFlight& frame = frames_in_flight[frame_in_flight];
+            frame.fence = SDL_SubmitGPUCommandBufferAndAcquireFence(command_buffer);
+            if (frame.fence == nullptr) {
                 SDL_LogError(SDL_LOG_CATEGORY_RENDER, "Failed to submit gpu command buffer: %s", SDL_GetError());
                 return false;
             }
-            SDL_WaitForGPUFences(device, true, &fence, 1);
-            SDL_ReleaseGPUFence(device, fence);
         }
     }
 
@@ -1131,7 +1819,7 @@ bool Renderer::Resize() {
         layers.push_back(layer);
     }
 
-    SDL_ReleaseGPUTexture(device, canvas_texture);
+    ReleaseDeferred(canvas_texture);
     const SDL_GPUTextureCreateInfo canvas_texture_create_info = {
         .type = SDL_GPU_TEXTURETYPE_2D,
         .format = texture_format,
@@ -1148,6 +1836,9 @@ bool Renderer::Resize() {
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create canvas layer texture");
         return false;
     }
+    if (!CreateWindowTextures()) {
+        return false;
+    }
 
     for (auto layer : layers) {
         DeleteLayerTexture(layer);
@@ -1158,30 +1849,69 @@ bool Renderer::Resize() {
 }
 
 bool Renderer::CanQuit() {
-    return allocated_tile_download_offset.empty();
+    return tile_download_ring.Empty() && tile_reduce_ring.Empty();
 }
 
 void Renderer::Quit() {
     ZoneScoped;
+    WaitFramesInFlight();
 
     SDL_UnmapGPUTransferBuffer(device, paint_stroke_point_transfer_buffer);
     SDL_ReleaseGPUTexture(device, brush_texture);
     SDL_ReleaseGPUSampler(device, brush_sampler);
+    SDL_ReleaseGPUBuffer(device, brush_falloff_buffer);
     SDL_ReleaseGPUTransferBuffer(device, paint_stroke_point_transfer_buffer);
     SDL_ReleaseGPUBuffer(device, paint_stroke_point_buffer);
+    if (paint_dab_index_buffer != nullptr) {
+        SDL_ReleaseGPUBuffer(device, paint_dab_index_buffer);
+        SDL_ReleaseGPUTransferBuffer(device, paint_dab_index_transfer_buffer);
+    }
     SDL_ReleaseGPUComputePipeline(device, erase_compute_pipeline);
     SDL_ReleaseGPUComputePipeline(device, paint_compute_pipeline);
+    // The frames in flight were already released, nothing can be deferred anymore
+    for (const auto& [tile, wet] : wet_textures) {
+        SDL_ReleaseGPUTexture(device, wet);
+    }
+    for (auto* wet : wet_texture_pool) {
+        SDL_ReleaseGPUTexture(device, wet);
+    }
 
     SDL_ReleaseGPUComputePipeline(device, merge_compute_pipeline);
+    SDL_ReleaseGPUComputePipeline(device, reduce_compute_pipeline);
 
-    for (const auto& [tile, texture] : tile_textures) {
-        SDL_ReleaseGPUTexture(device, texture);
+    for (auto* page : tile_pages) {
+        SDL_ReleaseGPUTexture(device, page);
+    }
+    for (auto* page : composite_pages) {
+        SDL_ReleaseGPUTexture(device, page);
+    }
+    if (tile_instance_buffer != nullptr) {
+        SDL_ReleaseGPUBuffer(device, tile_instance_buffer);
+        SDL_ReleaseGPUTransferBuffer(device, tile_instance_transfer_buffer);
+    }
+    for (auto& batch : tile_download_batches) {
+        if (batch.fence != nullptr) {
+            SDL_ReleaseGPUFence(device, batch.fence);
+        }
+        if (batch.ptr != nullptr) {
+            SDL_UnmapGPUTransferBuffer(device, batch.buffer);
+        }
+        SDL_ReleaseGPUTransferBuffer(device, batch.buffer);
+    }
+    for (auto& batch : tile_reduce_batches) {
+        if (batch.fence != nullptr) {
+            SDL_ReleaseGPUFence(device, batch.fence);
+        }
+        if (batch.ptr != nullptr) {
+            SDL_UnmapGPUTransferBuffer(device, batch.transfer_buffer);
+        }
+        SDL_ReleaseGPUBuffer(device, batch.buffer);
+        SDL_ReleaseGPUTransferBuffer(device, batch.transfer_buffer);
+    }
+    for (auto& page : tile_upload_pages) {
+        SDL_UnmapGPUTransferBuffer(device, page.buffer);
+        SDL_ReleaseGPUTransferBuffer(device, page.buffer);
     }
-    SDL_UnmapGPUTransferBuffer(device, tile_download_buffer);
-    SDL_ReleaseGPUTransferBuffer(device, tile_download_buffer);
-    SDL_UnmapGPUTransferBuffer(device, tile_upload_buffer);
-    SDL_ReleaseGPUTransferBuffer(device, tile_upload_buffer);
-    SDL_ReleaseGPUTransferBuffer(device, tile_blank_texture_buffer);
     SDL_ReleaseGPUSampler(device, tile_sampler);
     SDL_ReleaseGPUGraphicsPipeline(device, tile_graphics_pipeline);
     SDL_ReleaseGPUShader(device, tile_vertex_shader);
@@ -1191,6 +1921,11 @@ void Renderer::Quit() {
         SDL_ReleaseGPUTexture(device, texture);
     }
     SDL_ReleaseGPUTexture(device, canvas_texture);
+    SDL_ReleaseGPUTexture(device, clear_texture);
+    SDL_ReleaseGPUTexture(device, background_texture);
+    SDL_ReleaseGPUTexture(device, below_texture);
+    SDL_ReleaseGPUTexture(device, above_texture);
+    SDL_ReleaseGPUTexture(device, background_tile_texture);
     SDL_ReleaseGPUSampler(device, layer_sampler);
     SDL_ReleaseGPUGraphicsPipeline(device, layer_graphics_pipeline);
     SDL_ReleaseGPUShader(device, layer_vertex_shader);
@@ -1204,12 +1939,17 @@ void Renderer::Quit() {
 
 bool Renderer::CreateLayerTexture(const Layer layer) {
     ZoneScoped;
+    if (composite_mode == CompositeMode::Tiles) {
+        // Made when switching back to layer textures
+        return true;
+    }
     SDL_assert(!layer_textures.contains(layer));
     SDL_assert(app->window_size.x > 0);
     SDL_assert(app->window_size.y > 0);
 
+    // An array of one slice, it is sampled by the merge like the tile pages
     const SDL_GPUTextureCreateInfo texture_create_info = {
-        .type = SDL_GPU_TEXTURETYPE_2D,
+        .type = SDL_GPU_TEXTURETYPE_2D_ARRAY,
         .format = texture_format,
         .usage = SDL_GPU_TEXTUREUSAGE_SAMPLER | SDL_GPU_TEXTUREUSAGE_COLOR_TARGET,
         .width = (Uint32)app->window_size.x,
@@ -1225,83 +1965,351 @@ bool Renderer::CreateLayerTexture(const Layer layer) {
     }
 
     layer_textures[layer] = texture;
+    layer_dirty.MarkLayer(layer);
     return true;
 }
 
 void Renderer::DeleteLayerTexture(const Layer layer) {
     ZoneScoped;
+    if (composite_mode == CompositeMode::Tiles) {
+        SDL_assert(!layer_textures.contains(layer));
+        return;
+    }
     SDL_assert(layer_textures.contains(layer));
-    SDL_ReleaseGPUTexture(device, layer_textures.at(layer));
+    ReleaseDeferred(layer_textures.at(layer));
     layer_textures.erase(layer);
 }
 
-Renderer::TileTextureError Renderer::CreateTileTexture(const Tile tile) {
+Renderer::TileTextureError Renderer::CreateTileTexture(const Tile tile, const Layer layer) {
     ZoneScoped;
-    SDL_assert(!tile_textures.contains(tile));
+    SDL_assert(!HasTileTexture(tile));
 
-    const SDL_GPUTextureCreateInfo texture_create_info = {
-        .type = SDL_GPU_TEXTURETYPE_2D,
-        .format = texture_format,
-        .usage = SDL_GPU_TEXTUREUSAGE_SAMPLER | SDL_GPU_TEXTUREUSAGE_COMPUTE_STORAGE_WRITE,
-        .width = (Uint32)TILE_WIDTH,
-        .height = (Uint32)TILE_HEIGHT,
-        .layer_count_or_depth = 1,
-        .num_levels = 1,
-        .sample_count = SDL_GPU_SAMPLECOUNT_1,
-    };
-    SDL_GPUTexture* texture = SDL_CreateGPUTexture(device, &texture_create_info);
-    if (texture == nullptr) {
-        return TileTextureError::Unknwon;
-    } else {
-        tile_textures[tile] = texture;
-        tile_texture_uninitialized.insert(tile);
+    const auto slot = tile_atlas.Allocate(tile, layer);
+    if (slot.page == tile_pages.size()) {
+        tile_pages.push_back(nullptr);
     }
+    if (tile_pages[slot.page] == nullptr) {
+        ZoneScopedN("Creating tile page");
+        // The residency budget counts the free slices of the pages as well as the loaded tiles
+        const SDL_GPUTextureCreateInfo texture_create_info = {
+            .type = SDL_GPU_TEXTURETYPE_2D_ARRAY,
+            .format = texture_format,
+            .usage = SDL_GPU_TEXTUREUSAGE_SAMPLER | SDL_GPU_TEXTUREUSAGE_COLOR_TARGET |
+                     SDL_GPU_TEXTUREUSAGE_COMPUTE_STORAGE_WRITE,
+            .width = (Uint32)TILE_WIDTH,
+            .height = (Uint32)TILE_HEIGHT,
+            .layer_count_or_depth = TileAtlas::PAGE_SLICES,
+            .num_levels = 1,
+            .sample_count = SDL_GPU_SAMPLECOUNT_1,
+        };
+        SDL_GPUTexture* texture = SDL_CreateGPUTexture(device, &texture_create_info);
+        if (texture == nullptr) {
+            SDL_LogError(SDL_LOG_CATEGORY_RENDER, "Failed to create tile page: %s", SDL_GetError());
+            tile_atlas.Free(tile);
+            tile_atlas.ReleasePage(slot.page);
+            return TileTextureError::Unknwon;
+        }
+        tile_pages[slot.page] = texture;
+    }
+    tile_texture_uninitialized[tile] = SDL_FColor{.r = 0.0f, .g = 0.0f, .b = 0.0f, .a = 0.0f};
+    MarkTileDirty(tile);
 
     return TileTextureError::None;
 }
 
-Renderer::TileTextureError Renderer::UploadTileTexture(const Tile tile, const eastl::vector<uint8_t>& pixels) {
+bool Renderer::HasTileTexture(const Tile tile) const {
+    return tile_atlas.Contains(tile);
+}
+
+SDL_GPUTexture* Renderer::TilePage(const Tile tile) const {
+    return tile_pages[tile_atlas.At(tile).page];
+}
+
+Uint32 Renderer::TileSlice(const Tile tile) const {
+    return tile_atlas.At(tile).slice;
+}
+
+bool Renderer::ReserveTileInstances(const size_t count) {
+    if (count <= tile_instance_capacity) {
+        return true;
+    }
+    ZoneScoped;
+
+    size_t capacity = std::max<size_t>(tile_instance_capacity * 2, TileAtlas::PAGE_SLICES);
+    while (capacity < count) {
+        capacity *= 2;
+    }
+
+    if (tile_instance_buffer != nullptr) {
+        // The frames in flight may still be drawing from it
+        ReleaseDeferred(tile_instance_buffer);
+        ReleaseDeferred(tile_instance_transfer_buffer);
+        tile_instance_buffer = nullptr;
+        tile_instance_transfer_buffer = nullptr;
+        tile_instance_capacity = 0;
+    }
+
+    const SDL_GPUBufferCreateInfo buffer_create_info = {
+        .usage = SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ,
+        .size = static_cast<Uint32>(capacity * sizeof(TileInstance)),
+    };
+    tile_instance_buffer = SDL_CreateGPUBuffer(device, &buffer_create_info);
+    if (tile_instance_buffer == nullptr) {
+        SDL_LogError(SDL_LOG_CATEGORY_RENDER, "Failed to create tile instance buffer: %s", SDL_GetError());
+        return false;
+    }
+
+    const SDL_GPUTransferBufferCreateInfo transfer_buffer_create_info = {
+        .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
+        .size = static_cast<Uint32>(capacity * sizeof(TileInstance)),
+    };
+    tile_instance_transfer_buffer = SDL_CreateGPUTransferBuffer(device, &transfer_buffer_create_info);
+    if (tile_instance_transfer_buffer == nullptr) {
+        SDL_LogError(SDL_LOG_CATEGORY_RENDER, "Failed to create tile instance transfer buffer: %s", SDL_GetError());
+        SDL_ReleaseGPUBuffer(device, tile_instance_buffer);
+        tile_instance_buffer = nullptr;
+        return false;
+    }
+
+    tile_instance_capacity = capacity;
+    return true;
+}
+
+Renderer::TileTextureError Renderer::UploadTileTexture(const Tile tile, const eastl::vector<uint8_t>& pixels) {
     ZoneScoped;
-    if (!tile_textures.contains(tile)) {
+    SDL_assert(pixels.size() == TILE_WIDTH * TILE_HEIGHT * 4);
+    if (!HasTileTexture(tile)) {
         return TileTextureError::MissingTexture;
     }
 
-    if (free_tile_upload_offset.empty()) {
+    TileUploadSlot slot;
+    if (!ReserveTileUpload(slot)) {
         return TileTextureError::UploadSlotMissing;
     }
+    memcpy(slot.pixels, pixels.data(), pixels.size() * sizeof(pixels[0]));
+
+    return CommitTileUpload(tile, slot);
+}
 
-    if (!allocated_tile_upload_offset.contains(tile)) {
-        size_t offset = free_tile_upload_offset.back();
-        SDL_assert(offset <= (TILE_MAX_UPLOAD_TRANSFER - 1) * TILE_WIDTH * TILE_HEIGHT * 4);
-        free_tile_upload_offset.pop_back();
-        allocated_tile_upload_offset[tile] = offset;
+Renderer::TileTextureError Renderer::ClearTileTexture(const Tile tile, const uint32_t color) {
+    ZoneScoped;
+    if (!HasTileTexture(tile)) {
+        return TileTextureError::MissingTexture;
     }
 
-    auto* dst = (uint8_t*)(tile_upload_buffer_ptr + allocated_tile_upload_offset.at(tile));
-    memcpy(dst, pixels.data(), pixels.size() * sizeof(pixels[0]));
+    uint8_t rgba[4];
+    memcpy(rgba, &color, sizeof(rgba));
+    tile_texture_uninitialized[tile] = SDL_FColor{
+        .r = rgba[0] / 255.0f,
+        .g = rgba[1] / 255.0f,
+        .b = rgba[2] / 255.0f,
+        .a = rgba[3] / 255.0f,
+    };
+    MarkTileDirty(tile);
 
     return TileTextureError::None;
 }
 
+bool Renderer::ReserveTileUpload(TileUploadSlot& slot) {
+    ZoneScoped;
+    for (size_t i = 0; i < TILE_UPLOAD_PAGES; i++) {
+        auto& page = tile_upload_pages[i];
+        if (page.sealed || page.free_offsets.empty()) {
+            continue;
+        }
+
+        slot.page = i;
+        slot.offset = page.free_offsets.back();
+        slot.pixels = page.ptr + slot.offset;
+        SDL_assert(slot.offset <= (TILE_MAX_UPLOAD_TRANSFER - 1) * TILE_WIDTH * TILE_HEIGHT * 4);
+        page.free_offsets.pop_back();
+        page.reserved++;
+        return true;
+    }
+
+    return false;
+}
+
+Renderer::TileTextureError Renderer::CommitTileUpload(const Tile tile, const TileUploadSlot& slot) {
+    ZoneScoped;
+    auto& page = tile_upload_pages[slot.page];
+    SDL_assert(page.reserved > 0 && "Upload slot was not reserved");
+    page.reserved--;
+
+    if (!HasTileTexture(tile)) {
+        page.free_offsets.push_back(slot.offset);
+        return TileTextureError::MissingTexture;
+    }
+
+    page.committed.emplace_back(tile, slot.offset);
+    return TileTextureError::None;
+}
+
+void Renderer::CancelTileUpload(const TileUploadSlot& slot) {
+    auto& page = tile_upload_pages[slot.page];
+    SDL_assert(page.reserved > 0 && "Upload slot was not reserved");
+    page.reserved--;
+    page.free_offsets.push_back(slot.offset);
+}
+
 void Renderer::ReleaseTileTexture(const Tile tile) {
     ZoneScoped;
-    SDL_assert(tile_textures.contains(tile) && "Tile does not exists");
-    SDL_ReleaseGPUTexture(device, tile_textures.at(tile));
-    tile_textures.erase(tile);
+    SDL_assert(HasTileTexture(tile) && "Tile does not exists");
+    MarkTileDirty(tile);
+    const auto page = tile_atlas.At(tile).page;
+    tile_atlas.Free(tile);
+    tile_texture_uninitialized.erase(tile);
+    ReleaseWetTexture(tile);
+
+    // A spare empty page saves creating one again when a layer loses and gets back its last tile
+    if (tile_atlas.PageUsed(page) == 0 && tile_atlas.EmptyPages() > TILE_PAGES_SPARE) {
+        // Frames in flight may still draw from it
+        ReleaseDeferred(tile_pages[page]);
+        tile_pages[page] = nullptr;
+        tile_atlas.ReleasePage(page);
+    }
 }
 
-// TODO: transform into a single command buffer action, MergeTileTextures(eastl::vector<std::pair<Tile, Tile>>
-// tileToMerges)
-bool Renderer::MergeTileTextures(const Tile over_tile, const Tile below_tile) {
+void Renderer::ReleaseWetTextures() {
     ZoneScoped;
-    SDL_assert(tile_textures.contains(over_tile));
-    SDL_assert(tile_textures.contains(below_tile));
+    for (const auto& [tile, wet] : wet_textures) {
+        PoolWetTexture(wet);
+    }
+    wet_textures.clear();
+    wet_tiles_unseeded.clear();
+}
+
+void Renderer::ReleaseWetTexture(const Tile tile) {
+    const auto wet = wet_textures.find(tile);
+    if (wet == wet_textures.end()) {
+        return;
+    }
+    PoolWetTexture(wet->second);
+    wet_textures.erase(wet);
+    wet_tiles_unseeded.erase(std::remove(wet_tiles_unseeded.begin(), wet_tiles_unseeded.end(), tile),
+                             wet_tiles_unseeded.end());
+}
+
+void Renderer::PoolWetTexture(SDL_GPUTexture* texture) {
+    if (wet_texture_pool.size() < WET_TEXTURE_POOL_MAX) {
+        // Later uses are recorded after the last paint of the tile, the pool can hand it out again
+        wet_texture_pool.push_back(texture);
+    } else {
+        // Frames in flight may still be painting with it
+        ReleaseDeferred(texture);
+    }
+}
 
-    const auto over_tile_info = app->canvas.tileInfos.at(over_tile);
-    const auto below_tile_info = app->canvas.tileInfos.at(below_tile);
+SDL_GPUTexture* Renderer::AcquireWetTexture(const Tile tile) {
+    if (const auto wet = wet_textures.find(tile); wet != wet_textures.end()) {
+        return wet->second;
+    }
+    ZoneScoped;
 
-    const auto over_layer_info = app->canvas.layerInfos.at(over_tile_info.layer);
-    const auto below_layer_info = app->canvas.layerInfos.at(below_tile_info.layer);
+    SDL_GPUTexture* texture = nullptr;
+    if (!wet_texture_pool.empty()) {
+        texture = wet_texture_pool.back();
+        wet_texture_pool.pop_back();
+    } else {
+        const SDL_GPUTextureCreateInfo texture_create_info = {
+            .type = SDL_GPU_TEXTURETYPE_2D,
+            .format = SDL_GPU_TEXTUREFORMAT_R16G16B16A16_FLOAT,
+            // The paint shader loads and stores it in the same dispatch
+            .usage = SDL_GPU_TEXTUREUSAGE_COLOR_TARGET | SDL_GPU_TEXTUREUSAGE_COMPUTE_STORAGE_SIMULTANEOUS_READ_WRITE,
+            .width = (Uint32)TILE_WIDTH,
+            .height = (Uint32)TILE_HEIGHT,
+            .layer_count_or_depth = 1,
+            .num_levels = 1,
+            .sample_count = SDL_GPU_SAMPLECOUNT_1,
+        };
+        texture = SDL_CreateGPUTexture(device, &texture_create_info);
+        if (texture == nullptr) {
+            SDL_LogError(SDL_LOG_CATEGORY_RENDER, "Failed to create wet texture: %s", SDL_GetError());
+            return nullptr;
+        }
+    }
+    wet_textures[tile] = texture;
+    wet_tiles_unseeded.push_back(tile);
+    return texture;
+}
+
+// The points are streamed through the stroke point buffer in chunks, each chunk is binned, uploaded and dispatched on
+// every tile in its own command buffer.
+bool Renderer::PaintTiles(const eastl::vector<Tile>& tiles, const eastl::vector<StrokePoint>& points,
+                          const PaintMode mode) {
+    ZoneScoped;
+    if (tiles.empty() || points.empty()) {
+        return true;
+    }
+
+    paint_tiles.clear();
+    paint_tile_positions.clear();
+    for (const auto& tile : tiles) {
+        if (!HasTileTexture(tile)) {
+            SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Failed to get tile texture to paint");
+            continue;
+        }
+        if (!app->canvas.tileIndex.Contains(tile)) {
+            SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Failed to get tile info to paint");
+            continue;
+        }
+        if (mode == PaintMode::Erase) {
+            ReleaseWetTexture(tile);
+        } else if (AcquireWetTexture(tile) == nullptr) {
+            return false;
+        }
+        paint_tiles.push_back(tile);
+        paint_tile_positions.push_back(app->canvas.tileIndex.Coord(tile).pos);
+    }
+
+    if (paint_tiles.empty()) {
+        return true;
+    }
+
+    // One command buffer per chunk, they run in order on the queue
+    const auto& chunks = paint_stroke_stream.Plan(points.size());
+    if (!ReserveStrokePoints(paint_stroke_stream.Capacity())) {
+        return false;
+    }
+    for (const auto& chunk : chunks) {
+        if (!PaintStrokeChunk(points.data() + chunk.first, chunk.count, mode)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Renderer::PaintStrokeChunk(const StrokePoint* points, const size_t points_num, const PaintMode mode) {
+    ZoneScoped;
+    SDL_assert(points_num <= paint_stroke_point_capacity);
+
+    // Each tile dispatch only loops over the dabs touching it
+    paint_stroke_bins.Build(paint_tile_positions.data(), paint_tile_positions.size(), points, points_num);
+    const auto& dab_indices = paint_stroke_bins.Indices();
+    if (dab_indices.empty()) {
+        return true;
+    }
+    if (!ReserveDabIndices(dab_indices.size())) {
+        return false;
+    }
+
+    // Cycled, the previous chunk or frame may not have uploaded its points yet
+    paint_stroke_point_transfer_buffer_ptr =
+        (std::uint8_t*)SDL_MapGPUTransferBuffer(device, paint_stroke_point_transfer_buffer, true);
+    if (paint_stroke_point_transfer_buffer_ptr == nullptr) {
+        SDL_LogError(SDL_LOG_CATEGORY_RENDER, "Failed to map paint stroke transfer buffer: %s", SDL_GetError());
+        return false;
+    }
+    memcpy(paint_stroke_point_transfer_buffer_ptr, points, points_num * sizeof(StrokePoint));
+    SDL_UnmapGPUTransferBuffer(device, paint_stroke_point_transfer_buffer);
+
+    auto* dab_indices_ptr = SDL_MapGPUTransferBuffer(device, paint_dab_index_transfer_buffer, true);
+    if (dab_indices_ptr == nullptr) {
+        SDL_LogError(SDL_LOG_CATEGORY_RENDER, "Failed to map dab index transfer buffer: %s", SDL_GetError());
+        return false;
+    }
+    memcpy(dab_indices_ptr, dab_indices.data(), dab_indices.size() * sizeof(std::uint32_t));
+    SDL_UnmapGPUTransferBuffer(device, paint_dab_index_transfer_buffer);
 
     SDL_GPUCommandBuffer* command_buffer = nullptr;
     { // Acquire GPU command buffer
@@ -1313,112 +2321,419 @@ bool Renderer::MergeTileTextures(const Tile over_tile, const Tile below_tile) {
         }
     }
 
-    { // Layer rendering
-        constexpr auto tile_size = glm::vec2(TILE_WIDTH, TILE_HEIGHT);
-        ZoneScopedN("Layer blending and rendering");
-        const glm::ivec2 merge_compute_invocations = glm::ceil(tile_size / 32.0f);
-        MergeRenderData merge_render_data = {
-            .src_blend_mode = static_cast<std::uint32_t>(over_layer_info.blendMode),
-            .src_opacity = over_layer_info.opacity,
-            .src_pos = glm::vec2(0.0),
-            .src_size = tile_size,
-            .dst_blend_mode = static_cast<std::uint32_t>(below_layer_info.blendMode),
-            .dst_opacity = below_layer_info.opacity,
-            .dst_pos = glm::vec2(0.0),
-            .dst_size = tile_size,
+    ZoneScopedN("Painting Tiles");
+
+    // Copying data to the storage buffers
+    SDL_GPUCopyPass* stroke_copy_pass = SDL_BeginGPUCopyPass(command_buffer);
+    frame_counters.passes++;
+
+    const SDL_GPUTransferBufferLocation source = {
+        .transfer_buffer = paint_stroke_point_transfer_buffer,
+        .offset = 0,
+    };
+    const SDL_GPUBufferRegion destination = {
+        .buffer = paint_stroke_point_buffer,
+        .offset = 0,
+        .size = static_cast<Uint32>(points_num * sizeof(StrokePoint)),
+    };
+    SDL_UploadToGPUBuffer(stroke_copy_pass, &source, &destination, true);
+    frame_counters.uploads++;
+
+    const SDL_GPUTransferBufferLocation dab_indices_source = {
+        .transfer_buffer = paint_dab_index_transfer_buffer,
+        .offset = 0,
+    };
+    const SDL_GPUBufferRegion dab_indices_destination = {
+        .buffer = paint_dab_index_buffer,
+        .offset = 0,
+        .size = static_cast<Uint32>(dab_indices.size() * sizeof(std::uint32_t)),
+    };
+    SDL_UploadToGPUBuffer(stroke_copy_pass, &dab_indices_source, &dab_indices_destination, true);
+    frame_counters.uploads++;
+    SDL_EndGPUCopyPass(stroke_copy_pass);
+
+    // A wet texture starts from the RGBA8 tile, the blit converts it to float
+    for (const auto tile : wet_tiles_unseeded) {
+        const SDL_GPUBlitInfo blit_info = {
+            .source =
+                {
+                    .texture = TilePage(tile),
+                    .layer_or_depth_plane = TileSlice(tile),
+                    .w = TILE_WIDTH,
+                    .h = TILE_HEIGHT,
+                },
+            .destination =
+                {
+                    .texture = wet_textures.at(tile),
+                    .w = TILE_WIDTH,
+                    .h = TILE_HEIGHT,
+                },
+            .load_op = SDL_GPU_LOADOP_DONT_CARE,
+            .filter = SDL_GPU_FILTER_NEAREST,
         };
-        const SDL_GPUStorageTextureReadWriteBinding merge_layer_binding[1] = {{
-            .texture = tile_textures.at(below_tile),
-            .mip_level = 0,
-            .layer = 0,
-        }};
-        SDL_GPUComputePass* merge_compute_pass =
-            SDL_BeginGPUComputePass(command_buffer, merge_layer_binding, 1, nullptr, 0);
-        if (merge_compute_pass == nullptr) {
-            SDL_LogError(SDL_LOG_CATEGORY_RENDER, "Failed to create merge compute pass: %s", SDL_GetError());
-            return false;
+        SDL_BlitGPUTexture(command_buffer, &blit_info);
+        frame_counters.passes++;
+    }
+    wet_tiles_unseeded.clear();
+
+    const glm::ivec2 paint_compute_invocations = glm::ceil(glm::vec2(TILE_WIDTH / 32.0f, TILE_HEIGHT / 32.0f));
+    SDL_GPUComputePipeline* pipeline = mode == PaintMode::Paint ? paint_compute_pipeline : erase_compute_pipeline;
+    SDL_GPUBuffer* const stroke_buffers[3] = {paint_stroke_point_buffer, paint_dab_index_buffer, brush_falloff_buffer};
+    for (size_t i = 0; i < paint_tiles.size(); i++) {
+        const StrokeRenderData stroke_render_data = {
+            .dab_offset = paint_stroke_bins.Offset(i),
+            .dab_count = paint_stroke_bins.Count(i),
+            .round_tip = brush_round ? 1u : 0u,
+        };
+        if (stroke_render_data.dab_count == 0) {
+            continue;
         }
-        SDL_BindGPUComputePipeline(merge_compute_pass, merge_compute_pipeline);
-        SDL_PushGPUComputeUniformData(command_buffer, 0, &merge_render_data, sizeof(MergeRenderData));
+        const Tile tile = paint_tiles[i];
+        MarkTileDirty(tile);
+        // Erasing works on the RGBA8 tiles of the layer, only painting has a wet texture
+        const SDL_GPUStorageTextureReadWriteBinding paint_tile_bindings[2] = {
+            {
+                .texture = TilePage(tile),
+                .mip_level = 0,
+                .layer = TileSlice(tile),
+            },
+            {
+                .texture = mode == PaintMode::Paint ? wet_textures.at(tile) : nullptr,
+                .mip_level = 0,
+                .layer = 0,
+            },
+        };
+        SDL_GPUComputePass* paint_compute_pass = SDL_BeginGPUComputePass(
+            command_buffer, paint_tile_bindings, mode == PaintMode::Paint ? 2 : 1, nullptr, 0);
+        frame_counters.passes++;
+        SDL_BindGPUComputePipeline(paint_compute_pass, pipeline);
 
-        const SDL_GPUTextureSamplerBinding samplers[] = {{
-            .texture = tile_textures.at(over_tile),
-            .sampler = tile_sampler,
-        }};
-        SDL_BindGPUComputeSamplers(merge_compute_pass, 0, samplers, 1);
-        SDL_DispatchGPUCompute(merge_compute_pass, merge_compute_invocations.x, merge_compute_invocations.y, 1);
+        SDL_PushGPUComputeUniformData(command_buffer, 0, &stroke_render_data, sizeof(StrokeRenderData));
+        tile_render_data.position = paint_tile_positions[i];
+        tile_render_data.size = glm::vec2(TILE_WIDTH, TILE_HEIGHT);
+        SDL_PushGPUComputeUniformData(command_buffer, 1, &tile_render_data, sizeof(TileRenderData));
+
+        SDL_GPUTextureSamplerBinding samplerBinding = {
+            .texture = brush_texture,
+            .sampler = brush_sampler,
+        };
+        SDL_BindGPUComputeSamplers(paint_compute_pass, 0, &samplerBinding, 1);
+
+        SDL_BindGPUComputeStorageBuffers(paint_compute_pass, 0, stroke_buffers, 3);
 
-        SDL_EndGPUComputePass(merge_compute_pass);
+        SDL_DispatchGPUCompute(paint_compute_pass, paint_compute_invocations.x, paint_compute_invocations.y, 1);
+        frame_counters.dispatches++;
+
+        SDL_EndGPUComputePass(paint_compute_pass);
     }
 
     {
+        // The frame is submitted after it on the same queue, it sees the painted tiles without waiting
         ZoneScopedN("Submiting GPU command buffer");
+        frame_counters.submits++;
         if (!SDL_SubmitGPUCommandBuffer(command_buffer)) {
             SDL_LogError(SDL_LOG_CATEGORY_RENDER, "Failed to submit gpu command buffer: %s", SDL_GetError());
             return false;
         }
     }
+    return true;
+}
+
+bool Renderer::ReserveStrokePoints(const size_t count) {
+    if (count <= paint_stroke_point_capacity) {
+        return true;
+    }
+    ZoneScoped;
+
+    if (paint_stroke_point_buffer != nullptr) {
+        // The frames in flight may still be painting with it
+        ReleaseDeferred(paint_stroke_point_buffer);
+        ReleaseDeferred(paint_stroke_point_transfer_buffer);
+        paint_stroke_point_buffer = nullptr;
+        paint_stroke_point_transfer_buffer = nullptr;
+        paint_stroke_point_capacity = 0;
+    }
+
+    const SDL_GPUBufferCreateInfo buffer_create_info = {
+        .usage = SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_READ,
+        .size = static_cast<Uint32>(count * sizeof(StrokePoint)),
+    };
+    paint_stroke_point_buffer = SDL_CreateGPUBuffer(device, &buffer_create_info);
+    if (paint_stroke_point_buffer == nullptr) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create paint stroke buffer: %s", SDL_GetError());
+        return false;
+    }
 
+    const SDL_GPUTransferBufferCreateInfo upload_buffer_create_info = {
+        .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
+        .size = static_cast<Uint32>(count * sizeof(StrokePoint)),
+    };
+    paint_stroke_point_transfer_buffer = SDL_CreateGPUTransferBuffer(device, &upload_buffer_create_info);
+    if (paint_stroke_point_transfer_buffer == nullptr) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create paint stroke upload buffer: %s", SDL_GetError());
+        SDL_ReleaseGPUBuffer(device, paint_stroke_point_buffer);
+        paint_stroke_point_buffer = nullptr;
+        return false;
+    }
+
+    paint_stroke_point_capacity = count;
     return true;
 }
 
-bool Renderer::DownloadTileTexture(Tile tile) {
+bool Renderer::ReserveDabIndices(const size_t count) {
+    if (count <= paint_dab_index_capacity) {
+        return true;
+    }
     ZoneScoped;
-    SDL_assert(tile > 0 && "Tile is invalid");
-    SDL_assert(tile_textures.contains(tile));
-    SDL_assert(!allocated_tile_download_offset.contains(tile) && "??");
-    SDL_assert(!tile_downloaded.contains(tile));
 
-    if (free_tile_download_offset.empty()) {
-        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "No slot buffer slot for donwloading tile");
+    size_t capacity = std::max<size_t>(paint_dab_index_capacity * 2, StrokeStream::MIN_CAPACITY);
+    while (capacity < count) {
+        capacity *= 2;
+    }
+
+    if (paint_dab_index_buffer != nullptr) {
+        // The frames in flight may still be painting with it
+        ReleaseDeferred(paint_dab_index_buffer);
+        ReleaseDeferred(paint_dab_index_transfer_buffer);
+        paint_dab_index_buffer = nullptr;
+        paint_dab_index_transfer_buffer = nullptr;
+        paint_dab_index_capacity = 0;
+    }
+
+    const SDL_GPUBufferCreateInfo buffer_create_info = {
+        .usage = SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_READ,
+        .size = static_cast<Uint32>(capacity * sizeof(std::uint32_t)),
+    };
+    paint_dab_index_buffer = SDL_CreateGPUBuffer(device, &buffer_create_info);
+    if (paint_dab_index_buffer == nullptr) {
+        SDL_LogError(SDL_LOG_CATEGORY_RENDER, "Failed to create dab index buffer: %s", SDL_GetError());
+        return false;
+    }
+
+    const SDL_GPUTransferBufferCreateInfo transfer_buffer_create_info = {
+        .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
+        .size = static_cast<Uint32>(capacity * sizeof(std::uint32_t)),
+    };
+    paint_dab_index_transfer_buffer = SDL_CreateGPUTransferBuffer(device, &transfer_buffer_create_info);
+    if (paint_dab_index_transfer_buffer == nullptr) {
+        SDL_LogError(SDL_LOG_CATEGORY_RENDER, "Failed to create dab index transfer buffer: %s", SDL_GetError());
+        SDL_ReleaseGPUBuffer(device, paint_dab_index_buffer);
+        paint_dab_index_buffer = nullptr;
         return false;
     }
 
-    const auto tile_offset = free_tile_download_offset.back();
-    free_tile_download_offset.pop_back();
-    SDL_assert(tile_offset <= (TILE_MAX_DOWNLOAD_TRANSFER - 1) * TILE_WIDTH * TILE_HEIGHT * 4);
+    paint_dab_index_capacity = capacity;
+    return true;
+}
+
+// Every pair is merged in a single command buffer. Read-write storage textures are bound when a compute pass begins,
+// so each below tile still gets its own pass, they are just recorded back to back and submitted once.
+bool Renderer::MergeTileTextures(const eastl::vector<std::pair<Tile, Tile>>& tiles) {
+    ZoneScoped;
+    if (tiles.empty()) {
+        return true;
+    }
+
+    SDL_GPUCommandBuffer* command_buffer = nullptr;
+    { // Acquire GPU command buffer
+        ZoneScopedN("Acquire GPU command buffer");
+        command_buffer = SDL_AcquireGPUCommandBuffer(device);
+        if (command_buffer == nullptr) {
+            SDL_LogError(SDL_LOG_CATEGORY_RENDER, "Failed to acquire gpu command buffer: %s", SDL_GetError());
+            return false;
+        }
+    }
+
+    { // Layer rendering
+        constexpr auto tile_size = glm::vec2(TILE_WIDTH, TILE_HEIGHT);
+        ZoneScopedN("Layer blending and rendering");
+        const glm::ivec2 merge_compute_invocations = glm::ceil(tile_size / 32.0f);
+        for (const auto& [over_tile, below_tile] : tiles) {
+            SDL_assert(HasTileTexture(over_tile));
+            SDL_assert(HasTileTexture(below_tile));
+            // The over page is sampled while the below page is bound for writing, a page shared by both would be read
+            // and written in the same pass. Pages belong to a single layer, see TileAtlas.
+            SDL_assert(TilePage(over_tile) != TilePage(below_tile) && "Merged tiles share a page");
+            MarkTileDirty(below_tile);
+
+            const auto& over_layer_info = app->canvas.layerInfos.at(app->canvas.tileIndex.Coord(over_tile).layer);
+            const auto& below_layer_info = app->canvas.layerInfos.at(app->canvas.tileIndex.Coord(below_tile).layer);
+
+            const MergeRenderData merge_render_data = {
+                .src_blend_mode = static_cast<std::uint32_t>(over_layer_info.blendMode),
+                .src_opacity = over_layer_info.opacity,
+                .src_pos = glm::vec2(0.0),
+                .src_size = tile_size,
+                .dst_blend_mode = static_cast<std::uint32_t>(below_layer_info.blendMode),
+                .dst_opacity = below_layer_info.opacity,
+                .dst_pos = glm::vec2(0.0),
+                .dst_size = tile_size,
+                .src_layer = TileSlice(over_tile),
+            };
+            const SDL_GPUStorageTextureReadWriteBinding merge_layer_binding[1] = {{
+                .texture = TilePage(below_tile),
+                .mip_level = 0,
+                .layer = TileSlice(below_tile),
+            }};
+            SDL_GPUComputePass* merge_compute_pass =
+                SDL_BeginGPUComputePass(command_buffer, merge_layer_binding, 1, nullptr, 0);
+            if (merge_compute_pass == nullptr) {
+                SDL_LogError(SDL_LOG_CATEGORY_RENDER, "Failed to create merge compute pass: %s", SDL_GetError());
+                SDL_CancelGPUCommandBuffer(command_buffer);
+                return false;
+            }
+            SDL_BindGPUComputePipeline(merge_compute_pass, merge_compute_pipeline);
+            SDL_PushGPUComputeUniformData(command_buffer, 0, &merge_render_data, sizeof(MergeRenderData));
+
+            const SDL_GPUTextureSamplerBinding samplers[] = {{
+                .texture = TilePage(over_tile),
+                .sampler = tile_sampler,
+            }};
+            SDL_BindGPUComputeSamplers(merge_compute_pass, 0, samplers, 1);
+            SDL_DispatchGPUCompute(merge_compute_pass, merge_compute_invocations.x, merge_compute_invocations.y, 1);
 
-    allocated_tile_download_offset[tile] = tile_offset;
+            SDL_EndGPUComputePass(merge_compute_pass);
+        }
+    }
+
+    {
+        ZoneScopedN("Submiting GPU command buffer");
+        if (!SDL_SubmitGPUCommandBuffer(command_buffer)) {
+            SDL_LogError(SDL_LOG_CATEGORY_RENDER, "Failed to submit gpu command buffer: %s", SDL_GetError());
+            return false;
+        }
+        merge_submits++;
+    }
 
     return true;
 }
 
-bool Renderer::IsTileTextureDownloaded(Tile tile) const {
+bool Renderer::DownloadTileTexture(Tile tile) {
     ZoneScoped;
-    SDL_assert(tile > 0 && "Tile is invalid");
-    SDL_assert(allocated_tile_download_offset.contains(tile) && "Tile not allocated");
+    SDL_assert(tile != TILE_INVALID && "Tile is invalid");
+    SDL_assert(HasTileTexture(tile));
+    return tile_download_ring.Reserve(tile);
+}
 
-    return tile_downloaded.contains(tile);
+bool Renderer::IsTileTextureDownloaded(Tile tile) const {
+    ZoneScoped;
+    SDL_assert(tile != TILE_INVALID && "Tile is invalid");
+    SDL_assert(tile_download_ring.Contains(tile) && "Tile not allocated");
+    return tile_download_ring.IsReady(tile);
 }
 
 bool Renderer::CopyTileTextureDownloaded(const Tile tile, eastl::vector<uint8_t>& tile_texture) {
     ZoneScoped;
-    SDL_assert(tile > 0 && "Tile is invalid");
+    SDL_assert(tile != TILE_INVALID && "Tile is invalid");
     SDL_assert(IsTileTextureDownloaded(tile));
 
-    tile_texture.resize(TILE_WIDTH * TILE_HEIGHT * 4);
+    const auto slot = tile_download_ring.At(tile);
+    TileDownloadBatch& batch = tile_download_batches[slot.batch];
+    SDL_assert(batch.ptr != nullptr);
 
-    SDL_assert(tile_download_buffer_ptr != nullptr);
-    SDL_assert(allocated_tile_download_offset.at(tile) >= 0);
-    SDL_assert(allocated_tile_download_offset.at(tile) <=
-               (TILE_MAX_DOWNLOAD_TRANSFER - 1) * (TILE_WIDTH * TILE_HEIGHT * 4));
-    memcpy(tile_texture.data(), tile_download_buffer_ptr + allocated_tile_download_offset.at(tile),
+    tile_texture.resize(TILE_WIDTH * TILE_HEIGHT * 4);
+    memcpy(tile_texture.data(), batch.ptr + slot.index * (TILE_WIDTH * TILE_HEIGHT * 4),
            (TILE_WIDTH * TILE_HEIGHT * 4));
 
-    free_tile_download_offset.push_back(allocated_tile_download_offset.at(tile));
-    tile_downloaded.erase(tile);
-    allocated_tile_download_offset.erase(tile);
+    if (tile_download_ring.Release(tile)) {
+        // Every tile of the batch was read, it can be downloaded into again
+        SDL_UnmapGPUTransferBuffer(device, batch.buffer);
+        batch.ptr = nullptr;
+    }
+    return true;
+}
+
+bool Renderer::ReduceTileTexture(const Tile tile) {
+    ZoneScoped;
+    SDL_assert(tile != TILE_INVALID && "Tile is invalid");
+    SDL_assert(HasTileTexture(tile));
+    return tile_reduce_ring.Reserve(tile);
+}
+
+bool Renderer::IsTileTextureReduced(const Tile tile) const {
+    ZoneScoped;
+    SDL_assert(tile != TILE_INVALID && "Tile is invalid");
+    SDL_assert(tile_reduce_ring.Contains(tile) && "Tile not allocated");
+    return tile_reduce_ring.IsReady(tile);
+}
 
+TileReduce Renderer::TileTextureReduced(const Tile tile) {
+    ZoneScoped;
+    SDL_assert(IsTileTextureReduced(tile));
+
+    const auto slot = tile_reduce_ring.At(tile);
+    TileReduceBatch& batch = tile_reduce_batches[slot.batch];
+    SDL_assert(batch.ptr != nullptr);
+    const TileReduce reduce = batch.ptr[slot.index];
+
+    if (tile_reduce_ring.Release(tile)) {
+        SDL_UnmapGPUTransferBuffer(device, batch.transfer_buffer);
+        batch.ptr = nullptr;
+    }
+    return reduce;
+}
+
+bool Renderer::PollTileReduces() {
+    ZoneScoped;
+    for (size_t i = 0; i < tile_reduce_batches.size(); i++) {
+        TileReduceBatch& batch = tile_reduce_batches[i];
+        if (batch.fence == nullptr || !SDL_QueryGPUFence(device, batch.fence)) {
+            continue;
+        }
+        SDL_ReleaseGPUFence(device, batch.fence);
+        batch.fence = nullptr;
+
+        batch.ptr = static_cast<const TileReduce*>(SDL_MapGPUTransferBuffer(device, batch.transfer_buffer, false));
+        if (batch.ptr == nullptr) {
+            SDL_LogError(SDL_LOG_CATEGORY_RENDER, "Failed to map tile reduce buffer: %s", SDL_GetError());
+            return false;
+        }
+        tile_reduce_ring.Complete(i);
+    }
     return true;
 }
 
-SDL_GPUTexture* Renderer::DuplicateTileTexture(SDL_GPUCopyPass* copyPass, SDL_GPUTexture* tileTexture) const {
+bool Renderer::PollTileDownloads() {
+    ZoneScoped;
+    for (size_t i = 0; i < tile_download_batches.size(); i++) {
+        TileDownloadBatch& batch = tile_download_batches[i];
+        if (batch.fence == nullptr || !SDL_QueryGPUFence(device, batch.fence)) {
+            continue;
+        }
+        SDL_ReleaseGPUFence(device, batch.fence);
+        batch.fence = nullptr;
+
+        batch.ptr = (std::uint8_t*)SDL_MapGPUTransferBuffer(device, batch.buffer, false);
+        if (batch.ptr == nullptr) {
+            SDL_LogError(SDL_LOG_CATEGORY_RENDER, "Failed to map tile download buffer: %s", SDL_GetError());
+            return false;
+        }
+        tile_download_stats.tiles += tile_download_ring.BatchTiles(i).size();
+        tile_download_ring.Complete(i);
+    }
+
+    const std::uint64_t now = SDL_GetTicksNS();
+    if (tile_download_stats.window_start == 0) {
+        tile_download_stats.window_start = now;
+    } else if (now - tile_download_stats.window_start >= 1'000'000'000) {
+        const float seconds = static_cast<float>(now - tile_download_stats.window_start) / 1'000'000'000.0f;
+        tile_download_stats.tiles_per_second = static_cast<float>(tile_download_stats.tiles) / seconds;
+        constexpr float tile_mb = static_cast<float>(TILE_WIDTH * TILE_HEIGHT * 4) / (1024.0f * 1024.0f);
+        tile_download_stats.mb_per_second = tile_download_stats.tiles_per_second * tile_mb;
+        tile_download_stats.tiles = 0;
+        tile_download_stats.window_start = now;
+    }
+    return true;
+}
+
+SDL_GPUTexture* Renderer::DuplicateTileTexture(SDL_GPUCopyPass* copyPass, const Tile tile) const {
     ZoneScoped;
 
     const SDL_GPUTextureCreateInfo texture_create_info = {
         .type = SDL_GPU_TEXTURETYPE_2D,
         .format = app->renderer.texture_format,
-        .usage = SDL_GPU_TEXTUREUSAGE_SAMPLER | SDL_GPU_TEXTUREUSAGE_COMPUTE_STORAGE_WRITE,
+        .usage = SDL_GPU_TEXTUREUSAGE_SAMPLER | SDL_GPU_TEXTUREUSAGE_COLOR_TARGET |
+                 SDL_GPU_TEXTUREUSAGE_COMPUTE_STORAGE_WRITE,
         .width = (Uint32)TILE_WIDTH,
         .height = (Uint32)TILE_HEIGHT,
         .layer_count_or_depth = 1,
@@ -1428,10 +2743,21 @@ SDL_GPUTexture* Renderer::DuplicateTileTexture(SDL_GPUCopyPass* copyPass, SDL_GP
 
     SDL_GPUTexture* texture = SDL_CreateGPUTexture(app->renderer.device, &texture_create_info);
     const SDL_GPUTextureLocation sourceLoc = {
-        .texture = tileTexture, .mip_level = 0, .layer = 0, .x = 0, .y = 0, .z = 0};
+        .texture = TilePage(tile), .mip_level = 0, .layer = TileSlice(tile), .x = 0, .y = 0, .z = 0};
     const SDL_GPUTextureLocation destLoc = {.texture = texture, .mip_level = 0, .layer = 0, .x = 0, .y = 0, .z = 0};
     SDL_CopyGPUTextureToTexture(copyPass, &sourceLoc, &destLoc, TILE_WIDTH, TILE_HEIGHT, 1, false);
 
     return texture;
 }
+
+void Renderer::CopyToTileTexture(SDL_GPUCopyPass* copyPass, SDL_GPUTexture* texture, const Tile tile) {
+    ZoneScoped;
+    SDL_assert(HasTileTexture(tile));
+
+    MarkTileDirty(tile);
+    const SDL_GPUTextureLocation sourceLoc = {.texture = texture, .mip_level = 0, .layer = 0, .x = 0, .y = 0, .z = 0};
+    const SDL_GPUTextureLocation destLoc = {
+        .texture = TilePage(tile), .mip_level = 0, .layer = TileSlice(tile), .x = 0, .y = 0, .z = 0};
+    SDL_CopyGPUTextureToTexture(copyPass, &sourceLoc, &destLoc, TILE_WIDTH, TILE_HEIGHT, 1, false);
+}
 } // namespace Midori
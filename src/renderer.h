@@ -1,19 +1,33 @@
 ﻿#pragma once
 
+#include "composite_tiles.h"
+#include "dirty_regions.h"
+#include "frame_times.h"
 #include "layers.h"
+#include "paint_backend.h"
+#include "stroke_bins.h"
+#include "stroke_stream.h"
+#include "tile_atlas.h"
+#include "tile_download_ring.h"
+#include "tile_reduce.h"
+#include "tile_instances.h"
 #include "tiles.h"
 #include <cstdint>
 #include <EASTL/unordered_map.h>
 #include <EASTL/unordered_set.h>
+#include <EASTL/vector.h>
 #include <SDL3/SDL_gpu.h>
 #include <glm/mat4x4.hpp>
 #include <glm/vec2.hpp>
+#include <glm/vec4.hpp>
+#include <utility>
 
 namespace Midori {
 
 class App;
 
-class Renderer {
+// The GPU PaintBackend, the paint, erase and merge kernels run on the tile pages
+class Renderer final : public PaintBackend {
    public:
     Renderer(const Renderer &) = delete;
     Renderer(Renderer &&) = delete;
@@ -21,7 +35,7 @@ class Renderer {
     Renderer &operator=(Renderer &&) = delete;
 
     Renderer(App *app);
-    ~Renderer() = default;
+    ~Renderer() override = default;
 
     bool Init();
     bool Render();
@@ -44,28 +58,75 @@ class Renderer {
     };
 
 
-    TileTextureError CreateTileTexture(Tile tile);
+    TileTextureError CreateTileTexture(Tile tile, Layer layer);
+    [[nodiscard]] bool HasTileTexture(Tile tile) const;
+    // The page holding the tile texture, the tile is the slice TileSlice of it
+    [[nodiscard]] SDL_GPUTexture *TilePage(Tile tile) const;
+    [[nodiscard]] Uint32 TileSlice(Tile tile) const;
     TileTextureError UploadTileTexture(Tile tile, const eastl::vector<uint8_t>& pixels);
+    // Fill the tile with a single color on the GPU, `color` is RGBA8 in memory order
+    TileTextureError ClearTileTexture(Tile tile, uint32_t color);
+
+    // A slot of a mapped upload page, the pixels can be written from any thread until it is committed or canceled
+    struct TileUploadSlot {
+        size_t page = 0;
+        size_t offset = 0;
+        uint8_t *pixels = nullptr;
+    };
+    bool ReserveTileUpload(TileUploadSlot &slot);
+    TileTextureError CommitTileUpload(Tile tile, const TileUploadSlot &slot);
+    void CancelTileUpload(const TileUploadSlot &slot);
+    // Submits the pending tile clears and uploads now instead of at the start of the next frame
+    bool SubmitTileUploads();
 
     void ReleaseTileTexture(Tile tile);
-    bool MergeTileTextures(Tile over_tile, Tile below_tile);
+    bool PaintTiles(const eastl::vector<Tile> &tiles, const eastl::vector<StrokePoint> &points,
+                    PaintMode mode) override;
+    bool MergeTileTextures(const eastl::vector<std::pair<Tile, Tile>> &tiles) override;
+    std::uint64_t merge_submits = 0; // Command buffers submitted by MergeTileTextures
+    // At the end of a brush stroke, the stroke tiles hold the resolved stroke. Their wet textures go back to the pool.
+    void ReleaseWetTextures();
 
     App *app;
 
-    eastl::unordered_set<Tile> tile_to_draw;
-    eastl::unordered_set<Layer> layer_to_draw;
-
     // Common data
     SDL_GPUDevice *device = nullptr;
     SDL_GPUTextureFormat texture_format = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM;
     SDL_GPUTextureFormat swapchain_format = SDL_GPU_TEXTUREFORMAT_B8G8R8A8_UNORM;
     SDL_GPUTexture *canvas_texture = nullptr;
-    eastl::vector<SDL_GPUTexture *> textures_to_delete;
+
+    // Frames in flight
+    // The CPU records the next frame while the GPU runs the previous ones, nothing waits for a submit to finish. A frame
+    // keeps the fence of its last submit and what was released while it was recorded, the resources are freed once the
+    // GPU is done with the frame. Transfer buffers written every frame are mapped with cycling, SDL gives each frame in
+    // flight its own.
+    static constexpr size_t FRAMES_IN_FLIGHT = 2;
+    struct FrameInFlight {
+        SDL_GPUFence *fence = nullptr;
+        eastl::vector<SDL_GPUTexture *> textures_to_delete;
+        eastl::vector<SDL_GPUBuffer *> buffers_to_delete;
+        eastl::vector<SDL_GPUTransferBuffer *> transfer_buffers_to_delete;
+    };
+    FrameInFlight frames_in_flight[FRAMES_IN_FLIGHT];
+    size_t frame_in_flight = 0;
+    // Waits for the GPU to be done with the oldest frame, its slot is recorded into next
+    void BeginFrameInFlight();
+    void ReleaseFrameInFlight(FrameInFlight &frame);
+    // Every frame done, everything deferred released
+    void WaitFramesInFlight();
+    // Released once the frames that may use them are done
+    void ReleaseDeferred(SDL_GPUTexture *texture);
+    void ReleaseDeferred(SDL_GPUBuffer *buffer);
+    void ReleaseDeferred(SDL_GPUTransferBuffer *transfer_buffer);
+
+    FrameTimes frame_times;
+    std::uint64_t last_frame_ticks = 0;
 
     struct ViewportRenderData {
         glm::mat4 projection = glm::mat4(1.0f);
         glm::mat4 view = glm::mat4(1.0f);
     } viewport_render_data;
+    glm::mat4 last_view = glm::mat4(0.0f);
     bool view_changed = false;
 
     // Layer data
@@ -81,42 +142,175 @@ class Renderer {
     eastl::unordered_map<Layer, SDL_GPUTexture *> layer_textures;
     size_t last_layer_rendered_num = 0;
 
+    // Layer textures and the canvas texture are kept between frames, only the dirty part of them is drawn again
+    DirtyRegions layer_dirty;
+    void MarkTileDirty(TileCoord coord);
+    void MarkTileDirty(Tile tile); // Ignored if the tile isn't in the index anymore
+    SDL_Rect TileRectToScreen(const TileRect &rect) const; // Empty when off screen
+
+    // The composite is redone whole when any of these changed, the selected layer splits the caches
+    struct CompositeLayer {
+        Layer id = LAYER_INVALID;
+        float opacity = 1.0f;
+        BlendMode blend_mode = BlendMode::Alpha;
+
+        bool operator==(const CompositeLayer &other) const = default;
+    };
+    eastl::vector<CompositeLayer> last_composite_layers;
+    glm::vec4 last_bg_color = glm::vec4(-1.0f);
+    Layer last_selected_layer = LAYER_INVALID;
+    bool composite_full = true;
+
+    // Window sized, regions of them are copied to clear part of the layer textures and the caches
+    bool CreateWindowTextures();
+    SDL_GPUTexture *clear_texture = nullptr;      // Transparent
+    SDL_GPUTexture *background_texture = nullptr; // Background color
+    bool clear_textures_stale = true;
+
+    // Flattened layers under the selected one on top of the background, and those over it. While painting only the
+    // selected layer changes, so the canvas is the below cache with the selected layer and the above cache blended on
+    // it whatever the number of layers.
+    SDL_GPUTexture *below_texture = nullptr;
+    SDL_GPUTexture *above_texture = nullptr;
+
+    struct CompositeSource {
+        SDL_GPUTexture *texture = nullptr;
+        std::uint32_t slice = 0;
+        float opacity = 1.0f;
+        BlendMode blend_mode = BlendMode::Alpha;
+    };
+    // Blends the sources in order onto the region of a slice of dst, in a single compute pass
+    bool CompositeRegion(SDL_GPUCommandBuffer *command_buffer, SDL_GPUTexture *dst, std::uint32_t dst_layer,
+                         const SDL_Rect &rect, const eastl::vector<CompositeSource> &sources);
+    static void CopyTextureRegion(SDL_GPUCopyPass *copy_pass, SDL_GPUTexture *src, SDL_GPUTexture *dst,
+                                  const SDL_Rect &rect);
+
+    // How the visible layers become the canvas texture
+    enum class CompositeMode {
+        LayerTextures, // A window sized texture per layer, blended whole
+        Tiles,         // Layer tiles blended per canvas tile into composite tiles, no layer textures
+    };
+    CompositeMode composite_mode = CompositeMode::LayerTextures;
+    // Layer textures are made or released for the new mode
+    bool SetCompositeMode(CompositeMode mode);
+    bool CompositeLayerTextures(SDL_GPUCommandBuffer *command_buffer, const eastl::vector<LayerInfo> &layer_rendering);
+    bool CompositeTiles(SDL_GPUCommandBuffer *command_buffer, const eastl::vector<LayerInfo> &layer_rendering,
+                        const SDL_FColor &bg_color);
+
+    CompositeTileCache composite_tiles;
+    eastl::vector<SDL_GPUTexture *> composite_pages; // Indexed by the cache page
+    SDL_GPUTexture *background_tile_texture = nullptr; // Every composite tile starts as a copy of it
+    size_t last_composited_tiles_num = 0;
+
     // Tile data
     struct TileRenderData {
         glm::vec2 position = glm::vec2(0.0f, 0.0f);
         glm::vec2 size = glm::vec2(TILE_WIDTH, TILE_HEIGHT);
     } tile_render_data;
 
+    // Every visible tile of a layer sharing a page is drawn by one instanced call, the instances of the frame are
+    // uploaded together and each draw reads its range of them
+    struct TileDrawRenderData {
+        std::uint32_t instance_offset = 0;
+        float size = TILE_WIDTH;
+    };
+    bool ReserveTileInstances(size_t count);
+    // Uploads the instances of tile_instance_batch
+    bool UploadTileInstances(SDL_GPUCopyPass *copy_pass);
+
     SDL_GPUShader *tile_vertex_shader = nullptr;
     SDL_GPUShader *tile_fragment_shader = nullptr;
     SDL_GPUGraphicsPipeline *tile_graphics_pipeline = nullptr;
     SDL_GPUSampler *tile_sampler = nullptr;
-    eastl::unordered_map<Tile, SDL_GPUTexture *> tile_textures;
-    eastl::unordered_set<Tile> tile_texture_uninitialized;
+    TileAtlas tile_atlas;
+    eastl::vector<SDL_GPUTexture *> tile_pages; // Indexed by TileAtlas page, nullptr once released
+    static constexpr size_t TILE_PAGES_SPARE = 1; // Empty pages kept
+    eastl::unordered_map<Tile, SDL_FColor> tile_texture_uninitialized; // Cleared with the color before being drawn
+    TileInstanceBatch tile_instance_batch;
+    SDL_GPUBuffer *tile_instance_buffer = nullptr;
+    SDL_GPUTransferBuffer *tile_instance_transfer_buffer = nullptr;
+    size_t tile_instance_capacity = 0;
     size_t last_rendered_tiles_num = 0;
 
+    // What a frame asked of the GPU, counted as the commands are recorded
+    struct FrameCounters {
+        size_t draws = 0;
+        size_t dispatches = 0;
+        size_t passes = 0;
+        size_t uploads = 0;
+        size_t downloads = 0;
+        size_t submits = 0;
+    };
+    FrameCounters frame_counters;
+    FrameCounters last_frame_counters;
+
     // Tile upload
-    static constexpr size_t TILE_MAX_UPLOAD_TRANSFER = 32;
-    SDL_GPUTransferBuffer *tile_upload_buffer = nullptr;
-    SDL_GPUTransferBuffer *tile_blank_texture_buffer = nullptr;
-    uint8_t *tile_upload_buffer_ptr = nullptr;
-    eastl::unordered_map<Tile, size_t> allocated_tile_upload_offset;
-    eastl::vector<size_t> free_tile_upload_offset;
+    // Pages stay mapped while jobs decode into their slots. A page is only unmapped and submitted once every slot
+    // reserved in it is committed, it is sealed meanwhile so it can't be starved by new reservations.
+    static constexpr size_t TILE_MAX_UPLOAD_TRANSFER = 32; // Per page
+    static constexpr size_t TILE_UPLOAD_PAGES = 2;
+    struct TileUploadPage {
+        SDL_GPUTransferBuffer *buffer = nullptr;
+        uint8_t *ptr = nullptr;
+        eastl::vector<size_t> free_offsets;
+        eastl::vector<eastl::pair<Tile, size_t>> committed;
+        size_t reserved = 0;
+        bool sealed = false;
+    };
+    TileUploadPage tile_upload_pages[TILE_UPLOAD_PAGES];
 
     // Tile download
-
-    bool DownloadTileTexture(Tile tile);
+    // Reserved tiles are recorded at the next frame, their batch is polled every frame afterwards
+    bool DownloadTileTexture(Tile tile); // False when every batch is busy
     bool IsTileTextureDownloaded(Tile tile) const;
     bool CopyTileTextureDownloaded(Tile tile, eastl::vector<uint8_t> &tile_texture);
-    SDL_GPUTexture *DuplicateTileTexture(SDL_GPUCopyPass *copyPass, SDL_GPUTexture *tileTexture) const;
+    // Copies the tile into a standalone texture, owned by the caller
+    SDL_GPUTexture *DuplicateTileTexture(SDL_GPUCopyPass *copyPass, Tile tile) const;
+    // Copies a texture made by DuplicateTileTexture back into the tile
+    void CopyToTileTexture(SDL_GPUCopyPass *copyPass, SDL_GPUTexture *texture, Tile tile);
 
-    static constexpr size_t TILE_MAX_DOWNLOAD_TRANSFER = 32;
-    SDL_GPUTransferBuffer *tile_download_buffer = nullptr;
-    uint8_t *tile_download_buffer_ptr = nullptr;
-    eastl::unordered_map<Tile, size_t> allocated_tile_download_offset;
-    eastl::unordered_set<Tile> tile_downloaded;
-    eastl::vector<size_t> free_tile_download_offset;
-    SDL_GPUFence *tile_download_fence = nullptr;  // TODO: Use multiple fences
+    // Indexed by TileDownloadRing batch, a buffer is mapped while its batch is ready
+    struct TileDownloadBatch {
+        SDL_GPUTransferBuffer *buffer = nullptr;
+        SDL_GPUFence *fence = nullptr;
+        uint8_t *ptr = nullptr;
+    };
+    TileDownloadRing tile_download_ring;
+    eastl::vector<TileDownloadBatch> tile_download_batches;
+    bool PollTileDownloads();
+
+    // Tile reduction
+    // shaders/reduce runs on a tile before it is saved, only its TileReduce comes back. Empty, uniform and unchanged
+    // tiles are never downloaded. Slots and fences work like the downloads.
+    bool ReduceTileTexture(Tile tile); // False when every batch is busy
+    bool IsTileTextureReduced(Tile tile) const;
+    TileReduce TileTextureReduced(Tile tile); // Releases the slot
+
+    bool InitReduce();
+    struct ReduceRenderData {
+        std::uint32_t tile_slice = 0;
+        std::uint32_t result_index = 0;
+    };
+    SDL_GPUComputePipeline *reduce_compute_pipeline = nullptr;
+
+    // Indexed by TileDownloadRing batch, the results are written to `buffer` and downloaded to `transfer_buffer`
+    struct TileReduceBatch {
+        SDL_GPUBuffer *buffer = nullptr;
+        SDL_GPUTransferBuffer *transfer_buffer = nullptr;
+        SDL_GPUFence *fence = nullptr;
+        const TileReduce *ptr = nullptr;
+    };
+    TileDownloadRing tile_reduce_ring;
+    eastl::vector<TileReduceBatch> tile_reduce_batches;
+    bool PollTileReduces();
+
+    // Download throughput, measured over about a second
+    struct TileDownloadStats {
+        std::uint64_t tiles = 0; // Since the start of the window
+        std::uint64_t window_start = 0;
+        float tiles_per_second = 0.0f;
+        float mb_per_second = 0.0f;
+    } tile_download_stats;
 
     // OPERATIONS
 
@@ -132,21 +326,54 @@ class Renderer {
         float dst_opacity;
         glm::ivec2 dst_pos;
         glm::ivec2 dst_size;
+
+        std::uint32_t src_layer; // Slice of the src texture
     };
     SDL_GPUComputePipeline *merge_compute_pipeline = nullptr;
 
     bool InitPaint();
     struct StrokeRenderData {
-        std::uint32_t points_num = 0;
+        std::uint32_t dab_offset = 0; // The bin of the tile in paint_dab_index_buffer
+        std::uint32_t dab_count = 0;
+        std::uint32_t round_tip = 0;
     };
-    static constexpr size_t MAX_PAINT_STROKE_POINTS = 2048;
+    // Dabs past the capacity of the stroke point buffer are painted in several chunks
+    bool ReserveStrokePoints(size_t count);
+    bool PaintStrokeChunk(const StrokePoint *points, size_t points_num, PaintMode mode);
+    StrokeStream paint_stroke_stream;
+    size_t paint_stroke_point_capacity = 0;
     SDL_GPUBuffer *paint_stroke_point_buffer = nullptr;
+    // The dabs touching each painted tile, grown when a stroke needs more
+    bool ReserveDabIndices(size_t count);
+    StrokeBins paint_stroke_bins;
+    eastl::vector<Tile> paint_tiles;
+    eastl::vector<glm::ivec2> paint_tile_positions;
+    SDL_GPUBuffer *paint_dab_index_buffer = nullptr;
+    SDL_GPUTransferBuffer *paint_dab_index_transfer_buffer = nullptr;
+    size_t paint_dab_index_capacity = 0;
     SDL_GPUComputePipeline *paint_compute_pipeline = nullptr;
     SDL_GPUComputePipeline *erase_compute_pipeline = nullptr;
     SDL_GPUTransferBuffer *paint_stroke_point_transfer_buffer = nullptr;
     SDL_GPUTexture *brush_texture = nullptr;
     SDL_GPUSampler *brush_sampler = nullptr;
+    // BrushTip::Falloffs() of the brush, read instead of brush_texture when the tip is round
+    SDL_GPUBuffer *brush_falloff_buffer = nullptr;
+    bool brush_round = false;
+    BrushTip brush_tip; // The CPU paint backend paints with it too
     std::uint8_t *paint_stroke_point_transfer_buffer_ptr = nullptr;
+    // PaintMode::Paint blends into a float copy of each stroke tile (RGBA16F, see WET_TILE_SIZE in blend.h) and stores
+    // its RGBA8 rounding to the tile for display, so low flow dabs still build up. A stroke tile takes a wet texture
+    // from the pool the first time it is painted, the next paint blits the tile into it before its dispatches. An erase
+    // works on the RGBA8 tile and gives the wet texture back, like CpuPaintBackend. The pool keeps enough textures for
+    // a usual stroke, the ones of a larger stroke are released once it ends since they are outside of the tile
+    // residency budget.
+    static constexpr size_t WET_TEXTURE_POOL_MAX = 32; // 16 MB
+    SDL_GPUTexture *AcquireWetTexture(Tile tile);
+    void ReleaseWetTexture(Tile tile);
+    void PoolWetTexture(SDL_GPUTexture *texture);
+    eastl::unordered_map<Tile, SDL_GPUTexture *> wet_textures;
+    eastl::vector<SDL_GPUTexture *> wet_texture_pool;
+    eastl::vector<Tile> wet_tiles_unseeded;
 
     SDL_GPUShaderFormat shaderFormat;
 };
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace Midori {
+
+// Bounded lock-free multi-producer multi-consumer queue (Vyukov's array queue).
+// Used to hand finished work from the job threads back to the main thread without taking a lock.
+// The capacity must be a power of two, pushing into a full queue fails instead of blocking.
+template <typename T>
+class RingQueue {
+public:
+    RingQueue(const RingQueue&) = delete;
+    RingQueue(RingQueue&&) = delete;
+    RingQueue& operator=(const RingQueue&) = delete;
+    RingQueue& operator=(RingQueue&&) = delete;
+
+    explicit RingQueue(size_t capacity) : mask_(capacity - 1), cells_(std::make_unique<Cell[]>(capacity)) {
+        assert(capacity >= 2 && (capacity & (capacity - 1)) == 0 && "RingQueue capacity must be a power of two");
+        for (size_t i = 0; i < capacity; i++) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+    ~RingQueue() = default;
+
+    // The value is only moved from when the push succeeds
+    template <typename U>
+    bool TryPush(U&& value) {
+        Cell* cell = nullptr;
+        size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &cells_[pos & mask_];
+            const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos);
+            if (diff == 0) {
+                if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false; // Full
+            } else {
+                pos = enqueuePos_.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->value = std::forward<U>(value);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool TryPop(T& value) {
+        Cell* cell = nullptr;
+        size_t pos = dequeuePos_.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &cells_[pos & mask_];
+            const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos + 1);
+            if (diff == 0) {
+                if (dequeuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false; // Empty
+            } else {
+                pos = dequeuePos_.load(std::memory_order_relaxed);
+            }
+        }
+
+        value = std::move(cell->value);
+        cell->value = T();
+        cell->sequence.store(pos + mask_ + 1, std::memory_order_release);
+        return true;
+    }
+
+    [[nodiscard]] size_t Capacity() const {
+        return mask_ + 1;
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    alignas(64) std::atomic<size_t> enqueuePos_ = 0;
+    alignas(64) std::atomic<size_t> dequeuePos_ = 0;
+    alignas(64) size_t mask_;
+    std::unique_ptr<Cell[]> cells_;
+};
+
+} // namespace Midori
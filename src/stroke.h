@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+#include <glm/vec2.hpp>
+#include <glm/vec4.hpp>
+
+namespace Midori {
+
+// A dab of the brush, laid out like StrokePointData in paint.comp and erase.comp (std430, 48 bytes)
+struct StrokePoint {
+    glm::vec4 color = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    glm::vec2 position;
+    float radius = 8.0f;
+    float flow = 0.5f;
+    float hardness = 0.5f;
+    float _pad0;
+    float _pad1;
+    float _pad2;
+};
+static_assert(sizeof(StrokePoint) == 48);
+
+enum class PaintMode : std::uint8_t {
+    Paint, // paint.comp
+    Erase, // erase.comp
+};
+
+} // namespace Midori
@@ -0,0 +1,97 @@
+#include "stroke_bins.h"
+
+#include <SDL3/SDL_assert.h>
+#include <algorithm>
+#include <cmath>
+#include <tracy/Tracy.hpp>
+
+namespace Midori {
+
+void StrokeBins::Build(const glm::ivec2* tile_positions, const size_t tiles_num, const StrokePoint* points,
+                       const size_t points_num) {
+    ZoneScoped;
+    SDL_assert(points_num <= UINT32_MAX);
+
+    tileOfPos_.clear();
+    for (size_t i = 0; i < tiles_num; i++) {
+        [[maybe_unused]] const bool inserted =
+            tileOfPos_.insert({tile_positions[i], static_cast<std::uint32_t>(i)}).second;
+        SDL_assert(inserted && "Tiles painted together are on the same layer");
+    }
+
+    // The (tile, dab) pairs in stroke order, counted per tile
+    entries_.clear();
+    offsets_.assign(tiles_num + 1, 0);
+    constexpr auto width = static_cast<float>(TILE_WIDTH);
+    constexpr auto height = static_cast<float>(TILE_HEIGHT);
+    for (size_t dab = 0; dab < points_num; dab++) {
+        const StrokePoint& point = points[dab];
+        const auto add = [&](const std::uint32_t tile, const glm::ivec2 pos) {
+            const glm::vec2 min(static_cast<float>(pos.x) * width, static_cast<float>(pos.y) * height);
+            const glm::vec2 max(min.x + width - 1.0f, min.y + height - 1.0f);
+            if (DabTouches(point, min, max)) {
+                entries_.push_back({tile, static_cast<std::uint32_t>(dab)});
+                offsets_[tile + 1]++;
+            }
+        };
+
+        const int x_first = static_cast<int>(std::floor((point.position.x - point.radius) / width));
+        const int x_last = static_cast<int>(std::floor((point.position.x + point.radius) / width));
+        const int y_first = static_cast<int>(std::floor((point.position.y - point.radius) / height));
+        const int y_last = static_cast<int>(std::floor((point.position.y + point.radius) / height));
+        const auto covered = static_cast<size_t>(x_last - x_first + 1) * static_cast<size_t>(y_last - y_first + 1);
+        if (covered > tiles_num) {
+            // Huge dab, faster to go through the tiles
+            for (size_t tile = 0; tile < tiles_num; tile++) {
+                add(static_cast<std::uint32_t>(tile), tile_positions[tile]);
+            }
+            continue;
+        }
+        for (int y = y_first; y <= y_last; y++) {
+            for (int x = x_first; x <= x_last; x++) {
+                const auto it = tileOfPos_.find(glm::ivec2(x, y));
+                if (it != tileOfPos_.end()) {
+                    add(it->second, it->first);
+                }
+            }
+        }
+    }
+
+    for (size_t i = 0; i < tiles_num; i++) {
+        offsets_[i + 1] += offsets_[i];
+    }
+
+    // Counting sort, stable so every bin keeps the stroke order. Each offset is moved to the end of its bin, then back
+    indices_.resize(entries_.size());
+    for (const auto& entry : entries_) {
+        indices_[offsets_[entry.tile]++] = entry.dab;
+    }
+    for (size_t i = tiles_num; i > 0; i--) {
+        offsets_[i] = offsets_[i - 1];
+    }
+    offsets_[0] = 0;
+}
+
+std::uint32_t StrokeBins::Offset(const size_t tile) const {
+    SDL_assert(tile + 1 < offsets_.size());
+    return offsets_[tile];
+}
+
+std::uint32_t StrokeBins::Count(const size_t tile) const {
+    SDL_assert(tile + 1 < offsets_.size());
+    return offsets_[tile + 1] - offsets_[tile];
+}
+
+const eastl::vector<std::uint32_t>& StrokeBins::Indices() const {
+    return indices_;
+}
+
+bool StrokeBins::DabTouches(const StrokePoint& point, const glm::vec2 min, const glm::vec2 max) {
+    const float dx = point.position.x - std::clamp(point.position.x, min.x, max.x);
+    const float dy = point.position.y - std::clamp(point.position.y, min.y, max.y);
+    // A pixel of margin, the shaders round the distance differently
+    const float reach = point.radius + 1.0f;
+    return (dx * dx) + (dy * dy) <= reach * reach;
+}
+
+} // namespace Midori
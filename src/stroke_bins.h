@@ -0,0 +1,45 @@
+#pragma once
+
+#include "stroke.h"
+#include "tiles.h"
+#include <EASTL/hash_map.h>
+#include <EASTL/vector.h>
+#include <cstddef>
+#include <cstdint>
+#include <glm/vec2.hpp>
+
+namespace Midori {
+
+// Dabs of a stroke binned by the tiles they touch, so paint.comp and erase.comp only loop over the dabs of their tile.
+//
+// Packed like the index buffer read by the shaders: the dabs of the i-th tile are
+// Indices()[Offset(i), Offset(i) + Count(i)), in stroke order. Doesn't touch the GPU.
+class StrokeBins {
+public:
+    // Side of the blocks the shaders bin the dabs of their tile again into, one per workgroup
+    static constexpr int BLOCK_SIZE = 32;
+
+    // `tile_positions` are the positions of the painted tiles, in the order they are dispatched
+    void Build(const glm::ivec2* tile_positions, size_t tiles_num, const StrokePoint* points, size_t points_num);
+
+    [[nodiscard]] std::uint32_t Offset(size_t tile) const;
+    [[nodiscard]] std::uint32_t Count(size_t tile) const;
+    [[nodiscard]] const eastl::vector<std::uint32_t>& Indices() const;
+
+    // Whether the dab can reach a pixel of the canvas rectangle [min, max] (inclusive pixel positions). Conservative
+    // like the test of the shaders: the closest point of the rectangle is at most `radius` away.
+    [[nodiscard]] static bool DabTouches(const StrokePoint& point, glm::vec2 min, glm::vec2 max);
+
+private:
+    struct Entry {
+        std::uint32_t tile;
+        std::uint32_t dab;
+    };
+
+    eastl::vector<std::uint32_t> offsets_;
+    eastl::vector<std::uint32_t> indices_;
+    eastl::vector<Entry> entries_;
+    eastl::hash_map<glm::ivec2, std::uint32_t> tileOfPos_;
+};
+
+} // namespace Midori
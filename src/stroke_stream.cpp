@@ -0,0 +1,24 @@
+#include "stroke_stream.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace Midori {
+
+const eastl::vector<StrokeStream::Chunk>& StrokeStream::Plan(const size_t points_num) {
+    if (points_num > capacity_) {
+        capacity_ = std::min(std::bit_ceil(points_num), MAX_CAPACITY);
+    }
+
+    chunks_.clear();
+    for (size_t first = 0; first < points_num; first += capacity_) {
+        chunks_.push_back({.first = first, .count = std::min(capacity_, points_num - first)});
+    }
+    return chunks_;
+}
+
+size_t StrokeStream::Capacity() const {
+    return capacity_;
+}
+
+} // namespace Midori
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <EASTL/vector.h>
+#include <cstddef>
+
+namespace Midori {
+
+// How the dabs painted in a frame go through the stroke point buffer of the paint shaders.
+//
+// The dabs are split in chunks of at most Capacity() points, in stroke order, every chunk is binned, uploaded and
+// dispatched on its own. Each upload cycles the buffer, the dispatches of the previous chunk keep reading their points
+// while the next chunk is written. The capacity grows to the biggest frame seen so far, up to MAX_CAPACITY, past that
+// a frame takes several chunks. Doesn't touch the GPU.
+class StrokeStream {
+public:
+    static constexpr size_t MIN_CAPACITY = 2048;
+    static constexpr size_t MAX_CAPACITY = 32768; // 1.5MB of points
+
+    struct Chunk {
+        size_t first = 0;
+        size_t count = 0;
+    };
+
+    // Grows the capacity if the frame needs it, then splits its `points_num` dabs
+    const eastl::vector<Chunk>& Plan(size_t points_num);
+    [[nodiscard]] size_t Capacity() const;
+
+private:
+    size_t capacity_ = MIN_CAPACITY;
+    eastl::vector<Chunk> chunks_;
+};
+
+} // namespace Midori
@@ -0,0 +1,121 @@
+#include "tile_atlas.h"
+
+#include <SDL3/SDL_assert.h>
+
+namespace Midori {
+
+TileAtlas::Slot TileAtlas::Allocate(const Tile tile, const Layer layer) {
+    SDL_assert(tile != TILE_INVALID);
+    SDL_assert(layer != LAYER_INVALID);
+    SDL_assert(!Contains(tile) && "Tile already has a slot");
+    if (tile >= slots_.size()) {
+        slots_.resize(static_cast<size_t>(tile) + 1);
+    }
+
+    size_t page = 0;
+    while (page < pages_.size() && (pages_[page].layer != layer || pages_[page].free.empty())) {
+        page++;
+    }
+    if (page == pages_.size()) {
+        page = 0;
+        while (page < pages_.size() && (pages_[page].used != 0 || pages_[page].released)) {
+            page++;
+        }
+    }
+    if (page == pages_.size()) {
+        page = 0;
+        while (page < pages_.size() && !pages_[page].released) {
+            page++;
+        }
+    }
+    if (page == pages_.size()) {
+        SDL_assert(page < UINT16_MAX && "Too many tile pages");
+        Page& added = pages_.emplace_back();
+        added.free.reserve(PAGE_SLICES);
+        for (size_t slice = PAGE_SLICES; slice > 0; slice--) {
+            added.free.push_back(static_cast<std::uint16_t>(slice - 1));
+        }
+    }
+
+    Page& free_page = pages_[page];
+    if (free_page.released) {
+        free_page.released = false;
+        pagesReleased_--;
+    }
+    const Slot slot = {.page = static_cast<std::uint16_t>(page), .slice = free_page.free.back()};
+    free_page.free.pop_back();
+    free_page.used++;
+    free_page.layer = layer;
+
+    slots_[tile] = slot;
+    size_++;
+    return slot;
+}
+
+void TileAtlas::Free(const Tile tile) {
+    SDL_assert(Contains(tile) && "Tile has no slot");
+    const Slot slot = slots_[tile];
+
+    Page& page = pages_[slot.page];
+    page.free.push_back(slot.slice);
+    page.used--;
+    if (page.used == 0) {
+        page.layer = LAYER_INVALID;
+    }
+
+    slots_[tile] = Slot{};
+    size_--;
+}
+
+void TileAtlas::ReleasePage(const size_t page) {
+    SDL_assert(page < pages_.size());
+    SDL_assert(pages_[page].used == 0 && !pages_[page].released && "Page still in use");
+    pages_[page].released = true;
+    pagesReleased_++;
+}
+
+bool TileAtlas::Contains(const Tile tile) const {
+    return tile < slots_.size() && slots_[tile].page != UINT16_MAX;
+}
+
+TileAtlas::Slot TileAtlas::At(const Tile tile) const {
+    SDL_assert(Contains(tile) && "Tile has no slot");
+    return slots_[tile];
+}
+
+size_t TileAtlas::PageCount() const {
+    return pages_.size();
+}
+
+size_t TileAtlas::PageUsed(const size_t page) const {
+    SDL_assert(page < pages_.size());
+    return pages_[page].used;
+}
+
+Layer TileAtlas::PageLayer(const size_t page) const {
+    SDL_assert(page < pages_.size());
+    return pages_[page].layer;
+}
+
+bool TileAtlas::PageReleased(const size_t page) const {
+    SDL_assert(page < pages_.size());
+    return pages_[page].released;
+}
+
+size_t TileAtlas::EmptyPages() const {
+    size_t empty = 0;
+    for (const auto& page : pages_) {
+        empty += page.used == 0 && !page.released ? 1 : 0;
+    }
+    return empty;
+}
+
+size_t TileAtlas::FreeSlices() const {
+    return ((pages_.size() - pagesReleased_) * PAGE_SLICES) - size_;
+}
+
+size_t TileAtlas::Size() const {
+    return size_;
+}
+
+} // namespace Midori
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "tiles.h"
+#include <EASTL/vector.h>
+#include <cstddef>
+#include <cstdint>
+
+namespace Midori {
+
+// Slots of the tile texture pages.
+//
+// Tile textures aren't separate GPU textures, every tile is a slice of a 2D texture array (a page). Tiles of a layer
+// sharing a page are bound once and drawn with a single instanced call, so a page belongs to the layer that first took
+// a slice of it until it is empty again. Tiles are loaded for every layer at once, with shared pages each layer would
+// end up spread over all of them.
+//
+// Even a layer with a single loaded tile holds a whole page, so pages are kept small and an empty page can be released.
+// A released page keeps its index and gets a texture again when a tile needs it.
+
+class TileAtlas {
+public:
+    // 8MB, a layer in view takes a few pages. Vulkan only guarantees 256 array layers.
+    static constexpr std::uint16_t PAGE_SLICES = 32;
+
+    struct Slot {
+        std::uint16_t page = UINT16_MAX;
+        std::uint16_t slice = UINT16_MAX;
+
+        bool operator==(const Slot& other) const = default;
+    };
+
+    // Gives the tile a free slice in the lowest page of the layer, or else in the lowest empty page, preferring the
+    // ones that weren't released. The page is one past the last when a new one is needed.
+    Slot Allocate(Tile tile, Layer layer);
+    void Free(Tile tile);
+    // The page is empty and its texture was released
+    void ReleasePage(size_t page);
+
+    [[nodiscard]] bool Contains(Tile tile) const;
+    [[nodiscard]] Slot At(Tile tile) const;
+
+    [[nodiscard]] size_t PageCount() const;
+    [[nodiscard]] size_t PageUsed(size_t page) const;
+    [[nodiscard]] Layer PageLayer(size_t page) const; // LAYER_INVALID when empty
+    [[nodiscard]] bool PageReleased(size_t page) const;
+    [[nodiscard]] size_t EmptyPages() const; // Not released
+    // Slices left in the pages that weren't released, they take GPU memory as much as tiles do
+    [[nodiscard]] size_t FreeSlices() const;
+    [[nodiscard]] size_t Size() const;
+
+private:
+    struct Page {
+        eastl::vector<std::uint16_t> free; // Popped from the back, lowest slice first
+        size_t used = 0;
+        Layer layer = LAYER_INVALID;
+        bool released = false;
+    };
+
+    eastl::vector<Page> pages_;
+    eastl::vector<Slot> slots_; // Indexed by Tile
+    size_t size_ = 0;
+    size_t pagesReleased_ = 0;
+};
+
+} // namespace Midori
@@ -0,0 +1,74 @@
+#include "tile_blob_cache.h"
+
+#include <iterator>
+#include <tracy/Tracy.hpp>
+
+namespace Midori {
+
+void TileBlobCache::SetBudget(const size_t megabytes) {
+    std::scoped_lock lock(mutex_);
+    budget_ = megabytes;
+    EvictOverBudget();
+}
+
+size_t TileBlobCache::Budget() const {
+    std::scoped_lock lock(mutex_);
+    return budget_;
+}
+
+TileBlobCache::Blob TileBlobCache::Find(const std::uint64_t offset) {
+    std::scoped_lock lock(mutex_);
+
+    const auto it = entries_.find(offset);
+    if (it == entries_.end()) {
+        stats_.misses++;
+    } else {
+        stats_.hits++;
+        uses_.splice(uses_.end(), uses_, it->second.use);
+    }
+    TracyPlot("Tile blob cache hit ratio",
+              static_cast<double>(stats_.hits) / static_cast<double>(stats_.hits + stats_.misses));
+
+    return it != entries_.end() ? it->second.blob : nullptr;
+}
+
+void TileBlobCache::Insert(const std::uint64_t offset, const std::uint8_t* data, const size_t size) {
+    auto blob = std::make_shared<const eastl::vector<std::uint8_t>>(data, data + size);
+
+    std::scoped_lock lock(mutex_);
+    if (size > budget_ * 1024 * 1024 || entries_.contains(offset)) {
+        return;
+    }
+
+    uses_.push_back(offset);
+    entries_[offset] = Entry{.blob = std::move(blob), .use = std::prev(uses_.end())};
+    stats_.bytes += size;
+    stats_.count++;
+    EvictOverBudget();
+    TracyPlot("Tile blob cache size", static_cast<std::int64_t>(stats_.bytes));
+}
+
+void TileBlobCache::Clear() {
+    std::scoped_lock lock(mutex_);
+    entries_.clear();
+    uses_.clear();
+    stats_.bytes = 0;
+    stats_.count = 0;
+}
+
+TileBlobCache::Stats TileBlobCache::GetStats() const {
+    std::scoped_lock lock(mutex_);
+    return stats_;
+}
+
+void TileBlobCache::EvictOverBudget() {
+    while (stats_.bytes > budget_ * 1024 * 1024) {
+        const auto it = entries_.find(uses_.front());
+        stats_.bytes -= it->second.blob->size();
+        stats_.count--;
+        entries_.erase(it);
+        uses_.pop_front();
+    }
+}
+
+} // namespace Midori
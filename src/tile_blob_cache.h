@@ -0,0 +1,58 @@
+#pragma once
+
+#include <EASTL/list.h>
+#include <EASTL/unordered_map.h>
+#include <EASTL/vector.h>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+namespace Midori {
+
+// RAM tier between the GPU and the pack file: the encoded blobs of the tiles recently read or written, in least
+// recently used order under a byte budget. A hit is decoded straight from memory, without touching the mapping of the
+// pack or verifying the checksum again.
+//
+// Blobs are keyed by their offset in the pack. A blob is never modified once written, a rewritten tile gets a new
+// offset, so only a compaction or reopening the pack invalidates the cache. Thread safe.
+
+class TileBlobCache {
+public:
+    static constexpr size_t DEFAULT_BUDGET_MB = 128;
+
+    using Blob = std::shared_ptr<const eastl::vector<std::uint8_t>>;
+
+    struct Stats {
+        std::uint64_t hits = 0;
+        std::uint64_t misses = 0;
+        size_t bytes = 0;
+        size_t count = 0;
+    };
+
+    void SetBudget(size_t megabytes);
+    [[nodiscard]] size_t Budget() const; // In MB
+
+    // nullptr on a miss, the blob stays valid as long as it is held even if evicted
+    [[nodiscard]] Blob Find(std::uint64_t offset);
+    void Insert(std::uint64_t offset, const std::uint8_t* data, size_t size);
+    void Clear();
+
+    [[nodiscard]] Stats GetStats() const;
+
+private:
+    struct Entry {
+        Blob blob;
+        eastl::list<std::uint64_t>::iterator use;
+    };
+
+    void EvictOverBudget();
+
+    mutable std::mutex mutex_;
+    size_t budget_ = DEFAULT_BUDGET_MB;
+    eastl::unordered_map<std::uint64_t, Entry> entries_;
+    eastl::list<std::uint64_t> uses_; // Least recently used first
+    Stats stats_;
+};
+
+} // namespace Midori
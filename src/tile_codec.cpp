@@ -0,0 +1,401 @@
+#include "tile_codec.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <tracy/Tracy.hpp>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define MIDORI_TILE_CODEC_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MIDORI_TILE_CODEC_SSE2
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define MIDORI_TILE_CODEC_NEON
+#endif
+
+namespace Midori {
+
+// See deps/qoi/qoi.h for the format
+static constexpr std::uint8_t QOI_OP_INDEX = 0x00;
+static constexpr std::uint8_t QOI_OP_DIFF = 0x40;
+static constexpr std::uint8_t QOI_OP_LUMA = 0x80;
+static constexpr std::uint8_t QOI_OP_RUN = 0xc0;
+static constexpr std::uint8_t QOI_OP_RGB = 0xfe;
+static constexpr std::uint8_t QOI_OP_RGBA = 0xff;
+static constexpr std::uint8_t QOI_MASK_2 = 0xc0;
+static constexpr std::uint8_t QOI_COLORSPACE_LINEAR = 1;
+static constexpr size_t QOI_HEADER_SIZE = 14;
+static constexpr size_t QOI_PADDING_SIZE = 8;
+static constexpr size_t QOI_RUN_MAX = 62;
+
+static constexpr size_t TILE_PIXEL_COUNT = TILE_WIDTH * TILE_HEIGHT;
+
+struct QoiPixel {
+    std::uint8_t r = 0;
+    std::uint8_t g = 0;
+    std::uint8_t b = 0;
+    std::uint8_t a = 255;
+};
+static_assert(sizeof(QoiPixel) == 4);
+
+static std::uint32_t ReadBigEndian32(const std::uint8_t* bytes) {
+    return (std::uint32_t)bytes[0] << 24 | (std::uint32_t)bytes[1] << 16 | (std::uint32_t)bytes[2] << 8 |
+           (std::uint32_t)bytes[3];
+}
+
+static void WriteBigEndian32(std::uint8_t* bytes, const std::uint32_t v) {
+    bytes[0] = (std::uint8_t)(v >> 24);
+    bytes[1] = (std::uint8_t)(v >> 16);
+    bytes[2] = (std::uint8_t)(v >> 8);
+    bytes[3] = (std::uint8_t)v;
+}
+
+// Pixels are compared as 32 bit words, the byte order doesn't matter for equality
+static std::uint32_t LoadPixel(const std::uint8_t* bytes) {
+    std::uint32_t v;
+    std::memcpy(&v, bytes, 4);
+    return v;
+}
+
+static size_t QoiHash(const QoiPixel px) {
+    return (px.r * 3 + px.g * 5 + px.b * 7 + px.a * 11) & 63;
+}
+
+// Number of pixels at the start of `bytes` equal to `px`, at most `count`
+static size_t CountRun(const std::uint8_t* bytes, const size_t count, const std::uint32_t px) {
+    size_t n = 0;
+#if defined(MIDORI_TILE_CODEC_AVX2)
+    const __m256i target = _mm256_set1_epi32((int)px);
+    for (; n + 8 <= count; n += 8) {
+        const __m256i v = _mm256_loadu_si256((const __m256i*)(bytes + (n * 4)));
+        const auto mask = (unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(v, target)));
+        if (mask != 0xFF) {
+            return n + std::countr_one(mask);
+        }
+    }
+#elif defined(MIDORI_TILE_CODEC_SSE2)
+    const __m128i target = _mm_set1_epi32((int)px);
+    for (; n + 4 <= count; n += 4) {
+        const __m128i v = _mm_loadu_si128((const __m128i*)(bytes + (n * 4)));
+        const auto mask = (unsigned)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(v, target)));
+        if (mask != 0xF) {
+            return n + std::countr_one(mask);
+        }
+    }
+#elif defined(MIDORI_TILE_CODEC_NEON)
+    const uint32x4_t target = vdupq_n_u32(px);
+    for (; n + 4 <= count; n += 4) {
+        const uint32x4_t v = vld1q_u32((const std::uint32_t*)(bytes + (n * 4)));
+        if (vminvq_u32(vceqq_u32(v, target)) != 0xFFFFFFFFu) {
+            break;
+        }
+    }
+#endif
+    for (; n < count; n++) {
+        if (LoadPixel(bytes + (n * 4)) != px) {
+            break;
+        }
+    }
+    return n;
+}
+
+// QOI index of every pixel of a tile row
+static void HashRow(const std::uint8_t* bytes, std::uint8_t* hashes) {
+    static_assert(TILE_WIDTH % 8 == 0);
+#if defined(MIDORI_TILE_CODEC_AVX2)
+    // r * 3 + b * 7 and g * 5 + a * 11 with 16 bit multiply-adds, the sum can't overflow (255 * 26)
+    const __m256i low_bytes = _mm256_set1_epi32(0x00FF00FF);
+    const __m256i rb_weights = _mm256_set1_epi32(3 | (7 << 16));
+    const __m256i ga_weights = _mm256_set1_epi32(5 | (11 << 16));
+    const __m256i hash_mask = _mm256_set1_epi32(63);
+    for (size_t n = 0; n < TILE_WIDTH; n += 8) {
+        const __m256i v = _mm256_loadu_si256((const __m256i*)(bytes + (n * 4)));
+        const __m256i rb = _mm256_madd_epi16(_mm256_and_si256(v, low_bytes), rb_weights);
+        const __m256i ga = _mm256_madd_epi16(_mm256_srli_epi16(v, 8), ga_weights);
+        __m256i h = _mm256_and_si256(_mm256_add_epi32(rb, ga), hash_mask);
+        h = _mm256_packus_epi16(_mm256_packs_epi32(h, h), h);
+        const std::uint32_t lo = (std::uint32_t)_mm256_cvtsi256_si32(h);
+        const std::uint32_t hi = (std::uint32_t)_mm256_extract_epi32(h, 4);
+        std::memcpy(hashes + n, &lo, 4);
+        std::memcpy(hashes + n + 4, &hi, 4);
+    }
+#elif defined(MIDORI_TILE_CODEC_SSE2)
+    const __m128i low_bytes = _mm_set1_epi32(0x00FF00FF);
+    const __m128i rb_weights = _mm_set1_epi32(3 | (7 << 16));
+    const __m128i ga_weights = _mm_set1_epi32(5 | (11 << 16));
+    const __m128i hash_mask = _mm_set1_epi32(63);
+    for (size_t n = 0; n < TILE_WIDTH; n += 4) {
+        const __m128i v = _mm_loadu_si128((const __m128i*)(bytes + (n * 4)));
+        const __m128i rb = _mm_madd_epi16(_mm_and_si128(v, low_bytes), rb_weights);
+        const __m128i ga = _mm_madd_epi16(_mm_srli_epi16(v, 8), ga_weights);
+        __m128i h = _mm_and_si128(_mm_add_epi32(rb, ga), hash_mask);
+        h = _mm_packus_epi16(_mm_packs_epi32(h, h), h);
+        const std::uint32_t packed = (std::uint32_t)_mm_cvtsi128_si32(h);
+        std::memcpy(hashes + n, &packed, 4);
+    }
+#elif defined(MIDORI_TILE_CODEC_NEON)
+    const uint16x8_t weights = {3, 5, 7, 11, 3, 5, 7, 11};
+    const uint16x8_t hash_mask = vdupq_n_u16(63);
+    for (size_t n = 0; n < TILE_WIDTH; n += 4) {
+        const uint8x16_t v = vld1q_u8(bytes + (n * 4));
+        const uint16x8_t lo = vmulq_u16(vmovl_u8(vget_low_u8(v)), weights);
+        const uint16x8_t hi = vmulq_u16(vmovl_u8(vget_high_u8(v)), weights);
+        const uint16x8_t pairs = vpaddq_u16(lo, hi);
+        const uint16x8_t sums = vandq_u16(vpaddq_u16(pairs, pairs), hash_mask);
+        const std::uint32_t packed = vget_lane_u32(vreinterpret_u32_u8(vmovn_u16(sums)), 0);
+        std::memcpy(hashes + n, &packed, 4);
+    }
+#else
+    for (size_t n = 0; n < TILE_WIDTH; n++) {
+        const std::uint8_t* px = bytes + (n * 4);
+        hashes[n] = (std::uint8_t)((px[0] * 3 + px[1] * 5 + px[2] * 7 + px[3] * 11) & 63);
+    }
+#endif
+}
+
+static void FillPixels(std::uint8_t* out, const QoiPixel px, const size_t count) {
+    std::uint32_t v;
+    std::memcpy(&v, &px, 4);
+
+    size_t n = 0;
+#if defined(MIDORI_TILE_CODEC_AVX2)
+    const __m256i fill = _mm256_set1_epi32((int)v);
+    for (; n + 8 <= count; n += 8) {
+        _mm256_storeu_si256((__m256i*)(out + (n * 4)), fill);
+    }
+#elif defined(MIDORI_TILE_CODEC_SSE2)
+    const __m128i fill = _mm_set1_epi32((int)v);
+    for (; n + 4 <= count; n += 4) {
+        _mm_storeu_si128((__m128i*)(out + (n * 4)), fill);
+    }
+#elif defined(MIDORI_TILE_CODEC_NEON)
+    const uint32x4_t fill = vdupq_n_u32(v);
+    for (; n + 4 <= count; n += 4) {
+        vst1q_u32((std::uint32_t*)(out + (n * 4)), fill);
+    }
+#endif
+    for (; n < count; n++) {
+        std::memcpy(out + (n * 4), &v, 4);
+    }
+}
+
+bool DecodeTileQoi(const std::uint8_t* data, const size_t size, std::uint8_t* pixels) {
+    ZoneScoped;
+
+    if (data == nullptr || pixels == nullptr || size < QOI_HEADER_SIZE + QOI_PADDING_SIZE) {
+        return false;
+    }
+    if (std::memcmp(data, "qoif", 4) != 0 || ReadBigEndian32(data + 4) != TILE_WIDTH ||
+        ReadBigEndian32(data + 8) != TILE_HEIGHT || data[12] < 3 || data[12] > 4 || data[13] > 1) {
+        return false;
+    }
+
+    QoiPixel index[64];
+    std::fill(std::begin(index), std::end(index), QoiPixel{.a = 0});
+    QoiPixel px;
+
+    const std::uint8_t* bytes = data + QOI_HEADER_SIZE;
+    const std::uint8_t* chunks_end = data + size - QOI_PADDING_SIZE;
+    size_t pos = 0;
+
+    while (pos < TILE_PIXEL_COUNT) {
+        size_t run = 1;
+        if (bytes < chunks_end) {
+            const std::uint8_t b1 = *bytes++;
+
+            if (b1 == QOI_OP_RGB) {
+                px.r = bytes[0];
+                px.g = bytes[1];
+                px.b = bytes[2];
+                bytes += 3;
+            } else if (b1 == QOI_OP_RGBA) {
+                px.r = bytes[0];
+                px.g = bytes[1];
+                px.b = bytes[2];
+                px.a = bytes[3];
+                bytes += 4;
+            } else if ((b1 & QOI_MASK_2) == QOI_OP_INDEX) {
+                px = index[b1];
+            } else if ((b1 & QOI_MASK_2) == QOI_OP_DIFF) {
+                px.r += ((b1 >> 4) & 0x03) - 2;
+                px.g += ((b1 >> 2) & 0x03) - 2;
+                px.b += (b1 & 0x03) - 2;
+            } else if ((b1 & QOI_MASK_2) == QOI_OP_LUMA) {
+                const std::uint8_t b2 = *bytes++;
+                const int vg = (b1 & 0x3f) - 32;
+                px.r += (std::uint8_t)(vg - 8 + ((b2 >> 4) & 0x0f));
+                px.g += (std::uint8_t)(vg);
+                px.b += (std::uint8_t)(vg - 8 + (b2 & 0x0f));
+            } else if ((b1 & QOI_MASK_2) == QOI_OP_RUN) {
+                run += (b1 & 0x3f);
+            }
+
+            index[QoiHash(px)] = px;
+        } else {
+            // Truncated stream, the reference decoder repeats the last pixel
+            run = TILE_PIXEL_COUNT - pos;
+        }
+
+        run = std::min(run, TILE_PIXEL_COUNT - pos);
+        if (run == 1) {
+            std::memcpy(pixels + (pos * 4), &px, 4);
+        } else {
+            FillPixels(pixels + (pos * 4), px, run);
+        }
+        pos += run;
+    }
+
+    return true;
+}
+
+size_t EncodeTileQoi(const std::uint8_t* pixels, std::uint8_t* data) {
+    ZoneScoped;
+
+    std::memcpy(data, "qoif", 4);
+    WriteBigEndian32(data + 4, TILE_WIDTH);
+    WriteBigEndian32(data + 8, TILE_HEIGHT);
+    data[12] = 4;
+    data[13] = QOI_COLORSPACE_LINEAR;
+    std::uint8_t* out = data + QOI_HEADER_SIZE;
+
+    std::uint32_t index[64];
+    std::memset(index, 0, sizeof(index));
+
+    // Hashes are computed a row at a time, most pixels of a painted tile end up needing one
+    alignas(16) std::uint8_t hashes[TILE_WIDTH];
+    size_t hashed_row = TILE_HEIGHT;
+
+    QoiPixel prev;
+    std::uint32_t prev_v;
+    std::memcpy(&prev_v, &prev, 4);
+
+    size_t pos = 0;
+    while (pos < TILE_PIXEL_COUNT) {
+        const std::uint8_t* bytes = pixels + (pos * 4);
+        const std::uint32_t px_v = LoadPixel(bytes);
+
+        if (px_v == prev_v) {
+            // The reference codec counts the run pixel by pixel, flushing it every 62 pixels and at the last pixel
+            size_t run = 1 + CountRun(bytes + 4, TILE_PIXEL_COUNT - pos - 1, prev_v);
+            pos += run;
+            for (; run >= QOI_RUN_MAX; run -= QOI_RUN_MAX) {
+                *out++ = (std::uint8_t)(QOI_OP_RUN | (QOI_RUN_MAX - 1));
+            }
+            if (run > 0) {
+                *out++ = (std::uint8_t)(QOI_OP_RUN | (run - 1));
+            }
+            continue;
+        }
+
+        const size_t row = pos / TILE_WIDTH;
+        if (row != hashed_row) {
+            HashRow(pixels + (row * TILE_WIDTH * 4), hashes);
+            hashed_row = row;
+        }
+        const std::uint8_t index_pos = hashes[pos % TILE_WIDTH];
+
+        const QoiPixel px = {.r = bytes[0], .g = bytes[1], .b = bytes[2], .a = bytes[3]};
+        if (index[index_pos] == px_v) {
+            *out++ = (std::uint8_t)(QOI_OP_INDEX | index_pos);
+        } else {
+            index[index_pos] = px_v;
+
+            if (px.a == prev.a) {
+                const auto vr = (signed char)(px.r - prev.r);
+                const auto vg = (signed char)(px.g - prev.g);
+                const auto vb = (signed char)(px.b - prev.b);
+
+                const auto vg_r = (signed char)(vr - vg);
+                const auto vg_b = (signed char)(vb - vg);
+
+                if (vr > -3 && vr < 2 && vg > -3 && vg < 2 && vb > -3 && vb < 2) {
+                    *out++ = (std::uint8_t)(QOI_OP_DIFF | (vr + 2) << 4 | (vg + 2) << 2 | (vb + 2));
+                } else if (vg_r > -9 && vg_r < 8 && vg > -33 && vg < 32 && vg_b > -9 && vg_b < 8) {
+                    *out++ = (std::uint8_t)(QOI_OP_LUMA | (vg + 32));
+                    *out++ = (std::uint8_t)((vg_r + 8) << 4 | (vg_b + 8));
+                } else {
+                    *out++ = QOI_OP_RGB;
+                    *out++ = px.r;
+                    *out++ = px.g;
+                    *out++ = px.b;
+                }
+            } else {
+                *out++ = QOI_OP_RGBA;
+                *out++ = px.r;
+                *out++ = px.g;
+                *out++ = px.b;
+                *out++ = px.a;
+            }
+        }
+
+        prev = px;
+        prev_v = px_v;
+        pos++;
+    }
+
+    std::memset(out, 0, QOI_PADDING_SIZE - 1);
+    out[QOI_PADDING_SIZE - 1] = 1;
+    out += QOI_PADDING_SIZE;
+
+    return (size_t)(out - data);
+}
+
+bool IsTileEmpty(const std::uint8_t* pixels) {
+    ZoneScoped;
+
+    // Painted tiles usually fail in the first block, so the check only goes through the whole tile for empty ones
+    static constexpr size_t BLOCK_SIZE = 1024;
+    static_assert(TILE_PIXELS_SIZE % BLOCK_SIZE == 0);
+    for (size_t block = 0; block < TILE_PIXELS_SIZE; block += BLOCK_SIZE) {
+        const std::uint8_t* bytes = pixels + block;
+#if defined(MIDORI_TILE_CODEC_AVX2)
+        __m256i acc = _mm256_setzero_si256();
+        for (size_t i = 0; i < BLOCK_SIZE; i += 32) {
+            acc = _mm256_or_si256(acc, _mm256_loadu_si256((const __m256i*)(bytes + i)));
+        }
+        if (!_mm256_testz_si256(acc, _mm256_set1_epi8((char)0xFE))) {
+            return false;
+        }
+#elif defined(MIDORI_TILE_CODEC_SSE2)
+        __m128i acc = _mm_setzero_si128();
+        for (size_t i = 0; i < BLOCK_SIZE; i += 16) {
+            acc = _mm_or_si128(acc, _mm_loadu_si128((const __m128i*)(bytes + i)));
+        }
+        acc = _mm_and_si128(acc, _mm_set1_epi8((char)0xFE));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(acc, _mm_setzero_si128())) != 0xFFFF) {
+            return false;
+        }
+#elif defined(MIDORI_TILE_CODEC_NEON)
+        uint8x16_t acc = vdupq_n_u8(0);
+        for (size_t i = 0; i < BLOCK_SIZE; i += 16) {
+            acc = vorrq_u8(acc, vld1q_u8(bytes + i));
+        }
+        if (vmaxvq_u8(acc) > 1) {
+            return false;
+        }
+#else
+        std::uint64_t acc = 0;
+        for (size_t i = 0; i < BLOCK_SIZE; i += 8) {
+            std::uint64_t word;
+            std::memcpy(&word, bytes + i, 8);
+            acc |= word;
+        }
+        if ((acc & 0xFEFEFEFEFEFEFEFEull) != 0) {
+            return false;
+        }
+#endif
+    }
+    return true;
+}
+
+bool IsTileUniform(const std::uint8_t* pixels, std::uint32_t& color) {
+    ZoneScoped;
+
+    color = LoadPixel(pixels);
+    return 1 + CountRun(pixels + 4, TILE_PIXEL_COUNT - 1, color) == TILE_PIXEL_COUNT;
+}
+
+} // namespace Midori
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "tiles.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace Midori {
+
+// QOI codec specialised for TILE_WIDTH x TILE_HEIGHT RGBA8 tiles. The output is byte for byte what deps/qoi/qoi.h
+// produces (qoi_encode with 4 channels and QOI_LINEAR, qoi_decode(..., 4)) so old canvases and the reference codec stay
+// interchangeable. Neither function allocates, they work on caller provided buffers and are safe on the job threads.
+//
+// Run detection, the index hash and the empty/uniform checks use SSE2/AVX2/NEON when the compiler targets them, the
+// scalar path is the fallback.
+
+constexpr size_t TILE_PIXELS_SIZE = TILE_WIDTH * TILE_HEIGHT * 4;
+// Worst case of the encoder, every pixel stored as QOI_OP_RGBA
+constexpr size_t TILE_QOI_MAX_SIZE = 14 + (TILE_WIDTH * TILE_HEIGHT * 5) + 8;
+
+// Decode `data` into `pixels` (TILE_PIXELS_SIZE bytes). Fails if the data is not a TILE_WIDTH x TILE_HEIGHT QOI.
+bool DecodeTileQoi(const std::uint8_t* data, size_t size, std::uint8_t* pixels);
+
+// Encode `pixels` (TILE_PIXELS_SIZE bytes) into `data` (at least TILE_QOI_MAX_SIZE bytes), returns the encoded size
+size_t EncodeTileQoi(const std::uint8_t* pixels, std::uint8_t* data);
+
+// A tile is empty when no channel goes above 1, these are deleted instead of being saved
+[[nodiscard]] bool IsTileEmpty(const std::uint8_t* pixels);
+// A tile is uniform when every pixel is the same, `color` is that pixel in memory order (R, G, B, A bytes)
+[[nodiscard]] bool IsTileUniform(const std::uint8_t* pixels, std::uint32_t& color);
+
+} // namespace Midori
@@ -0,0 +1,99 @@
+#include "tile_download_ring.h"
+
+#include <SDL3/SDL_assert.h>
+
+namespace Midori {
+
+bool TileDownloadRing::Reserve(const Tile tile) {
+    SDL_assert(!Contains(tile) && "Tile already downloading");
+    if (filling_ == BATCH_NONE || batches_[filling_].tiles.size() == BATCH_TILES) {
+        filling_ = BATCH_NONE;
+        for (size_t batch = 0; batch < batches_.size(); batch++) {
+            if (batches_[batch].state == BatchState::Free) {
+                filling_ = batch;
+                break;
+            }
+        }
+        if (filling_ == BATCH_NONE) {
+            if (batches_.size() == MAX_BATCHES) {
+                return false;
+            }
+            filling_ = batches_.size();
+            batches_.emplace_back().tiles.reserve(BATCH_TILES);
+        }
+        batches_[filling_].state = BatchState::Filling;
+    }
+
+    Batch& batch = batches_[filling_];
+    slots_[tile] = Slot{.batch = filling_, .index = batch.tiles.size()};
+    batch.tiles.push_back(tile);
+    batch.unread++;
+    return true;
+}
+
+eastl::vector<size_t> TileDownloadRing::Submit() {
+    eastl::vector<size_t> submitted;
+    for (size_t batch = 0; batch < batches_.size(); batch++) {
+        if (batches_[batch].state == BatchState::Filling) {
+            batches_[batch].state = BatchState::InFlight;
+            submitted.push_back(batch);
+        }
+    }
+    filling_ = BATCH_NONE;
+    return submitted;
+}
+
+void TileDownloadRing::Complete(const size_t batch) {
+    SDL_assert(batch < batches_.size());
+    SDL_assert(batches_[batch].state == BatchState::InFlight);
+    batches_[batch].state = BatchState::Ready;
+}
+
+bool TileDownloadRing::Release(const Tile tile) {
+    SDL_assert(IsReady(tile) && "Tile not downloaded");
+    const Slot slot = slots_.at(tile);
+    slots_.erase(tile);
+
+    Batch& batch = batches_[slot.batch];
+    batch.unread--;
+    if (batch.unread > 0) {
+        return false;
+    }
+    batch.tiles.clear();
+    batch.state = BatchState::Free;
+    return true;
+}
+
+bool TileDownloadRing::Contains(const Tile tile) const {
+    return slots_.contains(tile);
+}
+
+bool TileDownloadRing::IsReady(const Tile tile) const {
+    const auto it = slots_.find(tile);
+    return it != slots_.end() && batches_[it->second.batch].state == BatchState::Ready;
+}
+
+TileDownloadRing::Slot TileDownloadRing::At(const Tile tile) const {
+    SDL_assert(Contains(tile));
+    return slots_.at(tile);
+}
+
+const eastl::vector<Tile>& TileDownloadRing::BatchTiles(const size_t batch) const {
+    SDL_assert(batch < batches_.size());
+    return batches_[batch].tiles;
+}
+
+TileDownloadRing::BatchState TileDownloadRing::State(const size_t batch) const {
+    SDL_assert(batch < batches_.size());
+    return batches_[batch].state;
+}
+
+size_t TileDownloadRing::BatchCount() const {
+    return batches_.size();
+}
+
+bool TileDownloadRing::Empty() const {
+    return slots_.empty();
+}
+
+} // namespace Midori
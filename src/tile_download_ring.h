@@ -0,0 +1,65 @@
+#pragma once
+
+#include "tiles.h"
+#include <EASTL/unordered_map.h>
+#include <EASTL/vector.h>
+#include <cstddef>
+#include <cstdint>
+
+namespace Midori {
+
+// Slots of the tile download transfer buffers.
+//
+// Downloads are recorded in batches, a batch is one transfer buffer submitted with its own fence. Batches are polled
+// instead of waited on, a tile is read once its batch is done and the batch is reused once every tile of it was read.
+// A batch is added whenever all of them are busy, so a mass save gets more downloads in flight instead of trickling
+// one batch per frame. Doesn't touch the GPU, the renderer owns the buffers and fences of the batches.
+// The tile reductions use a ring of their own, with a result per slot instead of the pixels.
+
+class TileDownloadRing {
+public:
+    static constexpr size_t BATCH_TILES = 32;
+    static constexpr size_t MAX_BATCHES = 8; // 64MB of transfer buffers
+    static constexpr size_t BATCH_NONE = SIZE_MAX;
+
+    enum class BatchState : std::uint8_t {
+        Free,
+        Filling,  // Tiles are reserved in it, not submitted yet
+        InFlight, // Submitted, the fence isn't signaled
+        Ready,    // Its tiles can be read
+    };
+
+    struct Slot {
+        size_t batch = BATCH_NONE;
+        size_t index = 0; // In the batch
+    };
+
+    // False when every batch is busy and no more can be added
+    bool Reserve(Tile tile);
+    // The batches filled since the last submit, they are in flight afterwards
+    eastl::vector<size_t> Submit();
+    void Complete(size_t batch);
+    // Read, the batch is free once all of its tiles are. Returns true when it became free.
+    bool Release(Tile tile);
+
+    [[nodiscard]] bool Contains(Tile tile) const;
+    [[nodiscard]] bool IsReady(Tile tile) const;
+    [[nodiscard]] Slot At(Tile tile) const;
+    [[nodiscard]] const eastl::vector<Tile>& BatchTiles(size_t batch) const;
+    [[nodiscard]] BatchState State(size_t batch) const;
+    [[nodiscard]] size_t BatchCount() const;
+    [[nodiscard]] bool Empty() const;
+
+private:
+    struct Batch {
+        BatchState state = BatchState::Free;
+        eastl::vector<Tile> tiles;
+        size_t unread = 0;
+    };
+
+    eastl::vector<Batch> batches_;
+    eastl::unordered_map<Tile, Slot> slots_;
+    size_t filling_ = BATCH_NONE; // Batch new tiles go to
+};
+
+} // namespace Midori
@@ -0,0 +1,190 @@
+#include "tile_index.h"
+
+#include <SDL3/SDL_assert.h>
+#include <algorithm>
+#include <tracy/Tracy.hpp>
+
+namespace Midori {
+
+void TileIndex::AddLayer(const Layer layer) {
+    SDL_assert(layer != LAYER_INVALID);
+    if (layer >= layers_.size()) {
+        layers_.resize(static_cast<size_t>(layer) + 1);
+    }
+    SDL_assert(!layers_[layer].used && "Layer already indexed");
+    layers_[layer] = LayerGrid{.used = true};
+}
+
+void TileIndex::EraseLayer(const Layer layer) {
+    SDL_assert(HasLayer(layer));
+    SDL_assert(layers_[layer].tiles.empty() && "Layer still has tiles loaded");
+    layers_[layer] = LayerGrid{};
+}
+
+bool TileIndex::HasLayer(const Layer layer) const {
+    return layer < layers_.size() && layers_[layer].used;
+}
+
+void TileIndex::CopySaved(const Layer src, const Layer dst) {
+    ZoneScoped;
+    SDL_assert(HasLayer(src) && HasLayer(dst));
+
+    auto& to = layers_[dst];
+    const auto& from = layers_[src];
+    to.chunkMin = from.chunkMin;
+    to.chunkCount = from.chunkCount;
+    to.cells = from.cells;
+    to.chunks = from.chunks;
+    for (auto& chunk : to.chunks) {
+        for (auto& slot : chunk) {
+            slot.tile = TILE_INVALID;
+        }
+    }
+    for (const auto tile : to.tiles) {
+        Get(dst, tilePos_[tile]).tile = tile;
+    }
+}
+
+const TileIndex::Slot* TileIndex::Find(const Layer layer, const glm::ivec2 pos) const {
+    if (layer >= layers_.size()) {
+        return nullptr;
+    }
+    const auto& grid = layers_[layer];
+
+    const glm::ivec2 chunk = ChunkOf(pos) - grid.chunkMin;
+    if (chunk.x < 0 || chunk.y < 0 || chunk.x >= grid.chunkCount.x || chunk.y >= grid.chunkCount.y) {
+        return nullptr;
+    }
+    const std::uint32_t cell = grid.cells[(static_cast<size_t>(chunk.y) * grid.chunkCount.x) + chunk.x];
+    if (cell == 0) {
+        return nullptr;
+    }
+    return &grid.chunks[cell - 1][SlotOf(pos)];
+}
+
+TileIndex::Slot& TileIndex::Get(const Layer layer, const glm::ivec2 pos) {
+    SDL_assert(HasLayer(layer));
+    auto& grid = layers_[layer];
+
+    const glm::ivec2 chunk = ChunkOf(pos);
+    if (grid.chunkCount.x == 0 || chunk.x < grid.chunkMin.x || chunk.y < grid.chunkMin.y ||
+        chunk.x >= grid.chunkMin.x + grid.chunkCount.x || chunk.y >= grid.chunkMin.y + grid.chunkCount.y) {
+        ZoneScopedN("Growing tile grid");
+        const glm::ivec2 new_min = grid.chunkCount.x == 0 ? chunk : glm::min(grid.chunkMin, chunk);
+        const glm::ivec2 new_max =
+            grid.chunkCount.x == 0 ? chunk + 1 : glm::max(grid.chunkMin + grid.chunkCount, chunk + 1);
+        const glm::ivec2 new_count = new_max - new_min;
+
+        eastl::vector<std::uint32_t> cells(static_cast<size_t>(new_count.x) * new_count.y, 0);
+        for (int y = 0; y < grid.chunkCount.y; y++) {
+            for (int x = 0; x < grid.chunkCount.x; x++) {
+                const glm::ivec2 moved = grid.chunkMin + glm::ivec2(x, y) - new_min;
+                cells[(static_cast<size_t>(moved.y) * new_count.x) + moved.x] =
+                    grid.cells[(static_cast<size_t>(y) * grid.chunkCount.x) + x];
+            }
+        }
+        grid.cells = std::move(cells);
+        grid.chunkMin = new_min;
+        grid.chunkCount = new_count;
+    }
+
+    const glm::ivec2 local = chunk - grid.chunkMin;
+    auto& cell = grid.cells[(static_cast<size_t>(local.y) * grid.chunkCount.x) + local.x];
+    if (cell == 0) {
+        grid.chunks.push_back(Chunk{});
+        cell = static_cast<std::uint32_t>(grid.chunks.size());
+    }
+    return grid.chunks[cell - 1][SlotOf(pos)];
+}
+
+TileIndex::Slot TileIndex::At(const Layer layer, const glm::ivec2 pos) const {
+    const Slot* slot = Find(layer, pos);
+    return slot != nullptr ? *slot : Slot{};
+}
+
+Tile TileIndex::Loaded(const Layer layer, const glm::ivec2 pos) const {
+    return At(layer, pos).tile;
+}
+
+bool TileIndex::Saved(const Layer layer, const glm::ivec2 pos) const {
+    return At(layer, pos).saved;
+}
+
+void TileIndex::SetSaved(const Layer layer, const glm::ivec2 pos, const bool saved) {
+    if (!saved && Find(layer, pos) == nullptr) {
+        return;
+    }
+    Get(layer, pos).saved = saved;
+}
+
+void TileIndex::Insert(const Tile tile, const TileCoord coord) {
+    SDL_assert(tile != TILE_INVALID);
+    SDL_assert(!Contains(tile) && "Tile already indexed");
+
+    if (tile >= tileLayer_.size()) {
+        tileLayer_.resize(static_cast<size_t>(tile) + 1, LAYER_INVALID);
+        tilePos_.resize(static_cast<size_t>(tile) + 1);
+        tileOrder_.resize(static_cast<size_t>(tile) + 1, UINT32_MAX);
+        tileSavedHash_.resize(static_cast<size_t>(tile) + 1, HASH_NONE);
+    }
+
+    auto& slot = Get(coord.layer, coord.pos);
+    SDL_assert(slot.tile == TILE_INVALID && "Position already has a tile");
+    slot.tile = tile;
+
+    auto& tiles = layers_[coord.layer].tiles;
+    tileLayer_[tile] = coord.layer;
+    tilePos_[tile] = coord.pos;
+    tileOrder_[tile] = static_cast<std::uint32_t>(tiles.size());
+    tileSavedHash_[tile] = HASH_NONE;
+    tiles.push_back(tile);
+    tileCount_++;
+}
+
+void TileIndex::Erase(const Tile tile) {
+    SDL_assert(Contains(tile));
+    const Layer layer = tileLayer_[tile];
+
+    Get(layer, tilePos_[tile]).tile = TILE_INVALID;
+
+    // Swap remove, the order of the layer tiles doesn't matter
+    auto& tiles = layers_[layer].tiles;
+    const std::uint32_t order = tileOrder_[tile];
+    tiles[order] = tiles.back();
+    tileOrder_[tiles[order]] = order;
+    tiles.pop_back();
+
+    tileLayer_[tile] = LAYER_INVALID;
+    tileOrder_[tile] = UINT32_MAX;
+    tileCount_--;
+}
+
+bool TileIndex::Contains(const Tile tile) const {
+    return tile < tileOrder_.size() && tileOrder_[tile] != UINT32_MAX;
+}
+
+TileCoord TileIndex::Coord(const Tile tile) const {
+    SDL_assert(Contains(tile) && "Tile not found");
+    return TileCoord{.layer = tileLayer_[tile], .pos = tilePos_[tile]};
+}
+
+const eastl::vector<Tile>& TileIndex::LayerTiles(const Layer layer) const {
+    SDL_assert(HasLayer(layer));
+    return layers_[layer].tiles;
+}
+
+std::uint64_t TileIndex::SavedHash(const Tile tile) const {
+    SDL_assert(Contains(tile) && "Tile not found");
+    return tileSavedHash_[tile];
+}
+
+void TileIndex::SetSavedHash(const Tile tile, const std::uint64_t hash) {
+    SDL_assert(Contains(tile) && "Tile not found");
+    tileSavedHash_[tile] = hash;
+}
+
+size_t TileIndex::Size() const {
+    return tileCount_;
+}
+
+} // namespace Midori
@@ -0,0 +1,136 @@
+#pragma once
+
+#include "tiles.h"
+#include <EASTL/array.h>
+#include <EASTL/vector.h>
+#include <cstdint>
+#include <glm/vec2.hpp>
+
+namespace Midori {
+
+// Spatial index of the canvas tiles, replacing the per layer hash maps.
+//
+// Every layer has a 2D grid of chunks covering the positions it knows about. A chunk is a fixed CHUNK_SIZE x
+// CHUNK_SIZE array of slots holding the tile loaded at that position and whether it is saved, so finding a position is
+// a few divisions and an array index, and culling a rectangle is a linear scan of its chunks.
+//
+// Per tile data is a flat table indexed by Tile (tiles are small recycled ids), with the loaded tiles of each layer
+// kept in a dense array for iteration.
+
+class TileIndex {
+public:
+    static constexpr int CHUNK_SIZE = 16;
+
+    struct Slot {
+        Tile tile = TILE_INVALID; // Loaded tile, TILE_INVALID if not loaded
+        bool saved = false;
+    };
+
+    // Layers
+    void AddLayer(Layer layer);
+    // The layer must not have any loaded tile
+    void EraseLayer(Layer layer);
+    [[nodiscard]] bool HasLayer(Layer layer) const;
+    // Copy the saved positions of `src` to `dst`, loaded tiles are not copied
+    void CopySaved(Layer src, Layer dst);
+
+    // Positions
+    [[nodiscard]] Slot At(Layer layer, glm::ivec2 pos) const;
+    [[nodiscard]] Tile Loaded(Layer layer, glm::ivec2 pos) const;
+    [[nodiscard]] bool Saved(Layer layer, glm::ivec2 pos) const;
+    void SetSaved(Layer layer, glm::ivec2 pos, bool saved);
+
+    // Calls fn(glm::ivec2 pos, const Slot& slot) for every slot of the layer in [min, max), chunk by chunk. Positions
+    // the layer never knew about are skipped.
+    template <typename F> void ForEachSlot(Layer layer, glm::ivec2 min, glm::ivec2 max, F&& fn) const;
+
+    // Tiles
+    void Insert(Tile tile, TileCoord coord);
+    void Erase(Tile tile);
+    [[nodiscard]] bool Contains(Tile tile) const;
+    [[nodiscard]] TileCoord Coord(Tile tile) const;
+    [[nodiscard]] const eastl::vector<Tile>& LayerTiles(Layer layer) const;
+    // TileReduce hash of what the pack holds for the loaded tile, HASH_NONE until it is saved once. A tile whose hash
+    // didn't change doesn't need to be saved again.
+    static constexpr std::uint64_t HASH_NONE = 0;
+    [[nodiscard]] std::uint64_t SavedHash(Tile tile) const;
+    void SetSavedHash(Tile tile, std::uint64_t hash);
+    // Number of loaded tiles
+    [[nodiscard]] size_t Size() const;
+
+private:
+    using Chunk = eastl::array<Slot, CHUNK_SIZE * CHUNK_SIZE>;
+
+    struct LayerGrid {
+        bool used = false;
+        glm::ivec2 chunkMin = glm::ivec2(0);
+        glm::ivec2 chunkCount = glm::ivec2(0);
+        eastl::vector<std::uint32_t> cells; // Index of the chunk + 1, 0 when the chunk doesn't exist
+        eastl::vector<Chunk> chunks;
+        eastl::vector<Tile> tiles;
+    };
+
+    static glm::ivec2 ChunkOf(glm::ivec2 pos);
+    static size_t SlotOf(glm::ivec2 pos);
+
+    [[nodiscard]] const Slot* Find(Layer layer, glm::ivec2 pos) const;
+    Slot& Get(Layer layer, glm::ivec2 pos);
+
+    eastl::vector<LayerGrid> layers_; // Indexed by Layer
+
+    // Indexed by Tile
+    eastl::vector<Layer> tileLayer_;
+    eastl::vector<glm::ivec2> tilePos_;
+    eastl::vector<std::uint32_t> tileOrder_; // Position in LayerGrid::tiles, UINT32_MAX when not loaded
+    eastl::vector<std::uint64_t> tileSavedHash_;
+    size_t tileCount_ = 0;
+};
+
+inline glm::ivec2 TileIndex::ChunkOf(const glm::ivec2 pos) {
+    // Floor division, negative positions belong to negative chunks
+    return {pos.x >= 0 ? pos.x / CHUNK_SIZE : ((pos.x + 1) / CHUNK_SIZE) - 1,
+            pos.y >= 0 ? pos.y / CHUNK_SIZE : ((pos.y + 1) / CHUNK_SIZE) - 1};
+}
+
+inline size_t TileIndex::SlotOf(const glm::ivec2 pos) {
+    const glm::ivec2 local = pos - (ChunkOf(pos) * CHUNK_SIZE);
+    return (static_cast<size_t>(local.y) * CHUNK_SIZE) + static_cast<size_t>(local.x);
+}
+
+template <typename F> void TileIndex::ForEachSlot(const Layer layer, glm::ivec2 min, glm::ivec2 max, F&& fn) const {
+    if (layer >= layers_.size() || !layers_[layer].used) {
+        return;
+    }
+    const auto& grid = layers_[layer];
+
+    // Clamp to the chunks the layer has
+    min = glm::max(min, grid.chunkMin * CHUNK_SIZE);
+    max = glm::min(max, (grid.chunkMin + grid.chunkCount) * CHUNK_SIZE);
+    if (min.x >= max.x || min.y >= max.y) {
+        return;
+    }
+
+    const glm::ivec2 chunk_min = ChunkOf(min);
+    const glm::ivec2 chunk_max = ChunkOf(max - 1);
+    for (int cy = chunk_min.y; cy <= chunk_max.y; cy++) {
+        for (int cx = chunk_min.x; cx <= chunk_max.x; cx++) {
+            const size_t cell = (static_cast<size_t>(cy - grid.chunkMin.y) * grid.chunkCount.x) +
+                                static_cast<size_t>(cx - grid.chunkMin.x);
+            if (grid.cells[cell] == 0) {
+                continue;
+            }
+            const Chunk& chunk = grid.chunks[grid.cells[cell] - 1];
+
+            const glm::ivec2 origin = glm::ivec2(cx, cy) * CHUNK_SIZE;
+            const glm::ivec2 from = glm::max(min, origin) - origin;
+            const glm::ivec2 to = glm::min(max, origin + CHUNK_SIZE) - origin;
+            for (int y = from.y; y < to.y; y++) {
+                for (int x = from.x; x < to.x; x++) {
+                    fn(origin + glm::ivec2(x, y), chunk[(y * CHUNK_SIZE) + x]);
+                }
+            }
+        }
+    }
+}
+
+} // namespace Midori
@@ -0,0 +1,71 @@
+#include "tile_instances.h"
+
+#include <SDL3/SDL_assert.h>
+#include <tracy/Tracy.hpp>
+
+namespace Midori {
+
+void TileInstanceBatch::Begin(const size_t page_count) {
+    SDL_assert(layer_ == LAYER_INVALID && "Layer not ended");
+    instances_.clear();
+    draws_.clear();
+    page_counts_.assign(page_count, 0);
+}
+
+void TileInstanceBatch::BeginLayer(const Layer layer) {
+    SDL_assert(layer != LAYER_INVALID);
+    SDL_assert(layer_ == LAYER_INVALID && "Layer not ended");
+    layer_ = layer;
+    pending_.clear();
+}
+
+void TileInstanceBatch::Add(const std::uint16_t page, const std::uint16_t slice, const glm::ivec2 pos) {
+    SDL_assert(layer_ != LAYER_INVALID && "No layer begun");
+    SDL_assert(page < page_counts_.size());
+    pending_.push_back(Pending{
+        .page = page,
+        .instance = TileInstance{.position = glm::vec2(pos), .slice = slice, .pad0 = 0},
+    });
+    page_counts_[page]++;
+}
+
+void TileInstanceBatch::EndLayer() {
+    ZoneScoped;
+    SDL_assert(layer_ != LAYER_INVALID && "No layer begun");
+
+    // Counting sort by page, each page with tiles becomes a draw and its counter the next write position
+    auto offset = static_cast<std::uint32_t>(instances_.size());
+    for (size_t page = 0; page < page_counts_.size(); page++) {
+        const std::uint32_t count = page_counts_[page];
+        if (count == 0) {
+            continue;
+        }
+        draws_.push_back(TileDraw{
+            .layer = layer_,
+            .page = static_cast<std::uint16_t>(page),
+            .instance_offset = offset,
+            .instance_count = count,
+        });
+        page_counts_[page] = offset;
+        offset += count;
+    }
+
+    instances_.resize(offset);
+    for (const auto& pending : pending_) {
+        instances_[page_counts_[pending.page]++] = pending.instance;
+    }
+
+    page_counts_.assign(page_counts_.size(), 0);
+    pending_.clear();
+    layer_ = LAYER_INVALID;
+}
+
+const eastl::vector<TileInstance>& TileInstanceBatch::Instances() const {
+    return instances_;
+}
+
+const eastl::vector<TileDraw>& TileInstanceBatch::Draws() const {
+    return draws_;
+}
+
+} // namespace Midori
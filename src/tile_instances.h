@@ -0,0 +1,53 @@
+#pragma once
+
+#include "layers.h"
+#include "tiles.h"
+#include <EASTL/vector.h>
+#include <cstddef>
+#include <cstdint>
+#include <glm/vec2.hpp>
+
+namespace Midori {
+
+// Per tile data read by tile.vert, matches TileInstance in the shader (std430)
+struct TileInstance {
+    glm::vec2 position;
+    std::uint32_t slice;
+    std::uint32_t pad0;
+};
+
+// An instanced draw of the tiles of a layer sharing a page
+struct TileDraw {
+    Layer layer;
+    std::uint16_t page;
+    std::uint32_t instance_offset;
+    std::uint32_t instance_count;
+};
+
+// Gathers the tile instances of a frame, they are uploaded at once and every layer draws its range of them with one
+// call per page it has tiles in. The tiles of a layer can be added in any order, they are sorted by page when the layer
+// ends. Doesn't touch the GPU, the draws of a frame can be counted without one.
+class TileInstanceBatch {
+public:
+    void Begin(size_t page_count);
+    void BeginLayer(Layer layer);
+    void Add(std::uint16_t page, std::uint16_t slice, glm::ivec2 pos);
+    void EndLayer();
+
+    [[nodiscard]] const eastl::vector<TileInstance>& Instances() const;
+    [[nodiscard]] const eastl::vector<TileDraw>& Draws() const;
+
+private:
+    struct Pending {
+        std::uint16_t page;
+        TileInstance instance;
+    };
+
+    eastl::vector<TileInstance> instances_;
+    eastl::vector<TileDraw> draws_;
+    eastl::vector<Pending> pending_;
+    eastl::vector<std::uint32_t> page_counts_;
+    Layer layer_ = LAYER_INVALID;
+};
+
+} // namespace Midori
@@ -0,0 +1,62 @@
+#include "tile_io.h"
+
+#include "tile_codec.h"
+#include <SDL3/SDL_assert.h>
+#include <SDL3/SDL_iostream.h>
+#include <SDL3/SDL_log.h>
+#include <cstring>
+#include <tracy/Tracy.hpp>
+// The renderer still uses the reference codec for brushes
+#define QOI_IMPLEMENTATION
+#define QOI_NO_STDIO
+#include <qoi.h>
+
+namespace Midori {
+
+bool ReadTileFile(const std::string& path, eastl::vector<std::uint8_t>& encoded) {
+    ZoneScoped;
+
+    SDL_IOStream* file_io = SDL_IOFromFile(path.c_str(), "rb");
+    if (file_io == nullptr) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to open tile %s: %s", path.c_str(), SDL_GetError());
+        return false;
+    }
+
+    // Read straight into the destination instead of going through SDL_LoadFile and copying
+    const Sint64 size = SDL_GetIOSize(file_io);
+    if (size <= 0) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Tile %s is empty", path.c_str());
+        SDL_CloseIO(file_io);
+        return false;
+    }
+
+    encoded.resize(static_cast<size_t>(size));
+    const size_t read = SDL_ReadIO(file_io, encoded.data(), encoded.size());
+    SDL_CloseIO(file_io);
+    if (read != encoded.size()) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to read tile %s: %s", path.c_str(), SDL_GetError());
+        encoded.clear();
+        return false;
+    }
+
+    return true;
+}
+
+bool DecodeTile(const eastl::vector<std::uint8_t>& encoded, eastl::vector<std::uint8_t>& pixels) {
+    ZoneScoped;
+
+    pixels.resize(TILE_PIXELS_SIZE);
+    return DecodeTileQoi(encoded.data(), encoded.size(), pixels.data());
+}
+
+bool EncodeTile(const eastl::vector<std::uint8_t>& pixels, eastl::vector<std::uint8_t>& encoded) {
+    ZoneScoped;
+    SDL_assert(pixels.size() == TILE_PIXELS_SIZE);
+
+    encoded.resize(TILE_QOI_MAX_SIZE);
+    encoded.resize(EncodeTileQoi(pixels.data(), encoded.data()));
+
+    return true;
+}
+
+} // namespace Midori
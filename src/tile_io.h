@@ -0,0 +1,15 @@
+#pragma once
+
+#include <EASTL/vector.h>
+#include <cstdint>
+#include <string>
+
+namespace Midori {
+
+// Blocking tile file helpers, they don't touch any shared state and are safe to call from the job threads.
+
+bool ReadTileFile(const std::string& path, eastl::vector<std::uint8_t>& encoded);
+bool DecodeTile(const eastl::vector<std::uint8_t>& encoded, eastl::vector<std::uint8_t>& pixels);
+bool EncodeTile(const eastl::vector<std::uint8_t>& pixels, eastl::vector<std::uint8_t>& encoded);
+
+} // namespace Midori
@@ -0,0 +1,631 @@
+#include "tile_pack.h"
+
+#include "tile_io.h"
+#include <SDL3/SDL_assert.h>
+#include <SDL3/SDL_filesystem.h>
+#include <SDL3/SDL_log.h>
+#include <SDL3/SDL_timer.h>
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <format>
+#include <tracy/Tracy.hpp>
+
+namespace Midori {
+
+// Slicing-by-8 tables, every tile read is checksummed so this has to keep up with the decoder
+static constexpr auto CRC32_TABLES = [] {
+    std::array<std::array<std::uint32_t, 256>, 8> tables{};
+    for (std::uint32_t i = 0; i < 256; i++) {
+        std::uint32_t c = i;
+        for (int k = 0; k < 8; k++) {
+            c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        }
+        tables[0][i] = c;
+    }
+    for (std::uint32_t i = 0; i < 256; i++) {
+        for (size_t t = 1; t < tables.size(); t++) {
+            tables[t][i] = (tables[t - 1][i] >> 8) ^ tables[0][tables[t - 1][i] & 0xFF];
+        }
+    }
+    return tables;
+}();
+
+static bool TileCoordLess(const TileCoord& a, const TileCoord& b) {
+    if (a.layer != b.layer) {
+        return a.layer < b.layer;
+    }
+    if (a.pos.x != b.pos.x) {
+        return a.pos.x < b.pos.x;
+    }
+    return a.pos.y < b.pos.y;
+}
+
+std::uint32_t TilePack::Checksum(const std::uint8_t* data, const size_t size) {
+    ZoneScoped;
+    const auto& t = CRC32_TABLES;
+    std::uint32_t crc = 0xFFFFFFFFu;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        const std::uint32_t lo = crc ^ (std::uint32_t(data[i]) | std::uint32_t(data[i + 1]) << 8 |
+                                        std::uint32_t(data[i + 2]) << 16 | std::uint32_t(data[i + 3]) << 24);
+        crc = t[7][lo & 0xFF] ^ t[6][(lo >> 8) & 0xFF] ^ t[5][(lo >> 16) & 0xFF] ^ t[4][lo >> 24] ^
+              t[3][data[i + 4]] ^ t[2][data[i + 5]] ^ t[1][data[i + 6]] ^ t[0][data[i + 7]];
+    }
+    for (; i < size; i++) {
+        crc = t[0][(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+TilePack::~TilePack() {
+    Close();
+}
+
+bool TilePack::Open(const std::string& path) {
+    ZoneScoped;
+    std::scoped_lock lock(mutex_);
+    SDL_assert(file_ == nullptr && "Pack already opened");
+
+    path_ = path;
+    blobs_.clear();
+    cache_.Clear();
+    liveBytes_ = 0;
+    dirty_ = false;
+    compactFailed_ = false;
+    mapping_.reset();
+
+    SDL_PathInfo info;
+    if (!SDL_GetPathInfo(path.c_str(), &info)) {
+        file_ = SDL_IOFromFile(path.c_str(), "w+b");
+        if (file_ == nullptr) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create %s: %s", path.c_str(), SDL_GetError());
+            return false;
+        }
+
+        dataEnd_ = sizeof(TilePackHeader);
+        std::uint64_t end = dataEnd_;
+        if (!WriteIndex(file_, end, blobs_)) {
+            return false;
+        }
+        dataEnd_ = end;
+        return true;
+    }
+
+    mapping_ = MappedFile::Open(path);
+    if (!mapping_ || mapping_->Size() < sizeof(TilePackHeader)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s is not a tile pack", path.c_str());
+        return false;
+    }
+
+    TilePackHeader header;
+    std::memcpy(&header, mapping_->Data(), sizeof(header));
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version == 0 || header.version > VERSION ||
+        header.entry_size != sizeof(TilePackIndexEntry)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s is not a supported tile pack", path.c_str());
+        return false;
+    }
+    if (header.index_offset + (header.index_count * sizeof(TilePackIndexEntry)) > mapping_->Size()) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s index is truncated", path.c_str());
+        return false;
+    }
+
+    blobs_.reserve(header.index_count);
+    for (std::uint64_t i = 0; i < header.index_count; i++) {
+        // Blobs have any size so the index is not necessarily aligned
+        TilePackIndexEntry entry;
+        std::memcpy(&entry, mapping_->Data() + header.index_offset + (i * sizeof(TilePackIndexEntry)), sizeof(entry));
+        if (entry.offset + entry.size > header.data_end) {
+            SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Tile %d_%d of layer %d is out of bound", entry.x, entry.y,
+                        entry.layer);
+            continue;
+        }
+
+        blobs_[TileCoord{.layer = entry.layer, .pos = {entry.x, entry.y}}] = Blob{
+            .offset = entry.offset,
+            .size = entry.size,
+            .checksum = entry.checksum,
+            .color = entry.color,
+        };
+        liveBytes_ += entry.size;
+    }
+
+    // Anything written after the header's data_end comes from a session that never flushed, it is left as garbage
+    // instead of being overwritten
+    dataEnd_ = mapping_->Size();
+
+    file_ = SDL_IOFromFile(path.c_str(), "r+b");
+    if (file_ == nullptr) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to open %s: %s", path.c_str(), SDL_GetError());
+        return false;
+    }
+
+    return true;
+}
+
+void TilePack::Close() {
+    std::scoped_lock lock(mutex_);
+    cache_.Clear();
+    if (file_ != nullptr) {
+        SDL_CloseIO(file_);
+        file_ = nullptr;
+    }
+    mapping_.reset();
+    retiredMappings_.clear();
+}
+
+bool TilePack::Contains(const TileCoord coord) const {
+    std::scoped_lock lock(mutex_);
+    return blobs_.contains(coord);
+}
+
+eastl::vector<TileCoord> TilePack::Tiles() const {
+    ZoneScoped;
+    std::scoped_lock lock(mutex_);
+
+    eastl::vector<TileCoord> tiles;
+    tiles.reserve(blobs_.size());
+    for (const auto& [coord, blob] : blobs_) {
+        tiles.push_back(coord);
+    }
+    return tiles;
+}
+
+std::shared_ptr<MappedFile> TilePack::MappingCovering(const std::uint64_t end) {
+    if (!mapping_ || mapping_->Size() < end) {
+        ZoneScopedN("Remapping tile pack");
+        if (mapping_) {
+            retiredMappings_.erase(std::remove_if(retiredMappings_.begin(), retiredMappings_.end(),
+                                                  [](const auto& mapping) { return mapping.expired(); }),
+                                   retiredMappings_.end());
+            retiredMappings_.emplace_back(mapping_);
+        }
+        mapping_ = MappedFile::Open(path_);
+    }
+    if (!mapping_ || mapping_->Size() < end) {
+        return nullptr;
+    }
+    return mapping_;
+}
+
+bool TilePack::ReleaseMappings() {
+    if (mapping_) {
+        retiredMappings_.emplace_back(mapping_);
+        mapping_.reset();
+    }
+    retiredMappings_.erase(std::remove_if(retiredMappings_.begin(), retiredMappings_.end(),
+                                          [](const auto& mapping) { return mapping.expired(); }),
+                           retiredMappings_.end());
+    return retiredMappings_.empty();
+}
+
+std::uint64_t TilePack::Garbage() const {
+    // Blobs shared between layers are counted once per tile, so the live size can go above the real one
+    const std::uint64_t used = sizeof(TilePackHeader) + liveBytes_;
+    return dataEnd_ > used ? dataEnd_ - used : 0;
+}
+
+bool TilePack::View(const TileCoord coord, BlobView& view) {
+    ZoneScoped;
+
+    Blob blob;
+    std::shared_ptr<MappedFile> mapping;
+    {
+        std::scoped_lock lock(mutex_);
+        const auto it = blobs_.find(coord);
+        if (it == blobs_.end()) {
+            return false;
+        }
+        blob = it->second;
+        if (blob.Solid()) {
+            return false;
+        }
+
+        // Cached blobs were verified when they were read or written
+        if (auto cached = cache_.Find(blob.offset)) {
+            view.data = cached->data();
+            view.size = cached->size();
+            view.owner = std::move(cached);
+            return true;
+        }
+        mapping = MappingCovering(blob.offset + blob.size);
+    }
+    if (!mapping) {
+        return false;
+    }
+
+    view.data = mapping->Data() + blob.offset;
+    view.size = blob.size;
+    view.owner = std::move(mapping);
+    if (Checksum(view.data, view.size) != blob.checksum) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Tile %d_%d of layer %d is corrupted", coord.pos.x, coord.pos.y,
+                     coord.layer);
+        view = {};
+        return false;
+    }
+
+    // Unless a compaction moved the blob meanwhile, its offset could now be another blob
+    std::scoped_lock lock(mutex_);
+    const auto it = blobs_.find(coord);
+    if (it != blobs_.end() && it->second.offset == blob.offset && it->second.checksum == blob.checksum) {
+        cache_.Insert(blob.offset, view.data, view.size);
+    }
+
+    return true;
+}
+
+bool TilePack::Read(const TileCoord coord, eastl::vector<std::uint8_t>& encoded) {
+    ZoneScoped;
+
+    BlobView view;
+    if (!View(coord, view)) {
+        return false;
+    }
+    encoded.assign(view.data, view.data + view.size);
+    return true;
+}
+
+bool TilePack::Write(const TileCoord coord, const std::uint8_t* data, const size_t size) {
+    ZoneScoped;
+    SDL_assert(data != nullptr && size > 0);
+
+    const std::uint32_t checksum = Checksum(data, size);
+
+    std::scoped_lock lock(mutex_);
+    if (file_ == nullptr) {
+        return false;
+    }
+
+    if (SDL_SeekIO(file_, static_cast<Sint64>(dataEnd_), SDL_IO_SEEK_SET) < 0 ||
+        SDL_WriteIO(file_, data, size) != size || !SDL_FlushIO(file_)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to write tile in %s: %s", path_.c_str(), SDL_GetError());
+        return false;
+    }
+
+    auto& blob = blobs_[coord];
+    liveBytes_ -= blob.size;
+    blob = Blob{
+        .offset = dataEnd_,
+        .size = static_cast<std::uint32_t>(size),
+        .checksum = checksum,
+    };
+    liveBytes_ += blob.size;
+    dataEnd_ += size;
+    dirty_ = true;
+    cache_.Insert(blob.offset, data, size);
+
+    return true;
+}
+
+bool TilePack::Solid(const TileCoord coord, std::uint32_t& color) const {
+    std::scoped_lock lock(mutex_);
+    const auto it = blobs_.find(coord);
+    if (it == blobs_.end() || !it->second.Solid()) {
+        return false;
+    }
+    color = it->second.color;
+    return true;
+}
+
+void TilePack::WriteSolid(const TileCoord coord, const std::uint32_t color) {
+    std::scoped_lock lock(mutex_);
+    auto& blob = blobs_[coord];
+    liveBytes_ -= blob.size;
+    blob = Blob{.color = color};
+    dirty_ = true;
+}
+
+void TilePack::Erase(const TileCoord coord) {
+    std::scoped_lock lock(mutex_);
+    const auto it = blobs_.find(coord);
+    if (it == blobs_.end()) {
+        return;
+    }
+
+    liveBytes_ -= it->second.size;
+    blobs_.erase(it);
+    dirty_ = true;
+}
+
+void TilePack::EraseLayer(const Layer layer) {
+    ZoneScoped;
+    std::scoped_lock lock(mutex_);
+    for (auto it = blobs_.begin(); it != blobs_.end();) {
+        if (it->first.layer == layer) {
+            liveBytes_ -= it->second.size;
+            it = blobs_.erase(it);
+            dirty_ = true;
+        } else {
+            ++it;
+        }
+    }
+}
+
+void TilePack::CopyLayer(const Layer src, const Layer dst) {
+    ZoneScoped;
+    std::scoped_lock lock(mutex_);
+
+    eastl::vector<std::pair<TileCoord, Blob>> copies;
+    for (const auto& [coord, blob] : blobs_) {
+        if (coord.layer == src) {
+            copies.emplace_back(TileCoord{.layer = dst, .pos = coord.pos}, blob);
+        }
+    }
+    for (const auto& [coord, blob] : copies) {
+        blobs_[coord] = blob;
+        liveBytes_ += blob.size;
+        dirty_ = true;
+    }
+}
+
+bool TilePack::WriteIndex(SDL_IOStream* file, std::uint64_t& end,
+                          const eastl::unordered_map<TileCoord, Blob>& blobs) const {
+    ZoneScoped;
+
+    eastl::vector<TileCoord> coords;
+    coords.reserve(blobs.size());
+    for (const auto& [coord, blob] : blobs) {
+        coords.push_back(coord);
+    }
+    std::sort(coords.begin(), coords.end(), TileCoordLess);
+
+    eastl::vector<TilePackIndexEntry> entries;
+    entries.reserve(coords.size());
+    for (const auto& coord : coords) {
+        const auto& blob = blobs.at(coord);
+        entries.push_back(TilePackIndexEntry{
+            .layer = coord.layer,
+            .x = coord.pos.x,
+            .y = coord.pos.y,
+            .size = blob.size,
+            .offset = blob.offset,
+            .checksum = blob.checksum,
+            .color = blob.color,
+        });
+    }
+
+    TilePackHeader header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.entry_size = sizeof(TilePackIndexEntry);
+    header.index_offset = end;
+    header.index_count = entries.size();
+    header.data_end = end + (entries.size() * sizeof(TilePackIndexEntry));
+
+    // The index has to reach the disk before the header points to it
+    const size_t index_size = entries.size() * sizeof(TilePackIndexEntry);
+    if (SDL_SeekIO(file, static_cast<Sint64>(end), SDL_IO_SEEK_SET) < 0 ||
+        SDL_WriteIO(file, entries.data(), index_size) != index_size || !SDL_FlushIO(file)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to write tile pack index: %s", SDL_GetError());
+        return false;
+    }
+    if (SDL_SeekIO(file, 0, SDL_IO_SEEK_SET) < 0 || SDL_WriteIO(file, &header, sizeof(header)) != sizeof(header) ||
+        !SDL_FlushIO(file)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to write tile pack header: %s", SDL_GetError());
+        return false;
+    }
+
+    end = header.data_end;
+    return true;
+}
+
+TileBlobCache& TilePack::Cache() {
+    return cache_;
+}
+
+bool TilePack::Flush() {
+    ZoneScoped;
+    std::scoped_lock lock(mutex_);
+    if (file_ == nullptr) {
+        return false;
+    }
+    if (!dirty_) {
+        return true;
+    }
+
+    std::uint64_t end = dataEnd_;
+    if (!WriteIndex(file_, end, blobs_)) {
+        return false;
+    }
+    dataEnd_ = end;
+    dirty_ = false;
+
+    return true;
+}
+
+bool TilePack::Dirty() const {
+    std::scoped_lock lock(mutex_);
+    return dirty_;
+}
+
+bool TilePack::ShouldCompact() const {
+    std::scoped_lock lock(mutex_);
+    if (compacting_ || file_ == nullptr) {
+        return false;
+    }
+
+    const std::uint64_t garbage = Garbage();
+    if (compactFailed_ && SDL_GetTicks() - compactFailedTicks_ < COMPACT_RETRY_INTERVAL_MS &&
+        garbage < compactFailedGarbage_ + COMPACT_RETRY_GARBAGE) {
+        return false;
+    }
+    return garbage >= COMPACT_MIN_GARBAGE && garbage > liveBytes_;
+}
+
+bool TilePack::Compact() {
+    ZoneScoped;
+    if (compacting_.exchange(true)) {
+        return false;
+    }
+
+    const std::string tmp_path = std::format("{}.compact", path_);
+
+    // Copy the blobs known at the start without holding the lock, readers and writers keep going meanwhile
+    eastl::unordered_map<TileCoord, Blob> snapshot;
+    std::shared_ptr<MappedFile> mapping;
+    {
+        std::scoped_lock lock(mutex_);
+        snapshot = blobs_;
+        mapping = MappingCovering(dataEnd_);
+    }
+
+    SDL_IOStream* out = SDL_IOFromFile(tmp_path.c_str(), "w+b");
+    if (out == nullptr || !mapping) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to start compacting %s", path_.c_str());
+        if (out != nullptr) {
+            SDL_CloseIO(out);
+            SDL_RemovePath(tmp_path.c_str());
+        }
+        std::scoped_lock lock(mutex_);
+        compactFailed_ = true;
+        compactFailedTicks_ = SDL_GetTicks();
+        compactFailedGarbage_ = Garbage();
+        compacting_ = false;
+        return false;
+    }
+
+    eastl::unordered_map<TileCoord, Blob> compacted;
+    eastl::unordered_map<std::uint64_t, std::uint64_t> moved; // Shared blobs are only copied once
+    std::uint64_t end = sizeof(TilePackHeader);
+    bool ok = SDL_SeekIO(out, static_cast<Sint64>(end), SDL_IO_SEEK_SET) >= 0;
+
+    const auto copy_blob = [&](const MappedFile& from, const Blob& blob) -> bool {
+        if (blob.Solid() || moved.contains(blob.offset)) {
+            return true;
+        }
+        if (blob.offset + blob.size > from.Size() ||
+            SDL_WriteIO(out, from.Data() + blob.offset, blob.size) != blob.size) {
+            return false;
+        }
+        moved[blob.offset] = end;
+        end += blob.size;
+        return true;
+    };
+
+    {
+        ZoneScopedN("Copying blobs");
+        // Tiles of a layer end up next to each other
+        eastl::vector<TileCoord> coords;
+        coords.reserve(snapshot.size());
+        for (const auto& [coord, blob] : snapshot) {
+            coords.push_back(coord);
+        }
+        std::sort(coords.begin(), coords.end(), TileCoordLess);
+
+        for (const auto& coord : coords) {
+            ok = ok && copy_blob(*mapping, snapshot.at(coord));
+        }
+    }
+
+    {
+        ZoneScopedN("Swapping tile pack");
+        std::scoped_lock lock(mutex_);
+
+        // Pick up what was written or erased while copying
+        for (const auto& [coord, blob] : blobs_) {
+            if (!ok) {
+                break;
+            }
+            if (blob.Solid()) {
+                compacted[coord] = blob;
+                continue;
+            }
+            if (!moved.contains(blob.offset)) {
+                const auto current = MappingCovering(blob.offset + blob.size);
+                ok = current && copy_blob(*current, blob);
+            }
+            compacted[coord] = Blob{
+                .offset = moved[blob.offset],
+                .size = blob.size,
+                .checksum = blob.checksum,
+            };
+        }
+
+        ok = ok && WriteIndex(out, end, compacted);
+        SDL_CloseIO(out);
+
+        // Windows can't replace a file that is still opened or mapped, views pinning a mapping are left to finish
+        // and the compaction is tried again later
+        mapping.reset();
+        if (ok && !ReleaseMappings()) {
+            SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Tile pack %s is still being read, compaction postponed",
+                        path_.c_str());
+            ok = false;
+        }
+
+        bool replaced = false;
+        if (ok) {
+            SDL_CloseIO(file_);
+            replaced = SDL_RenamePath(tmp_path.c_str(), path_.c_str());
+            if (!replaced) {
+                SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Failed to replace %s: %s", path_.c_str(), SDL_GetError());
+            }
+
+            file_ = SDL_IOFromFile(path_.c_str(), "r+b");
+            if (file_ == nullptr) {
+                // Writes and flushes fail from now on instead of losing tiles
+                SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to reopen %s: %s", path_.c_str(), SDL_GetError());
+            }
+            ok = replaced && file_ != nullptr;
+        }
+
+        if (replaced) {
+            // Every blob moved, the cached ones are keyed by their old offset. The index has to follow the new file
+            // even if it couldn't be reopened
+            cache_.Clear();
+            blobs_ = std::move(compacted);
+            liveBytes_ = 0;
+            for (const auto& [coord, blob] : blobs_) {
+                liveBytes_ += blob.size;
+            }
+            dataEnd_ = end;
+            dirty_ = false;
+        } else {
+            SDL_RemovePath(tmp_path.c_str());
+        }
+
+        compactFailed_ = !ok;
+        if (!ok) {
+            compactFailedTicks_ = SDL_GetTicks();
+            compactFailedGarbage_ = Garbage();
+        }
+    }
+
+    compacting_ = false;
+    return ok;
+}
+
+bool TilePack::ImportLegacyLayer(const std::string& folder, const Layer layer,
+                                 eastl::vector<std::string>& imported) {
+    ZoneScoped;
+
+    int count = 0;
+    char** files = SDL_GlobDirectory(folder.c_str(), "*.qoi", 0, &count);
+    if (files == nullptr) {
+        return false;
+    }
+
+    bool ok = true;
+    for (int i = 0; i < count; i++) {
+        glm::ivec2 pos{};
+        if (std::sscanf(files[i], "%d_%d.qoi", &pos.x, &pos.y) != 2) {
+            SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Skipping unknown tile file %s", files[i]);
+            continue;
+        }
+
+        const std::string path = std::format("{}/{}", folder, files[i]);
+        eastl::vector<std::uint8_t> encoded;
+        if (!ReadTileFile(path, encoded) ||
+            !Write(TileCoord{.layer = layer, .pos = pos}, encoded.data(), encoded.size())) {
+            ok = false;
+            continue;
+        }
+        imported.push_back(path);
+    }
+    SDL_free(files);
+
+    return ok;
+}
+
+} // namespace Midori
@@ -0,0 +1,147 @@
+#pragma once
+
+#include "mapped_file.h"
+#include "tile_blob_cache.h"
+#include "tiles.h"
+#include <EASTL/unordered_map.h>
+#include <EASTL/vector.h>
+#include <SDL3/SDL_iostream.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace Midori {
+
+// Every tile of the canvas is stored in a single pack file:
+//
+//   [header][tile blobs ...][index]
+//
+// Blobs are only ever appended, a rewritten tile gets a new blob and the old one becomes garbage until the pack is
+// compacted. The index is sorted by (layer, x, y) and written after the blobs on Flush, then the header is updated to
+// point to it. Until the header is rewritten the previous index is still intact, so a crash only loses the tiles
+// written since the last flush and never corrupts the pack.
+//
+// Tiles filled with a single color are stored in the index only, as an entry without blob (size 0) holding the color.
+//
+// Reads, writes and compaction are thread safe. Reads go through a memory mapping of the pack, blobs recently read or
+// written are also kept in a TileBlobCache and read from there first.
+
+struct TilePackHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t entry_size;
+    std::uint64_t index_offset;
+    std::uint64_t index_count;
+    std::uint64_t data_end;
+    std::uint8_t _reserved[24];
+};
+static_assert(sizeof(TilePackHeader) == 64);
+
+struct TilePackIndexEntry {
+    Layer layer;
+    std::uint16_t _reserved0;
+    std::int32_t x;
+    std::int32_t y;
+    std::uint32_t size;
+    std::uint64_t offset;
+    std::uint32_t checksum; // CRC32 of the blob
+    std::uint32_t color;    // RGBA8 of a solid tile
+};
+static_assert(sizeof(TilePackIndexEntry) == 32);
+
+class TilePack {
+public:
+    static constexpr char MAGIC[8] = {'M', 'I', 'D', 'O', 'P', 'A', 'C', 'K'};
+    static constexpr std::uint32_t VERSION = 2; // 2: solid tiles
+
+    // Compaction is worth it once this much space is wasted and it is more than the live data
+    static constexpr std::uint64_t COMPACT_MIN_GARBAGE = 32ull * 1024 * 1024;
+    // After a failed compaction, it is only tried again once this much time passed or the garbage grew that much
+    static constexpr std::uint64_t COMPACT_RETRY_INTERVAL_MS = 60 * 1000;
+    static constexpr std::uint64_t COMPACT_RETRY_GARBAGE = COMPACT_MIN_GARBAGE;
+
+    struct Blob {
+        std::uint64_t offset = 0;
+        std::uint32_t size = 0;
+        std::uint32_t checksum = 0;
+        std::uint32_t color = 0; // Memory order (R, G, B, A bytes), only used by solid tiles
+
+        [[nodiscard]] bool Solid() const {
+            return size == 0;
+        }
+    };
+
+    // Zero copy access to a blob, the data stays valid as long as the view holds the mapping or the cached blob
+    struct BlobView {
+        std::shared_ptr<const void> owner;
+        const std::uint8_t* data = nullptr;
+        size_t size = 0;
+    };
+
+    TilePack(const TilePack&) = delete;
+    TilePack(TilePack&&) = delete;
+    TilePack& operator=(const TilePack&) = delete;
+    TilePack& operator=(TilePack&&) = delete;
+
+    TilePack() = default;
+    ~TilePack();
+
+    // Create the pack if it doesn't exist
+    bool Open(const std::string& path);
+    void Close();
+
+    [[nodiscard]] bool Contains(TileCoord coord) const;
+    [[nodiscard]] eastl::vector<TileCoord> Tiles() const;
+
+    // Solid tiles have no blob to view or read
+    bool View(TileCoord coord, BlobView& view);
+    bool Read(TileCoord coord, eastl::vector<std::uint8_t>& encoded);
+    bool Write(TileCoord coord, const std::uint8_t* data, size_t size);
+    [[nodiscard]] bool Solid(TileCoord coord, std::uint32_t& color) const;
+    void WriteSolid(TileCoord coord, std::uint32_t color);
+    void Erase(TileCoord coord);
+    void EraseLayer(Layer layer);
+    // Blobs are immutable so the new layer shares them with the source
+    void CopyLayer(Layer src, Layer dst);
+
+    bool Flush();
+    [[nodiscard]] bool Dirty() const;
+
+    [[nodiscard]] bool ShouldCompact() const;
+    bool Compact();
+
+    // Import the legacy <layer>/<x>_<y>.qoi files of a layer folder, the imported files are returned so they can be
+    // removed once the pack is flushed
+    bool ImportLegacyLayer(const std::string& folder, Layer layer, eastl::vector<std::string>& imported);
+
+    [[nodiscard]] static std::uint32_t Checksum(const std::uint8_t* data, size_t size);
+
+    [[nodiscard]] TileBlobCache& Cache();
+
+private:
+    [[nodiscard]] std::shared_ptr<MappedFile> MappingCovering(std::uint64_t end);
+    // Drops the mapping of the pack, false while views still hold one of its mappings
+    [[nodiscard]] bool ReleaseMappings();
+    [[nodiscard]] std::uint64_t Garbage() const;
+    [[nodiscard]] bool WriteIndex(SDL_IOStream* file, std::uint64_t& end,
+                                  const eastl::unordered_map<TileCoord, Blob>& blobs) const;
+
+    std::string path_;
+    mutable std::mutex mutex_;
+    SDL_IOStream* file_ = nullptr;
+    std::shared_ptr<MappedFile> mapping_;
+    eastl::vector<std::weak_ptr<MappedFile>> retiredMappings_; // Replaced mappings that views may still hold
+    eastl::unordered_map<TileCoord, Blob> blobs_;
+    std::uint64_t dataEnd_ = 0;
+    std::uint64_t liveBytes_ = 0;
+    bool dirty_ = false;
+    std::atomic<bool> compacting_ = false;
+    bool compactFailed_ = false;
+    std::uint64_t compactFailedTicks_ = 0;
+    std::uint64_t compactFailedGarbage_ = 0;
+    TileBlobCache cache_;
+};
+
+} // namespace Midori
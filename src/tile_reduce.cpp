@@ -0,0 +1,64 @@
+#include "tile_reduce.h"
+
+#include <cstring>
+#include <tracy/Tracy.hpp>
+
+namespace Midori {
+
+bool TileReduce::Empty() const {
+    return (flags & EMPTY) != 0;
+}
+
+bool TileReduce::Uniform() const {
+    return (flags & UNIFORM) != 0;
+}
+
+std::uint64_t TileReduce::Hash() const {
+    return (static_cast<std::uint64_t>(hash[1]) << 32) | hash[0];
+}
+
+// Finalizer of MurmurHash3
+std::uint32_t TileReduceMix(std::uint32_t h) {
+    h ^= h >> 16;
+    h *= 0x85EBCA6Bu;
+    h ^= h >> 13;
+    h *= 0xC2B2AE35u;
+    h ^= h >> 16;
+    return h;
+}
+
+std::uint32_t TileReduceHash0(const std::uint32_t pixel, const std::uint32_t index) {
+    return TileReduceMix(pixel ^ (index * 0x9E3779B9u));
+}
+
+std::uint32_t TileReduceHash1(const std::uint32_t pixel, const std::uint32_t index) {
+    return TileReduceMix(pixel + index * 0x27D4EB2Fu + 0x165667B1u);
+}
+
+TileReduce ReduceTile(const std::uint8_t* pixels) {
+    ZoneScoped;
+
+    TileReduce reduce;
+    std::memcpy(&reduce.color, pixels, 4);
+
+    std::uint32_t bits = 0;
+    bool uniform = true;
+    for (std::uint32_t i = 0; i < TILE_WIDTH * TILE_HEIGHT; i++) {
+        std::uint32_t pixel;
+        std::memcpy(&pixel, pixels + i * 4, 4);
+        bits |= pixel;
+        uniform &= pixel == reduce.color;
+        reduce.hash[0] += TileReduceHash0(pixel, i);
+        reduce.hash[1] += TileReduceHash1(pixel, i);
+    }
+
+    if ((bits & 0xFEFEFEFEu) == 0) {
+        reduce.flags |= TileReduce::EMPTY;
+    }
+    if (uniform) {
+        reduce.flags |= TileReduce::UNIFORM;
+    }
+    return reduce;
+}
+
+} // namespace Midori
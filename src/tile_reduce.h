@@ -0,0 +1,36 @@
+#pragma once
+
+#include "tiles.h"
+#include <cstdint>
+
+namespace Midori {
+
+// What shaders/reduce computes for a tile before it is saved, so empty and unchanged tiles are never downloaded.
+//
+// Laid out like the result buffer of the shader (std430, 16 bytes per tile). The pixels are read in memory order
+// (R, G, B, A bytes, row after row) and the hash only uses integer operations that wrap the same way on both sides, so
+// ReduceTile gives exactly what the GPU gives for the same tile.
+struct TileReduce {
+    static constexpr std::uint32_t EMPTY = 1 << 0;   // No channel goes above 1, like IsTileEmpty
+    static constexpr std::uint32_t UNIFORM = 1 << 1; // Every pixel is `color`, like IsTileUniform
+
+    std::uint32_t flags = 0;
+    std::uint32_t color = 0; // The first pixel
+    std::uint32_t hash[2] = {};
+
+    [[nodiscard]] bool Empty() const;
+    [[nodiscard]] bool Uniform() const;
+    [[nodiscard]] std::uint64_t Hash() const;
+};
+static_assert(sizeof(TileReduce) == 16);
+
+// Each pixel is mixed with its index and the two lanes sum the mixes. Sums don't depend on the order, the threads of
+// the shader can add their part in any order.
+[[nodiscard]] std::uint32_t TileReduceMix(std::uint32_t h);
+[[nodiscard]] std::uint32_t TileReduceHash0(std::uint32_t pixel, std::uint32_t index);
+[[nodiscard]] std::uint32_t TileReduceHash1(std::uint32_t pixel, std::uint32_t index);
+
+// CPU reference of the shader, `pixels` is TILE_WIDTH x TILE_HEIGHT RGBA8
+[[nodiscard]] TileReduce ReduceTile(const std::uint8_t* pixels);
+
+} // namespace Midori
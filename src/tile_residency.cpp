@@ -0,0 +1,123 @@
+#include "tile_residency.h"
+
+#include <SDL3/SDL_assert.h>
+
+namespace Midori {
+
+void TileResidency::SetBudget(const size_t megabytes) {
+    budget_ = megabytes;
+}
+
+size_t TileResidency::Budget() const {
+    return budget_;
+}
+
+void TileResidency::SetPageSlack(const size_t bytes) {
+    pageSlack_ = bytes;
+}
+
+void TileResidency::Ensure(const Tile tile) {
+    SDL_assert(tile != TILE_INVALID);
+    if (tile >= state_.size()) {
+        state_.resize(static_cast<size_t>(tile) + 1, State::None);
+        prev_.resize(static_cast<size_t>(tile) + 1, TILE_INVALID);
+        next_.resize(static_cast<size_t>(tile) + 1, TILE_INVALID);
+    }
+}
+
+void TileResidency::Unlink(const Tile tile) {
+    SDL_assert(state_[tile] == State::Cold);
+    if (prev_[tile] != TILE_INVALID) {
+        next_[prev_[tile]] = next_[tile];
+    } else {
+        head_ = next_[tile];
+    }
+    if (next_[tile] != TILE_INVALID) {
+        prev_[next_[tile]] = prev_[tile];
+    } else {
+        tail_ = prev_[tile];
+    }
+    prev_[tile] = TILE_INVALID;
+    next_[tile] = TILE_INVALID;
+    cold_--;
+}
+
+void TileResidency::Add(const Tile tile) {
+    Ensure(tile);
+    SDL_assert(state_[tile] == State::None && "Tile already resident");
+    state_[tile] = State::Hot;
+    resident_++;
+}
+
+bool TileResidency::Use(const Tile tile) {
+    Ensure(tile);
+    if (state_[tile] == State::Evicting) {
+        state_[tile] = State::Hot;
+        resident_++;
+        stats.hits++;
+        return true;
+    }
+    if (state_[tile] != State::Cold) {
+        return false;
+    }
+    Unlink(tile);
+    state_[tile] = State::Hot;
+    stats.hits++;
+    return false;
+}
+
+void TileResidency::Release(const Tile tile) {
+    Ensure(tile);
+    if (state_[tile] == State::Cold) {
+        Unlink(tile);
+    } else if (state_[tile] != State::Hot) {
+        return;
+    }
+
+    state_[tile] = State::Cold;
+    prev_[tile] = tail_;
+    if (tail_ != TILE_INVALID) {
+        next_[tail_] = tile;
+    } else {
+        head_ = tile;
+    }
+    tail_ = tile;
+    cold_++;
+}
+
+void TileResidency::Remove(const Tile tile) {
+    Ensure(tile);
+    if (state_[tile] == State::Cold) {
+        Unlink(tile);
+    }
+    if (state_[tile] == State::Hot || state_[tile] == State::Cold) {
+        resident_--;
+    }
+    state_[tile] = State::None;
+}
+
+Tile TileResidency::Evict() {
+    if (head_ == TILE_INVALID || (resident_ * TILE_TEXTURE_SIZE) + pageSlack_ <= budget_ * 1024 * 1024) {
+        return TILE_INVALID;
+    }
+
+    const Tile tile = head_;
+    Unlink(tile);
+    state_[tile] = State::Evicting;
+    resident_--;
+    return tile;
+}
+
+bool TileResidency::Cold(const Tile tile) const {
+    return tile < state_.size() && state_[tile] == State::Cold;
+}
+
+size_t TileResidency::Resident() const {
+    return resident_;
+}
+
+size_t TileResidency::ColdCount() const {
+    return cold_;
+}
+
+} // namespace Midori
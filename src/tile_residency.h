@@ -0,0 +1,78 @@
+#pragma once
+
+#include "tiles.h"
+#include <EASTL/vector.h>
+#include <cstddef>
+#include <cstdint>
+
+namespace Midori {
+
+// Keeps track of which loaded tiles are in use and which ones can be evicted.
+//
+// Tiles in the resident area of the view are hot, tiles outside of it are cold and stay loaded in least recently
+// released order until the GPU memory they use goes over the budget. Only cold tiles are evicted, a cold tile coming
+// back into the view is a hit and doesn't have to be read again.
+
+class TileResidency {
+public:
+    static constexpr size_t TILE_TEXTURE_SIZE = TILE_WIDTH * TILE_HEIGHT * 4;
+    static constexpr size_t DEFAULT_BUDGET_MB = 512;
+
+    struct Stats {
+        std::uint64_t hits = 0;           // Cold tiles used again
+        std::uint64_t misses = 0;         // Tiles that had to be read
+        std::uint64_t evictions = 0;      // Clean tiles released without a download
+        std::uint64_t evictionsDirty = 0; // Modified tiles saved before being released
+    };
+
+    void SetBudget(size_t megabytes);
+    [[nodiscard]] size_t Budget() const; // In MB
+    // GPU memory of the tile pages that no tile uses (see TileAtlas::FreeSlices), it counts against the budget too
+    void SetPageSlack(size_t bytes);
+
+    // A tile was loaded and is in use
+    void Add(Tile tile);
+    // The tile is in use again, counts a hit if it was cold or being evicted. Returns true if it was being evicted, the
+    // caller keeps it loaded and it counts against the budget again.
+    bool Use(Tile tile);
+    // The tile is not in use anymore, it becomes the most recently released cold tile
+    void Release(Tile tile);
+    // The tile was unloaded
+    void Remove(Tile tile);
+
+    // Takes the least recently released tile if the resident tiles go over the budget, TILE_INVALID otherwise. The
+    // tile doesn't count against the budget anymore, it is up to the caller to unload it and Remove it.
+    [[nodiscard]] Tile Evict();
+
+    [[nodiscard]] bool Cold(Tile tile) const;
+    [[nodiscard]] size_t Resident() const;
+    [[nodiscard]] size_t ColdCount() const;
+
+    Stats stats;
+
+private:
+    enum class State : std::uint8_t {
+        None,
+        Hot,
+        Cold,
+        Evicting,
+    };
+
+    void Ensure(Tile tile);
+    void Unlink(Tile tile);
+
+    size_t budget_ = DEFAULT_BUDGET_MB;
+    size_t pageSlack_ = 0;
+    size_t resident_ = 0;
+    size_t cold_ = 0;
+
+    // Indexed by Tile, the cold tiles form a doubly linked list from the least (head) to the most (tail) recently
+    // released
+    eastl::vector<State> state_;
+    eastl::vector<Tile> prev_;
+    eastl::vector<Tile> next_;
+    Tile head_ = TILE_INVALID;
+    Tile tail_ = TILE_INVALID;
+};
+
+} // namespace Midori
@@ -2,6 +2,10 @@
 
 #include "app.h"
 #include "commands.h"
+#include <algorithm>
+#include <cmath>
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
 #include <imgui.h>
 #include <numbers>
 #include <tracy/Tracy.hpp>
@@ -110,6 +114,7 @@ void Viewport::ComputeViewMatrix() {
     viewMatInv_ = glm::inverse(viewMat_);
 
     viewComputed_ = true;
+    visibleTilesDirty_ = true;
 }
 
 glm::mat4 Viewport::ViewMatrix() const {
@@ -149,11 +154,7 @@ bool Viewport::IsTileVisible(glm::ivec2 tilePos) const {
            (tMin.y <= (viewSize_.y / 2.0f) && tMax.y >= (-viewSize_.y / 2.0f));
 }
 
-std::vector<glm::ivec2> Viewport::VisibleTiles() const {
-    SDL_assert(viewComputed_);
-    constexpr glm::vec2 tSize(TILE_WIDTH, TILE_HEIGHT);
-
-    // Broad pass (AABB in canvas Space)
+void Viewport::ViewBounds(glm::vec2& min, glm::vec2& max) const {
     const glm::vec2 vCorners[4] = {
         glm::vec2(viewMatInv_ * glm::vec4(viewSize_ * glm::vec2(-0.5f, -0.5f), 0.0f, 1.0f)),
         glm::vec2(viewMatInv_ * glm::vec4(viewSize_ * glm::vec2(0.5f, -0.5f), 0.0f, 1.0f)),
@@ -161,11 +162,21 @@ std::vector<glm::ivec2> Viewport::VisibleTiles() const {
         glm::vec2(viewMatInv_ * glm::vec4(viewSize_ * glm::vec2(0.5f, 0.5f), 0.0f, 1.0f)),
     };
 
-    glm::vec2 vAabbMin{vCorners[0]}, vAabbMax{vCorners[0]};
+    min = vCorners[0];
+    max = vCorners[0];
     for (int i = 1; i < 4; ++i) {
-        vAabbMin = glm::min(vAabbMin, vCorners[i]);
-        vAabbMax = glm::max(vAabbMax, vCorners[i]);
+        min = glm::min(min, vCorners[i]);
+        max = glm::max(max, vCorners[i]);
     }
+}
+
+std::vector<glm::ivec2> Viewport::VisibleTiles() const {
+    SDL_assert(viewComputed_);
+    constexpr glm::vec2 tSize(TILE_WIDTH, TILE_HEIGHT);
+
+    // Broad pass (AABB in canvas Space)
+    glm::vec2 vAabbMin, vAabbMax;
+    ViewBounds(vAabbMin, vAabbMax);
 
     vAabbMin = glm::floor(vAabbMin / tSize);
     vAabbMax = glm::ceil(vAabbMax / tSize);
@@ -185,6 +196,86 @@ std::vector<glm::ivec2> Viewport::VisibleTiles() const {
     return tPositions;
 }
 
+bool Viewport::UpdateResidentTiles(std::vector<glm::ivec2>& entered, std::vector<glm::ivec2>& left) {
+    ZoneScoped;
+    SDL_assert(viewComputed_);
+    constexpr glm::vec2 tSize(TILE_WIDTH, TILE_HEIGHT);
+    entered.clear();
+    left.clear();
+
+    glm::vec2 vAabbMin, vAabbMax;
+    ViewBounds(vAabbMin, vAabbMax);
+    const glm::vec2 center = (vAabbMin + vAabbMax) / 2.0f;
+
+    // Track the motion of the view, whatever moved it (navigation, undo, reset, resize)
+    if (motionTracked_) {
+        velocity_ = glm::mix(velocity_, center - lastCenter_, 0.5f);
+        zoomVelocity_ = glm::mix(zoomVelocity_, zoom_.x / lastZoom_, 0.5f);
+    }
+    lastCenter_ = center;
+    lastZoom_ = zoom_.x;
+    motionTracked_ = true;
+
+    // Where the view is heading in PREFETCH_LOOKAHEAD frames, zooming in never shrinks the area
+    const glm::vec2 maxExtension = tSize * static_cast<float>(PREFETCH_MAX_EXTENSION);
+    const glm::vec2 offset = glm::clamp(velocity_ * PREFETCH_LOOKAHEAD, -maxExtension, maxExtension);
+    const float growth = std::min(std::pow(1.0f / std::min(zoomVelocity_, 1.0f), PREFETCH_LOOKAHEAD), 2.0f);
+    const glm::vec2 halfSize = (vAabbMax - vAabbMin) * growth / 2.0f;
+    const glm::vec2 aheadMin = center + offset - halfSize;
+    const glm::vec2 aheadMax = center + offset + halfSize;
+
+    const glm::ivec2 newMin = glm::ivec2(glm::floor(glm::min(vAabbMin, aheadMin) / tSize)) - PREFETCH_MARGIN;
+    const glm::ivec2 newMax = glm::ivec2(glm::ceil(glm::max(vAabbMax, aheadMax) / tSize)) + PREFETCH_MARGIN;
+    if (newMin == residentMin_ && newMax == residentMax_) {
+        return false;
+    }
+
+    const auto inside = [](const glm::ivec2 pos, const glm::ivec2 min, const glm::ivec2 max) {
+        return pos.x >= min.x && pos.y >= min.y && pos.x < max.x && pos.y < max.y;
+    };
+    for (int y = newMin.y; y < newMax.y; y++) {
+        for (int x = newMin.x; x < newMax.x; x++) {
+            if (!inside(glm::ivec2(x, y), residentMin_, residentMax_)) {
+                entered.emplace_back(x, y);
+            }
+        }
+    }
+    for (int y = residentMin_.y; y < residentMax_.y; y++) {
+        for (int x = residentMin_.x; x < residentMax_.x; x++) {
+            if (!inside(glm::ivec2(x, y), newMin, newMax)) {
+                left.emplace_back(x, y);
+            }
+        }
+    }
+    residentMin_ = newMin;
+    residentMax_ = newMax;
+
+    return true;
+}
+
+bool Viewport::IsTileResident(const glm::ivec2 tilePos) const {
+    return tilePos.x >= residentMin_.x && tilePos.y >= residentMin_.y && tilePos.x < residentMax_.x &&
+           tilePos.y < residentMax_.y;
+}
+
+void Viewport::ResidentArea(glm::ivec2& min, glm::ivec2& max) const {
+    min = residentMin_;
+    max = residentMax_;
+}
+
+float Viewport::TileLoadPriority(const glm::ivec2 tilePos) const {
+    constexpr glm::vec2 tSize(TILE_WIDTH, TILE_HEIGHT);
+    const glm::vec2 tileCenter = (glm::vec2(tilePos) + 0.5f) * tSize;
+    if (IsTileVisible(tilePos)) {
+        return glm::length((tileCenter - lastCenter_) / tSize);
+    }
+
+    // Prefetched tiles always come after the visible ones
+    constexpr float PREFETCH_PRIORITY = 1.0e6f;
+    const glm::vec2 ahead = lastCenter_ + (velocity_ * PREFETCH_LOOKAHEAD);
+    return PREFETCH_PRIORITY + glm::length((tileCenter - ahead) / tSize);
+}
+
 void Viewport::UI() {
     if (ImGui::Begin("Viewport")) {
         ImGui::LabelText("Pos", "%.2f, %.2f", translation_.x, translation_.y);
@@ -29,10 +29,28 @@ public:
     bool IsTileVisible(glm::ivec2 tilePos) const;
     std::vector<glm::ivec2> VisibleTiles() const;
 
+    // The resident area is the rectangle of tiles kept loaded: the visible tiles plus a prefetch margin, extended in the
+    // direction the view is panning or zooming out so tiles are loaded before they show up.
+    static constexpr int PREFETCH_MARGIN = 1;         // Tiles around the view
+    static constexpr float PREFETCH_LOOKAHEAD = 8.0f; // Frames of motion the area is extended by
+    static constexpr int PREFETCH_MAX_EXTENSION = 4;  // Tiles the motion can extend the area by
+
+    // Must be called once per frame, it tracks the view motion. The tiles that entered and left the resident area since
+    // the last call are written to `entered` and `left`, returns false if the area didn't change.
+    bool UpdateResidentTiles(std::vector<glm::ivec2>& entered, std::vector<glm::ivec2>& left);
+    bool IsTileResident(glm::ivec2 tilePos) const;
+    // Resident area as of the last UpdateResidentTiles, `max` is exclusive
+    void ResidentArea(glm::ivec2& min, glm::ivec2& max) const;
+    // Load order of a tile, lower first: visible tiles by distance to the center of the view, then the prefetched ones
+    // by distance to where the view is heading
+    float TileLoadPriority(glm::ivec2 tilePos) const;
+
     void UI();
 
    private:
     void ComputeViewMatrix();
+    // AABB of the view in canvas space
+    void ViewBounds(glm::vec2& min, glm::vec2& max) const;
 
     glm::vec2 viewSize_{1.0f};
     
@@ -45,6 +63,15 @@ public:
     glm::mat4 viewMat_{1.0f};
     glm::mat4 viewMatInv_{1.0f};
     bool viewComputed_{false};
+
+    // Motion of the view center (canvas space) and zoom per frame, smoothed over a few frames
+    glm::vec2 lastCenter_{0.0f};
+    float lastZoom_{1.0f};
+    glm::vec2 velocity_{0.0f};
+    float zoomVelocity_{1.0f};
+    bool motionTracked_{false};
+    glm::ivec2 residentMin_{0};
+    glm::ivec2 residentMax_{0};
     
     glm::vec2 vX{1.0f, 0.0f};
     glm::vec2 vY{0.0f, 1.0f};
@@ -0,0 +1,251 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "../src/blend.h"
+#include "../src/tiles.h"
+
+static std::vector<std::uint8_t> Pixels(std::initializer_list<std::uint8_t> rgba, size_t count) {
+    std::vector<std::uint8_t> pixels;
+    for (size_t i = 0; i < count; i++) {
+        pixels.insert(pixels.end(), rgba);
+    }
+    return pixels;
+}
+
+TEST(MidoriBlend, MergeOpaqueReplaces) {
+    const auto over = Pixels({10, 20, 30, 255}, 4);
+    auto below = Pixels({200, 100, 50, 255}, 4);
+    Midori::MergePixels(over.data(), 1.0f, below.data(), 4);
+    EXPECT_EQ(below, over);
+}
+
+TEST(MidoriBlend, MergeTransparentKeeps) {
+    const auto over = Pixels({0, 0, 0, 0}, 4);
+    const auto original = Pixels({200, 100, 50, 128}, 4);
+    auto below = original;
+    Midori::MergePixels(over.data(), 1.0f, below.data(), 4);
+    EXPECT_EQ(below, original);
+
+    // Zero opacity hides whatever the layer holds
+    const auto opaque = Pixels({255, 255, 255, 255}, 4);
+    Midori::MergePixels(opaque.data(), 0.0f, below.data(), 4);
+    EXPECT_EQ(below, original);
+}
+
+TEST(MidoriBlend, MergePremultiplied) {
+    // Half transparent premultiplied red over opaque blue
+    const auto over = Pixels({128, 0, 0, 128}, 1);
+    auto below = Pixels({0, 0, 255, 255}, 1);
+    Midori::MergePixels(over.data(), 1.0f, below.data(), 1);
+    EXPECT_EQ(below, Pixels({128, 0, 127, 255}, 1));
+
+    // Same with the opacity of the layer instead of the alpha of the pixel
+    const auto red = Pixels({255, 0, 0, 255}, 1);
+    below = Pixels({0, 0, 255, 255}, 1);
+    Midori::MergePixels(red.data(), 0.5f, below.data(), 1);
+    EXPECT_EQ(below, Pixels({128, 0, 128, 255}, 1));
+}
+
+// Soft round tip, opaque in the middle and transparent at the edge like brushes/sphere.qoi
+static Midori::BrushTip RoundTip(const bool detect_round = true) {
+    constexpr int size = 64;
+    std::vector<std::uint8_t> rgba(size * size * 4);
+    for (int y = 0; y < size; y++) {
+        for (int x = 0; x < size; x++) {
+            const float dx = (static_cast<float>(x) + 0.5f) / size - 0.5f;
+            const float dy = (static_cast<float>(y) + 0.5f) / size - 0.5f;
+            const float alpha = std::max(0.0f, 1.0f - (2.0f * std::sqrt((dx * dx) + (dy * dy))));
+            std::fill_n(rgba.begin() + ((y * size + x) * 4), 4, static_cast<std::uint8_t>(alpha * 255.0f));
+        }
+    }
+    return {rgba.data(), size, size, detect_round};
+}
+
+static Midori::StrokePoint Dab(const glm::vec2 position, const glm::vec4 color, const float hardness = 1.0f) {
+    Midori::StrokePoint point;
+    point.color = color;
+    point.position = position;
+    point.radius = 20.0f;
+    point.flow = 1.0f;
+    point.hardness = hardness;
+    return point;
+}
+
+static const std::uint8_t* TilePixel(const std::vector<std::uint8_t>& tile, const int x, const int y) {
+    return tile.data() + ((static_cast<size_t>(y) * Midori::TILE_WIDTH + x) * 4);
+}
+
+TEST(MidoriBlend, PaintCoversTheDab) {
+    const auto tip = RoundTip();
+    std::vector<std::uint8_t> tile(Midori::TILE_WIDTH * Midori::TILE_HEIGHT * 4, 0);
+    const auto dab = Dab({100.0f, 50.0f}, {1.0f, 0.0f, 0.0f, 1.0f});
+    Midori::PaintPixels(Midori::PaintMode::Paint, &dab, 1, tip, {0, 0}, tile.data());
+
+    const std::uint8_t* center = TilePixel(tile, 100, 50);
+    EXPECT_EQ(center[0], 255);
+    EXPECT_EQ(center[1], 0);
+    EXPECT_EQ(center[3], 255);
+
+    // Outside of the radius nothing is touched
+    EXPECT_EQ(TilePixel(tile, 121, 50)[3], 0);
+    EXPECT_EQ(TilePixel(tile, 100, 71)[3], 0);
+    EXPECT_EQ(TilePixel(tile, 0, 0)[3], 0);
+
+    // Opaque pixels are left alone
+    const auto green = Dab({100.0f, 50.0f}, {0.0f, 1.0f, 0.0f, 1.0f});
+    Midori::PaintPixels(Midori::PaintMode::Paint, &green, 1, tip, {0, 0}, tile.data());
+    EXPECT_EQ(TilePixel(tile, 100, 50)[0], 255);
+    EXPECT_EQ(TilePixel(tile, 100, 50)[1], 0);
+}
+
+TEST(MidoriBlend, PaintStopsAtTheColorAlpha) {
+    const auto tip = RoundTip();
+    std::vector<std::uint8_t> tile(Midori::TILE_WIDTH * Midori::TILE_HEIGHT * 4, 0);
+    std::vector<Midori::StrokePoint> dabs(16, Dab({128.0f, 128.0f}, {0.0f, 0.0f, 1.0f, 0.5f}));
+    Midori::PaintPixels(Midori::PaintMode::Paint, dabs.data(), dabs.size(), tip, {0, 0}, tile.data());
+
+    const std::uint8_t* center = TilePixel(tile, 128, 128);
+    EXPECT_NEAR(center[3], 128, 1);
+    EXPECT_EQ(center[2], center[3]);
+}
+
+TEST(MidoriBlend, EraseRemovesAlpha) {
+    const auto tip = RoundTip();
+    std::vector<std::uint8_t> tile(Midori::TILE_WIDTH * Midori::TILE_HEIGHT * 4, 255);
+    auto dab = Dab({30.0f, 30.0f}, {0.0f, 0.0f, 0.0f, 1.0f});
+    Midori::PaintPixels(Midori::PaintMode::Erase, &dab, 1, tip, {0, 0}, tile.data());
+    EXPECT_EQ(TilePixel(tile, 30, 30)[3], 0);
+    EXPECT_EQ(TilePixel(tile, 30, 60)[3], 255);
+
+    // A soft dab only removes part of it
+    std::fill(tile.begin(), tile.end(), 255);
+    dab.hardness = 0.0f;
+    dab.flow = 0.5f;
+    Midori::PaintPixels(Midori::PaintMode::Erase, &dab, 1, tip, {0, 0}, tile.data());
+    EXPECT_GT(TilePixel(tile, 30, 30)[3], 0);
+    EXPECT_LT(TilePixel(tile, 30, 30)[3], 255);
+}
+
+TEST(MidoriBlend, PaintUsesCanvasPositions) {
+    // A dab across the edge of two tiles paints both halves like it would on a single texture
+    const auto tip = RoundTip();
+    const auto dab = Dab({260.0f, 100.0f}, {0.2f, 0.4f, 0.6f, 1.0f}, 0.5f);
+    std::vector<std::uint8_t> left(Midori::TILE_WIDTH * Midori::TILE_HEIGHT * 4, 0);
+    std::vector<std::uint8_t> right = left;
+    Midori::PaintPixels(Midori::PaintMode::Paint, &dab, 1, tip, {0, 0}, left.data());
+    Midori::PaintPixels(Midori::PaintMode::Paint, &dab, 1, tip, {1, 0}, right.data());
+
+    auto shifted = dab;
+    shifted.position.x -= 200.0f;
+    std::vector<std::uint8_t> whole(Midori::TILE_WIDTH * Midori::TILE_HEIGHT * 4, 0);
+    Midori::PaintPixels(Midori::PaintMode::Paint, &shifted, 1, tip, {0, 0}, whole.data());
+    for (int x = 0; x < 30; x++) {
+        for (int c = 0; c < 4; c++) {
+            EXPECT_EQ(TilePixel(right, x, 100)[c], TilePixel(whole, x + 56, 100)[c]);
+            EXPECT_EQ(TilePixel(left, 255 - x, 100)[c], TilePixel(whole, 55 - x, 100)[c]);
+        }
+    }
+}
+
+TEST(MidoriBlend, OnlyRoundTipsUseTheFalloffs) {
+    EXPECT_TRUE(RoundTip().Round());
+    EXPECT_FALSE(RoundTip(false).Round());
+
+    // Brighter on the left half
+    constexpr int size = 32;
+    std::vector<std::uint8_t> rgba(size * size * 4, 255);
+    for (int y = 0; y < size; y++) {
+        std::fill_n(rgba.begin() + (y * size * 4), size * 2, 128);
+    }
+    EXPECT_FALSE(Midori::BrushTip(rgba.data(), size, size).Round());
+
+    const auto tip = RoundTip();
+    EXPECT_EQ(tip.Falloffs().size(), Midori::BrushTip::FALLOFF_ROWS * Midori::BrushTip::FALLOFF_SIZE);
+    for (const float hardness : {0.0f, 0.5f, 1.0f}) {
+        const auto falloff = tip.FalloffOf(hardness);
+        EXPECT_NEAR(falloff.Sample(0.0f), 1.0f, 0.01f);
+        EXPECT_GE(falloff.Sample(0.25f), falloff.Sample(0.75f));
+    }
+    EXPECT_NEAR(tip.FalloffOf(0.0f).Sample(1.0f), 0.0f, 0.01f);
+}
+
+TEST(MidoriBlend, FalloffsPaintLikeTheTexture) {
+    // The texture path amplifies the noise of the 8 bits tip in the last pixels of hard dabs, the falloffs are its
+    // average over the angles. Inside, the masks are close, and the dabs cover the same amount.
+    const auto falloffs = RoundTip();
+    const auto texture = RoundTip(false);
+    for (int step = 0; step <= 20; step++) {
+        for (const float radius : {4.0f, 30.0f, 100.0f}) {
+            auto dab = Dab({128.3f, 127.6f}, {1.0f, 1.0f, 1.0f, 1.0f}, static_cast<float>(step) / 20.0f);
+            dab.radius = radius;
+            std::vector<std::uint8_t> a(Midori::TILE_WIDTH * Midori::TILE_HEIGHT * 4, 0);
+            auto b = a;
+            Midori::PaintPixels(Midori::PaintMode::Paint, &dab, 1, falloffs, {0, 0}, a.data());
+            Midori::PaintPixels(Midori::PaintMode::Paint, &dab, 1, texture, {0, 0}, b.data());
+
+            double a_cover = 0.0;
+            double b_cover = 0.0;
+            int inside_difference = 0;
+            for (int y = 0; y < static_cast<int>(Midori::TILE_HEIGHT); y++) {
+                for (int x = 0; x < static_cast<int>(Midori::TILE_WIDTH); x++) {
+                    const int a_alpha = TilePixel(a, x, y)[3];
+                    const int b_alpha = TilePixel(b, x, y)[3];
+                    a_cover += a_alpha;
+                    b_cover += b_alpha;
+                    const float dx = static_cast<float>(x) - dab.position.x;
+                    const float dy = static_cast<float>(y) - dab.position.y;
+                    if (std::sqrt((dx * dx) + (dy * dy)) <= 0.9f * radius) {
+                        inside_difference = std::max(inside_difference, std::abs(a_alpha - b_alpha));
+                    }
+                }
+            }
+            EXPECT_LE(inside_difference, 8) << "hardness " << dab.hardness << " radius " << radius;
+            EXPECT_NEAR(a_cover / b_cover, 1.0, 0.01) << "hardness " << dab.hardness << " radius " << radius;
+        }
+    }
+}
+
+TEST(MidoriBlend, WetTilesResolveToTheirPixels) {
+    std::vector<std::uint8_t> tile(Midori::TILE_WIDTH * Midori::TILE_HEIGHT * 4);
+    for (size_t i = 0; i < tile.size(); i++) {
+        tile[i] = static_cast<std::uint8_t>((i * 7) + (i / 255));
+    }
+    std::vector<float> wet(Midori::WET_TILE_SIZE);
+    Midori::WetPixels(tile.data(), wet.data());
+    std::vector<std::uint8_t> resolved(tile.size());
+    Midori::ResolveWetPixels(wet.data(), resolved.data());
+    EXPECT_EQ(resolved, tile);
+    EXPECT_FLOAT_EQ(wet[(3 * Midori::TILE_WIDTH * Midori::TILE_HEIGHT) + 1], static_cast<float>(tile[7]) / 255.0f);
+}
+
+TEST(MidoriBlend, LowFlowBuildsUpOnWetTiles) {
+    // Each dab adds less than half of a unorm step, rounded after every dab nothing is ever painted
+    const auto tip = RoundTip();
+    auto dab = Dab({128.0f, 128.0f}, {0.0f, 0.0f, 1.0f, 1.0f});
+    dab.flow = 0.0015f;
+    const std::vector<Midori::StrokePoint> dabs(400, dab);
+    const double expected = 255.0 * (1.0 - std::pow(1.0 - dab.flow, static_cast<double>(dabs.size())));
+
+    std::vector<std::uint8_t> rounded(Midori::TILE_WIDTH * Midori::TILE_HEIGHT * 4, 0);
+    std::vector<float> wet(Midori::WET_TILE_SIZE, 0.0f);
+    std::vector<std::uint8_t> resolved(rounded.size(), 0);
+    for (const auto& point : dabs) {
+        Midori::PaintPixels(Midori::PaintMode::Paint, &point, 1, tip, {0, 0}, rounded.data());
+        Midori::PaintPixels(Midori::PaintMode::Paint, &point, 1, tip, {0, 0}, wet.data(), resolved.data());
+    }
+    EXPECT_EQ(TilePixel(rounded, 128, 128)[3], 0);
+
+    EXPECT_NEAR(TilePixel(resolved, 128, 128)[3], expected, 2.0);
+    EXPECT_EQ(TilePixel(resolved, 128, 128)[2], TilePixel(resolved, 128, 128)[3]);
+
+    // The dabs of a single call are only rounded at the end, like the registers of the shaders
+    std::vector<std::uint8_t> once(rounded.size(), 0);
+    Midori::PaintPixels(Midori::PaintMode::Paint, dabs.data(), dabs.size(), tip, {0, 0}, once.data());
+    EXPECT_EQ(once, resolved);
+    std::vector<std::uint8_t> whole(rounded.size());
+    Midori::ResolveWetPixels(wet.data(), whole.data());
+    EXPECT_EQ(whole, resolved);
+}
@@ -0,0 +1,59 @@
+#include <gtest/gtest.h>
+
+#include "../src/composite_tiles.h"
+
+TEST(MidoriCompositeTiles, StaleUntilComposited) {
+    Midori::CompositeTileCache cache;
+    cache.BeginFrame();
+
+    bool stale = false;
+    const auto slot = cache.Use({2, 3}, stale);
+    EXPECT_TRUE(stale);
+    cache.Composited({2, 3});
+
+    // Reused on the next frames, at the same slot
+    cache.BeginFrame();
+    EXPECT_EQ(cache.Use({2, 3}, stale), slot);
+    EXPECT_FALSE(stale);
+
+    cache.Mark({2, 3});
+    cache.Mark({9, 9}); // Nothing there
+    EXPECT_FALSE(cache.Contains({9, 9}));
+    cache.Use({2, 3}, stale);
+    EXPECT_TRUE(stale);
+    cache.Composited({2, 3});
+
+    cache.MarkAll();
+    cache.Use({2, 3}, stale);
+    EXPECT_TRUE(stale);
+}
+
+TEST(MidoriCompositeTiles, TrimEvictsTheOldest) {
+    Midori::CompositeTileCache cache;
+    bool stale = false;
+    for (int x = 0; x < 4; x++) {
+        cache.BeginFrame();
+        cache.Use({x, 0}, stale);
+    }
+    EXPECT_EQ(cache.Size(), 4);
+
+    // The composite used this frame stays even over budget
+    cache.Trim(0);
+    EXPECT_EQ(cache.Size(), 1);
+    EXPECT_TRUE(cache.Contains({3, 0}));
+
+    cache.BeginFrame();
+    cache.Use({0, 0}, stale);
+    cache.Use({1, 0}, stale);
+    cache.BeginFrame();
+    cache.Use({1, 0}, stale);
+    cache.Trim(2);
+    EXPECT_EQ(cache.Size(), 2);
+    EXPECT_FALSE(cache.Contains({3, 0}));
+    EXPECT_TRUE(cache.Contains({0, 0}));
+
+    // Freed slots are given again
+    cache.Use({5, 5}, stale);
+    EXPECT_TRUE(stale);
+    EXPECT_EQ(cache.PageCount(), 1);
+}
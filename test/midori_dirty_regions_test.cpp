@@ -0,0 +1,66 @@
+#include <gtest/gtest.h>
+
+#include "../src/dirty_regions.h"
+
+TEST(MidoriDirtyRegions, TilesGrowTheRect) {
+    Midori::DirtyRegions dirty;
+    EXPECT_FALSE(dirty.Dirty(3));
+
+    dirty.MarkTile(3, {2, 5});
+    dirty.MarkTile(3, {-1, 6});
+    dirty.MarkTile(3, {0, 4});
+    EXPECT_TRUE(dirty.Dirty(3));
+    EXPECT_FALSE(dirty.Full(3));
+    EXPECT_EQ(dirty.Rect(3).min, glm::ivec2(-1, 4));
+    EXPECT_EQ(dirty.Rect(3).max, glm::ivec2(3, 7));
+
+    EXPECT_FALSE(dirty.Dirty(1));
+    dirty.Clean(3);
+    EXPECT_FALSE(dirty.Dirty(3));
+    EXPECT_TRUE(dirty.Rect(3).Empty());
+}
+
+TEST(MidoriDirtyRegions, FullLayers) {
+    Midori::DirtyRegions dirty;
+    dirty.MarkTile(1, {0, 0});
+    dirty.MarkLayer(2);
+    EXPECT_TRUE(dirty.Full(2));
+
+    // Tiles don't matter anymore once the layer is redrawn whole
+    dirty.MarkTile(2, {8, 8});
+    EXPECT_TRUE(dirty.Rect(2).Empty());
+
+    dirty.MarkAll();
+    EXPECT_TRUE(dirty.Full(1));
+    EXPECT_TRUE(dirty.Full(2));
+
+    dirty.Clean(1);
+    EXPECT_FALSE(dirty.Dirty(1));
+    EXPECT_TRUE(dirty.Full(2));
+}
+
+TEST(MidoriDirtyRegions, StrokeLayerStaysOutOfTheCaches) {
+    // The stroke layer takes the height of the selected layer, which moves down with the layers under it
+    const Midori::LayerInfo below = {.id = 1, .height = 3};
+    const Midori::LayerInfo selected = {.id = 2, .height = 2};
+    const Midori::LayerInfo stroke = {.id = 3, .height = 1};
+    const Midori::LayerInfo above = {.id = 4, .height = 0};
+    EXPECT_EQ(Midori::LayerCompositeGroup(below, &selected, stroke.id), Midori::CompositeGroup::Below);
+    EXPECT_EQ(Midori::LayerCompositeGroup(selected, &selected, stroke.id), Midori::CompositeGroup::Selected);
+    EXPECT_EQ(Midori::LayerCompositeGroup(stroke, &selected, stroke.id), Midori::CompositeGroup::Stroke);
+    EXPECT_EQ(Midori::LayerCompositeGroup(above, &selected, stroke.id), Midori::CompositeGroup::Above);
+
+    // Painting the stroke blends neither cache again
+    Midori::DirtyRegions dirty;
+    dirty.MarkTile(stroke.id, {0, 0});
+    dirty.MarkTile(stroke.id, {4, 2});
+    for (const auto& layer : {below, selected, stroke, above}) {
+        const auto group = Midori::LayerCompositeGroup(layer, &selected, stroke.id);
+        if (group == Midori::CompositeGroup::Below || group == Midori::CompositeGroup::Above) {
+            EXPECT_FALSE(dirty.Dirty(layer.id));
+        }
+    }
+
+    // Without a selected layer everything is below
+    EXPECT_EQ(Midori::LayerCompositeGroup(above, nullptr, Midori::LAYER_INVALID), Midori::CompositeGroup::Below);
+}
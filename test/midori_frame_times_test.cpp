@@ -0,0 +1,29 @@
+#include <gtest/gtest.h>
+
+#include "../src/frame_times.h"
+
+TEST(MidoriFrameTimes, Percentiles) {
+    Midori::FrameTimes times;
+    EXPECT_EQ(times.Percentile(0.5f), 0.0f);
+
+    for (int i = 100; i >= 1; i--) {
+        times.Add(static_cast<float>(i));
+    }
+    EXPECT_EQ(times.Percentile(0.5f), 50.0f);
+    EXPECT_EQ(times.Percentile(0.99f), 99.0f);
+    EXPECT_EQ(times.Percentile(1.0f), 100.0f);
+    EXPECT_EQ(times.Percentile(0.0f), 1.0f);
+}
+
+TEST(MidoriFrameTimes, KeepsTheLastFrames) {
+    Midori::FrameTimes times;
+    times.Add(1000.0f); // A stall, pushed out by the frames after it
+    for (size_t i = 0; i < Midori::FrameTimes::CAPACITY; i++) {
+        times.Add(16.0f);
+    }
+    EXPECT_EQ(times.Size(), Midori::FrameTimes::CAPACITY);
+    EXPECT_EQ(times.Percentile(1.0f), 16.0f);
+
+    times.Clear();
+    EXPECT_EQ(times.Size(), 0);
+}
@@ -0,0 +1,188 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <vector>
+
+#include "../src/jobs.h"
+#include "../src/paint_backend.h"
+
+namespace {
+
+Midori::BrushTip HardTip() {
+    std::vector<std::uint8_t> rgba(8 * 8 * 4, 255);
+    return {rgba.data(), 8, 8};
+}
+
+eastl::vector<Midori::StrokePoint> Stroke(const glm::vec2 from, const glm::vec2 to, const size_t dabs) {
+    eastl::vector<Midori::StrokePoint> points;
+    for (size_t i = 0; i < dabs; i++) {
+        const float t = static_cast<float>(i) / static_cast<float>(dabs - 1);
+        Midori::StrokePoint point;
+        point.color = {0.8f, 0.3f, 0.1f, 1.0f};
+        point.position = {from.x + ((to.x - from.x) * t), from.y + ((to.y - from.y) * t)};
+        point.radius = 24.0f;
+        point.flow = 0.3f;
+        point.hardness = 0.7f;
+        points.push_back(point);
+    }
+    return points;
+}
+
+} // namespace
+
+TEST(MidoriPaintBackend, JobsPaintLikeASingleThread) {
+    Midori::JobSystem jobs(3);
+    Midori::CpuPaintBackend backend(jobs, HardTip());
+    const auto points = Stroke({-100.0f, 40.0f}, {400.0f, 300.0f}, 200);
+
+    eastl::vector<Midori::Tile> tiles;
+    Midori::Tile tile = 1;
+    for (int y = -1; y <= 1; y++) {
+        for (int x = -1; x <= 1; x++) {
+            backend.CreateTile(tile, {.layer = 1, .pos = {x, y}});
+            tiles.push_back(tile++);
+        }
+    }
+    ASSERT_TRUE(backend.PaintTiles(tiles, points, Midori::PaintMode::Paint));
+
+    const auto tip = HardTip();
+    size_t painted = 0;
+    for (const auto painted_tile : tiles) {
+        std::vector<std::uint8_t> expected(Midori::TILE_WIDTH * Midori::TILE_HEIGHT * 4, 0);
+        const glm::ivec2 pos = {((painted_tile - 1) % 3) - 1, ((painted_tile - 1) / 3) - 1};
+        Midori::PaintPixels(Midori::PaintMode::Paint, points.data(), points.size(), tip, pos, expected.data());
+        EXPECT_EQ(std::memcmp(expected.data(), backend.TilePixels(painted_tile), expected.size()), 0);
+        for (size_t i = 3; i < expected.size(); i += 4) {
+            painted += expected[i] != 0 ? 1 : 0;
+        }
+    }
+    EXPECT_GT(painted, 0);
+
+    // Tiles the backend doesn't have
+    EXPECT_FALSE(backend.PaintTiles({100}, points, Midori::PaintMode::Erase));
+}
+
+TEST(MidoriPaintBackend, TilesStayWetForTheStroke) {
+    // One low flow dab per paint, like a slow stroke over many frames
+    Midori::JobSystem jobs(2);
+    Midori::CpuPaintBackend backend(jobs, HardTip());
+    backend.CreateTile(1, {.layer = 1, .pos = {0, 0}});
+    auto points = Stroke({128.0f, 128.0f}, {128.0f, 128.0f}, 300);
+    for (auto& point : points) {
+        point.flow = 0.001f;
+    }
+    for (const auto& point : points) {
+        ASSERT_TRUE(backend.PaintTiles({1}, {point}, Midori::PaintMode::Paint));
+    }
+
+    // Same as every dab blended at once, the pixels were only rounded for display
+    std::vector<std::uint8_t> expected(Midori::TILE_WIDTH * Midori::TILE_HEIGHT * 4, 0);
+    Midori::PaintPixels(Midori::PaintMode::Paint, points.data(), points.size(), HardTip(), {0, 0}, expected.data());
+    EXPECT_EQ(std::memcmp(expected.data(), backend.TilePixels(1), expected.size()), 0);
+    EXPECT_GT(backend.TilePixels(1)[((128 * Midori::TILE_WIDTH) + 128) * 4 + 3], 0);
+
+    // Erasing works on the RGBA8 pixels, the next paint starts from them
+    ASSERT_TRUE(backend.PaintTiles({1}, points, Midori::PaintMode::Erase));
+    ASSERT_TRUE(backend.PaintTiles({1}, {points[0]}, Midori::PaintMode::Paint));
+    Midori::PaintPixels(Midori::PaintMode::Erase, points.data(), points.size(), HardTip(), {0, 0}, expected.data());
+    Midori::PaintPixels(Midori::PaintMode::Paint, points.data(), 1, HardTip(), {0, 0}, expected.data());
+    EXPECT_EQ(std::memcmp(expected.data(), backend.TilePixels(1), expected.size()), 0);
+}
+
+TEST(MidoriPaintBackend, MergeUsesTheLayerOpacity) {
+    Midori::JobSystem jobs(2);
+    Midori::CpuPaintBackend backend(jobs, HardTip());
+    backend.CreateTile(1, {.layer = 1, .pos = {0, 0}});
+    backend.CreateTile(2, {.layer = 2, .pos = {0, 0}});
+    backend.CreateTile(3, {.layer = 3, .pos = {0, 0}});
+    backend.SetLayerOpacity(1, 0.5f);
+
+    const size_t size = Midori::TILE_WIDTH * Midori::TILE_HEIGHT * 4;
+    std::memset(backend.TilePixels(1), 255, size);
+    std::memset(backend.TilePixels(3), 255, size);
+    // Both are merged into the same tile, in order
+    ASSERT_TRUE(backend.MergeTileTextures({{1, 2}, {3, 2}}));
+
+    const std::uint8_t* below = backend.TilePixels(2);
+    for (size_t i = 0; i < size; i++) {
+        ASSERT_EQ(below[i], 255);
+    }
+    EXPECT_FALSE(backend.MergeTileTextures({{1, 9}}));
+}
+
+TEST(MidoriPaintBackend, HundredThousandDabsInOneUpdate) {
+    // Every dab paints its own pixel of a 2x2 block of tiles with a color that is its index
+    constexpr size_t DABS = 100000;
+    constexpr int BLOCK_WIDTH = 2 * static_cast<int>(Midori::TILE_WIDTH);
+    eastl::vector<Midori::StrokePoint> points(DABS);
+    for (size_t i = 0; i < DABS; i++) {
+        auto& point = points[i];
+        point.position = {static_cast<float>(i % BLOCK_WIDTH), static_cast<float>(i / BLOCK_WIDTH)};
+        point.color = {static_cast<float>(i & 0xFF) / 255.0f, static_cast<float>((i >> 8) & 0xFF) / 255.0f,
+                       static_cast<float>((i >> 16) & 0xFF) / 255.0f, 1.0f};
+        point.radius = 0.5f;
+        point.flow = 1.0f;
+        point.hardness = 1.0f;
+    }
+
+    Midori::JobSystem jobs(2);
+    Midori::CpuPaintBackend backend(jobs, HardTip());
+    eastl::vector<Midori::Tile> tiles;
+    for (int y = 0; y < 2; y++) {
+        for (int x = 0; x < 2; x++) {
+            const auto tile = static_cast<Midori::Tile>(tiles.size() + 1);
+            backend.CreateTile(tile, {.layer = 1, .pos = {x, y}});
+            tiles.push_back(tile);
+        }
+    }
+    ASSERT_TRUE(backend.PaintTiles(tiles, points, Midori::PaintMode::Paint));
+    EXPECT_GT(DABS, backend.Stream().Capacity()) << "The dabs should take several chunks";
+
+    size_t applied = 0;
+    for (size_t i = 0; i < DABS; i++) {
+        const int x = static_cast<int>(i % BLOCK_WIDTH);
+        const int y = static_cast<int>(i / BLOCK_WIDTH);
+        const auto tile = tiles[((y / Midori::TILE_HEIGHT) * 2) + (x / Midori::TILE_WIDTH)];
+        const std::uint8_t* pixel =
+            backend.TilePixels(tile) +
+            (((static_cast<size_t>(y) % Midori::TILE_HEIGHT) * Midori::TILE_WIDTH) + (x % Midori::TILE_WIDTH)) * 4;
+        const size_t index = pixel[0] | (pixel[1] << 8) | (pixel[2] << 16);
+        if (pixel[3] == 255 && index == i) {
+            applied++;
+        }
+    }
+    EXPECT_EQ(applied, DABS);
+}
+
+TEST(MidoriPaintBackend, PaintEraseAndPaintAgainLikeTheRenderer) {
+    // The renderer's sequence: wet tiles start from the tile, an erase works on the RGBA8 tile of every tile it is
+    // given and drops their wet tiles
+    Midori::JobSystem jobs(2);
+    Midori::CpuPaintBackend backend(jobs, HardTip());
+    backend.CreateTile(1, {.layer = 1, .pos = {0, 0}});
+    backend.CreateTile(2, {.layer = 1, .pos = {1, 0}});
+    const auto paint = Stroke({40.0f, 60.0f}, {470.0f, 200.0f}, 120);
+    const auto erase = Stroke({60.0f, 40.0f}, {200.0f, 220.0f}, 40); // Only reaches the first tile
+    auto repaint = Stroke({30.0f, 200.0f}, {480.0f, 80.0f}, 120);
+    for (auto& point : repaint) {
+        point.flow = 0.01f;
+    }
+    ASSERT_TRUE(backend.PaintTiles({1, 2}, paint, Midori::PaintMode::Paint));
+    ASSERT_TRUE(backend.PaintTiles({1, 2}, erase, Midori::PaintMode::Erase));
+    ASSERT_TRUE(backend.PaintTiles({1, 2}, repaint, Midori::PaintMode::Paint));
+
+    const auto tip = HardTip();
+    for (const Midori::Tile tile : {1, 2}) {
+        const glm::ivec2 pos = {tile - 1, 0};
+        std::vector<std::uint8_t> expected(Midori::TILE_WIDTH * Midori::TILE_HEIGHT * 4, 0);
+        std::vector<float> wet(Midori::WET_TILE_SIZE);
+        Midori::WetPixels(expected.data(), wet.data());
+        Midori::PaintPixels(Midori::PaintMode::Paint, paint.data(), paint.size(), tip, pos, wet.data(),
+                            expected.data());
+        Midori::PaintPixels(Midori::PaintMode::Erase, erase.data(), erase.size(), tip, pos, expected.data());
+        Midori::WetPixels(expected.data(), wet.data());
+        Midori::PaintPixels(Midori::PaintMode::Paint, repaint.data(), repaint.size(), tip, pos, wet.data(),
+                            expected.data());
+        EXPECT_EQ(std::memcmp(expected.data(), backend.TilePixels(tile), expected.size()), 0) << "tile " << tile;
+    }
+}
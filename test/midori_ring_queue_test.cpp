@@ -0,0 +1,79 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "../src/ring_queue.h"
+
+TEST(MidoriBase, RingQueue_PushPop) {
+    Midori::RingQueue<int> queue(4);
+    int value = 0;
+    EXPECT_FALSE(queue.TryPop(value));
+
+    EXPECT_TRUE(queue.TryPush(0));
+    EXPECT_TRUE(queue.TryPush(1));
+    EXPECT_TRUE(queue.TryPush(2));
+    EXPECT_TRUE(queue.TryPush(3));
+    EXPECT_FALSE(queue.TryPush(4));
+
+    for (int i = 0; i < 4; i++) {
+        EXPECT_TRUE(queue.TryPop(value));
+        EXPECT_EQ(value, i);
+    }
+    EXPECT_FALSE(queue.TryPop(value));
+}
+
+TEST(MidoriBase, RingQueue_Wrapping) {
+    Midori::RingQueue<int> queue(2);
+    int value = 0;
+    for (int i = 0; i < 100; i++) {
+        EXPECT_TRUE(queue.TryPush(i));
+        EXPECT_TRUE(queue.TryPop(value));
+        EXPECT_EQ(value, i);
+    }
+}
+
+TEST(MidoriBase, RingQueue_FailedPushKeepsValue) {
+    Midori::RingQueue<std::vector<int>> queue(2);
+    EXPECT_TRUE(queue.TryPush(std::vector<int>{1}));
+    EXPECT_TRUE(queue.TryPush(std::vector<int>{2}));
+
+    std::vector<int> value = {3, 4, 5};
+    EXPECT_FALSE(queue.TryPush(std::move(value)));
+    EXPECT_EQ(value.size(), 3);
+}
+
+TEST(MidoriBase, RingQueue_MultipleProducers) {
+    constexpr int producers = 4;
+    constexpr int perProducer = 10000;
+    Midori::RingQueue<int> queue(64);
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; p++) {
+        threads.emplace_back([&queue, p] {
+            for (int i = 0; i < perProducer; i++) {
+                while (!queue.TryPush(p * perProducer + i)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    std::vector<int> received(producers * perProducer, 0);
+    int count = 0;
+    int value = 0;
+    while (count < producers * perProducer) {
+        if (queue.TryPop(value)) {
+            received[value]++;
+            count++;
+        }
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    for (const int r : received) {
+        EXPECT_EQ(r, 1);
+    }
+}
@@ -0,0 +1,162 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "../src/blend.h"
+#include "../src/stroke_bins.h"
+
+namespace {
+
+constexpr int TILE_W = static_cast<int>(Midori::TILE_WIDTH);
+constexpr int TILE_H = static_cast<int>(Midori::TILE_HEIGHT);
+
+std::vector<Midori::StrokePoint> RandomDabs(const unsigned seed, const size_t count, const float max_radius) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> position(-TILE_W, 4.0f * TILE_W);
+    std::uniform_real_distribution<float> radius(0.5f, max_radius);
+    std::vector<Midori::StrokePoint> points(count);
+    for (auto& point : points) {
+        point.position = {position(rng), position(rng)};
+        point.radius = radius(rng);
+        point.color = {0.2f, 0.4f, 0.6f, 1.0f};
+        point.flow = 0.5f;
+    }
+    return points;
+}
+
+// A 3x3 block of tiles
+std::vector<glm::ivec2> TileBlock() {
+    std::vector<glm::ivec2> positions;
+    for (int y = 0; y < 3; y++) {
+        for (int x = 0; x < 3; x++) {
+            positions.emplace_back(x, y);
+        }
+    }
+    return positions;
+}
+
+// Whether the distance test of the shaders passes for a pixel of the rectangle, the closest pixel is the closest
+// integer position on each axis
+bool DabReaches(const Midori::StrokePoint& point, const glm::ivec2 min, const glm::ivec2 max) {
+    const float x = std::clamp(std::round(point.position.x), static_cast<float>(min.x), static_cast<float>(max.x));
+    const float y = std::clamp(std::round(point.position.y), static_cast<float>(min.y), static_cast<float>(max.y));
+    const float dx = x - point.position.x;
+    const float dy = y - point.position.y;
+    return std::sqrt((dx * dx) + (dy * dy)) <= point.radius;
+}
+
+std::vector<std::uint32_t> Bin(const Midori::StrokeBins& bins, const size_t tile) {
+    const auto& indices = bins.Indices();
+    return {indices.begin() + bins.Offset(tile), indices.begin() + bins.Offset(tile) + bins.Count(tile)};
+}
+
+Midori::BrushTip FlatTip() {
+    const std::vector<std::uint8_t> rgba(8 * 8 * 4, 255);
+    return {rgba.data(), 8, 8};
+}
+
+} // namespace
+
+TEST(MidoriStrokeBins, TilesGetTheDabsReachingThemInOrder) {
+    const auto positions = TileBlock();
+    const auto points = RandomDabs(1, 500, 80.0f);
+    Midori::StrokeBins bins;
+    bins.Build(positions.data(), positions.size(), points.data(), points.size());
+
+    for (size_t tile = 0; tile < positions.size(); tile++) {
+        const auto bin = Bin(bins, tile);
+        EXPECT_TRUE(std::ranges::is_sorted(bin));
+        EXPECT_EQ(std::ranges::adjacent_find(bin), bin.end());
+
+        const glm::ivec2 min = positions[tile] * glm::ivec2(TILE_W, TILE_H);
+        const glm::ivec2 max = min + glm::ivec2(TILE_W - 1, TILE_H - 1);
+        for (std::uint32_t dab = 0; dab < points.size(); dab++) {
+            const bool binned = std::ranges::find(bin, dab) != bin.end();
+            if (DabReaches(points[dab], min, max)) {
+                EXPECT_TRUE(binned) << "tile " << tile << " dab " << dab;
+            }
+            if (binned) {
+                // Conservative by at most a pixel
+                auto wider = points[dab];
+                wider.radius += 2.0f;
+                EXPECT_TRUE(DabReaches(wider, min, max)) << "tile " << tile << " dab " << dab;
+            }
+        }
+    }
+}
+
+TEST(MidoriStrokeBins, BlocksOfTheShaderCoverTheirPixels) {
+    // paint.comp bins the dabs of its tile again for each 32x32 workgroup with DabTouches
+    const auto positions = TileBlock();
+    const auto points = RandomDabs(2, 300, 40.0f);
+    Midori::StrokeBins bins;
+    bins.Build(positions.data(), positions.size(), points.data(), points.size());
+
+    constexpr int block = Midori::StrokeBins::BLOCK_SIZE;
+    for (size_t tile = 0; tile < positions.size(); tile++) {
+        const auto bin = Bin(bins, tile);
+        for (int y = 0; y < TILE_H; y += block) {
+            for (int x = 0; x < TILE_W; x += block) {
+                const glm::ivec2 min = positions[tile] * glm::ivec2(TILE_W, TILE_H) + glm::ivec2(x, y);
+                const glm::ivec2 max = min + glm::ivec2(block - 1, block - 1);
+                for (std::uint32_t dab = 0; dab < points.size(); dab++) {
+                    if (!DabReaches(points[dab], min, max)) {
+                        continue;
+                    }
+                    EXPECT_NE(std::ranges::find(bin, dab), bin.end());
+                    EXPECT_TRUE(Midori::StrokeBins::DabTouches(points[dab], min, max));
+                }
+            }
+        }
+    }
+}
+
+TEST(MidoriStrokeBins, HugeDabsGoToEveryTile) {
+    const auto positions = TileBlock();
+    std::vector<Midori::StrokePoint> points(2);
+    points[0].position = {1.5f * TILE_W, 1.5f * TILE_H};
+    points[0].radius = 100000.0f;
+    points[1].position = {-10.0f * TILE_W, 0.0f};
+    points[1].radius = 8.0f;
+    Midori::StrokeBins bins;
+    bins.Build(positions.data(), positions.size(), points.data(), points.size());
+
+    EXPECT_EQ(bins.Indices().size(), positions.size());
+    for (size_t tile = 0; tile < positions.size(); tile++) {
+        EXPECT_EQ(Bin(bins, tile), std::vector<std::uint32_t>{0});
+    }
+}
+
+TEST(MidoriStrokeBins, NoTilesOrNoDabs) {
+    const auto positions = TileBlock();
+    const auto points = RandomDabs(3, 10, 10.0f);
+    Midori::StrokeBins bins;
+    bins.Build(positions.data(), positions.size(), points.data(), 0);
+    for (size_t tile = 0; tile < positions.size(); tile++) {
+        EXPECT_EQ(bins.Count(tile), 0);
+    }
+    bins.Build(positions.data(), 0, points.data(), points.size());
+    EXPECT_TRUE(bins.Indices().empty());
+}
+
+TEST(MidoriStrokeBins, BinnedPaintMatchesPaintingEveryDab) {
+    const auto positions = TileBlock();
+    const auto points = RandomDabs(4, 400, 60.0f);
+    const auto tip = FlatTip();
+    Midori::StrokeBins bins;
+    bins.Build(positions.data(), positions.size(), points.data(), points.size());
+
+    for (const auto mode : {Midori::PaintMode::Paint, Midori::PaintMode::Erase}) {
+        for (size_t tile = 0; tile < positions.size(); tile++) {
+            std::vector<std::uint8_t> every(Midori::TILE_WIDTH * Midori::TILE_HEIGHT * 4, 128);
+            auto binned = every;
+            Midori::PaintPixels(mode, points.data(), points.size(), tip, positions[tile], every.data());
+            const auto bin = Bin(bins, tile);
+            Midori::PaintPixels(mode, points.data(), bin.data(), bin.size(), tip, positions[tile], binned.data());
+            EXPECT_EQ(every, binned) << "tile " << tile;
+        }
+    }
+}
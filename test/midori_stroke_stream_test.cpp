@@ -0,0 +1,36 @@
+#include <gtest/gtest.h>
+
+#include "../src/stroke_stream.h"
+
+TEST(MidoriStrokeStream, ChunksCoverTheDabsInOrder) {
+    Midori::StrokeStream stream;
+    const size_t dabs = (Midori::StrokeStream::MAX_CAPACITY * 3) + 17;
+    const auto& chunks = stream.Plan(dabs);
+    ASSERT_EQ(chunks.size(), 4);
+    size_t next = 0;
+    for (const auto& chunk : chunks) {
+        EXPECT_EQ(chunk.first, next);
+        EXPECT_GT(chunk.count, 0);
+        EXPECT_LE(chunk.count, stream.Capacity());
+        next += chunk.count;
+    }
+    EXPECT_EQ(next, dabs);
+    EXPECT_TRUE(stream.Plan(0).empty());
+}
+
+TEST(MidoriStrokeStream, CapacityGrowsToTheBiggestFrame) {
+    Midori::StrokeStream stream;
+    EXPECT_EQ(stream.Plan(100).size(), 1);
+    EXPECT_EQ(stream.Capacity(), Midori::StrokeStream::MIN_CAPACITY);
+
+    // A fast stroke, one chunk once grown
+    EXPECT_EQ(stream.Plan(5000).size(), 1);
+    EXPECT_EQ(stream.Capacity(), 8192);
+
+    // It doesn't shrink back, the next fast stroke doesn't reallocate
+    stream.Plan(10);
+    EXPECT_EQ(stream.Capacity(), 8192);
+
+    stream.Plan(Midori::StrokeStream::MAX_CAPACITY * 10);
+    EXPECT_EQ(stream.Capacity(), Midori::StrokeStream::MAX_CAPACITY);
+}
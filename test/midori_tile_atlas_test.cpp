@@ -0,0 +1,90 @@
+#include <gtest/gtest.h>
+
+#include "../src/tile_atlas.h"
+
+TEST(MidoriTileAtlas, PagesFillInOrder) {
+    Midori::TileAtlas atlas;
+    EXPECT_EQ(atlas.PageCount(), 0);
+
+    for (Midori::Tile tile = 1; tile <= Midori::TileAtlas::PAGE_SLICES; tile++) {
+        const auto slot = atlas.Allocate(tile, 1);
+        EXPECT_EQ(slot.page, 0);
+        EXPECT_EQ(slot.slice, tile - 1);
+    }
+    EXPECT_EQ(atlas.PageCount(), 1);
+    EXPECT_EQ(atlas.PageUsed(0), Midori::TileAtlas::PAGE_SLICES);
+
+    const auto slot = atlas.Allocate(1000, 1);
+    EXPECT_EQ(slot, (Midori::TileAtlas::Slot{.page = 1, .slice = 0}));
+    EXPECT_EQ(atlas.PageCount(), 2);
+    EXPECT_EQ(atlas.Size(), Midori::TileAtlas::PAGE_SLICES + 1);
+}
+
+TEST(MidoriTileAtlas, FreedSlicesAreReused) {
+    Midori::TileAtlas atlas;
+    for (Midori::Tile tile = 1; tile <= Midori::TileAtlas::PAGE_SLICES + 2; tile++) {
+        atlas.Allocate(tile, 1);
+    }
+
+    const auto freed = atlas.At(10);
+    atlas.Free(10);
+    EXPECT_FALSE(atlas.Contains(10));
+    EXPECT_EQ(atlas.PageUsed(0), Midori::TileAtlas::PAGE_SLICES - 1);
+
+    // The lowest page with a free slice comes first, even if a later page has room
+    EXPECT_EQ(atlas.Allocate(2000, 1), freed);
+    EXPECT_EQ(atlas.PageCount(), 2);
+
+    // Ids are recycled
+    atlas.Free(3);
+    atlas.Allocate(3, 1);
+    EXPECT_TRUE(atlas.Contains(3));
+    EXPECT_EQ(atlas.At(3).page, 0);
+}
+
+TEST(MidoriTileAtlas, LayersKeepTheirPages) {
+    Midori::TileAtlas atlas;
+
+    // Loaded interleaved, every layer still ends up in its own page
+    Midori::Tile tile = 1;
+    for (int i = 0; i < 10; i++) {
+        for (Midori::Layer layer = 1; layer <= 3; layer++) {
+            EXPECT_EQ(atlas.Allocate(tile++, layer).page, layer - 1);
+        }
+    }
+    EXPECT_EQ(atlas.PageCount(), 3);
+    EXPECT_EQ(atlas.PageLayer(1), 2);
+    EXPECT_EQ(atlas.PageUsed(1), 10);
+
+    // An empty page goes to whichever layer needs one
+    for (Midori::Tile freed = 2; freed < tile; freed += 3) {
+        atlas.Free(freed);
+    }
+    EXPECT_EQ(atlas.PageLayer(1), Midori::LAYER_INVALID);
+    EXPECT_EQ(atlas.Allocate(tile++, 7).page, 1);
+    EXPECT_EQ(atlas.PageLayer(1), 7);
+    EXPECT_EQ(atlas.Allocate(tile++, 8).page, 3);
+}
+
+TEST(MidoriTileAtlas, ReleasedPagesAreTakenLast) {
+    Midori::TileAtlas atlas;
+    for (Midori::Tile tile = 1; tile <= 3; tile++) {
+        EXPECT_EQ(atlas.Allocate(tile, tile).page, tile - 1);
+    }
+    EXPECT_EQ(atlas.FreeSlices(), (3 * Midori::TileAtlas::PAGE_SLICES) - 3);
+
+    atlas.Free(1);
+    atlas.Free(2);
+    EXPECT_EQ(atlas.EmptyPages(), 2);
+    atlas.ReleasePage(0);
+    EXPECT_TRUE(atlas.PageReleased(0));
+    EXPECT_EQ(atlas.EmptyPages(), 1);
+    EXPECT_EQ(atlas.FreeSlices(), (2 * Midori::TileAtlas::PAGE_SLICES) - 1);
+
+    // The empty page that still has a texture comes first, then the released one
+    EXPECT_EQ(atlas.Allocate(4, 7).page, 1);
+    EXPECT_EQ(atlas.Allocate(5, 8).page, 0);
+    EXPECT_FALSE(atlas.PageReleased(0));
+    EXPECT_EQ(atlas.PageCount(), 3);
+    EXPECT_EQ(atlas.FreeSlices(), (3 * Midori::TileAtlas::PAGE_SLICES) - 3);
+}
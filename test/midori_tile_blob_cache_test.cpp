@@ -0,0 +1,47 @@
+#include <gtest/gtest.h>
+
+#include "../src/tile_blob_cache.h"
+
+static constexpr size_t MB = 1024 * 1024;
+
+TEST(MidoriTileBlobCache, FindInserted) {
+    Midori::TileBlobCache cache;
+    const eastl::vector<std::uint8_t> blob = {1, 2, 3, 4};
+    cache.Insert(64, blob.data(), blob.size());
+
+    EXPECT_EQ(cache.Find(65), nullptr);
+    const auto found = cache.Find(64);
+    ASSERT_NE(found, nullptr);
+    EXPECT_EQ(*found, blob);
+
+    const auto stats = cache.GetStats();
+    EXPECT_EQ(stats.hits, 1);
+    EXPECT_EQ(stats.misses, 1);
+    EXPECT_EQ(stats.bytes, 4);
+    EXPECT_EQ(stats.count, 1);
+}
+
+TEST(MidoriTileBlobCache, EvictsLeastRecentlyUsed) {
+    Midori::TileBlobCache cache;
+    cache.SetBudget(2);
+    const eastl::vector<std::uint8_t> blob(MB - 1, 7);
+    cache.Insert(1, blob.data(), blob.size());
+    cache.Insert(2, blob.data(), blob.size());
+    const auto held = cache.Find(2);
+    EXPECT_NE(cache.Find(1), nullptr); // 2 is now the least recently used
+
+    cache.Insert(3, blob.data(), blob.size());
+    EXPECT_EQ(cache.Find(2), nullptr);
+    EXPECT_NE(cache.Find(1), nullptr);
+    EXPECT_NE(cache.Find(3), nullptr);
+    // An evicted blob stays valid while it is held
+    EXPECT_EQ(held->size(), blob.size());
+
+    cache.SetBudget(1);
+    EXPECT_EQ(cache.GetStats().count, 1);
+    EXPECT_NE(cache.Find(3), nullptr);
+
+    cache.Clear();
+    EXPECT_EQ(cache.GetStats().bytes, 0);
+    EXPECT_EQ(cache.Find(3), nullptr);
+}
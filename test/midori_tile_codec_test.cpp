@@ -0,0 +1,172 @@
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "../src/tile_codec.h"
+
+// The reference codec the tile codec has to stay identical to
+#define QOI_IMPLEMENTATION
+#define QOI_NO_STDIO
+#include "../deps/qoi/qoi.h"
+
+static std::vector<std::uint8_t> ReferenceEncode(const std::vector<std::uint8_t>& pixels) {
+    const qoi_desc desc = {
+        .width = Midori::TILE_WIDTH,
+        .height = Midori::TILE_HEIGHT,
+        .channels = 4,
+        .colorspace = QOI_LINEAR,
+    };
+    int size = 0;
+    auto* encoded = static_cast<std::uint8_t*>(qoi_encode(pixels.data(), &desc, &size));
+    std::vector<std::uint8_t> result(encoded, encoded + size);
+    std::free(encoded);
+    return result;
+}
+
+static std::vector<std::uint8_t> ReferenceDecode(const std::vector<std::uint8_t>& encoded) {
+    qoi_desc desc;
+    auto* pixels = static_cast<std::uint8_t*>(qoi_decode(encoded.data(), static_cast<int>(encoded.size()), &desc, 4));
+    if (pixels == nullptr) {
+        return {};
+    }
+    std::vector<std::uint8_t> result(pixels, pixels + Midori::TILE_PIXELS_SIZE);
+    std::free(pixels);
+    return result;
+}
+
+static std::vector<std::uint8_t> Encode(const std::vector<std::uint8_t>& pixels) {
+    std::vector<std::uint8_t> encoded(Midori::TILE_QOI_MAX_SIZE);
+    encoded.resize(Midori::EncodeTileQoi(pixels.data(), encoded.data()));
+    return encoded;
+}
+
+// Mixes every kind of content the encoder has to choose between: runs of any length (across rows and the 62 pixels
+// limit), small and medium deltas, repeated colors and alpha changes
+static std::vector<std::uint8_t> RandomTile(std::mt19937& rng) {
+    std::vector<std::uint8_t> pixels(Midori::TILE_PIXELS_SIZE);
+    std::uint8_t px[4] = {0, 0, 0, 255};
+    std::vector<std::uint32_t> palette(8);
+    for (auto& color : palette) {
+        color = rng();
+    }
+
+    size_t pos = 0;
+    while (pos < Midori::TILE_PIXELS_SIZE) {
+        const auto kind = rng() % 6;
+        if (kind == 0) {
+            for (auto& c : px) {
+                c = static_cast<std::uint8_t>(rng());
+            }
+        } else if (kind == 1) {
+            px[0] += static_cast<std::uint8_t>(rng() % 4) - 2;
+            px[1] += static_cast<std::uint8_t>(rng() % 4) - 2;
+            px[2] += static_cast<std::uint8_t>(rng() % 4) - 2;
+        } else if (kind == 2) {
+            const auto vg = static_cast<std::uint8_t>(rng() % 64) - 32;
+            px[0] += vg + static_cast<std::uint8_t>(rng() % 16) - 8;
+            px[1] += vg;
+            px[2] += vg + static_cast<std::uint8_t>(rng() % 16) - 8;
+        } else if (kind == 3) {
+            std::memcpy(px, &palette[rng() % palette.size()], 4);
+        } else if (kind == 4) {
+            px[3] = static_cast<std::uint8_t>(rng());
+        }
+
+        const size_t run = (rng() % 4 == 0) ? 1 + (rng() % 300) : 1;
+        for (size_t i = 0; i < run && pos < Midori::TILE_PIXELS_SIZE; i++, pos += 4) {
+            std::memcpy(&pixels[pos], px, 4);
+        }
+    }
+    return pixels;
+}
+
+TEST(MidoriTileCodec, MatchesReferenceOnUniformTiles) {
+    for (const std::uint32_t color : {0x00000000u, 0xFF000000u, 0xFFFFFFFFu, 0x80402010u}) {
+        std::vector<std::uint8_t> pixels(Midori::TILE_PIXELS_SIZE);
+        for (size_t i = 0; i < pixels.size(); i += 4) {
+            std::memcpy(&pixels[i], &color, 4);
+        }
+
+        const auto encoded = Encode(pixels);
+        EXPECT_EQ(encoded, ReferenceEncode(pixels));
+
+        std::vector<std::uint8_t> decoded(Midori::TILE_PIXELS_SIZE);
+        EXPECT_TRUE(Midori::DecodeTileQoi(encoded.data(), encoded.size(), decoded.data()));
+        EXPECT_EQ(decoded, pixels);
+    }
+}
+
+TEST(MidoriTileCodec, MatchesReferenceOnRandomTiles) {
+    std::mt19937 rng(1234);
+    for (int i = 0; i < 64; i++) {
+        const auto pixels = RandomTile(rng);
+
+        const auto encoded = Encode(pixels);
+        ASSERT_EQ(encoded, ReferenceEncode(pixels)) << "tile " << i;
+
+        std::vector<std::uint8_t> decoded(Midori::TILE_PIXELS_SIZE);
+        ASSERT_TRUE(Midori::DecodeTileQoi(encoded.data(), encoded.size(), decoded.data()));
+        ASSERT_EQ(decoded, pixels) << "tile " << i;
+    }
+}
+
+TEST(MidoriTileCodec, MatchesReferenceOnCorruptedData) {
+    std::mt19937 rng(5678);
+    for (int i = 0; i < 256; i++) {
+        auto encoded = ReferenceEncode(RandomTile(rng));
+
+        // Flip chunk bytes and truncate, the header is kept so the reference decoder accepts it
+        for (int flip = 0; flip < 8; flip++) {
+            encoded[14 + (rng() % (encoded.size() - 14))] = static_cast<std::uint8_t>(rng());
+        }
+        if (rng() % 2 == 0) {
+            encoded.resize(22 + (rng() % (encoded.size() - 22)));
+        }
+
+        std::vector<std::uint8_t> decoded(Midori::TILE_PIXELS_SIZE);
+        ASSERT_TRUE(Midori::DecodeTileQoi(encoded.data(), encoded.size(), decoded.data()));
+        ASSERT_EQ(decoded, ReferenceDecode(encoded)) << "tile " << i;
+    }
+}
+
+TEST(MidoriTileCodec, RejectsOtherImages) {
+    std::vector<std::uint8_t> pixels(Midori::TILE_PIXELS_SIZE, 7);
+    auto encoded = Encode(pixels);
+    std::vector<std::uint8_t> decoded(Midori::TILE_PIXELS_SIZE);
+
+    EXPECT_FALSE(Midori::DecodeTileQoi(encoded.data(), 10, decoded.data()));
+
+    auto wrong_size = encoded;
+    wrong_size[6] = 2; // Width of 512
+    EXPECT_FALSE(Midori::DecodeTileQoi(wrong_size.data(), wrong_size.size(), decoded.data()));
+
+    auto wrong_magic = encoded;
+    wrong_magic[0] = 'x';
+    EXPECT_FALSE(Midori::DecodeTileQoi(wrong_magic.data(), wrong_magic.size(), decoded.data()));
+}
+
+TEST(MidoriTileCodec, EmptyAndUniformTiles) {
+    std::vector<std::uint8_t> pixels(Midori::TILE_PIXELS_SIZE, 1);
+    std::uint32_t color = 0;
+    EXPECT_TRUE(Midori::IsTileEmpty(pixels.data()));
+    EXPECT_TRUE(Midori::IsTileUniform(pixels.data(), color));
+    EXPECT_EQ(color, 0x01010101u);
+
+    pixels.back() = 2;
+    EXPECT_FALSE(Midori::IsTileEmpty(pixels.data()));
+    EXPECT_FALSE(Midori::IsTileUniform(pixels.data(), color));
+
+    const std::uint8_t background[4] = {200, 180, 160, 255};
+    for (size_t i = 0; i < pixels.size(); i += 4) {
+        std::memcpy(&pixels[i], background, 4);
+    }
+    EXPECT_FALSE(Midori::IsTileEmpty(pixels.data()));
+    EXPECT_TRUE(Midori::IsTileUniform(pixels.data(), color));
+    EXPECT_EQ(std::memcmp(&color, background, 4), 0);
+
+    pixels[Midori::TILE_PIXELS_SIZE / 2] = 0;
+    EXPECT_FALSE(Midori::IsTileUniform(pixels.data(), color));
+}
@@ -0,0 +1,51 @@
+#include <gtest/gtest.h>
+
+#include "../src/tile_download_ring.h"
+
+using Ring = Midori::TileDownloadRing;
+
+TEST(MidoriTileDownloadRing, BatchLifetime) {
+    Ring ring;
+    EXPECT_TRUE(ring.Empty());
+    EXPECT_TRUE(ring.Reserve(1));
+    EXPECT_TRUE(ring.Reserve(2));
+    EXPECT_EQ(ring.BatchCount(), 1);
+    EXPECT_EQ(ring.At(2).index, 1);
+
+    const auto submitted = ring.Submit();
+    ASSERT_EQ(submitted.size(), 1);
+    EXPECT_EQ(ring.State(0), Ring::BatchState::InFlight);
+    EXPECT_FALSE(ring.IsReady(1));
+
+    // Reserved while the first is in flight, goes to a new batch
+    EXPECT_TRUE(ring.Reserve(3));
+    EXPECT_EQ(ring.At(3).batch, 1);
+
+    ring.Complete(0);
+    EXPECT_TRUE(ring.IsReady(1));
+    EXPECT_FALSE(ring.Release(1));
+    EXPECT_TRUE(ring.Release(2));
+    EXPECT_EQ(ring.State(0), Ring::BatchState::Free);
+    EXPECT_FALSE(ring.Contains(1));
+    EXPECT_FALSE(ring.Empty());
+}
+
+TEST(MidoriTileDownloadRing, GrowsUnderPressure) {
+    Ring ring;
+    Midori::Tile tile = 1;
+    for (size_t i = 0; i < Ring::BATCH_TILES * Ring::MAX_BATCHES; i++) {
+        EXPECT_TRUE(ring.Reserve(tile++));
+    }
+    EXPECT_EQ(ring.BatchCount(), Ring::MAX_BATCHES);
+    EXPECT_FALSE(ring.Reserve(tile));
+    EXPECT_EQ(ring.Submit().size(), Ring::MAX_BATCHES);
+
+    // A free batch is reused before adding any
+    ring.Complete(3);
+    for (const auto done : eastl::vector<Midori::Tile>(ring.BatchTiles(3))) {
+        ring.Release(done);
+    }
+    EXPECT_TRUE(ring.Reserve(tile));
+    EXPECT_EQ(ring.At(tile).batch, 3);
+    EXPECT_EQ(ring.BatchCount(), Ring::MAX_BATCHES);
+}
@@ -0,0 +1,126 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "../src/tile_index.h"
+
+TEST(MidoriTileIndex, InsertErase) {
+    Midori::TileIndex index;
+    index.AddLayer(1);
+    index.AddLayer(2);
+
+    index.Insert(3, {.layer = 1, .pos = {0, 0}});
+    index.Insert(4, {.layer = 1, .pos = {5, -2}});
+    index.Insert(5, {.layer = 2, .pos = {0, 0}});
+    EXPECT_EQ(index.Size(), 3);
+
+    EXPECT_TRUE(index.Contains(4));
+    EXPECT_FALSE(index.Contains(6));
+    EXPECT_EQ(index.Coord(4), (Midori::TileCoord{.layer = 1, .pos = {5, -2}}));
+    EXPECT_EQ(index.Loaded(1, {5, -2}), 4);
+    EXPECT_EQ(index.Loaded(2, {0, 0}), 5);
+    EXPECT_EQ(index.Loaded(2, {5, -2}), Midori::TILE_INVALID);
+    EXPECT_EQ(index.LayerTiles(1).size(), 2);
+
+    index.Erase(3);
+    EXPECT_FALSE(index.Contains(3));
+    EXPECT_EQ(index.Loaded(1, {0, 0}), Midori::TILE_INVALID);
+    ASSERT_EQ(index.LayerTiles(1).size(), 1);
+    EXPECT_EQ(index.LayerTiles(1)[0], 4);
+    EXPECT_EQ(index.Size(), 2);
+
+    // Tiles ids are recycled by the canvas
+    index.Insert(3, {.layer = 2, .pos = {1, 1}});
+    EXPECT_EQ(index.Coord(3).layer, 2);
+    EXPECT_EQ(index.LayerTiles(2).size(), 2);
+}
+
+TEST(MidoriTileIndex, SavedHashesGoWithTheTile) {
+    Midori::TileIndex index;
+    index.AddLayer(1);
+    index.Insert(2, {.layer = 1, .pos = {0, 0}});
+    EXPECT_EQ(index.SavedHash(2), Midori::TileIndex::HASH_NONE);
+
+    index.SetSavedHash(2, 0x1234);
+    EXPECT_EQ(index.SavedHash(2), 0x1234);
+
+    // A recycled id doesn't inherit the hash
+    index.Erase(2);
+    index.Insert(2, {.layer = 1, .pos = {3, 3}});
+    EXPECT_EQ(index.SavedHash(2), Midori::TileIndex::HASH_NONE);
+}
+
+TEST(MidoriTileIndex, GridGrowsInEveryDirection) {
+    Midori::TileIndex index;
+    index.AddLayer(1);
+
+    const std::vector<glm::ivec2> positions = {{0, 0}, {-1, -1}, {-16, 15}, {16, -17}, {100, 3}, {-250, -70}, {31, 32}};
+    Midori::Tile tile = 1;
+    for (const auto& pos : positions) {
+        index.SetSaved(1, pos, true);
+        index.Insert(tile++, {.layer = 1, .pos = pos});
+    }
+
+    tile = 1;
+    for (const auto& pos : positions) {
+        EXPECT_TRUE(index.Saved(1, pos));
+        EXPECT_EQ(index.Loaded(1, pos), tile++);
+    }
+    EXPECT_FALSE(index.Saved(1, {1, 0}));
+    EXPECT_FALSE(index.Saved(1, {-1000, 1000}));
+}
+
+TEST(MidoriTileIndex, SavedPositions) {
+    Midori::TileIndex index;
+    index.AddLayer(1);
+    index.AddLayer(2);
+
+    index.SetSaved(1, {2, 3}, true);
+    index.SetSaved(1, {-20, 3}, true);
+    index.Insert(1, {.layer = 1, .pos = {2, 3}});
+    EXPECT_TRUE(index.Saved(1, {2, 3}));
+    EXPECT_FALSE(index.Saved(2, {2, 3}));
+
+    // Unsaving a position never seen doesn't grow the grid
+    index.SetSaved(2, {500, 500}, false);
+    EXPECT_FALSE(index.Saved(2, {500, 500}));
+
+    index.CopySaved(1, 2);
+    EXPECT_TRUE(index.Saved(2, {2, 3}));
+    EXPECT_TRUE(index.Saved(2, {-20, 3}));
+    EXPECT_EQ(index.Loaded(2, {2, 3}), Midori::TILE_INVALID);
+    EXPECT_EQ(index.Loaded(1, {2, 3}), 1);
+
+    index.SetSaved(1, {2, 3}, false);
+    EXPECT_FALSE(index.Saved(1, {2, 3}));
+    EXPECT_TRUE(index.Saved(2, {2, 3}));
+}
+
+TEST(MidoriTileIndex, ForEachSlotVisitsTheRectangle) {
+    Midori::TileIndex index;
+    index.AddLayer(1);
+    for (int y = -20; y < 20; y++) {
+        for (int x = -20; x < 20; x++) {
+            index.SetSaved(1, {x, y}, (x + y) % 3 == 0);
+        }
+    }
+
+    std::vector<glm::ivec2> visited;
+    int saved = 0;
+    index.ForEachSlot(1, {-17, -3}, {2, 18}, [&](const glm::ivec2 pos, const Midori::TileIndex::Slot& slot) {
+        visited.push_back(pos);
+        saved += slot.saved ? 1 : 0;
+        EXPECT_EQ(slot.saved, (pos.x + pos.y) % 3 == 0);
+    });
+    EXPECT_EQ(visited.size(), 19 * 21);
+    EXPECT_EQ(saved, std::count_if(visited.begin(), visited.end(), [](auto pos) { return (pos.x + pos.y) % 3 == 0; }));
+    for (const auto& pos : visited) {
+        EXPECT_TRUE(pos.x >= -17 && pos.x < 2 && pos.y >= -3 && pos.y < 18);
+    }
+
+    // Outside of the grid nothing is visited
+    visited.clear();
+    index.ForEachSlot(1, {100, 100}, {120, 120}, [&](const glm::ivec2 pos, const auto&) { visited.push_back(pos); });
+    EXPECT_TRUE(visited.empty());
+}
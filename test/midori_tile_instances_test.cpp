@@ -0,0 +1,51 @@
+#include <gtest/gtest.h>
+
+#include "../src/tile_instances.h"
+
+TEST(MidoriTileInstances, OneDrawPerLayerPage) {
+    Midori::TileInstanceBatch batch;
+    batch.Begin(3);
+
+    batch.BeginLayer(4);
+    batch.Add(2, 7, {1, 1});
+    batch.Add(0, 3, {0, 0});
+    batch.Add(2, 8, {2, 1});
+    batch.Add(0, 4, {-1, 0});
+    batch.EndLayer();
+
+    batch.BeginLayer(1); // Nothing loaded
+    batch.EndLayer();
+
+    batch.BeginLayer(9);
+    batch.Add(1, 0, {5, 5});
+    batch.EndLayer();
+
+    const auto& draws = batch.Draws();
+    ASSERT_EQ(draws.size(), 3);
+    EXPECT_EQ(draws[0].layer, 4);
+    EXPECT_EQ(draws[0].page, 0);
+    EXPECT_EQ(draws[0].instance_offset, 0);
+    EXPECT_EQ(draws[0].instance_count, 2);
+    EXPECT_EQ(draws[1].layer, 4);
+    EXPECT_EQ(draws[1].page, 2);
+    EXPECT_EQ(draws[1].instance_offset, 2);
+    EXPECT_EQ(draws[1].instance_count, 2);
+    EXPECT_EQ(draws[2].layer, 9);
+    EXPECT_EQ(draws[2].page, 1);
+    EXPECT_EQ(draws[2].instance_offset, 4);
+
+    // Instances keep the order they were added in within a page
+    const auto& instances = batch.Instances();
+    ASSERT_EQ(instances.size(), 5);
+    EXPECT_EQ(instances[0].slice, 3);
+    EXPECT_EQ(instances[1].slice, 4);
+    EXPECT_EQ(instances[1].position, glm::vec2(-1.0f, 0.0f));
+    EXPECT_EQ(instances[2].slice, 7);
+    EXPECT_EQ(instances[3].slice, 8);
+    EXPECT_EQ(instances[4].position, glm::vec2(5.0f, 5.0f));
+
+    // A new frame starts empty
+    batch.Begin(3);
+    EXPECT_TRUE(batch.Draws().empty());
+    EXPECT_TRUE(batch.Instances().empty());
+}
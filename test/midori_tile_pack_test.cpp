@@ -0,0 +1,230 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+
+#include "../src/tile_pack.h"
+
+static std::string TestPackPath(const char* name) {
+    return std::string(::testing::TempDir()) + name;
+}
+
+static eastl::vector<std::uint8_t> TestBlob(std::uint8_t seed, size_t size) {
+    eastl::vector<std::uint8_t> blob(size);
+    for (size_t i = 0; i < size; i++) {
+        blob[i] = static_cast<std::uint8_t>(seed + i * 7);
+    }
+    return blob;
+}
+
+TEST(MidoriTilePack, WriteFlushReopen) {
+    const auto path = TestPackPath("midori_pack_reopen.pack");
+    std::remove(path.c_str());
+
+    const Midori::TileCoord a = {.layer = 1, .pos = {0, 0}};
+    const Midori::TileCoord b = {.layer = 1, .pos = {-3, 7}};
+    const Midori::TileCoord c = {.layer = 2, .pos = {0, 0}};
+    {
+        Midori::TilePack pack;
+        ASSERT_TRUE(pack.Open(path));
+        const auto blob_a = TestBlob(1, 100);
+        const auto blob_b = TestBlob(2, 333);
+        const auto blob_c = TestBlob(3, 64);
+        EXPECT_TRUE(pack.Write(a, blob_a.data(), blob_a.size()));
+        EXPECT_TRUE(pack.Write(b, blob_b.data(), blob_b.size()));
+        EXPECT_TRUE(pack.Write(c, blob_c.data(), blob_c.size()));
+        EXPECT_TRUE(pack.Dirty());
+        EXPECT_TRUE(pack.Flush());
+        EXPECT_FALSE(pack.Dirty());
+    }
+
+    Midori::TilePack pack;
+    ASSERT_TRUE(pack.Open(path));
+    EXPECT_EQ(pack.Tiles().size(), 3);
+
+    eastl::vector<std::uint8_t> read;
+    EXPECT_TRUE(pack.Read(b, read));
+    EXPECT_EQ(read, TestBlob(2, 333));
+    EXPECT_FALSE(pack.Read({.layer = 3, .pos = {0, 0}}, read));
+}
+
+TEST(MidoriTilePack, UnflushedWritesAreLost) {
+    const auto path = TestPackPath("midori_pack_unflushed.pack");
+    std::remove(path.c_str());
+
+    const Midori::TileCoord a = {.layer = 1, .pos = {1, 1}};
+    {
+        Midori::TilePack pack;
+        ASSERT_TRUE(pack.Open(path));
+        const auto blob = TestBlob(1, 100);
+        EXPECT_TRUE(pack.Write(a, blob.data(), blob.size()));
+        EXPECT_TRUE(pack.Flush());
+
+        const auto rewritten = TestBlob(9, 50);
+        EXPECT_TRUE(pack.Write(a, rewritten.data(), rewritten.size()));
+    }
+
+    // The previous index is still valid
+    Midori::TilePack pack;
+    ASSERT_TRUE(pack.Open(path));
+    eastl::vector<std::uint8_t> read;
+    EXPECT_TRUE(pack.Read(a, read));
+    EXPECT_EQ(read, TestBlob(1, 100));
+}
+
+TEST(MidoriTilePack, EraseAndCopyLayer) {
+    const auto path = TestPackPath("midori_pack_layers.pack");
+    std::remove(path.c_str());
+
+    Midori::TilePack pack;
+    ASSERT_TRUE(pack.Open(path));
+    for (int i = 0; i < 8; i++) {
+        const auto blob = TestBlob(static_cast<std::uint8_t>(i), 40 + i);
+        EXPECT_TRUE(pack.Write({.layer = 1, .pos = {i, 0}}, blob.data(), blob.size()));
+    }
+
+    pack.CopyLayer(1, 2);
+    EXPECT_EQ(pack.Tiles().size(), 16);
+
+    eastl::vector<std::uint8_t> read;
+    EXPECT_TRUE(pack.Read({.layer = 2, .pos = {5, 0}}, read));
+    EXPECT_EQ(read, TestBlob(5, 45));
+
+    pack.Erase({.layer = 2, .pos = {5, 0}});
+    EXPECT_FALSE(pack.Contains({.layer = 2, .pos = {5, 0}}));
+    EXPECT_TRUE(pack.Contains({.layer = 1, .pos = {5, 0}}));
+
+    pack.EraseLayer(1);
+    EXPECT_EQ(pack.Tiles().size(), 7);
+}
+
+TEST(MidoriTilePack, Compact) {
+    const auto path = TestPackPath("midori_pack_compact.pack");
+    std::remove(path.c_str());
+
+    Midori::TilePack pack;
+    ASSERT_TRUE(pack.Open(path));
+    for (int round = 0; round < 10; round++) {
+        for (int i = 0; i < 4; i++) {
+            const auto blob = TestBlob(static_cast<std::uint8_t>(round + i), 1000);
+            EXPECT_TRUE(pack.Write({.layer = 1, .pos = {i, i}}, blob.data(), blob.size()));
+        }
+        EXPECT_TRUE(pack.Flush());
+    }
+    pack.CopyLayer(1, 2);
+
+    EXPECT_TRUE(pack.Compact());
+    EXPECT_FALSE(pack.Dirty());
+
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    ASSERT_NE(file, nullptr);
+    std::fseek(file, 0, SEEK_END);
+    const long size = std::ftell(file);
+    std::fclose(file);
+    // Shared blobs are only kept once
+    EXPECT_EQ(size, sizeof(Midori::TilePackHeader) + (4 * 1000) + (8 * sizeof(Midori::TilePackIndexEntry)));
+
+    Midori::TilePack reopened;
+    pack.Close();
+    ASSERT_TRUE(reopened.Open(path));
+    eastl::vector<std::uint8_t> read;
+    for (int i = 0; i < 4; i++) {
+        EXPECT_TRUE(reopened.Read({.layer = 2, .pos = {i, i}}, read));
+        EXPECT_EQ(read, TestBlob(static_cast<std::uint8_t>(9 + i), 1000));
+    }
+}
+
+TEST(MidoriTilePack, CompactWaitsForViews) {
+    const auto path = TestPackPath("midori_pack_compact_views.pack");
+    std::remove(path.c_str());
+
+    Midori::TilePack pack;
+    ASSERT_TRUE(pack.Open(path));
+    const Midori::TileCoord coord = {.layer = 1, .pos = {0, 0}};
+    const auto blob = TestBlob(1, 1000);
+    EXPECT_TRUE(pack.Write(coord, blob.data(), blob.size()));
+    EXPECT_TRUE(pack.Flush());
+    pack.Close();
+    ASSERT_TRUE(pack.Open(path));
+
+    // The view pins the mapping, the pack can't be replaced under it
+    Midori::TilePack::BlobView view;
+    ASSERT_TRUE(pack.View(coord, view));
+    EXPECT_FALSE(pack.Compact());
+    EXPECT_FALSE(pack.ShouldCompact());
+    EXPECT_TRUE(std::equal(view.data, view.data + view.size, blob.begin(), blob.end()));
+
+    view = {};
+    EXPECT_TRUE(pack.Compact());
+    eastl::vector<std::uint8_t> read;
+    EXPECT_TRUE(pack.Read(coord, read));
+    EXPECT_EQ(read, blob);
+    EXPECT_TRUE(pack.Write(coord, blob.data(), blob.size()));
+    EXPECT_TRUE(pack.Flush());
+}
+
+TEST(MidoriTilePack, SolidTiles) {
+    const auto path = TestPackPath("midori_pack_solid.pack");
+    std::remove(path.c_str());
+
+    const Midori::TileCoord solid = {.layer = 1, .pos = {2, 3}};
+    const Midori::TileCoord painted = {.layer = 1, .pos = {4, 5}};
+    {
+        Midori::TilePack pack;
+        ASSERT_TRUE(pack.Open(path));
+        const auto blob = TestBlob(1, 100);
+        EXPECT_TRUE(pack.Write(painted, blob.data(), blob.size()));
+        EXPECT_TRUE(pack.Write(solid, blob.data(), blob.size()));
+        pack.WriteSolid(solid, 0xFF336699u);
+        EXPECT_TRUE(pack.Compact());
+    }
+
+    Midori::TilePack pack;
+    ASSERT_TRUE(pack.Open(path));
+    EXPECT_TRUE(pack.Contains(solid));
+
+    std::uint32_t color = 0;
+    EXPECT_TRUE(pack.Solid(solid, color));
+    EXPECT_EQ(color, 0xFF336699u);
+    EXPECT_FALSE(pack.Solid(painted, color));
+
+    // Nothing to read for a solid tile
+    eastl::vector<std::uint8_t> read;
+    EXPECT_FALSE(pack.Read(solid, read));
+    EXPECT_TRUE(pack.Read(painted, read));
+    EXPECT_EQ(read, TestBlob(1, 100));
+}
+
+TEST(MidoriTilePack, BlobCache) {
+    const auto path = TestPackPath("midori_pack_cache.pack");
+    std::remove(path.c_str());
+
+    Midori::TilePack pack;
+    ASSERT_TRUE(pack.Open(path));
+    const Midori::TileCoord a = {.layer = 1, .pos = {0, 0}};
+    const Midori::TileCoord b = {.layer = 1, .pos = {1, 0}};
+    const auto blob_a = TestBlob(1, 500);
+    const auto blob_b = TestBlob(2, 700);
+    EXPECT_TRUE(pack.Write(a, blob_a.data(), blob_a.size()));
+    EXPECT_TRUE(pack.Write(b, blob_b.data(), blob_b.size()));
+    EXPECT_TRUE(pack.Write(a, blob_b.data(), blob_b.size()));
+
+    // Writes populate the cache
+    eastl::vector<std::uint8_t> read;
+    EXPECT_TRUE(pack.Read(a, read));
+    EXPECT_EQ(read, blob_b);
+    EXPECT_EQ(pack.Cache().GetStats().hits, 1);
+
+    // Compaction moves every blob, reads go back to the pack once and fill the cache again
+    EXPECT_TRUE(pack.Compact());
+    EXPECT_EQ(pack.Cache().GetStats().count, 0);
+    EXPECT_TRUE(pack.Read(b, read));
+    EXPECT_EQ(read, blob_b);
+    EXPECT_EQ(pack.Cache().GetStats().misses, 1);
+    EXPECT_TRUE(pack.Read(b, read));
+    EXPECT_EQ(read, blob_b);
+    EXPECT_EQ(pack.Cache().GetStats().hits, 2);
+    EXPECT_TRUE(pack.Read(a, read));
+    EXPECT_EQ(read, blob_b);
+}
@@ -0,0 +1,122 @@
+#include <gtest/gtest.h>
+
+#include "../src/tile_codec.h"
+#include "../src/tile_reduce.h"
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace {
+
+std::vector<std::uint8_t> SolidTile(const std::uint32_t color) {
+    std::vector<std::uint8_t> pixels(Midori::TILE_PIXELS_SIZE);
+    for (size_t i = 0; i < pixels.size(); i += 4) {
+        std::memcpy(pixels.data() + i, &color, 4);
+    }
+    return pixels;
+}
+
+std::vector<std::uint8_t> NoiseTile(const unsigned seed) {
+    std::vector<std::uint8_t> pixels(Midori::TILE_PIXELS_SIZE);
+    std::mt19937 rng(seed);
+    for (auto& byte : pixels) {
+        byte = static_cast<std::uint8_t>(rng());
+    }
+    return pixels;
+}
+
+// What reduce.comp does, every thread of the 16x16 group takes a strided part of the tile and the partial results
+// are combined in whatever order the threads finish, here backwards
+Midori::TileReduce ReduceLikeTheShader(const std::uint8_t* pixels) {
+    constexpr std::uint32_t THREADS = 256;
+    constexpr std::uint32_t PIXELS = Midori::TILE_WIDTH * Midori::TILE_HEIGHT;
+
+    std::uint32_t first;
+    std::memcpy(&first, pixels, 4);
+    std::uint32_t bits[THREADS] = {};
+    std::uint32_t differ[THREADS] = {};
+    std::uint32_t hash0[THREADS] = {};
+    std::uint32_t hash1[THREADS] = {};
+    for (std::uint32_t thread = 0; thread < THREADS; thread++) {
+        for (std::uint32_t i = thread; i < PIXELS; i += THREADS) {
+            std::uint32_t pixel;
+            std::memcpy(&pixel, pixels + i * 4, 4);
+            bits[thread] |= pixel;
+            differ[thread] |= pixel != first ? 1 : 0;
+            hash0[thread] += Midori::TileReduceHash0(pixel, i);
+            hash1[thread] += Midori::TileReduceHash1(pixel, i);
+        }
+    }
+
+    Midori::TileReduce reduce{.color = first};
+    std::uint32_t all_bits = 0;
+    std::uint32_t all_differ = 0;
+    for (std::uint32_t thread = THREADS; thread-- > 0;) {
+        all_bits |= bits[thread];
+        all_differ |= differ[thread];
+        reduce.hash[0] += hash0[thread];
+        reduce.hash[1] += hash1[thread];
+    }
+    reduce.flags = ((all_bits & 0xFEFEFEFEu) == 0 ? Midori::TileReduce::EMPTY : 0) |
+                   (all_differ == 0 ? Midori::TileReduce::UNIFORM : 0);
+    return reduce;
+}
+
+void ExpectSameReduce(const Midori::TileReduce& a, const Midori::TileReduce& b) {
+    EXPECT_EQ(a.flags, b.flags);
+    EXPECT_EQ(a.color, b.color);
+    EXPECT_EQ(a.Hash(), b.Hash());
+}
+
+} // namespace
+
+TEST(MidoriTileReduce, FlagsMatchTheCodecChecks) {
+    const std::vector<std::vector<std::uint8_t>> tiles = {
+        SolidTile(0x00000000u), SolidTile(0x01010101u), SolidTile(0xFF3366CCu),
+        SolidTile(0x02000000u), NoiseTile(1),           NoiseTile(2),
+    };
+    for (const auto& pixels : tiles) {
+        const auto reduce = Midori::ReduceTile(pixels.data());
+        std::uint32_t color = 0;
+        const bool uniform = Midori::IsTileUniform(pixels.data(), color);
+        EXPECT_EQ(reduce.Empty(), Midori::IsTileEmpty(pixels.data()));
+        EXPECT_EQ(reduce.Uniform(), uniform);
+        if (uniform) {
+            EXPECT_EQ(reduce.color, color);
+        }
+    }
+
+    // A single stroke pixel in the last row is enough
+    auto almost_empty = SolidTile(0x01000100u);
+    almost_empty[Midori::TILE_PIXELS_SIZE - 2] = 0x80;
+    const auto reduce = Midori::ReduceTile(almost_empty.data());
+    EXPECT_FALSE(reduce.Empty());
+    EXPECT_FALSE(reduce.Uniform());
+}
+
+TEST(MidoriTileReduce, HashFollowsTheContent) {
+    const auto pixels = NoiseTile(3);
+    auto copy = pixels;
+    EXPECT_EQ(Midori::ReduceTile(pixels.data()).Hash(), Midori::ReduceTile(copy.data()).Hash());
+
+    // One channel of one pixel
+    copy[4 * 1000 + 2] ^= 1;
+    EXPECT_NE(Midori::ReduceTile(pixels.data()).Hash(), Midori::ReduceTile(copy.data()).Hash());
+
+    // Same pixels in other places
+    copy = pixels;
+    std::swap_ranges(copy.begin(), copy.begin() + 4, copy.begin() + 4 * 77);
+    EXPECT_NE(Midori::ReduceTile(pixels.data()).Hash(), Midori::ReduceTile(copy.data()).Hash());
+
+    EXPECT_NE(Midori::ReduceTile(SolidTile(0xFF0000FFu).data()).Hash(),
+              Midori::ReduceTile(SolidTile(0xFFFF0000u).data()).Hash());
+}
+
+TEST(MidoriTileReduce, ShaderOrderGivesTheSameResult) {
+    const std::vector<std::vector<std::uint8_t>> tiles = {
+        SolidTile(0x00000000u), SolidTile(0x80402010u), NoiseTile(4), NoiseTile(5)};
+    for (const auto& pixels : tiles) {
+        ExpectSameReduce(Midori::ReduceTile(pixels.data()), ReduceLikeTheShader(pixels.data()));
+    }
+}
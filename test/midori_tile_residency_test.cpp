@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+
+#include "../src/tile_residency.h"
+
+// Budget of `tiles` tiles, in MB
+static size_t TestBudget(size_t tiles) {
+    return tiles * Midori::TileResidency::TILE_TEXTURE_SIZE / (1024 * 1024);
+}
+
+TEST(MidoriTileResidency, HotTilesAreNeverEvicted) {
+    Midori::TileResidency residency;
+    residency.SetBudget(TestBudget(4));
+    for (Midori::Tile tile = 1; tile <= 8; tile++) {
+        residency.Add(tile);
+    }
+    EXPECT_EQ(residency.Resident(), 8);
+    EXPECT_EQ(residency.Evict(), Midori::TILE_INVALID);
+}
+
+TEST(MidoriTileResidency, EvictsLeastRecentlyReleased) {
+    Midori::TileResidency residency;
+    residency.SetBudget(TestBudget(4));
+    for (Midori::Tile tile = 1; tile <= 6; tile++) {
+        residency.Add(tile);
+    }
+    residency.Release(3);
+    residency.Release(1);
+    residency.Release(5);
+    residency.Release(3); // Released again, back to the most recent
+    EXPECT_EQ(residency.ColdCount(), 3);
+
+    EXPECT_EQ(residency.Evict(), 1);
+    EXPECT_EQ(residency.Evict(), 5);
+    // Back within the budget
+    EXPECT_EQ(residency.Evict(), Midori::TILE_INVALID);
+    EXPECT_EQ(residency.Resident(), 4);
+    EXPECT_TRUE(residency.Cold(3));
+
+    residency.Remove(1);
+    residency.Remove(5);
+    EXPECT_EQ(residency.Resident(), 4);
+}
+
+TEST(MidoriTileResidency, UseCountsHits) {
+    Midori::TileResidency residency;
+    residency.SetBudget(TestBudget(4));
+    residency.Add(1);
+    residency.Add(2);
+
+    residency.Use(1);
+    EXPECT_EQ(residency.stats.hits, 0);
+
+    residency.Release(1);
+    residency.Use(1);
+    EXPECT_EQ(residency.stats.hits, 1);
+    EXPECT_FALSE(residency.Cold(1));
+    EXPECT_EQ(residency.Evict(), Midori::TILE_INVALID);
+
+    residency.Release(2);
+    residency.Remove(2);
+    EXPECT_EQ(residency.ColdCount(), 0);
+    EXPECT_EQ(residency.Resident(), 1);
+
+    // Ids are recycled
+    residency.Add(2);
+    EXPECT_EQ(residency.Resident(), 2);
+}
+
+TEST(MidoriTileResidency, PageSlackCountsAgainstTheBudget) {
+    Midori::TileResidency residency;
+    residency.SetBudget(TestBudget(4));
+    for (Midori::Tile tile = 1; tile <= 3; tile++) {
+        residency.Add(tile);
+        residency.Release(tile);
+    }
+    EXPECT_EQ(residency.Evict(), Midori::TILE_INVALID);
+
+    // Two free slices take the memory of two tiles
+    residency.SetPageSlack(2 * Midori::TileResidency::TILE_TEXTURE_SIZE);
+    EXPECT_EQ(residency.Evict(), 1);
+    EXPECT_EQ(residency.Evict(), Midori::TILE_INVALID);
+}
+
+TEST(MidoriTileResidency, UseCancelsAnEviction) {
+    Midori::TileResidency residency;
+    residency.SetBudget(TestBudget(2));
+    for (Midori::Tile tile = 1; tile <= 3; tile++) {
+        residency.Add(tile);
+        residency.Release(tile);
+    }
+    EXPECT_EQ(residency.Evict(), 1);
+    EXPECT_EQ(residency.Resident(), 2);
+
+    // Back into the view before it was unloaded
+    EXPECT_TRUE(residency.Use(1));
+    EXPECT_EQ(residency.Resident(), 3);
+    EXPECT_EQ(residency.stats.hits, 1);
+    EXPECT_FALSE(residency.Use(1));
+
+    // Hot now, the next cold tile goes instead
+    EXPECT_EQ(residency.Evict(), 2);
+    residency.Remove(2);
+    residency.Remove(1);
+    EXPECT_EQ(residency.Resident(), 1);
+}